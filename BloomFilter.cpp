@@ -0,0 +1,208 @@
+// BloomFilter.cpp
+#include "BloomFilter.h"
+#include "MemoryAccount.h"
+#include <bitset>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+/**
+ * @brief Allocates a bit array through the current memory account.
+ * @param lanes The number of 64-bit lanes.
+ * @return The uninitialized bit array.
+ */
+static uint64_t* allocateLanes(size_t lanes) {
+    return static_cast<uint64_t*>(MemoryAccount::current().allocate(lanes * sizeof(uint64_t), MemoryAccount::Structure::Indexes));
+}
+
+/**
+ * @brief Frees a bit array allocated by allocateLanes.
+ * @param blocks The bit array, or nullptr.
+ * @param lanes The number of lanes it was allocated with.
+ */
+static void freeLanes(uint64_t* blocks, size_t lanes) {
+    MemoryAccount::deallocate(blocks, lanes * sizeof(uint64_t), MemoryAccount::Structure::Indexes);
+}
+
+/**
+ * @brief Default constructor. Initializes an empty filter that rejects every word.
+ */
+BloomFilter::BloomFilter() : blocks{ nullptr }, block_count{ 0 }, item_count{ 0 }, item_capacity{ 0 } {}
+
+/**
+ * @brief Destructor. Deallocates the bit array.
+ */
+BloomFilter::~BloomFilter() {
+    freeLanes(blocks, block_count * LANES_PER_BLOCK); // Free the bit array
+}
+
+/**
+ * @brief Copy constructor. Copies the bit array of another filter.
+ * @param other The filter to copy.
+ */
+BloomFilter::BloomFilter(const BloomFilter& other) :
+    blocks{ other.block_count ? allocateLanes(other.block_count * LANES_PER_BLOCK) : nullptr },
+    block_count{ other.block_count },
+    item_count{ other.item_count },
+    item_capacity{ other.item_capacity } {
+    if (blocks) std::memcpy(blocks, other.blocks, block_count * LANES_PER_BLOCK * sizeof(uint64_t)); // Copy the bits
+}
+
+/**
+ * @brief Copy assignment operator. Copies the bit array of another filter.
+ * @param other The filter to copy.
+ * @return A reference to this object.
+ */
+BloomFilter& BloomFilter::operator=(const BloomFilter& other) {
+    if (this != &other) { // Avoid self-assignment
+        BloomFilter copy(other); // Copy first so that this object is unchanged if allocation fails
+        *this = std::move(copy); // Take ownership of the copy
+    }
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Takes ownership of another filter's bit array.
+ * @param other The filter to move from.
+ */
+BloomFilter::BloomFilter(BloomFilter&& other) noexcept :
+    blocks{ other.blocks },
+    block_count{ other.block_count },
+    item_count{ other.item_count },
+    item_capacity{ other.item_capacity } {
+    other.blocks = nullptr; // The other filter becomes empty
+    other.block_count = 0;
+    other.item_count = 0;
+    other.item_capacity = 0;
+}
+
+/**
+ * @brief Move assignment operator. Takes ownership of another filter's bit array.
+ * @param other The filter to move from.
+ * @return A reference to this object.
+ */
+BloomFilter& BloomFilter::operator=(BloomFilter&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        freeLanes(blocks, block_count * LANES_PER_BLOCK); // Free the old bit array
+        blocks = other.blocks; // Take ownership of the other's bits
+        block_count = other.block_count;
+        item_count = other.item_count;
+        item_capacity = other.item_capacity;
+
+        other.blocks = nullptr; // The other filter becomes empty
+        other.block_count = 0;
+        other.item_count = 0;
+        other.item_capacity = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Clears the filter and sizes it for the given number of words.
+ * @param expected_items The number of words that will be added.
+ */
+void BloomFilter::reset(size_t expected_items) {
+    size_t bits_per_block = LANES_PER_BLOCK * 64; // 512 bits per block
+    size_t new_block_count = (expected_items * BITS_PER_WORD + bits_per_block - 1) / bits_per_block; // Round up
+    if (new_block_count == 0) new_block_count = 1; // Always keep one block so add() has somewhere to go
+
+    if (new_block_count != block_count) { // Reallocate only when the size changes
+        uint64_t* new_blocks = allocateLanes(new_block_count * LANES_PER_BLOCK); // Before freeing, so a refused allocation leaves the filter intact
+        freeLanes(blocks, block_count * LANES_PER_BLOCK);
+        blocks = new_blocks;
+        block_count = new_block_count;
+    }
+    std::memset(blocks, 0, block_count * LANES_PER_BLOCK * sizeof(uint64_t)); // Clear every bit
+
+    item_count = 0; // No words added yet
+    item_capacity = block_count * bits_per_block / BITS_PER_WORD; // Words the filter can hold at its target rate
+}
+
+/**
+ * @brief Computes the block and the in-block bit positions of a word.
+ * The 64-bit hash is split in two: the high half picks the block, and the low half seeds
+ * the double-hashing sequence for the bits inside the block.
+ * @param word The word.
+ * @param block Receives the index of the word's block.
+ * @param bits Receives HASH_COUNT bit positions in [0, 512).
+ */
+void BloomFilter::positions(const Word& word, size_t& block, unsigned* bits) const {
+    uint64_t h = static_cast<uint64_t>(word.hash()); // Hash of the word
+    uint64_t mixed = h * 0x9E3779B97F4A7C15ULL; // Spread the hash before splitting it
+    block = static_cast<size_t>((mixed >> 32) % block_count); // High half picks the block
+
+    uint32_t h1 = static_cast<uint32_t>(h); // Low half seeds the in-block positions
+    uint32_t h2 = static_cast<uint32_t>(h >> 32) | 1; // Odd step so the positions differ
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+        bits[i] = (h1 + static_cast<uint32_t>(i) * h2) & 511; // Position within the 512-bit block
+    }
+}
+
+/**
+ * @brief Adds a word to the filter.
+ * @param word The word to add.
+ */
+void BloomFilter::add(const Word& word) {
+    if (block_count == 0) reset(1); // Lazily size an empty filter
+
+    size_t block;
+    unsigned bits[HASH_COUNT];
+    positions(word, block, bits);
+
+    uint64_t* lanes = blocks + block * LANES_PER_BLOCK; // The word's cache line
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+        lanes[bits[i] >> 6] |= uint64_t{ 1 } << (bits[i] & 63); // Set the bit
+    }
+    item_count++; // Count the word
+}
+
+/**
+ * @brief Tests whether a word may have been added.
+ * @param word The word to test.
+ * @return False if the word was definitely not added, true if it probably was.
+ */
+bool BloomFilter::mightContain(const Word& word) const {
+    if (block_count == 0) return false; // Nothing was ever added
+
+    size_t block;
+    unsigned bits[HASH_COUNT];
+    positions(word, block, bits);
+
+    const uint64_t* lanes = blocks + block * LANES_PER_BLOCK; // The word's cache line
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+        if ((lanes[bits[i] >> 6] & (uint64_t{ 1 } << (bits[i] & 63))) == 0) return false; // A clear bit proves absence
+    }
+    return true; // Every bit is set
+}
+
+/**
+ * @brief Checks whether more words were added than the filter was sized for.
+ * @return True if the filter should be rebuilt with a larger size.
+ */
+bool BloomFilter::isOverfull() const {
+    return item_count > item_capacity;
+}
+
+/**
+ * @brief Returns the memory used by the bit array.
+ * @return The size of the bit array in bytes.
+ */
+size_t BloomFilter::memoryBytes() const {
+    return block_count * LANES_PER_BLOCK * sizeof(uint64_t);
+}
+
+/**
+ * @brief Estimates the false-positive rate from the fraction of bits that are set.
+ * @return The probability that a word that was never added tests positive.
+ */
+double BloomFilter::estimatedFalsePositiveRate() const {
+    if (block_count == 0) return 0.0; // An empty filter rejects everything
+
+    size_t set_bits{ 0 }; // Number of bits that are set
+    for (size_t i = 0; i < block_count * LANES_PER_BLOCK; ++i) {
+        set_bits += std::bitset<64>(blocks[i]).count(); // Population count of the lane
+    }
+
+    double fill = static_cast<double>(set_bits) / static_cast<double>(block_count * LANES_PER_BLOCK * 64); // Fraction of bits set
+    return std::pow(fill, static_cast<double>(HASH_COUNT)); // All HASH_COUNT probed bits must be set
+}
@@ -0,0 +1,110 @@
+// BloomFilter.h
+#ifndef BLOOMFILTER_H_
+#define BLOOMFILTER_H_
+
+#include "Word.h"
+#include <cstdint>
+
+/**
+ * @class BloomFilter
+ * @brief A cache-blocked Bloom filter over Words.
+ *
+ * All bits of one word fall into a single 64-byte block, so a membership test touches one cache line.
+ * The filter never reports a false negative: a word that was added always tests positive, even after
+ * other words were added. Removing words is not supported; rebuild the filter instead.
+ */
+class BloomFilter {
+private:
+    static constexpr size_t BITS_PER_WORD = 10; ///< Bits reserved per expected word (about 1% false positives)
+    static constexpr size_t HASH_COUNT = 7; ///< Bits set per word
+    static constexpr size_t LANES_PER_BLOCK = 8; ///< 64-bit lanes per 64-byte block
+
+    uint64_t* blocks; ///< The bit array, LANES_PER_BLOCK lanes per block
+    size_t block_count; ///< The number of blocks (0 for an empty filter)
+    size_t item_count; ///< The number of words added since the last reset
+    size_t item_capacity; ///< The number of words the filter was sized for
+
+    /**
+     * @brief Computes the block and the in-block bit positions of a word.
+     * @param word The word
+     * @param block Receives the index of the word's block
+     * @param bits Receives HASH_COUNT bit positions in [0, 512)
+     */
+    void positions(const Word& word, size_t& block, unsigned* bits) const;
+
+public:
+    /**
+     * @brief Default constructor. Initializes an empty filter that rejects every word.
+     */
+    BloomFilter();
+
+    /**
+     * @brief Destructor. Deallocates the bit array.
+     */
+    ~BloomFilter();
+
+    /**
+     * @brief Copy constructor. Copies the bit array of another filter.
+     * @param other The filter to copy
+     */
+    BloomFilter(const BloomFilter& other);
+
+    /**
+     * @brief Copy assignment operator. Copies the bit array of another filter.
+     * @param other The filter to copy
+     * @return A reference to this object
+     */
+    BloomFilter& operator=(const BloomFilter& other);
+
+    /**
+     * @brief Move constructor. Takes ownership of another filter's bit array.
+     * @param other The filter to move from
+     */
+    BloomFilter(BloomFilter&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator. Takes ownership of another filter's bit array.
+     * @param other The filter to move from
+     * @return A reference to this object
+     */
+    BloomFilter& operator=(BloomFilter&& other) noexcept;
+
+    /**
+     * @brief Clears the filter and sizes it for the given number of words.
+     * @param expected_items The number of words that will be added
+     */
+    void reset(size_t expected_items);
+
+    /**
+     * @brief Adds a word to the filter.
+     * @param word The word to add
+     */
+    void add(const Word& word);
+
+    /**
+     * @brief Tests whether a word may have been added.
+     * @param word The word to test
+     * @return false if the word was definitely not added, true if it probably was
+     */
+    bool mightContain(const Word& word) const;
+
+    /**
+     * @brief Checks whether more words were added than the filter was sized for.
+     * @return true if the false-positive rate has drifted above its target and the filter should be rebuilt
+     */
+    bool isOverfull() const;
+
+    /**
+     * @brief Returns the memory used by the bit array.
+     * @return The size of the bit array in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Estimates the false-positive rate from the fraction of bits that are set.
+     * @return The probability that a word that was never added tests positive
+     */
+    double estimatedFalsePositiveRate() const;
+};
+
+#endif // BLOOMFILTER_H_
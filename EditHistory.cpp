@@ -0,0 +1,323 @@
+// EditHistory.cpp
+#include "EditHistory.h"
+#include "WordCatVec.h"
+#include <cstdio> // For std::remove
+#include <filesystem> // For std::filesystem::resize_file
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+/**
+ * @brief Appends a varint (7 bits per byte, low bits first) to a string.
+ * @param out The string to append to.
+ * @param value The value to encode.
+ */
+static void appendVarint(std::string& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Reads a varint from a string and advances past it.
+ * @param in The string to read from.
+ * @param at The read position; moved past the varint.
+ * @param value Receives the decoded value.
+ * @return False if the string ends inside the varint.
+ */
+static bool readVarint(const std::string& in, size_t& at, size_t& value) {
+    value = 0;
+    for (unsigned shift = 0; at < in.size() && shift < 64; shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(in[at++]);
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief One decoded delta of a step.
+ */
+struct Delta {
+    EditHistory::Operation operation; // What was done
+    Word category; // The category it was done to
+    Word word; // The word, for word operations
+};
+
+/**
+ * @brief Constructor.
+ * @param budget Bytes of steps to keep in memory.
+ * @param spill_path A file for the steps beyond the budget, or nullptr to forget them.
+ */
+EditHistory::EditHistory(size_t budget, const char* spill_path) :
+    budget{ budget },
+    spill_path{ spill_path != nullptr ? spill_path : "" },
+    undo_first{ 0 },
+    memory{ 0 },
+    spilled{ 0 },
+    step_open{ false } {}
+
+/**
+ * @brief Destructor. Deletes the spill file.
+ */
+EditHistory::~EditHistory() {
+    clear();
+}
+
+/**
+ * @brief Starts recording a step.
+ */
+void EditHistory::beginStep() {
+    open_step.clear();
+    open_category = Word();
+    step_open = true;
+}
+
+/**
+ * @brief Records one delta of the open step. A delta recorded with no open step is a step of its own.
+ * @param operation What was done.
+ * @param category The category it was done to.
+ * @param word The word, for InsertWord and RemoveWord.
+ */
+void EditHistory::record(Operation operation, const Word& category, const Word& word) {
+    bool own_step = !step_open;
+    if (own_step) beginStep();
+
+    unsigned char code = static_cast<unsigned char>(operation);
+    bool same = !open_step.empty() && category == open_category;
+    open_step.push_back(static_cast<char>(same ? code | SAME_CATEGORY : code));
+    if (!same) {
+        appendVarint(open_step, category.length());
+        open_step.append(category.c_str(), category.length());
+        open_category = category;
+    }
+    if (operation == Operation::InsertWord || operation == Operation::RemoveWord) {
+        appendVarint(open_step, word.length());
+        open_step.append(word.c_str(), word.length());
+    }
+
+    if (own_step) endStep();
+}
+
+/**
+ * @brief Finishes the open step.
+ */
+void EditHistory::endStep() {
+    step_open = false;
+    if (open_step.empty()) return; // Nothing changed
+
+    memory += open_step.size();
+    undo_steps.push_back(std::move(open_step));
+    open_step = std::string();
+    for (const std::string& step : redo_steps) memory -= step.size(); // A new edit ends the redo branch
+    redo_steps.clear();
+    enforceBudget();
+}
+
+/**
+ * @brief Moves or drops the oldest steps until the memory is within budget.
+ * The newest step always stays, so that it can be undone however large it is.
+ */
+void EditHistory::enforceBudget() {
+    while (memory > budget && !redo_steps.empty()) { // The farthest redo steps go first
+        memory -= redo_steps.front().size();
+        redo_steps.erase(redo_steps.begin());
+    }
+    while (memory > budget && undo_steps.size() - undo_first > 1) {
+        if (spill_path.empty() || !spillOldest()) spilled = 0; // Dropping a step makes the spilled ones unreachable
+        memory -= undo_steps[undo_first].size();
+        undo_steps[undo_first] = std::string(); // Free it now
+        undo_first++;
+    }
+    if (undo_first > undo_steps.size() / 2) { // Compact once most entries are spent, so each step moves O(1) times
+        undo_steps.erase(undo_steps.begin(), undo_steps.begin() + static_cast<std::ptrdiff_t>(undo_first));
+        undo_first = 0;
+    }
+}
+
+/**
+ * @brief Appends the oldest undo step to the spill file, followed by its length.
+ * @return False if the file could not be written.
+ */
+bool EditHistory::spillOldest() {
+    std::ofstream file(spill_path, spilled == 0 ? std::ios::binary | std::ios::trunc : std::ios::binary | std::ios::app);
+    const std::string& step = undo_steps[undo_first];
+    uint64_t length = step.size();
+    file.write(step.data(), static_cast<std::streamsize>(step.size()));
+    file.write(reinterpret_cast<const char*>(&length), sizeof length);
+    if (!file) {
+        std::cerr << "Error writing edit history to " << spill_path << std::endl;
+        return false;
+    }
+    spilled++;
+    return true;
+}
+
+/**
+ * @brief Reads the newest spilled step back from the end of the spill file and truncates it away.
+ * @param step Receives the step.
+ * @return False if no step could be read.
+ */
+bool EditHistory::unspill(std::string& step) {
+    std::ifstream file(spill_path, std::ios::binary | std::ios::ate);
+    uint64_t length{ 0 };
+    std::streamoff end = file ? static_cast<std::streamoff>(file.tellg()) : 0;
+    bool read = end >= static_cast<std::streamoff>(sizeof length) &&
+                file.seekg(end - static_cast<std::streamoff>(sizeof length)) &&
+                file.read(reinterpret_cast<char*>(&length), sizeof length) &&
+                length <= static_cast<uint64_t>(end) - sizeof length;
+    std::streamoff start = read ? end - static_cast<std::streamoff>(sizeof length + length) : 0;
+    if (read) {
+        step.resize(static_cast<size_t>(length));
+        read = file.seekg(start) && file.read(&step[0], static_cast<std::streamsize>(length));
+    }
+    file.close();
+
+    std::error_code error;
+    if (read) std::filesystem::resize_file(spill_path, static_cast<std::uintmax_t>(start), error); // Pop it off the file
+    if (!read || error) {
+        std::cerr << "Error reading edit history from " << spill_path << std::endl;
+        spilled = 0;
+        return false;
+    }
+    spilled--;
+    return true;
+}
+
+/**
+ * @brief Applies a step to a vocabulary, forwards or inverted and backwards.
+ * Every delta is attempted even if one fails, so a step applies as far as it can.
+ * @param step The encoded step.
+ * @param target The vocabulary.
+ * @param inverse True to undo the step, false to redo it.
+ * @return False if some delta did not apply.
+ */
+bool EditHistory::apply(const std::string& step, WordCatVec& target, bool inverse) {
+    std::vector<Delta> deltas; // Decoded first, since an undo walks them backwards
+    Word category;
+    size_t at = 0, length = 0;
+    while (at < step.size()) {
+        unsigned char code = static_cast<unsigned char>(step[at++]);
+        Operation operation = static_cast<Operation>(code & ~SAME_CATEGORY);
+        if ((code & SAME_CATEGORY) == 0) {
+            if (!readVarint(step, at, length) || step.size() - at < length) return false;
+            category = Word(std::string(step, at, length).c_str());
+            at += length;
+        }
+        Word word;
+        if (operation == Operation::InsertWord || operation == Operation::RemoveWord) {
+            if (!readVarint(step, at, length) || step.size() - at < length) return false;
+            word = Word(std::string(step, at, length).c_str());
+            at += length;
+        }
+        deltas.push_back(Delta{ operation, category, std::move(word) });
+    }
+
+    bool clean = true;
+    for (size_t i = 0; i < deltas.size(); ++i) {
+        const Delta& delta = deltas[inverse ? deltas.size() - 1 - i : i];
+        Operation operation = delta.operation;
+        if (inverse) { // Each operation has an opposite
+            switch (operation) {
+                case Operation::InsertWord: operation = Operation::RemoveWord; break;
+                case Operation::RemoveWord: operation = Operation::InsertWord; break;
+                case Operation::AddCategory: operation = Operation::RemoveCategory; break;
+                case Operation::RemoveCategory: operation = Operation::AddCategory; break;
+            }
+        }
+        switch (operation) {
+            case Operation::InsertWord: clean &= target.insertWord(delta.category, delta.word); break;
+            case Operation::RemoveWord: clean &= target.removeWord(delta.category, delta.word); break;
+            case Operation::AddCategory: clean &= target.addCategory(WordCat(delta.category)); break; // Added at the end
+            case Operation::RemoveCategory: clean &= target.removeCategory(delta.category); break;
+        }
+    }
+    return clean;
+}
+
+/**
+ * @brief Undoes the newest step, reading it back from the spill file if it was spilled.
+ * @param target The vocabulary the step was recorded on.
+ * @return False if there is nothing to undo, or the step did not apply cleanly.
+ */
+bool EditHistory::undo(WordCatVec& target) {
+    std::string step;
+    if (undo_steps.size() > undo_first) {
+        step = std::move(undo_steps.back());
+        undo_steps.pop_back();
+        memory -= step.size();
+    } else if (spilled == 0 || !unspill(step)) {
+        return false; // Nothing to undo
+    }
+
+    bool clean = apply(step, target, true);
+    memory += step.size();
+    redo_steps.push_back(std::move(step));
+    enforceBudget();
+    return clean;
+}
+
+/**
+ * @brief Redoes the step undone last.
+ * @param target The vocabulary the step was recorded on.
+ * @return False if there is nothing to redo, or the step did not apply cleanly.
+ */
+bool EditHistory::redo(WordCatVec& target) {
+    if (redo_steps.empty()) return false;
+    std::string step = std::move(redo_steps.back());
+    redo_steps.pop_back();
+
+    bool clean = apply(step, target, false);
+    undo_steps.push_back(std::move(step)); // Same size, so the memory is unchanged
+    enforceBudget();
+    return clean;
+}
+
+/**
+ * @brief Forgets every step, in memory and spilled.
+ */
+void EditHistory::clear() {
+    undo_steps.clear();
+    redo_steps.clear();
+    undo_first = 0;
+    memory = 0;
+    open_step.clear();
+    step_open = false;
+    if (!spill_path.empty()) std::remove(spill_path.c_str()); // Nothing to read back any more
+    spilled = 0;
+}
+
+/**
+ * @brief Returns the number of steps that can be undone, including spilled ones.
+ * @return The number of steps.
+ */
+size_t EditHistory::undoCount() const {
+    return undo_steps.size() - undo_first + spilled;
+}
+
+/**
+ * @brief Returns the number of steps that can be redone.
+ * @return The number of steps.
+ */
+size_t EditHistory::redoCount() const {
+    return redo_steps.size();
+}
+
+/**
+ * @brief Returns the bytes of steps held in memory.
+ * @return The size in bytes.
+ */
+size_t EditHistory::memoryBytes() const {
+    return memory;
+}
+
+/**
+ * @brief Returns the number of steps in the spill file.
+ * @return The number of steps.
+ */
+size_t EditHistory::spilledCount() const {
+    return spilled;
+}
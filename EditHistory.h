@@ -0,0 +1,163 @@
+// EditHistory.h
+#ifndef EDITHISTORY_H_
+#define EDITHISTORY_H_
+
+#include "Word.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WordCatVec;
+
+/**
+ * @class EditHistory
+ * @brief An undo/redo journal of edits to a WordCatVec, stored as compact deltas.
+ *
+ * Each step is one user action, recorded as the deltas it made: (operation, category, word). A step is
+ * encoded into a single string: one operation byte per delta, then the category and the word, each
+ * preceded by a varint length. A delta that applies to the same category as the one before it sets the
+ * SAME_CATEGORY bit instead of repeating the name, so clearing a category costs little more than its words.
+ * Undo applies the inverse of a step's deltas in reverse order; redo applies them again. Either costs one
+ * decode and one category operation per delta, however long the history is.
+ *
+ * The steps kept in memory are bounded by a budget in bytes. When recording goes over it, the oldest steps
+ * are moved to a spill file if one was given, and dropped otherwise; undo reads them back from the end of
+ * the file, one at a time, when it reaches them. Each spilled step is followed by its length, so the file is
+ * a stack that is read and truncated from its end.
+ */
+class EditHistory {
+public:
+    static constexpr size_t DEFAULT_BUDGET = 1 << 20; ///< Bytes of steps kept in memory by default
+
+    /**
+     * @brief The deltas a step is made of. Each has an inverse: insert and remove, add and remove category.
+     */
+    enum class Operation : char {
+        InsertWord = 'W', ///< A word was inserted into a category
+        RemoveWord = 'w', ///< A word was removed from a category
+        AddCategory = 'C', ///< An empty category was added
+        RemoveCategory = 'c' ///< An empty category was removed (its words are recorded as removed first)
+    };
+
+private:
+    static constexpr unsigned char SAME_CATEGORY = 0x80; ///< Set on an operation byte whose category is the previous delta's
+
+    size_t budget; ///< Bytes of steps kept in memory before the oldest are spilled or dropped
+    std::string spill_path; ///< Where the oldest steps go; empty to drop them
+    std::vector<std::string> undo_steps; ///< Steps that can be undone, oldest first
+    size_t undo_first; ///< Index of the oldest undo step still in undo_steps; earlier entries were spilled
+    std::vector<std::string> redo_steps; ///< Steps that can be redone, the next one last
+    size_t memory; ///< Bytes of the steps in undo_steps and redo_steps
+    size_t spilled; ///< Steps in the spill file
+    std::string open_step; ///< The step being recorded
+    Word open_category; ///< Category of the last delta of the open step
+    bool step_open; ///< Whether a step is being recorded
+
+    /**
+     * @brief Moves or drops the oldest steps until the memory is within budget.
+     */
+    void enforceBudget();
+
+    /**
+     * @brief Appends the oldest undo step to the spill file.
+     * @return false if the file could not be written, in which case the step is dropped
+     */
+    bool spillOldest();
+
+    /**
+     * @brief Reads the newest spilled step back from the end of the spill file and truncates it away.
+     * @param step Receives the step
+     * @return false if no step could be read, in which case the spilled steps are forgotten
+     */
+    bool unspill(std::string& step);
+
+    /**
+     * @brief Applies a step to a vocabulary, forwards or inverted and backwards.
+     * @param step The encoded step
+     * @param target The vocabulary
+     * @param inverse true to undo the step, false to redo it
+     * @return false if some delta did not apply, because the vocabulary was changed outside the history
+     */
+    static bool apply(const std::string& step, WordCatVec& target, bool inverse);
+
+public:
+    /**
+     * @brief Constructor.
+     * @param budget Bytes of steps to keep in memory
+     * @param spill_path A file for the steps beyond the budget, or nullptr to forget them; it is overwritten
+     */
+    explicit EditHistory(size_t budget = DEFAULT_BUDGET, const char* spill_path = nullptr);
+
+    /**
+     * @brief Destructor. Deletes the spill file.
+     */
+    ~EditHistory();
+
+    EditHistory(const EditHistory& other) = delete;
+    EditHistory& operator=(const EditHistory& other) = delete;
+
+    /**
+     * @brief Starts recording a step. Deltas recorded until endStep() are undone and redone together.
+     */
+    void beginStep();
+
+    /**
+     * @brief Records one delta of the open step.
+     * @param operation What was done
+     * @param category The category it was done to
+     * @param word The word, for InsertWord and RemoveWord
+     */
+    void record(Operation operation, const Word& category, const Word& word = Word());
+
+    /**
+     * @brief Finishes the open step. A step with deltas becomes the next one to undo and clears the redo steps;
+     * an empty step is dropped.
+     */
+    void endStep();
+
+    /**
+     * @brief Undoes the newest step.
+     * @param target The vocabulary the step was recorded on
+     * @return false if there is nothing to undo, or the step did not apply cleanly (it is undone as far as it applies)
+     */
+    bool undo(WordCatVec& target);
+
+    /**
+     * @brief Redoes the step undone last.
+     * @param target The vocabulary the step was recorded on
+     * @return false if there is nothing to redo, or the step did not apply cleanly
+     */
+    bool redo(WordCatVec& target);
+
+    /**
+     * @brief Forgets every step, in memory and spilled.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of steps that can be undone, including spilled ones.
+     * @return The number of steps
+     */
+    size_t undoCount() const;
+
+    /**
+     * @brief Returns the number of steps that can be redone.
+     * @return The number of steps
+     */
+    size_t redoCount() const;
+
+    /**
+     * @brief Returns the bytes of steps held in memory.
+     * @return The size in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Returns the number of steps in the spill file.
+     * @return The number of steps
+     */
+    size_t spilledCount() const;
+};
+
+#endif // EDITHISTORY_H_
@@ -0,0 +1,218 @@
+// FoldedIndex.cpp
+#include "FoldedIndex.h"
+#include "MemoryAccount.h"
+#include <new>
+#include <utility>
+
+/**
+ * @brief Allocates a table of empty slots, charged to the current memory account as an index.
+ * @param slot_count The number of slots.
+ * @return The table.
+ */
+FoldedIndex::Slot* FoldedIndex::allocateSlots(size_t slot_count) {
+    static_assert(alignof(Slot) <= MemoryAccount::HEADER, "Accounted blocks are only 8-byte aligned");
+    Slot* table = static_cast<Slot*>(MemoryAccount::current().allocate(slot_count * sizeof(Slot), MemoryAccount::Structure::Indexes));
+    for (size_t i = 0; i < slot_count; i++) new (table + i) Slot(); // Empty slots allocate nothing
+    return table;
+}
+
+/**
+ * @brief Frees a table allocated by allocateSlots, with the buffers of its words.
+ * @param table The table, or nullptr.
+ * @param slot_count The number of slots it was allocated with.
+ */
+void FoldedIndex::freeSlots(Slot* table, size_t slot_count) {
+    if (table == nullptr) return;
+    for (size_t i = 0; i < slot_count; i++) table[i].~Slot();
+    MemoryAccount::deallocate(table, slot_count * sizeof(Slot), MemoryAccount::Structure::Indexes);
+}
+
+/**
+ * @brief Default constructor. Initializes an empty index that allocates nothing.
+ */
+FoldedIndex::FoldedIndex() : slots{ nullptr }, capacity{ 0 }, count{ 0 }, removed{ 0 } {}
+
+/**
+ * @brief Destructor. Deallocates the table.
+ */
+FoldedIndex::~FoldedIndex() {
+    freeSlots(slots, capacity);
+}
+
+/**
+ * @brief Copy constructor. Copies the table of another index.
+ * @param other The index to copy.
+ */
+FoldedIndex::FoldedIndex(const FoldedIndex& other) :
+    slots{ other.capacity ? allocateSlots(other.capacity) : nullptr },
+    capacity{ other.capacity }, count{ other.count }, removed{ other.removed } {
+    try {
+        for (size_t i = 0; i < capacity; i++) slots[i] = other.slots[i];
+    } catch (...) { // A word's buffer was refused; the destructor will not run
+        freeSlots(slots, capacity);
+        throw;
+    }
+}
+
+/**
+ * @brief Copy assignment operator. Copies the table of another index.
+ * @param other The index to copy.
+ * @return A reference to this object.
+ */
+FoldedIndex& FoldedIndex::operator=(const FoldedIndex& other) {
+    if (this != &other) { // Avoid self-assignment
+        FoldedIndex copy(other); // Copy first so that this object is unchanged if allocation fails
+        *this = std::move(copy); // Take ownership of the copy
+    }
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Takes ownership of another index's table.
+ * @param other The index to move from.
+ */
+FoldedIndex::FoldedIndex(FoldedIndex&& other) noexcept :
+    slots{ other.slots }, capacity{ other.capacity }, count{ other.count }, removed{ other.removed } {
+    other.slots = nullptr; // The other index becomes empty
+    other.capacity = other.count = other.removed = 0;
+}
+
+/**
+ * @brief Move assignment operator. Takes ownership of another index's table.
+ * @param other The index to move from.
+ * @return A reference to this object.
+ */
+FoldedIndex& FoldedIndex::operator=(FoldedIndex&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        freeSlots(slots, capacity); // Free the old table
+        slots = other.slots;
+        capacity = other.capacity;
+        count = other.count;
+        removed = other.removed;
+        other.slots = nullptr; // The other index becomes empty
+        other.capacity = other.count = other.removed = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Hashes the search key of a word, avoiding the values reserved for EMPTY and REMOVED.
+ * @param word The word.
+ * @return The hash.
+ */
+size_t FoldedIndex::hashKey(const Word& word) {
+    size_t h = word.searchKeyHash(); // Without building the key
+    return h <= REMOVED ? h + 2 : h; // Keep the reserved values free
+}
+
+/**
+ * @brief Moves every word into a new table with the given number of slots, dropping the REMOVED markers.
+ * @param new_capacity The new number of slots, a power of two larger than the number of words.
+ */
+void FoldedIndex::rehash(size_t new_capacity) {
+    Slot* old_slots = slots;
+    size_t old_capacity = capacity;
+    slots = allocateSlots(new_capacity);
+    capacity = new_capacity;
+    removed = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].hash <= REMOVED) continue; // Nothing to move
+        size_t j = old_slots[i].hash & (capacity - 1);
+        while (slots[j].hash != EMPTY) j = (j + 1) & (capacity - 1); // The new table has no markers yet
+        slots[j].hash = old_slots[i].hash;
+        slots[j].word = std::move(old_slots[i].word);
+    }
+    freeSlots(old_slots, old_capacity);
+}
+
+/**
+ * @brief Adds a word. The caller ensures it is not already in the index.
+ * The word is copied before the table changes, so that if a copy or the rehash fails the index is unchanged.
+ * @param word The word to add.
+ */
+void FoldedIndex::add(const Word& word) {
+    Word stored(word);
+    size_t h = hashKey(word);
+    if ((count + removed + 1) * 4 > capacity * 3) { // Keep probe sequences short
+        size_t new_capacity = capacity ? capacity : MIN_CAPACITY;
+        while ((count + 1) * 2 > new_capacity) new_capacity *= 2; // At most half full after rehashing
+        rehash(new_capacity);
+    }
+
+    size_t i = h & (capacity - 1);
+    while (slots[i].hash > REMOVED) i = (i + 1) & (capacity - 1); // The first free slot, reusing a marker if one comes first
+    if (slots[i].hash == REMOVED) removed--;
+    slots[i].hash = h;
+    slots[i].word = std::move(stored);
+    count++;
+}
+
+/**
+ * @brief Removes a word, matched exactly.
+ * @param word The word to remove.
+ * @return True if the word was found and removed, false otherwise.
+ */
+bool FoldedIndex::remove(const Word& word) {
+    if (count == 0) return false;
+    size_t h = hashKey(word);
+    for (size_t i = h & (capacity - 1); slots[i].hash != EMPTY; i = (i + 1) & (capacity - 1)) {
+        if (slots[i].hash == h && slots[i].word == word) {
+            slots[i].hash = REMOVED; // Later words of the probe sequence stay reachable
+            slots[i].word = Word();
+            count--;
+            removed++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Removes all words and frees the table.
+ */
+void FoldedIndex::clear() {
+    freeSlots(slots, capacity);
+    slots = nullptr;
+    capacity = count = removed = 0;
+}
+
+/**
+ * @brief Checks if any word has the same search key as the given one.
+ * @param word The word to look up, in any case and with or without accents.
+ * @return True if a matching word is found, false otherwise.
+ */
+bool FoldedIndex::contains(const Word& word) const {
+    if (count == 0) return false;
+    Word key = word.searchKey();
+    size_t h = hashKey(word);
+    for (size_t i = h & (capacity - 1); slots[i].hash != EMPTY; i = (i + 1) & (capacity - 1)) {
+        if (slots[i].hash == h && slots[i].word.searchKey() == key) return true; // Confirm past a hash collision
+    }
+    return false;
+}
+
+/**
+ * @brief Returns every word with the same search key as the given one.
+ * @param word The word to look up, in any case and with or without accents.
+ * @return A sorted list of the matching words, as stored.
+ */
+WordList FoldedIndex::find(const Word& word) const {
+    WordList matches;
+    if (count == 0) return matches;
+    Word key = word.searchKey();
+    size_t h = hashKey(word);
+    for (size_t i = h & (capacity - 1); slots[i].hash != EMPTY; i = (i + 1) & (capacity - 1)) {
+        if (slots[i].hash == h && slots[i].word.searchKey() == key) matches.insertSorted(slots[i].word); // A handful at most
+    }
+    return matches;
+}
+
+/**
+ * @brief Returns the memory allocated by the table, including the heap buffers of long words.
+ * @return The allocated size in bytes.
+ */
+size_t FoldedIndex::memoryBytes() const {
+    size_t bytes = capacity * sizeof(Slot);
+    for (size_t i = 0; i < capacity; i++) bytes += slots[i].word.heapBytes();
+    return bytes;
+}
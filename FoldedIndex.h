@@ -0,0 +1,150 @@
+// FoldedIndex.h
+#ifndef FOLDEDINDEX_H_
+#define FOLDEDINDEX_H_
+
+#include "Word.h"
+#include "WordList.h"
+#include <cstddef>
+
+/**
+ * @class FoldedIndex
+ * @brief A hash index from the search key of a word (see Word::searchKey) to the words that have it.
+ *
+ * "Apple", "apple" and "APPLE" share the key "apple", and "école" and "Ecole" share "ecole", so one
+ * probe sequence finds every spelling of a word that differs only in case or accents. The table uses
+ * open addressing with linear probing; each slot keeps the hash of its word's key and the word itself.
+ * The key is recomputed only for slots whose hash matches, which is almost always a true match.
+ * Removed words leave a marker that later insertions reuse, and the table is rehashed when live words
+ * and markers together pass three quarters of the slots. The table is charged to the current memory
+ * account as an index, and the words' buffers as words (see MemoryAccount).
+ */
+class FoldedIndex {
+private:
+    static constexpr size_t EMPTY = 0; ///< Hash of a slot that was never used; ends a probe sequence
+    static constexpr size_t REMOVED = 1; ///< Hash of a slot whose word was removed; probes continue past it
+    static constexpr size_t MIN_CAPACITY = 16; ///< Slots allocated by the first insertion
+
+    /**
+     * @brief One slot of the table.
+     */
+    struct Slot {
+        size_t hash = EMPTY; ///< Hash of the word's search key, or EMPTY or REMOVED
+        Word word; ///< The word as stored in the category
+    };
+
+    Slot* slots; ///< The table; its size is a power of two
+    size_t capacity; ///< Number of slots (0 before the first insertion)
+    size_t count; ///< Number of words
+    size_t removed; ///< Number of REMOVED slots
+
+    /**
+     * @brief Hashes the search key of a word, avoiding the values reserved for EMPTY and REMOVED.
+     * Allocates nothing, so that remove cannot fail.
+     * @param word The word
+     * @return The hash
+     */
+    static size_t hashKey(const Word& word);
+
+    /**
+     * @brief Allocates a table of empty slots, charged to the current memory account as an index.
+     * @param slot_count The number of slots
+     * @return The table
+     */
+    static Slot* allocateSlots(size_t slot_count);
+
+    /**
+     * @brief Frees a table allocated by allocateSlots.
+     * @param table The table, or nullptr
+     * @param slot_count The number of slots it was allocated with
+     */
+    static void freeSlots(Slot* table, size_t slot_count);
+
+    /**
+     * @brief Moves every word into a new table with the given number of slots, dropping the REMOVED markers.
+     * @param new_capacity The new number of slots, a power of two larger than the number of words
+     */
+    void rehash(size_t new_capacity);
+
+public:
+    /**
+     * @brief Default constructor. Initializes an empty index that allocates nothing.
+     */
+    FoldedIndex();
+
+    /**
+     * @brief Destructor. Deallocates the table.
+     */
+    ~FoldedIndex();
+
+    /**
+     * @brief Copy constructor. Copies the table of another index.
+     * @param other The index to copy
+     */
+    FoldedIndex(const FoldedIndex& other);
+
+    /**
+     * @brief Copy assignment operator. Copies the table of another index.
+     * @param other The index to copy
+     * @return A reference to this object
+     */
+    FoldedIndex& operator=(const FoldedIndex& other);
+
+    /**
+     * @brief Move constructor. Takes ownership of another index's table.
+     * @param other The index to move from
+     */
+    FoldedIndex(FoldedIndex&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator. Takes ownership of another index's table.
+     * @param other The index to move from
+     * @return A reference to this object
+     */
+    FoldedIndex& operator=(FoldedIndex&& other) noexcept;
+
+    /**
+     * @brief Adds a word. The caller ensures it is not already in the index. If it throws, the index is unchanged.
+     * @param word The word to add
+     */
+    void add(const Word& word);
+
+    /**
+     * @brief Removes a word, matched exactly. Allocates nothing.
+     * @param word The word to remove
+     * @return true if the word was found and removed, false otherwise
+     */
+    bool remove(const Word& word);
+
+    /**
+     * @brief Removes all words and frees the table.
+     */
+    void clear();
+
+    /**
+     * @brief Checks if any word has the same search key as the given one.
+     * @param word The word to look up, in any case and with or without accents
+     * @return true if a matching word is found, false otherwise
+     */
+    bool contains(const Word& word) const;
+
+    /**
+     * @brief Returns every word with the same search key as the given one.
+     * @param word The word to look up, in any case and with or without accents
+     * @return A sorted list of the matching words, as stored
+     */
+    WordList find(const Word& word) const;
+
+    /**
+     * @brief Returns the number of words.
+     * @return The number of words
+     */
+    inline size_t length() const { return count; }
+
+    /**
+     * @brief Returns the memory allocated by the table, including the heap buffers of long words.
+     * @return The allocated size in bytes
+     */
+    size_t memoryBytes() const;
+};
+
+#endif // FOLDEDINDEX_H_
@@ -0,0 +1,554 @@
+// FrontCodedList.cpp
+#include "FrontCodedList.h"
+#include "WordFormatter.h"
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Compares two character ranges the way strcmp compares strings.
+ * @return Negative, zero or positive as a is less than, equal to or greater than b.
+ */
+static int compareRange(const char* a, size_t a_length, const char* b, size_t b_length) {
+    int cmp = std::memcmp(a, b, a_length < b_length ? a_length : b_length); // memcmp compares bytes as unsigned, like strcmp
+    if (cmp != 0) return cmp;
+    return a_length < b_length ? -1 : (a_length > b_length ? 1 : 0); // A proper prefix comes first
+}
+
+/**
+ * @brief Default constructor. Initializes an empty list.
+ */
+FrontCodedList::FrontCodedList() :
+    bytes{ nullptr }, byte_count{ 0 }, block_offsets{ nullptr }, block_count{ 0 }, word_count{ 0 }, longest{ 0 } {}
+
+/**
+ * @brief Destructor. Deallocates the blocks and the block index.
+ */
+FrontCodedList::~FrontCodedList() {
+    delete[] bytes;
+    delete[] block_offsets;
+}
+
+/**
+ * @brief Copy constructor. Copies the encoded blocks of another list.
+ * @param other The list to copy.
+ */
+FrontCodedList::FrontCodedList(const FrontCodedList& other) :
+    bytes{ other.byte_count ? new unsigned char[other.byte_count] : nullptr },
+    byte_count{ other.byte_count },
+    block_offsets{ other.block_count ? new uint32_t[other.block_count] : nullptr },
+    block_count{ other.block_count },
+    word_count{ other.word_count },
+    longest{ other.longest } {
+    if (bytes) std::memcpy(bytes, other.bytes, byte_count);
+    if (block_offsets) std::memcpy(block_offsets, other.block_offsets, block_count * sizeof(uint32_t));
+}
+
+/**
+ * @brief Copy assignment operator. Copies the encoded blocks of another list.
+ * @param other The list to copy.
+ * @return A reference to this object.
+ */
+FrontCodedList& FrontCodedList::operator=(const FrontCodedList& other) {
+    if (this != &other) { // Avoid self-assignment
+        FrontCodedList copy(other); // Copy first so that this object is unchanged if allocation fails
+        *this = std::move(copy); // Take ownership of the copy
+    }
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Takes ownership of another list's buffers.
+ * @param other The list to move from.
+ */
+FrontCodedList::FrontCodedList(FrontCodedList&& other) noexcept :
+    bytes{ other.bytes }, byte_count{ other.byte_count },
+    block_offsets{ other.block_offsets }, block_count{ other.block_count },
+    word_count{ other.word_count }, longest{ other.longest } {
+    other.bytes = nullptr; // The other list becomes empty
+    other.block_offsets = nullptr;
+    other.byte_count = other.block_count = other.word_count = other.longest = 0;
+}
+
+/**
+ * @brief Move assignment operator. Takes ownership of another list's buffers.
+ * @param other The list to move from.
+ * @return A reference to this object.
+ */
+FrontCodedList& FrontCodedList::operator=(FrontCodedList&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        delete[] bytes; // Free the old buffers
+        delete[] block_offsets;
+
+        bytes = other.bytes; // Take ownership of the other's buffers
+        byte_count = other.byte_count;
+        block_offsets = other.block_offsets;
+        block_count = other.block_count;
+        word_count = other.word_count;
+        longest = other.longest;
+
+        other.bytes = nullptr; // The other list becomes empty
+        other.block_offsets = nullptr;
+        other.byte_count = other.block_count = other.word_count = other.longest = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Reads a varint: 7 bits per byte, least significant first, high bit set on all but the last byte.
+ * @param p The position to read from; moved past the varint.
+ * @return The decoded value.
+ */
+size_t FrontCodedList::readVarint(const unsigned char*& p) {
+    size_t value{ 0 };
+    unsigned shift{ 0 };
+    while (*p & 0x80) { // More bytes follow
+        value |= static_cast<size_t>(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    return value | (static_cast<size_t>(*p++) << shift); // The last byte
+}
+
+/**
+ * @brief Writes a varint, or only counts its bytes when out is nullptr.
+ * @param out The position to write at, advanced past the varint; may be nullptr.
+ * @param value The value to encode.
+ * @return The number of bytes of the encoding.
+ */
+size_t FrontCodedList::writeVarint(unsigned char*& out, size_t value) {
+    size_t written{ 1 };
+    while (value >= 0x80) {
+        if (out) *out++ = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+        written++;
+    }
+    if (out) *out++ = static_cast<unsigned char>(value);
+    return written;
+}
+
+/**
+ * @brief Decodes the next word of a block into the cursor's key.
+ * The key keeps the previous word, so only the suffix is copied.
+ * @param cursor The cursor to advance.
+ */
+void FrontCodedList::decodeNext(Cursor& cursor) const {
+    size_t shared = readVarint(cursor.next); // Characters kept from the previous word
+    size_t rest = readVarint(cursor.next); // Characters that follow
+    std::memcpy(cursor.key + shared, cursor.next, rest);
+    cursor.next += rest;
+    cursor.length = shared + rest;
+    cursor.key[cursor.length] = '\0';
+}
+
+/**
+ * @brief Finds the last block whose first word is not greater than the given characters.
+ * @param str The characters to search for.
+ * @param length The number of characters.
+ * @return The block index, or block_count if every block starts after the characters.
+ */
+size_t FrontCodedList::findBlock(const char* str, size_t length) const {
+    size_t low{ 0 }, high{ block_count }; // The answer + 1 lies in [low, high]
+    while (low < high) { // Find the first block that starts after str
+        size_t middle = low + (high - low) / 2;
+        const unsigned char* p = bytes + block_offsets[middle];
+        readVarint(p); // Shared prefix length, always 0 for a block's first word
+        size_t first_length = readVarint(p);
+        if (compareRange(reinterpret_cast<const char*>(p), first_length, str, length) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low == 0 ? block_count : low - 1; // The block before it, if any
+}
+
+/**
+ * @brief Returns the number of words in a block.
+ * @param block The block index.
+ * @return BLOCK_SIZE, or fewer for the last block.
+ */
+size_t FrontCodedList::wordsInBlock(size_t block) const {
+    size_t remaining = word_count - block * BLOCK_SIZE;
+    return remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+}
+
+/**
+ * @brief Replaces the contents with the words of a sorted list.
+ * A first pass measures the encoding so that both buffers are allocated at their exact size; a second pass writes it.
+ * @param sortedWords The words, in sorted order and without duplicates.
+ */
+void FrontCodedList::assign(const WordList& sortedWords) {
+    size_t count = sortedWords.length();
+    size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    const char* previous{ nullptr }; // The previous word, within the current block
+    size_t previous_length{ 0 };
+    size_t index{ 0 }; // Position of the word being encoded
+    unsigned char* out{ nullptr }; // nullptr while measuring
+    size_t total{ 0 }; // Bytes measured or written
+    size_t max_length{ 0 };
+    uint32_t* offsets{ nullptr };
+
+    auto encode = [&](const Word& word) { // Append one word
+        size_t length = word.length();
+        size_t shared{ 0 };
+        if (index % BLOCK_SIZE == 0) { // A block starts with a full word
+            if (offsets) offsets[index / BLOCK_SIZE] = static_cast<uint32_t>(total);
+        } else {
+            while (shared < length && shared < previous_length && previous[shared] == word.c_str()[shared]) shared++;
+        }
+        total += writeVarint(out, shared);
+        total += writeVarint(out, length - shared);
+        if (out) {
+            std::memcpy(out, word.c_str() + shared, length - shared);
+            out += length - shared;
+        }
+        total += length - shared;
+        if (length > max_length) max_length = length;
+        previous = word.c_str(); // The list's words stay put while it is traversed
+        previous_length = length;
+        index++;
+    };
+
+    sortedWords.forEach(encode); // Measure
+    if (total > UINT32_MAX) throw std::length_error("FrontCodedList cannot hold more than 4 GiB of encoded words"); // Offsets are 32-bit
+
+    unsigned char* new_bytes = total ? new unsigned char[total] : nullptr;
+    uint32_t* new_offsets;
+    try {
+        new_offsets = blocks ? new uint32_t[blocks] : nullptr;
+    } catch (...) { // The list keeps its old contents
+        delete[] new_bytes;
+        throw;
+    }
+    out = new_bytes;
+    offsets = new_offsets;
+    total = 0;
+    index = 0;
+    previous = nullptr;
+    previous_length = 0;
+    sortedWords.forEach(encode); // Write
+
+    delete[] bytes; // Replace the old contents
+    delete[] block_offsets;
+    bytes = new_bytes;
+    byte_count = total;
+    block_offsets = new_offsets;
+    block_count = blocks;
+    word_count = count;
+    longest = max_length;
+}
+
+/**
+ * @brief Decodes the words into a new sorted WordList.
+ * @return The words as a list.
+ */
+WordList FrontCodedList::toWordList() const {
+    WordList words;
+    forEach([&words](const Word& word) { words.push_back(word); });
+    return words;
+}
+
+/**
+ * @brief Inserts a word in sorted position by re-encoding the list. Duplicates are ignored.
+ * @param word The word to insert.
+ * @return True if the word was inserted, false if it was already present.
+ */
+bool FrontCodedList::insertSorted(const Word& word) {
+    if (lookup(word)) return false; // No duplicates
+
+    WordList words = toWordList();
+    words.insertSorted(word);
+    assign(words);
+    return true;
+}
+
+/**
+ * @brief Removes a word by re-encoding the list.
+ * @param word The word to remove.
+ * @return True if the word was found and removed, false otherwise.
+ */
+bool FrontCodedList::remove(const Word& word) {
+    if (!lookup(word)) return false; // Nothing to remove
+
+    WordList words = toWordList();
+    words.remove(word);
+    assign(words);
+    return true;
+}
+
+/**
+ * @brief Removes all words and frees the buffers.
+ */
+void FrontCodedList::clear() {
+    *this = FrontCodedList();
+}
+
+/**
+ * @brief Checks if the given word is in the list.
+ * @param word The word to look up.
+ * @return True if the word is found, false otherwise.
+ */
+bool FrontCodedList::lookup(const Word& word) const {
+    size_t block = findBlock(word.c_str(), word.length());
+    if (block == block_count) return false; // Less than every word
+
+    char small[128]; // Decoding buffer for typical words
+    char* key = longest < sizeof small ? small : new char[longest + 1];
+    Cursor cursor{ bytes + block_offsets[block], key, 0 };
+
+    bool found{ false };
+    for (size_t i = 0, n = wordsInBlock(block); i < n; ++i) { // The word can only be in this block
+        decodeNext(cursor);
+        int cmp = compareRange(cursor.key, cursor.length, word.c_str(), word.length());
+        if (cmp >= 0) { // Reached or passed the word
+            found = cmp == 0;
+            break;
+        }
+    }
+
+    if (key != small) delete[] key;
+    return found;
+}
+
+/**
+ * @brief Looks up a batch of words, each with its own binary search.
+ * @param words The words to look up.
+ * @param count The number of words.
+ * @param found Array of count elements; found[i] is set to whether words[i] is in the list.
+ */
+void FrontCodedList::lookupMany(const Word* words, size_t count, bool* found) const {
+    for (size_t i = 0; i < count; ++i) found[i] = lookup(words[i]);
+}
+
+/**
+ * @brief Returns a copy of the word at the given index.
+ * @param index The index of the word, in sorted order.
+ * @return A copy of the word.
+ * @throws std::runtime_error if the index is out of range.
+ */
+Word FrontCodedList::fetchWord(size_t index) const {
+    if (index >= word_count) throw std::runtime_error("Index out of range");
+
+    std::unique_ptr<char[]> buffer(new char[longest + 1]); // Freed even if a word cannot be copied
+    char* key = buffer.get();
+    Cursor cursor{ bytes + block_offsets[index / BLOCK_SIZE], key, 0 };
+    for (size_t i = 0; i <= index % BLOCK_SIZE; ++i) decodeNext(cursor); // Decode up to the word
+    Word word(key);
+    return word;
+}
+
+/**
+ * @brief Returns the words at positions [offset, offset + limit), in sorted order.
+ * @param offset The position of the first word.
+ * @param limit The maximum number of words.
+ * @return The words of the page; empty when offset is past the end.
+ */
+WordList FrontCodedList::page(size_t offset, size_t limit) const {
+    WordList words;
+    if (offset >= word_count || limit == 0) return words;
+
+    std::unique_ptr<char[]> buffer(new char[longest + 1]); // Freed even if a word cannot be copied
+    char* key = buffer.get();
+    size_t skip = offset % BLOCK_SIZE; // Words of the first block before the page
+    for (size_t block = offset / BLOCK_SIZE; block < block_count && limit > 0; ++block) {
+        Cursor cursor{ bytes + block_offsets[block], key, 0 };
+        for (size_t i = 0, count = wordsInBlock(block); i < count && limit > 0; ++i) {
+            decodeNext(cursor); // Every word is decoded, since each depends on the previous one
+            if (skip > 0) {
+                skip--;
+                continue;
+            }
+            words.push_back(Word(cursor.key));
+            limit--;
+        }
+    }
+    return words;
+}
+
+/**
+ * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+ * @param from Where to start; it need not be in the list.
+ * @param limit The maximum number of words.
+ * @return The words of the page.
+ */
+WordList FrontCodedList::range(const Word& from, size_t limit) const {
+    return page(rank(from), limit);
+}
+
+/**
+ * @brief Counts the words less than a given word.
+ * The block that can hold the word is found by binary search and decoded up to the word.
+ * @param word The word to rank; it need not be in the list.
+ * @return The number of words that sort before it.
+ */
+size_t FrontCodedList::rank(const Word& word) const {
+    size_t block = findBlock(word.c_str(), word.length());
+    if (block == block_count) return 0; // Less than every word
+
+    char* key = new char[longest + 1];
+    Cursor cursor{ bytes + block_offsets[block], key, 0 };
+    size_t position = block * BLOCK_SIZE;
+    for (size_t i = 0, count = wordsInBlock(block); i < count; ++i, ++position) {
+        decodeNext(cursor);
+        if (compareRange(cursor.key, cursor.length, word.c_str(), word.length()) >= 0) break; // Reached or passed the word
+    }
+    delete[] key;
+    return position;
+}
+
+/**
+ * @brief Returns the words starting with the given letter.
+ * The block that can hold the first of them is found by binary search; decoding stops at the first word past them.
+ * @param letter The initial letter of the words to return.
+ * @return A sorted list of the matching words.
+ */
+WordList FrontCodedList::wordsStartingWith(const char letter) const {
+    WordList matches;
+    if (word_count == 0) return matches;
+
+    size_t block = findBlock(&letter, 1); // The last block starting at or before "letter"
+    if (block == block_count) block = 0; // Every word is greater: start from the beginning
+
+    std::unique_ptr<char[]> buffer(new char[longest + 1]); // Freed even if a word cannot be copied
+    char* key = buffer.get();
+    for (; block < block_count; ++block) {
+        Cursor cursor{ bytes + block_offsets[block], key, 0 };
+        for (size_t i = 0, n = wordsInBlock(block); i < n; ++i) {
+            decodeNext(cursor);
+            if (cursor.length == 0) continue; // An empty word starts with nothing
+            unsigned char first = static_cast<unsigned char>(cursor.key[0]);
+            if (first > static_cast<unsigned char>(letter)) { // Past the matching words
+                return matches;
+            }
+            if (first == static_cast<unsigned char>(letter)) matches.push_back(Word(cursor.key));
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief Calls a function on every word, in sorted order.
+ * @param visit The function to call with each word.
+ */
+void FrontCodedList::forEach(const std::function<void(const Word&)>& visit) const {
+    std::unique_ptr<char[]> buffer(new char[longest + 1]); // Freed even if a word cannot be copied or the visitor throws
+    char* key = buffer.get();
+    for (size_t block = 0; block < block_count; ++block) {
+        Cursor cursor{ bytes + block_offsets[block], key, 0 };
+        for (size_t i = 0, n = wordsInBlock(block); i < n; ++i) {
+            decodeNext(cursor);
+            visit(Word(cursor.key));
+        }
+    }
+}
+
+/**
+ * @brief Prints the words with a maximum of n words per line, in the same layout as WordList::print.
+ * @param sout The output stream to print to.
+ * @param n The maximum number of words per line.
+ * @return The total number of words printed.
+ */
+int FrontCodedList::print(std::ostream& sout, const int n) const {
+    WordFormatter formatter(sout, n);
+    std::unique_ptr<char[]> buffer(new char[longest + 1]); // Freed even if the stream throws
+    char* key = buffer.get();
+    for (size_t block = 0; block < block_count; ++block) {
+        Cursor cursor{ bytes + block_offsets[block], key, 0 };
+        for (size_t i = 0, count = wordsInBlock(block); i < count; ++i) {
+            decodeNext(cursor);
+            formatter.put(cursor.key, cursor.length); // Straight from the decoding buffer
+        }
+    }
+    return formatter.finish();
+}
+
+/**
+ * @brief Returns the memory allocated by the blocks and the block index.
+ * @return The allocated size in bytes.
+ */
+size_t FrontCodedList::memoryBytes() const {
+    return byte_count + block_count * sizeof(uint32_t);
+}
+
+/**
+ * @brief Writes the list in binary form: counts, block index and blocks.
+ * @param out The binary output stream to write to.
+ */
+void FrontCodedList::write(std::ostream& out) const {
+    uint64_t header[4] = { word_count, block_count, byte_count, longest };
+    out.write(reinterpret_cast<const char*>(header), sizeof header);
+    out.write(reinterpret_cast<const char*>(block_offsets), static_cast<std::streamsize>(block_count * sizeof(uint32_t)));
+    out.write(reinterpret_cast<const char*>(bytes), static_cast<std::streamsize>(byte_count));
+}
+
+/**
+ * @brief Replaces the contents with a list written by write().
+ * The header is checked against the bytes left in the stream before anything is allocated, and every block
+ * offset is checked against the size of the blocks, so a damaged file cannot make lookups read out of bounds
+ * or allocate more than the file holds. The stream must be seekable, to tell how many bytes are left.
+ * @param in The binary input stream to read from.
+ * @return False if the stream ended early or the data is inconsistent, in which case the list is left empty.
+ */
+bool FrontCodedList::read(std::istream& in) {
+    clear();
+
+    uint64_t header[4];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof header)) return false;
+    uint64_t words = header[0], blocks = header[1], size = header[2], max_length = header[3];
+    if (blocks != (words + BLOCK_SIZE - 1) / BLOCK_SIZE || size > UINT32_MAX || (words != 0 && size == 0)) return false;
+    if (max_length > size) return false; // Every character of a word is stored in some entry's bytes
+
+    std::streampos here = in.tellg(); // How much is left decides what the header may claim
+    if (here == std::streampos(-1) || !in.seekg(0, std::ios::end)) return false;
+    uint64_t left = static_cast<uint64_t>(in.tellg() - here);
+    if (!in.seekg(here)) return false;
+    if (blocks > left / sizeof(uint32_t) || blocks * sizeof(uint32_t) + size > left) return false; // Claims more than the file holds
+
+    FrontCodedList loaded; // Filled completely before it replaces this list
+    loaded.block_offsets = blocks ? new uint32_t[blocks] : nullptr;
+    loaded.bytes = size ? new unsigned char[size] : nullptr;
+    loaded.block_count = static_cast<size_t>(blocks);
+    loaded.byte_count = static_cast<size_t>(size);
+    loaded.word_count = static_cast<size_t>(words);
+    loaded.longest = static_cast<size_t>(max_length); // Bounds the entries; replaced by the true longest below
+    size_t longest_seen{ 0 };
+
+    if (!in.read(reinterpret_cast<char*>(loaded.block_offsets), static_cast<std::streamsize>(blocks * sizeof(uint32_t))) ||
+        !in.read(reinterpret_cast<char*>(loaded.bytes), static_cast<std::streamsize>(size))) {
+        return false; // Truncated
+    }
+    for (size_t i = 0; i < loaded.block_count; ++i) { // Walk every entry with bounds checks
+        size_t begin = loaded.block_offsets[i];
+        size_t end = i + 1 < loaded.block_count ? loaded.block_offsets[i + 1] : loaded.byte_count;
+        if (begin >= end || end > loaded.byte_count) return false; // Offsets must be increasing and inside the blocks
+
+        size_t position = begin;
+        size_t previous_length{ 0 };
+        auto readChecked = [&](size_t& value) { // A varint that must end inside the block
+            value = 0;
+            for (unsigned shift = 0; position < end && shift < 64; shift += 7) {
+                unsigned char byte = loaded.bytes[position++];
+                value |= static_cast<size_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) return true;
+            }
+            return false;
+        };
+        for (size_t k = 0, n = loaded.wordsInBlock(i); k < n; ++k) {
+            size_t shared, rest;
+            if (!readChecked(shared) || !readChecked(rest)) return false;
+            if ((k == 0 && shared != 0) || shared > previous_length || rest > end - position || shared + rest > loaded.longest) {
+                return false; // The entry does not fit what precedes it or the decoding buffers
+            }
+            position += rest;
+            previous_length = shared + rest;
+            if (previous_length > longest_seen) longest_seen = previous_length;
+        }
+        if (position != end) return false; // Stray bytes between blocks
+    }
+    loaded.longest = longest_seen; // Decoding buffers are sized by what the words need, not by what the header said
+
+    *this = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,251 @@
+// FrontCodedList.h
+#ifndef FRONTCODEDLIST_H_
+#define FRONTCODEDLIST_H_
+
+#include "Word.h"
+#include "WordList.h"
+#include <cstdint>
+#include <functional>
+#include <iostream>
+
+/**
+ * @class FrontCodedList
+ * @brief A sorted set of words compressed with front coding, searchable without decompressing it.
+ *
+ * The words are grouped in blocks of BLOCK_SIZE. Each word is stored as the length of the prefix it shares
+ * with the previous word, the length of the rest, and the rest itself; the two lengths are varints, so
+ * they usually take one byte each. The first word of every block shares nothing and is therefore stored
+ * in full, and a block index records where each block starts. A lookup binary-searches the blocks by
+ * their first words, which are read in place, and then decodes at most one block.
+ *
+ * Mutations re-encode the whole list, so the structure suits categories that are read far more often
+ * than they are changed.
+ */
+class FrontCodedList {
+private:
+    static constexpr size_t BLOCK_SIZE = 16; ///< Words per block; the first one of each is stored in full
+
+    unsigned char* bytes; ///< The encoded blocks, back to back
+    size_t byte_count; ///< Size of bytes
+    uint32_t* block_offsets; ///< Position in bytes of the start of each block
+    size_t block_count; ///< Number of blocks
+    size_t word_count; ///< Number of words
+    size_t longest; ///< Length of the longest word, to size decoding buffers
+
+    /**
+     * @brief Decoding state while walking the words of one block.
+     */
+    struct Cursor {
+        const unsigned char* next; ///< The next encoded word
+        char* key; ///< The current word, '\0'-terminated; must have room for longest + 1 characters
+        size_t length; ///< Length of the current word
+    };
+
+    /**
+     * @brief Reads a varint and advances past it.
+     * @param p The position to read from; moved past the varint
+     * @return The decoded value
+     */
+    static size_t readVarint(const unsigned char*& p);
+
+    /**
+     * @brief Writes a varint, or only counts its bytes when out is nullptr.
+     * @param out The position to write at, advanced past the varint; may be nullptr
+     * @param value The value to encode
+     * @return The number of bytes of the encoding
+     */
+    static size_t writeVarint(unsigned char*& out, size_t value);
+
+    /**
+     * @brief Decodes the next word of a block into the cursor's key.
+     * @param cursor The cursor to advance
+     */
+    void decodeNext(Cursor& cursor) const;
+
+    /**
+     * @brief Finds the last block whose first word is not greater than the given characters.
+     * Only the first words are read, and they are stored in full, so nothing is decoded.
+     * @param str The characters to search for
+     * @param length The number of characters
+     * @return The block index, or block_count if every block starts after the characters
+     */
+    size_t findBlock(const char* str, size_t length) const;
+
+    /**
+     * @brief Returns the number of words in a block.
+     * @param block The block index
+     * @return BLOCK_SIZE, or fewer for the last block
+     */
+    size_t wordsInBlock(size_t block) const;
+
+public:
+    /**
+     * @brief Default constructor. Initializes an empty list.
+     */
+    FrontCodedList();
+
+    /**
+     * @brief Destructor. Deallocates the blocks and the block index.
+     */
+    ~FrontCodedList();
+
+    /**
+     * @brief Copy constructor. Copies the encoded blocks of another list.
+     * @param other The list to copy
+     */
+    FrontCodedList(const FrontCodedList& other);
+
+    /**
+     * @brief Copy assignment operator. Copies the encoded blocks of another list.
+     * @param other The list to copy
+     * @return A reference to this object
+     */
+    FrontCodedList& operator=(const FrontCodedList& other);
+
+    /**
+     * @brief Move constructor. Takes ownership of another list's buffers.
+     * @param other The list to move from
+     */
+    FrontCodedList(FrontCodedList&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator. Takes ownership of another list's buffers.
+     * @param other The list to move from
+     * @return A reference to this object
+     */
+    FrontCodedList& operator=(FrontCodedList&& other) noexcept;
+
+    /**
+     * @brief Replaces the contents with the words of a sorted list. Both buffers are sized exactly once.
+     * @param sortedWords The words, in sorted order and without duplicates
+     */
+    void assign(const WordList& sortedWords);
+
+    /**
+     * @brief Decodes the words into a new sorted WordList.
+     * @return The words as a list
+     */
+    WordList toWordList() const;
+
+    /**
+     * @brief Inserts a word in sorted position by re-encoding the list. Duplicates are ignored.
+     * @param word The word to insert
+     * @return true if the word was inserted, false if it was already present
+     */
+    bool insertSorted(const Word& word);
+
+    /**
+     * @brief Removes a word by re-encoding the list.
+     * @param word The word to remove
+     * @return true if the word was found and removed, false otherwise
+     */
+    bool remove(const Word& word);
+
+    /**
+     * @brief Removes all words and frees the buffers.
+     */
+    void clear();
+
+    /**
+     * @brief Checks if the given word is in the list: a binary search over the blocks, then one block decoded.
+     * @param word The word to look up
+     * @return true if the word is found, false otherwise
+     */
+    bool lookup(const Word& word) const;
+
+    /**
+     * @brief Looks up a batch of words.
+     * @param words The words to look up
+     * @param count The number of words
+     * @param found Array of count elements; found[i] is set to whether words[i] is in the list
+     */
+    void lookupMany(const Word* words, size_t count, bool* found) const;
+
+    /**
+     * @brief Returns a copy of the word at the given index. Decodes at most one block.
+     * @param index The index of the word, in sorted order
+     * @return A copy of the word
+     * @throws std::runtime_error if the index is out of range.
+     */
+    Word fetchWord(size_t index) const;
+
+    /**
+     * @brief Returns the words at positions [offset, offset + limit), in sorted order.
+     * Decoding starts at the block holding the offset, so a page costs at most BLOCK_SIZE words more than it holds.
+     * @param offset The position of the first word
+     * @param limit The maximum number of words
+     * @return The words of the page; empty when offset is past the end
+     */
+    WordList page(size_t offset, size_t limit) const;
+
+    /**
+     * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+     * @param from Where to start, found by binary search over the blocks; it need not be in the list
+     * @param limit The maximum number of words
+     * @return The words of the page
+     */
+    WordList range(const Word& from, size_t limit) const;
+
+    /**
+     * @brief Counts the words less than a given word. Decodes at most one block.
+     * @param word The word to rank; it need not be in the list
+     * @return The number of words that sort before it
+     */
+    size_t rank(const Word& word) const;
+
+    /**
+     * @brief Determines whether the list is empty.
+     * @return True if the list has no words, false otherwise
+     */
+    inline bool isEmpty() const { return word_count == 0; }
+
+    /**
+     * @brief Returns the number of words.
+     * @return The number of words
+     */
+    inline size_t length() const { return word_count; }
+
+    /**
+     * @brief Returns the words starting with the given letter. The first block is found by binary search.
+     * @param letter The initial letter of the words to return
+     * @return A sorted list of the matching words
+     */
+    WordList wordsStartingWith(const char letter) const;
+
+    /**
+     * @brief Calls a function on every word, in sorted order.
+     * @param visit The function to call with each word
+     */
+    void forEach(const std::function<void(const Word&)>& visit) const;
+
+    /**
+     * @brief Prints the words with a maximum of n words per line, in the same layout as WordList::print.
+     * @param sout The output stream to print to
+     * @param n The maximum number of words per line, or WordFormatter::FIT_TERMINAL to fit the terminal width
+     * @return The total number of words printed
+     */
+    int print(std::ostream& sout, const int n = 5) const;
+
+    /**
+     * @brief Returns the memory allocated by the blocks and the block index.
+     * @return The allocated size in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Writes the list in binary form: counts, block index and blocks, as stored in memory.
+     * Integers are written in the machine's byte order.
+     * @param out The binary output stream to write to
+     */
+    void write(std::ostream& out) const;
+
+    /**
+     * @brief Replaces the contents with a list written by write(). The blocks are read as they are, without re-encoding.
+     * Nothing is allocated beyond what the rest of the stream can hold.
+     * @param in The binary input stream to read from; it must be seekable
+     * @return false if the stream ended early or the data is inconsistent, in which case the list is left empty
+     */
+    bool read(std::istream& in);
+};
+
+#endif // FRONTCODEDLIST_H_
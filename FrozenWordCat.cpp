@@ -0,0 +1,555 @@
+// FrozenWordCat.cpp
+#include "FrozenWordCat.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FROZENWORDCAT_MMAP 1
+#endif
+
+constexpr char FrozenWordCat::FROZEN_MAGIC[8];
+
+/**
+ * @brief A state of the automaton while it is being built.
+ */
+struct BuildState {
+    bool final = false; ///< The state ends a word
+    std::vector<std::pair<unsigned char, uint32_t>> edges; ///< Outgoing transitions, in label order
+};
+
+/**
+ * @brief Encodes what makes a built state equivalent to another: its finality and its transitions.
+ * Two states with the same signature accept the same words, because their targets are already unique.
+ * @param state The state to encode.
+ * @return The signature.
+ */
+static std::string signatureOf(const BuildState& state) {
+    std::string signature(1, state.final ? '\1' : '\0');
+    for (const auto& edge : state.edges) {
+        signature.push_back(static_cast<char>(edge.first));
+        signature.append(reinterpret_cast<const char*>(&edge.second), sizeof edge.second);
+    }
+    return signature;
+}
+
+/**
+ * @brief Default constructor. Initializes an empty category.
+ */
+FrozenWordCat::FrozenWordCat() :
+    owned{ nullptr }, mapping{ nullptr }, block_size{ 0 },
+    states{ nullptr }, targets{ nullptr }, labels{ nullptr }, state_count{ 0 }, word_count{ 0 } {
+    build(Word(), nullptr);
+}
+
+/**
+ * @brief Constructor. Freezes the words of a category into a minimal automaton.
+ * @param source The category to freeze.
+ */
+FrozenWordCat::FrozenWordCat(const WordCat& source) :
+    owned{ nullptr }, mapping{ nullptr }, block_size{ 0 },
+    states{ nullptr }, targets{ nullptr }, labels{ nullptr }, state_count{ 0 }, word_count{ 0 } {
+    build(source.getCategoryName(), &source);
+}
+
+/**
+ * @brief Destructor. Frees or unmaps the block.
+ */
+FrozenWordCat::~FrozenWordCat() {
+    release();
+}
+
+/**
+ * @brief Copy constructor. The copy holds its own block in memory, even if the original is mapped.
+ * @param other The category to copy.
+ */
+FrozenWordCat::FrozenWordCat(const FrozenWordCat& other) :
+    category(other.category), owned{ nullptr }, mapping{ nullptr }, block_size{ 0 },
+    states{ nullptr }, targets{ nullptr }, labels{ nullptr }, state_count{ 0 }, word_count{ 0 } {
+    if (other.block_size == 0) return; // The other category was moved from
+    owned = new char[other.block_size];
+    std::memcpy(owned, other.owned ? other.owned : static_cast<const char*>(other.mapping), other.block_size);
+    block_size = other.block_size;
+    attach(owned, block_size); // Already validated
+}
+
+/**
+ * @brief Copy assignment operator. Copies the block of another category into memory.
+ * @param other The category to copy.
+ * @return A reference to this object.
+ */
+FrozenWordCat& FrozenWordCat::operator=(const FrozenWordCat& other) {
+    if (this != &other) { // Avoid self-assignment
+        FrozenWordCat copy(other); // Copy first so that this object is unchanged if allocation fails
+        *this = std::move(copy); // Take ownership of the copy
+    }
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Takes over the block of another category.
+ * @param other The category to move from.
+ */
+FrozenWordCat::FrozenWordCat(FrozenWordCat&& other) noexcept :
+    category(std::move(other.category)), owned{ other.owned }, mapping{ other.mapping }, block_size{ other.block_size },
+    states{ other.states }, targets{ other.targets }, labels{ other.labels },
+    state_count{ other.state_count }, word_count{ other.word_count } {
+    other.owned = nullptr; // The other category becomes empty; the views stay valid because the block does not move
+    other.mapping = nullptr;
+    other.block_size = 0;
+    other.release();
+}
+
+/**
+ * @brief Move assignment operator. Takes over the block of another category.
+ * @param other The category to move from.
+ * @return A reference to this object.
+ */
+FrozenWordCat& FrozenWordCat::operator=(FrozenWordCat&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        release(); // Free the old block
+        category = std::move(other.category);
+        owned = other.owned;
+        mapping = other.mapping;
+        block_size = other.block_size;
+        states = other.states;
+        targets = other.targets;
+        labels = other.labels;
+        state_count = other.state_count;
+        word_count = other.word_count;
+        other.owned = nullptr; // The other category becomes empty
+        other.mapping = nullptr;
+        other.block_size = 0;
+        other.release();
+    }
+    return *this;
+}
+
+/**
+ * @brief Builds the minimal automaton of a category's words into a new owned block.
+ *
+ * The words arrive in sorted order, so the automaton can be minimized as it grows (Daciuk et al.):
+ * only the states on the path of the previous word can still change, and as soon as the next word
+ * leaves that path, the states below the divergence point are final. Each of them is then replaced by
+ * an equivalent state seen before, looked up by signature, or registered as a new one. The freed
+ * states are reused, so building needs memory for the minimal automaton plus one word, not for a trie.
+ *
+ * @param name The category name to store in the block.
+ * @param source The category whose words to freeze, or nullptr for none.
+ * @throws std::runtime_error if the category does not visit its words in strictly ascending order.
+ */
+void FrozenWordCat::build(const Word& name, const WordCat* source) {
+    std::vector<BuildState> nodes(1); // State 0 is the start state
+    std::vector<uint32_t> free_ids; // States replaced by an equivalent one
+    std::unordered_map<std::string, uint32_t> registry; // Signature of every finished state
+    std::vector<uint32_t> path(1, 0); // path[i] is the state reached by the first i characters of the previous word
+    std::string previous; // The previous word
+    uint32_t words = 0;
+
+    auto minimize = [&](size_t down_to) { // Finish the states on the path deeper than down_to characters
+        while (path.size() - 1 > down_to) {
+            uint32_t child = path.back();
+            path.pop_back();
+            std::string signature = signatureOf(nodes[child]);
+            auto found = registry.find(signature);
+            if (found != registry.end()) { // An equivalent state exists; use it instead
+                nodes[path.back()].edges.back().second = found->second;
+                nodes[child] = BuildState();
+                free_ids.push_back(child);
+            } else {
+                registry.emplace(std::move(signature), child);
+            }
+        }
+    };
+
+    if (source) source->forEachWord([&](const Word& word) {
+        const char* str = word.c_str();
+        size_t length = word.length();
+        int cmp = std::strcmp(previous.c_str(), str);
+        if (words > 0 && cmp == 0) return; // Duplicate
+        if (words > 0 && cmp > 0) throw std::runtime_error("Words are not in sorted order");
+
+        size_t common = 0; // Length of the prefix shared with the previous word
+        while (common < length && common < previous.size() && previous[common] == str[common]) common++;
+        minimize(common); // The rest of the previous word's path can no longer change
+
+        for (size_t i = common; i < length; i++) { // Add the new suffix
+            uint32_t id;
+            if (!free_ids.empty()) {
+                id = free_ids.back();
+                free_ids.pop_back();
+            } else {
+                id = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            nodes[path.back()].edges.emplace_back(static_cast<unsigned char>(str[i]), id);
+            path.push_back(id);
+        }
+        nodes[path.back()].final = true;
+        previous.assign(str, length);
+        words++;
+    });
+    minimize(0);
+
+    // Number the reachable states in reverse postorder, so that every transition leads to a higher number
+    std::vector<uint32_t> number(nodes.size(), UINT32_MAX); // New number of each built state
+    std::vector<uint32_t> postorder; // Built states, each after all of its targets
+    std::vector<std::pair<uint32_t, size_t>> stack(1, { 0, 0 }); // (state, next edge to explore)
+    number[0] = 0; // Marks the state as visited
+    size_t transition_count = 0;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const BuildState& state = nodes[top.first];
+        if (top.second < state.edges.size()) {
+            uint32_t target = state.edges[top.second++].second;
+            if (number[target] == UINT32_MAX) {
+                number[target] = 0;
+                stack.emplace_back(target, 0);
+            }
+        } else {
+            postorder.push_back(top.first);
+            transition_count += state.edges.size();
+            stack.pop_back();
+        }
+    }
+    uint32_t count = static_cast<uint32_t>(postorder.size());
+    for (uint32_t i = 0; i < count; i++) number[postorder[i]] = count - 1 - i;
+
+    // Lay out the block: header, states, targets, labels, name
+    size_t size = sizeof(Header) + count * sizeof(State) + transition_count * (sizeof(uint32_t) + 1) + name.length();
+    char* block = new char[size];
+    Header* header = reinterpret_cast<Header*>(block);
+    State* out_states = reinterpret_cast<State*>(block + sizeof(Header));
+    uint32_t* out_targets = reinterpret_cast<uint32_t*>(out_states + count);
+    unsigned char* out_labels = reinterpret_cast<unsigned char*>(out_targets + transition_count);
+    std::memcpy(header->magic, FROZEN_MAGIC, sizeof header->magic);
+    header->state_count = count;
+    header->transition_count = static_cast<uint32_t>(transition_count);
+    header->word_count = words;
+    header->name_length = static_cast<uint32_t>(name.length());
+    header->reserved = 0;
+    std::memcpy(out_labels + transition_count, name.c_str(), name.length());
+
+    uint32_t next_transition = 0;
+    for (uint32_t i = 0; i < count; i++) { // In new-number order, so each state's transitions are consecutive
+        const BuildState& state = nodes[postorder[count - 1 - i]];
+        out_states[i].first = next_transition;
+        out_states[i].count_final = static_cast<uint32_t>(state.edges.size() * 2 + (state.final ? 1 : 0));
+        for (const auto& edge : state.edges) {
+            out_labels[next_transition] = edge.first;
+            out_targets[next_transition] = number[edge.second];
+            next_transition++;
+        }
+    }
+    for (uint32_t i = count; i-- > 0;) { // Targets first, so their word counts are known
+        uint32_t below = out_states[i].count_final & 1;
+        for (uint32_t t = out_states[i].first; t < out_states[i].first + (out_states[i].count_final >> 1); t++)
+            below += out_states[out_targets[t]].words;
+        out_states[i].words = below;
+    }
+
+    release();
+    owned = block;
+    block_size = size;
+    attach(owned, block_size);
+}
+
+/**
+ * @brief Points the views at a block and checks that it is a well-formed, acyclic automaton.
+ * Every transition must lead to a higher-numbered state, which rules out cycles, and every state's
+ * word count must match its targets, so that rank() and fetchWord() cannot be led astray.
+ * @param block The block.
+ * @param size Its size in bytes.
+ * @return false if the block is malformed, in which case nothing is changed.
+ */
+bool FrozenWordCat::attach(const char* block, size_t size) {
+    if (size < sizeof(Header)) return false;
+    const Header* header = reinterpret_cast<const Header*>(block);
+    if (std::memcmp(header->magic, FROZEN_MAGIC, sizeof header->magic) != 0) return false;
+    uint64_t expected = sizeof(Header) + uint64_t(header->state_count) * sizeof(State) +
+        uint64_t(header->transition_count) * (sizeof(uint32_t) + 1) + header->name_length;
+    if (header->state_count == 0 || expected != size) return false;
+
+    const State* block_states = reinterpret_cast<const State*>(block + sizeof(Header));
+    const uint32_t* block_targets = reinterpret_cast<const uint32_t*>(block_states + header->state_count);
+    const unsigned char* block_labels = reinterpret_cast<const unsigned char*>(block_targets + header->transition_count);
+    for (uint32_t i = header->state_count; i-- > 0;) {
+        const State& state = block_states[i];
+        uint64_t end = uint64_t(state.first) + (state.count_final >> 1);
+        if (end > header->transition_count) return false;
+        uint64_t below = state.count_final & 1;
+        for (uint32_t t = state.first; t < end; t++) {
+            if (block_targets[t] <= i || block_targets[t] >= header->state_count) return false; // Backward or out of range
+            if (t > state.first && block_labels[t] <= block_labels[t - 1]) return false; // Labels must ascend
+            below += block_states[block_targets[t]].words;
+        }
+        if (below != state.words) return false;
+    }
+    if (block_states[0].words != header->word_count) return false;
+
+    states = block_states;
+    targets = block_targets;
+    labels = block_labels;
+    state_count = header->state_count;
+    word_count = header->word_count;
+    category = Word(std::string(reinterpret_cast<const char*>(block_labels + header->transition_count),
+        header->name_length).c_str());
+    return true;
+}
+
+/**
+ * @brief Frees the owned block or unmaps the mapped one and resets to an empty category.
+ */
+void FrozenWordCat::release() {
+    delete[] owned;
+#ifdef FROZENWORDCAT_MMAP
+    if (mapping) munmap(mapping, block_size);
+#endif
+    owned = nullptr;
+    mapping = nullptr;
+    block_size = 0;
+    states = nullptr;
+    targets = nullptr;
+    labels = nullptr;
+    state_count = 0;
+    word_count = 0;
+}
+
+/**
+ * @brief Follows the transition of a state on a character, by binary search over its labels.
+ * @param state The state.
+ * @param c The character.
+ * @return The target state, or state_count if there is no such transition.
+ */
+uint32_t FrozenWordCat::step(uint32_t state, unsigned char c) const {
+    uint32_t low = states[state].first;
+    uint32_t high = low + (states[state].count_final >> 1);
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (labels[mid] < c) low = mid + 1;
+        else high = mid;
+    }
+    return low < states[state].first + (states[state].count_final >> 1) && labels[low] == c ? targets[low] : state_count;
+}
+
+/**
+ * @brief Visits every word accepted from a state, in sorted order.
+ * @param state The state to start from.
+ * @param prefix The characters leading to the state; extended and restored while visiting.
+ * @param visit The function to call with each word.
+ */
+void FrozenWordCat::enumerate(uint32_t state, std::string& prefix, const std::function<void(const Word&)>& visit) const {
+    if (states[state].count_final & 1) visit(Word(prefix.c_str())); // A word ends here; it precedes its extensions
+    uint32_t end = states[state].first + (states[state].count_final >> 1);
+    for (uint32_t t = states[state].first; t < end; t++) {
+        prefix.push_back(static_cast<char>(labels[t]));
+        enumerate(targets[t], prefix, visit);
+        prefix.pop_back();
+    }
+}
+
+/**
+ * @brief Returns the name of the category.
+ * @return The category name.
+ */
+const Word& FrozenWordCat::getCategoryName() const {
+    return category;
+}
+
+/**
+ * @brief Checks if the given word is in the category. Costs one transition search per character.
+ * @param word The word to look up.
+ * @return true if the word is found, false otherwise.
+ */
+bool FrozenWordCat::lookup(const Word& word) const {
+    if (state_count == 0) return false;
+    const char* str = word.c_str();
+    uint32_t state = 0;
+    for (size_t i = 0; i < word.length(); i++) {
+        state = step(state, static_cast<unsigned char>(str[i]));
+        if (state == state_count) return false; // No word continues this way
+    }
+    return (states[state].count_final & 1) != 0;
+}
+
+/**
+ * @brief Counts the words less than the given word. For a word in the category, this is its ordinal.
+ * Walking the word, every word that ends on the way (a proper prefix) and every word under a smaller
+ * label is counted, using the word counts stored in the states.
+ * @param word The word to rank; it need not be in the category.
+ * @return The number of words that sort before it.
+ */
+size_t FrozenWordCat::rank(const Word& word) const {
+    if (state_count == 0) return 0;
+    const unsigned char* str = reinterpret_cast<const unsigned char*>(word.c_str());
+    size_t before = 0;
+    uint32_t state = 0;
+    for (size_t i = 0; i < word.length(); i++) {
+        before += states[state].count_final & 1; // The prefix read so far is a smaller word
+        uint32_t end = states[state].first + (states[state].count_final >> 1);
+        uint32_t next = state_count;
+        for (uint32_t t = states[state].first; t < end && labels[t] <= str[i]; t++) {
+            if (labels[t] == str[i]) next = targets[t];
+            else before += states[targets[t]].words;
+        }
+        if (next == state_count) return before; // Every word below this point sorts before the word
+        state = next;
+    }
+    return before;
+}
+
+/**
+ * @brief Returns the word with the given ordinal. Costs one transition scan per character.
+ * @param index The index of the word, in sorted order.
+ * @return The word.
+ * @throws std::runtime_error if the index is out of range.
+ */
+Word FrozenWordCat::fetchWord(size_t index) const {
+    if (index >= word_count) throw std::runtime_error("Index out of range");
+    std::string word;
+    uint32_t state = 0;
+    while (true) {
+        if (states[state].count_final & 1) { // The word read so far comes first
+            if (index == 0) return Word(word.c_str());
+            index--;
+        }
+        uint32_t end = states[state].first + (states[state].count_final >> 1);
+        for (uint32_t t = states[state].first; t < end; t++) { // Skip whole subtrees until the index falls in one
+            if (index < states[targets[t]].words) {
+                word.push_back(static_cast<char>(labels[t]));
+                state = targets[t];
+                break;
+            }
+            index -= states[targets[t]].words;
+        }
+    }
+}
+
+/**
+ * @brief Returns the words that start with a prefix, in sorted order.
+ * @param prefix The prefix; "" returns every word.
+ * @return A sorted list of the matching words.
+ */
+WordList FrozenWordCat::wordsWithPrefix(const char* prefix) const {
+    WordList result;
+    if (state_count == 0) return result;
+    uint32_t state = 0;
+    for (const char* p = prefix; *p; p++) {
+        state = step(state, static_cast<unsigned char>(*p));
+        if (state == state_count) return result; // No word has this prefix
+    }
+    std::string path(prefix);
+    enumerate(state, path, [&result](const Word& word) { result.push_back(Word(word)); });
+    return result;
+}
+
+/**
+ * @brief Returns the words starting with the given letter.
+ * @param letter The initial letter of the words to return.
+ * @return A sorted list of the matching words.
+ */
+WordList FrozenWordCat::wordsStartingWith(const char letter) const {
+    const char prefix[2] = { letter, '\0' };
+    return wordsWithPrefix(prefix);
+}
+
+/**
+ * @brief Calls a function on every word, in sorted order.
+ * @param visit The function to call with each word.
+ */
+void FrozenWordCat::forEach(const std::function<void(const Word&)>& visit) const {
+    if (state_count == 0) return;
+    std::string path;
+    enumerate(0, path, visit);
+}
+
+/**
+ * @brief Returns the size of the automaton block.
+ * @return The size in bytes.
+ */
+size_t FrozenWordCat::memoryBytes() const {
+    return block_size;
+}
+
+/**
+ * @brief Writes the block to a file. Integers are written in the machine's byte order.
+ * @param filename The path to the file to write.
+ * @return false if the file could not be written.
+ */
+bool FrozenWordCat::save(const char* filename) const {
+    if (block_size == 0) {
+        std::cerr << "Nothing to save" << std::endl;
+        return false;
+    }
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    file.write(owned ? owned : static_cast<const char*>(mapping), static_cast<std::streamsize>(block_size));
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Replaces the contents with a block saved by save(), mapping the file where possible.
+ * @param filename The path to the file to open.
+ * @return false if the file could not be read or is not a valid frozen category, in which case nothing changes.
+ */
+bool FrozenWordCat::open(const char* filename) {
+    FrozenWordCat opened; // Built aside, so that this object is unchanged on failure
+    opened.release();
+#ifdef FROZENWORDCAT_MMAP
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        std::cerr << "Invalid frozen category file: " << filename << std::endl;
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error mapping file: " << filename << std::endl;
+        return false;
+    }
+    opened.mapping = mapped;
+    opened.block_size = static_cast<size_t>(info.st_size);
+    const char* block = static_cast<const char*>(mapped);
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    std::streamoff size = file.tellg();
+    if (size <= 0) {
+        std::cerr << "Invalid frozen category file: " << filename << std::endl;
+        return false;
+    }
+    opened.owned = new char[static_cast<size_t>(size)];
+    opened.block_size = static_cast<size_t>(size);
+    file.seekg(0);
+    if (!file.read(opened.owned, size)) {
+        std::cerr << "Error reading file: " << filename << std::endl;
+        return false;
+    }
+    const char* block = opened.owned;
+#endif
+    if (!opened.attach(block, opened.block_size)) {
+        std::cerr << "Invalid frozen category file: " << filename << std::endl;
+        return false; // The destructor releases the block
+    }
+    *this = std::move(opened);
+    return true;
+}
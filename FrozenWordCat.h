@@ -0,0 +1,226 @@
+// FrozenWordCat.h
+#ifndef FROZENWORDCAT_H_
+#define FROZENWORDCAT_H_
+
+#include "Word.h"
+#include "WordList.h"
+#include "WordCat.h"
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+
+/**
+ * @class FrozenWordCat
+ * @brief A read-only category stored as a minimal acyclic automaton that also numbers its words.
+ *
+ * Freezing a WordCat builds the minimal deterministic automaton accepting exactly its words, so words
+ * that share a prefix share the states of the prefix and words that share a suffix share the states of
+ * the suffix. Every state also records how many words can be completed from it, which turns the
+ * automaton into a map from each word to its ordinal: rank() sums counts while walking a word, and
+ * fetchWord() spends an index on the way down.
+ *
+ * The automaton is one flat block: a header, the states, and the transition targets and labels in two
+ * parallel arrays. The block is the same in memory and on disk, so save() writes it as it is and open()
+ * maps the file and uses it in place, without parsing. States are numbered so that every transition leads
+ * to a higher number, which lets open() check that a file describes an acyclic automaton.
+ */
+class FrozenWordCat {
+private:
+    /**
+     * @brief Fixed-size start of the block.
+     */
+    struct Header {
+        char magic[8]; ///< FROZEN_MAGIC
+        uint32_t state_count; ///< Number of states; state 0 is the start state
+        uint32_t transition_count; ///< Number of transitions
+        uint32_t word_count; ///< Number of words accepted
+        uint32_t name_length; ///< Length of the category name stored after the labels
+        uint64_t reserved; ///< Zero; keeps the states 8-byte aligned
+    };
+
+    /**
+     * @brief One state: its outgoing transitions and the number of words below it.
+     */
+    struct State {
+        uint32_t first; ///< Index of the first outgoing transition; they are consecutive and sorted by label
+        uint32_t count_final; ///< Number of outgoing transitions times two, plus one if the state ends a word
+        uint32_t words; ///< Number of words accepted from this state, including the empty one if it is final
+    };
+
+    static constexpr char FROZEN_MAGIC[8] = { 'W', 'W', 'F', 'R', 'O', 'Z', 'E', '1' }; ///< First bytes of the block
+
+    Word category; ///< The name of the category
+    char* owned; ///< The block when it is held in memory, or nullptr
+    void* mapping; ///< The block when it is mapped from a file, or nullptr
+    size_t block_size; ///< Size of the block in bytes
+
+    const State* states; ///< The states, within the block
+    const uint32_t* targets; ///< Target state of each transition, within the block
+    const unsigned char* labels; ///< Character of each transition, within the block
+    uint32_t state_count; ///< Number of states
+    uint32_t word_count; ///< Number of words
+
+    /**
+     * @brief Builds the minimal automaton of a category's words into a new owned block.
+     * @param name The category name to store in the block
+     * @param source The category whose words to freeze, or nullptr for none
+     * @throws std::runtime_error if the category does not visit its words in strictly ascending order.
+     */
+    void build(const Word& name, const WordCat* source);
+
+    /**
+     * @brief Points the views at a block and checks that it is a well-formed, acyclic automaton.
+     * @param block The block
+     * @param size Its size in bytes
+     * @return false if the block is malformed, in which case nothing is changed
+     */
+    bool attach(const char* block, size_t size);
+
+    /**
+     * @brief Frees the owned block or unmaps the mapped one and resets to an empty category.
+     */
+    void release();
+
+    /**
+     * @brief Follows the transition of a state on a character.
+     * @param state The state
+     * @param c The character
+     * @return The target state, or state_count if there is no such transition
+     */
+    uint32_t step(uint32_t state, unsigned char c) const;
+
+    /**
+     * @brief Visits every word accepted from a state, in sorted order.
+     * @param state The state to start from
+     * @param prefix The characters leading to the state; extended and restored while visiting
+     * @param visit The function to call with each word
+     */
+    void enumerate(uint32_t state, std::string& prefix, const std::function<void(const Word&)>& visit) const;
+
+public:
+    /**
+     * @brief Default constructor. Initializes an empty category.
+     */
+    FrozenWordCat();
+
+    /**
+     * @brief Constructor. Freezes the words of a category into a minimal automaton.
+     * @param source The category to freeze
+     */
+    explicit FrozenWordCat(const WordCat& source);
+
+    /**
+     * @brief Destructor. Frees or unmaps the block.
+     */
+    ~FrozenWordCat();
+
+    /**
+     * @brief Copy constructor. The copy holds its own block in memory, even if the original is mapped.
+     * @param other The category to copy
+     */
+    FrozenWordCat(const FrozenWordCat& other);
+
+    /**
+     * @brief Copy assignment operator. Copies the block of another category into memory.
+     * @param other The category to copy
+     * @return A reference to this object
+     */
+    FrozenWordCat& operator=(const FrozenWordCat& other);
+
+    /**
+     * @brief Move constructor. Takes over the block of another category.
+     * @param other The category to move from
+     */
+    FrozenWordCat(FrozenWordCat&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator. Takes over the block of another category.
+     * @param other The category to move from
+     * @return A reference to this object
+     */
+    FrozenWordCat& operator=(FrozenWordCat&& other) noexcept;
+
+    /**
+     * @brief Returns the name of the category.
+     * @return The category name
+     */
+    const Word& getCategoryName() const;
+
+    /**
+     * @brief Checks if the given word is in the category. Costs one transition search per character.
+     * @param word The word to look up
+     * @return true if the word is found, false otherwise
+     */
+    bool lookup(const Word& word) const;
+
+    /**
+     * @brief Counts the words less than the given word. For a word in the category, this is its ordinal.
+     * @param word The word to rank; it need not be in the category
+     * @return The number of words that sort before it
+     */
+    size_t rank(const Word& word) const;
+
+    /**
+     * @brief Returns the word with the given ordinal. Costs one transition scan per character.
+     * @param index The index of the word, in sorted order
+     * @return The word
+     * @throws std::runtime_error if the index is out of range.
+     */
+    Word fetchWord(size_t index) const;
+
+    /**
+     * @brief Returns the words that start with a prefix, in sorted order.
+     * @param prefix The prefix; "" returns every word
+     * @return A sorted list of the matching words
+     */
+    WordList wordsWithPrefix(const char* prefix) const;
+
+    /**
+     * @brief Returns the words starting with the given letter.
+     * @param letter The initial letter of the words to return
+     * @return A sorted list of the matching words
+     */
+    WordList wordsStartingWith(const char letter) const;
+
+    /**
+     * @brief Calls a function on every word, in sorted order.
+     * @param visit The function to call with each word
+     */
+    void forEach(const std::function<void(const Word&)>& visit) const;
+
+    /**
+     * @brief Returns the number of words.
+     * @return The number of words
+     */
+    inline size_t length() const { return word_count; }
+
+    /**
+     * @brief Returns the number of automaton states.
+     * @return The number of states
+     */
+    inline size_t stateCount() const { return state_count; }
+
+    /**
+     * @brief Returns the size of the automaton block, which is all the memory the category uses for its words.
+     * @return The size in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Writes the block to a file.
+     * @param filename The path to the file to write
+     * @return false if the file could not be written
+     */
+    bool save(const char* filename) const;
+
+    /**
+     * @brief Replaces the contents with a block saved by save(). Where available the file is memory-mapped
+     * and used in place, so opening costs one validation pass and no allocation; otherwise it is read into memory.
+     * @param filename The path to the file to open
+     * @return false if the file could not be read or is not a valid frozen category, in which case nothing changes
+     */
+    bool open(const char* filename);
+};
+
+#endif // FROZENWORDCAT_H_
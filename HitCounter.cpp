@@ -0,0 +1,234 @@
+// HitCounter.cpp
+#include "HitCounter.h"
+#include "MemoryAccount.h"
+#include <new>
+#include <utility>
+
+/**
+ * @brief Allocates a table of empty slots, charged to the current memory account as an index.
+ * @param slot_count The number of slots.
+ * @return The table.
+ */
+HitCounter::Slot* HitCounter::allocateSlots(size_t slot_count) {
+    static_assert(alignof(Slot) <= MemoryAccount::HEADER, "Accounted blocks are only 8-byte aligned");
+    Slot* table = static_cast<Slot*>(MemoryAccount::current().allocate(slot_count * sizeof(Slot), MemoryAccount::Structure::Indexes));
+    for (size_t i = 0; i < slot_count; i++) new (table + i) Slot();
+    return table;
+}
+
+/**
+ * @brief Frees a table allocated by allocateSlots.
+ * @param table The table, or nullptr.
+ * @param slot_count The number of slots it was allocated with.
+ */
+void HitCounter::freeSlots(Slot* table, size_t slot_count) {
+    if (table == nullptr) return;
+    for (size_t i = 0; i < slot_count; i++) table[i].~Slot();
+    MemoryAccount::deallocate(table, slot_count * sizeof(Slot), MemoryAccount::Structure::Indexes);
+}
+
+/**
+ * @brief Default constructor. Initializes an empty counter that allocates nothing.
+ */
+HitCounter::HitCounter() : slots{ nullptr }, capacity{ 0 }, count{ 0 }, removed{ 0 } {}
+
+/**
+ * @brief Destructor. Deallocates the table.
+ */
+HitCounter::~HitCounter() {
+    freeSlots(slots, capacity);
+}
+
+/**
+ * @brief Copy constructor. Copies the words and their counts.
+ * @param other The counter to copy.
+ */
+HitCounter::HitCounter(const HitCounter& other) :
+    slots{ other.capacity ? allocateSlots(other.capacity) : nullptr },
+    capacity{ other.capacity }, count{ other.count }, removed{ other.removed } {
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].hash = other.slots[i].hash;
+        slots[i].hits.store(other.slots[i].hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Copy assignment operator. Copies the words and their counts.
+ * @param other The counter to copy.
+ * @return A reference to this object.
+ */
+HitCounter& HitCounter::operator=(const HitCounter& other) {
+    if (this != &other) { // Avoid self-assignment
+        HitCounter copy(other); // Copy first so that this object is unchanged if allocation fails
+        *this = std::move(copy); // Take ownership of the copy
+    }
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Takes ownership of another counter's table.
+ * @param other The counter to move from.
+ */
+HitCounter::HitCounter(HitCounter&& other) noexcept :
+    slots{ other.slots }, capacity{ other.capacity }, count{ other.count }, removed{ other.removed } {
+    other.slots = nullptr; // The other counter becomes empty
+    other.capacity = other.count = other.removed = 0;
+}
+
+/**
+ * @brief Move assignment operator. Takes ownership of another counter's table.
+ * @param other The counter to move from.
+ * @return A reference to this object.
+ */
+HitCounter& HitCounter::operator=(HitCounter&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        freeSlots(slots, capacity); // Free the old table
+        slots = other.slots;
+        capacity = other.capacity;
+        count = other.count;
+        removed = other.removed;
+        other.slots = nullptr; // The other counter becomes empty
+        other.capacity = other.count = other.removed = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Hashes a word, avoiding the values reserved for EMPTY and REMOVED.
+ * @param word The word.
+ * @return The hash.
+ */
+uint64_t HitCounter::hashOf(const Word& word) {
+    uint64_t h = word.hash();
+    return h <= REMOVED ? h + 2 : h; // Keep the reserved values free
+}
+
+/**
+ * @brief Finds the slot of a word.
+ * @param hash The word's hash.
+ * @return The slot, or nullptr if the word is not counted.
+ */
+const HitCounter::Slot* HitCounter::find(uint64_t hash) const {
+    if (count == 0) return nullptr;
+    for (size_t i = hash & (capacity - 1); slots[i].hash != EMPTY; i = (i + 1) & (capacity - 1)) {
+        if (slots[i].hash == hash) return &slots[i];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Moves every counter into a new table with the given number of slots, dropping the REMOVED markers.
+ * @param new_capacity The new number of slots, a power of two larger than the number of words.
+ */
+void HitCounter::rehash(size_t new_capacity) {
+    Slot* old_slots = slots;
+    size_t old_capacity = capacity;
+    slots = allocateSlots(new_capacity);
+    capacity = new_capacity;
+    removed = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].hash <= REMOVED) continue; // Nothing to move
+        size_t j = old_slots[i].hash & (capacity - 1);
+        while (slots[j].hash != EMPTY) j = (j + 1) & (capacity - 1); // The new table has no markers yet
+        slots[j].hash = old_slots[i].hash;
+        slots[j].hits.store(old_slots[i].hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    freeSlots(old_slots, old_capacity);
+}
+
+/**
+ * @brief Starts counting a word, from the given number of hits.
+ * @param word The word to count.
+ * @param hits The initial number of hits.
+ */
+void HitCounter::add(const Word& word, uint64_t hits) {
+    if ((count + removed + 1) * 4 > capacity * 3) { // Keep probe sequences short
+        size_t new_capacity = capacity ? capacity : MIN_CAPACITY;
+        while ((count + 1) * 2 > new_capacity) new_capacity *= 2; // At most half full after rehashing
+        rehash(new_capacity);
+    }
+
+    uint64_t h = hashOf(word);
+    size_t i = h & (capacity - 1);
+    while (slots[i].hash > REMOVED) i = (i + 1) & (capacity - 1); // The first free slot, reusing a marker if one comes first
+    if (slots[i].hash == REMOVED) removed--;
+    slots[i].hash = h;
+    slots[i].hits.store(hits, std::memory_order_relaxed);
+    count++;
+}
+
+/**
+ * @brief Stops counting a word and forgets its hits.
+ * @param word The word.
+ * @return True if the word was counted, false otherwise.
+ */
+bool HitCounter::remove(const Word& word) {
+    Slot* slot = const_cast<Slot*>(find(hashOf(word)));
+    if (slot == nullptr) return false;
+    slot->hash = REMOVED; // Later words of the probe sequence stay reachable
+    slot->hits.store(0, std::memory_order_relaxed);
+    count--;
+    removed++;
+    return true;
+}
+
+/**
+ * @brief Forgets every word and frees the table.
+ */
+void HitCounter::clear() {
+    freeSlots(slots, capacity);
+    slots = nullptr;
+    capacity = count = removed = 0;
+}
+
+/**
+ * @brief Starts loading the slot where a word's probe sequence begins into the cache.
+ * @param hash The word's hash.
+ */
+void HitCounter::prefetch(uint64_t hash) const {
+#if defined(__GNUC__) || defined(__clang__)
+    if (capacity != 0) __builtin_prefetch(&slots[hash & (capacity - 1)], 1); // For writing: touch will add to it
+#else
+    (void)hash; // Only a hint; nothing to do without the builtin
+#endif
+}
+
+/**
+ * @brief Records a hit on a word.
+ * @param word The word that was used.
+ * @return True if the word is counted, false if it is not.
+ */
+bool HitCounter::touch(const Word& word) const {
+    return touch(hashOf(word));
+}
+
+/**
+ * @brief Records a hit on a word whose hash is already known. Only the counter is written, with a
+ * relaxed add, so readers need no lock.
+ * @param hash The word's hash.
+ * @return True if the word is counted, false if it is not.
+ */
+bool HitCounter::touch(uint64_t hash) const {
+    const Slot* slot = find(hash);
+    if (slot == nullptr) return false;
+    slot->hits.fetch_add(1, std::memory_order_relaxed); // Ordering with other memory does not matter for a statistic
+    return true;
+}
+
+/**
+ * @brief Returns the number of hits on a word.
+ * @param word The word.
+ * @return The hits recorded since the word was added; 0 for a word that is not counted.
+ */
+uint64_t HitCounter::hits(const Word& word) const {
+    const Slot* slot = find(hashOf(word));
+    return slot == nullptr ? 0 : slot->hits.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the memory allocated by the table.
+ * @return The allocated size in bytes.
+ */
+size_t HitCounter::memoryBytes() const {
+    return capacity * sizeof(Slot);
+}
@@ -0,0 +1,175 @@
+// HitCounter.h
+#ifndef HITCOUNTER_H_
+#define HITCOUNTER_H_
+
+#include "Word.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class HitCounter
+ * @brief Counts how often each word of a category is used, for ranking by popularity.
+ *
+ * The table uses open addressing with linear probing, like FoldedIndex, but a slot holds only the
+ * 64-bit hash of its word and an atomic hit count, so it costs 16 bytes per word whatever the word's
+ * length. Two words of a category with the same 64-bit hash would share a counter; at the sizes a
+ * category reaches this does not happen in practice. The table is charged to the current memory
+ * account as an index (see MemoryAccount).
+ *
+ * The set of words changes only through add, remove and clear, which the category calls while it
+ * is being modified. touch only increments the counter of a word already in the table, with a relaxed
+ * atomic add, so any number of readers can count hits at the same time without a lock: a hit costs
+ * one probe sequence and one uncontended add. A caller about to look a word up can prefetch its slot
+ * first, so that the cache miss on the counter overlaps the lookup instead of following it.
+ */
+class HitCounter {
+private:
+    static constexpr uint64_t EMPTY = 0; ///< Hash of a slot that was never used; ends a probe sequence
+    static constexpr uint64_t REMOVED = 1; ///< Hash of a slot whose word was removed; probes continue past it
+    static constexpr size_t MIN_CAPACITY = 16; ///< Slots allocated by the first insertion
+
+    /**
+     * @brief One slot of the table.
+     */
+    struct Slot {
+        uint64_t hash = EMPTY; ///< Hash of the word, or EMPTY or REMOVED
+        mutable std::atomic<uint64_t> hits{ 0 }; ///< Times the word was used; counted by const readers
+    };
+
+    Slot* slots; ///< The table; its size is a power of two
+    size_t capacity; ///< Number of slots (0 before the first insertion)
+    size_t count; ///< Number of words
+    size_t removed; ///< Number of REMOVED slots
+
+    /**
+     * @brief Finds the slot of a word.
+     * @param hash The word's hash (see hashOf)
+     * @return The slot, or nullptr if the word is not counted
+     */
+    const Slot* find(uint64_t hash) const;
+
+    /**
+     * @brief Allocates a table of empty slots, charged to the current memory account as an index.
+     * @param slot_count The number of slots
+     * @return The table
+     */
+    static Slot* allocateSlots(size_t slot_count);
+
+    /**
+     * @brief Frees a table allocated by allocateSlots.
+     * @param table The table, or nullptr
+     * @param slot_count The number of slots it was allocated with
+     */
+    static void freeSlots(Slot* table, size_t slot_count);
+
+    /**
+     * @brief Moves every counter into a new table with the given number of slots, dropping the REMOVED markers.
+     * @param new_capacity The new number of slots, a power of two larger than the number of words
+     */
+    void rehash(size_t new_capacity);
+
+public:
+    /**
+     * @brief Default constructor. Initializes an empty counter that allocates nothing.
+     */
+    HitCounter();
+
+    /**
+     * @brief Destructor. Deallocates the table.
+     */
+    ~HitCounter();
+
+    /**
+     * @brief Copy constructor. Copies the words and their counts.
+     * @param other The counter to copy
+     */
+    HitCounter(const HitCounter& other);
+
+    /**
+     * @brief Copy assignment operator. Copies the words and their counts.
+     * @param other The counter to copy
+     * @return A reference to this object
+     */
+    HitCounter& operator=(const HitCounter& other);
+
+    /**
+     * @brief Move constructor. Takes ownership of another counter's table.
+     * @param other The counter to move from
+     */
+    HitCounter(HitCounter&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator. Takes ownership of another counter's table.
+     * @param other The counter to move from
+     * @return A reference to this object
+     */
+    HitCounter& operator=(HitCounter&& other) noexcept;
+
+    /**
+     * @brief Starts counting a word, from the given number of hits. The caller ensures it is not already counted.
+     * @param word The word to count
+     * @param hits The initial number of hits
+     */
+    void add(const Word& word, uint64_t hits = 0);
+
+    /**
+     * @brief Stops counting a word and forgets its hits.
+     * @param word The word
+     * @return true if the word was counted, false otherwise
+     */
+    bool remove(const Word& word);
+
+    /**
+     * @brief Forgets every word and frees the table.
+     */
+    void clear();
+
+    /**
+     * @brief Hashes a word for prefetch and touch, avoiding the values reserved for EMPTY and REMOVED.
+     * @param word The word
+     * @return The hash
+     */
+    static uint64_t hashOf(const Word& word);
+
+    /**
+     * @brief Starts loading the slot where a word's probe sequence begins into the cache. Never faults.
+     * @param hash The word's hash (see hashOf)
+     */
+    void prefetch(uint64_t hash) const;
+
+    /**
+     * @brief Records a hit on a word. Safe to call from concurrent readers.
+     * @param word The word that was used
+     * @return true if the word is counted, false if it is not (nothing is recorded)
+     */
+    bool touch(const Word& word) const;
+
+    /**
+     * @brief Records a hit on a word whose hash is already known. Safe to call from concurrent readers.
+     * @param hash The word's hash (see hashOf)
+     * @return true if the word is counted, false if it is not (nothing is recorded)
+     */
+    bool touch(uint64_t hash) const;
+
+    /**
+     * @brief Returns the number of hits on a word.
+     * @param word The word
+     * @return The hits recorded since the word was added; 0 for a word that is not counted
+     */
+    uint64_t hits(const Word& word) const;
+
+    /**
+     * @brief Returns the number of words counted.
+     * @return The number of words
+     */
+    inline size_t length() const { return count; }
+
+    /**
+     * @brief Returns the memory allocated by the table.
+     * @return The allocated size in bytes
+     */
+    size_t memoryBytes() const;
+};
+
+#endif // HITCOUNTER_H_
@@ -0,0 +1,83 @@
+// LineReader.cpp
+#include "LineReader.h"
+#include <cstring>
+
+/**
+ * @brief Constructor. Nothing is read until the first call to next().
+ * @param in The stream to read.
+ */
+LineReader::LineReader(std::istream& in) :
+    in(in), buffer{ new char[INITIAL_CAPACITY] }, capacity{ INITIAL_CAPACITY },
+    begin{ 0 }, end{ 0 }, scanned{ 0 }, exhausted{ false } {}
+
+/**
+ * @brief Destructor. Deallocates the buffer.
+ */
+LineReader::~LineReader() {
+    delete[] buffer;
+}
+
+/**
+ * @brief Reads more bytes, first moving the unread ones to the front and growing the buffer if it is full.
+ * @return False if the stream had no more bytes.
+ */
+bool LineReader::fill() {
+    if (exhausted) return false;
+
+    if (begin > 0) { // Make room by dropping the lines already returned
+        std::memmove(buffer, buffer + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end + 1 >= capacity) { // One line fills the whole buffer
+        char* larger = new char[capacity * 2];
+        std::memcpy(larger, buffer, end);
+        delete[] buffer;
+        buffer = larger;
+        capacity *= 2;
+    }
+
+    in.read(buffer + end, static_cast<std::streamsize>(capacity - 1 - end)); // Keep a byte for the last '\0'
+    size_t count = static_cast<size_t>(in.gcount());
+    end += count;
+    if (count == 0) exhausted = true;
+    return count > 0;
+}
+
+/**
+ * @brief Returns the next line, without its '\n'.
+ * @param length Receives the number of characters of the line.
+ * @return The line, '\0'-terminated and writable, valid until the next call; nullptr at the end of the stream.
+ */
+char* LineReader::next(size_t& length) {
+    while (true) {
+        char* start = buffer + begin;
+        char* newline = static_cast<char*>(std::memchr(start + scanned, '\n', end - begin - scanned));
+        if (newline != nullptr) { // A whole line is in the buffer
+            *newline = '\0';
+            length = static_cast<size_t>(newline - start);
+            begin += length + 1;
+            scanned = 0;
+            return start;
+        }
+        scanned = end - begin; // Do not scan these bytes again
+        if (!fill()) break; // The stream ended
+    }
+
+    if (begin == end) return nullptr; // Nothing left
+    char* start = buffer + begin; // The last line has no '\n'
+    length = end - begin;
+    start[length] = '\0'; // fill() kept a byte free for this
+    begin = end;
+    scanned = 0;
+    return start;
+}
+
+/**
+ * @brief Returns the next line, without its '\n'.
+ * @return The line, '\0'-terminated and writable, valid until the next call; nullptr at the end of the stream.
+ */
+char* LineReader::next() {
+    size_t length;
+    return next(length);
+}
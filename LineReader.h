@@ -0,0 +1,65 @@
+// LineReader.h
+#ifndef LINEREADER_H_
+#define LINEREADER_H_
+
+#include <cstddef>
+#include <iostream>
+
+/**
+ * @class LineReader
+ * @brief Reads a stream line by line, without a limit on line length and without copying each line.
+ *
+ * The stream is read in large blocks into one buffer, and next() returns each line in place: the
+ * '\n' that ends it is overwritten with '\0', so the line can be trimmed and turned into a Word
+ * directly. When a line does not fit in what is left of the buffer, the unread bytes are moved to
+ * the front, and the buffer doubles only if a single line is longer than the whole buffer. Typical
+ * short lines therefore cost one memchr each, and the buffer is allocated once.
+ */
+class LineReader {
+private:
+    static constexpr size_t INITIAL_CAPACITY = 1 << 16; ///< Bytes read at a time, until a longer line needs more
+
+    std::istream& in; ///< The stream being read
+    char* buffer; ///< Bytes read and not yet returned, from 'begin' to 'end'
+    size_t capacity; ///< Size of buffer; one byte is always kept free for the last line's '\0'
+    size_t begin; ///< Start of the next line
+    size_t end; ///< End of the bytes read
+    size_t scanned; ///< Bytes from 'begin' already known to contain no '\n'
+    bool exhausted; ///< The stream has no more bytes
+
+    /**
+     * @brief Reads more bytes, first moving the unread ones to the front and growing the buffer if it is full.
+     * @return false if the stream had no more bytes
+     */
+    bool fill();
+
+public:
+    /**
+     * @brief Constructor. Nothing is read until the first call to next().
+     * @param in The stream to read; it must outlive the reader
+     */
+    explicit LineReader(std::istream& in);
+
+    /**
+     * @brief Destructor. Deallocates the buffer.
+     */
+    ~LineReader();
+
+    LineReader(const LineReader& other) = delete; // The returned lines point into the buffer
+    LineReader& operator=(const LineReader& other) = delete;
+
+    /**
+     * @brief Returns the next line, without its '\n'.
+     * @param length Receives the number of characters of the line
+     * @return The line, '\0'-terminated and writable, valid until the next call; nullptr at the end of the stream
+     */
+    char* next(size_t& length);
+
+    /**
+     * @brief Returns the next line, without its '\n'.
+     * @return The line, '\0'-terminated and writable, valid until the next call; nullptr at the end of the stream
+     */
+    char* next();
+};
+
+#endif // LINEREADER_H_
@@ -0,0 +1,208 @@
+// MemoryAccount.cpp
+#include "MemoryAccount.h"
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief The allocator of the global operator new and delete.
+ */
+class HeapAllocator : public Allocator {
+public:
+    void* allocate(size_t bytes) override { return ::operator new(bytes); }
+    void deallocate(void* block, size_t) noexcept override { ::operator delete(block); }
+};
+
+static thread_local MemoryAccount* current_account = nullptr; ///< The account of the innermost Scope on this thread
+
+/**
+ * @brief Returns the allocator that uses the global operator new and delete.
+ * @return The allocator.
+ */
+Allocator& Allocator::heap() {
+    static HeapAllocator* allocator = new HeapAllocator(); // Never destroyed, so blocks freed during exit still find it
+    return *allocator;
+}
+
+/**
+ * @brief Returns a description of the error.
+ * @return The description.
+ */
+const char* MemoryBudgetExceeded::what() const noexcept {
+    return "memory budget exceeded";
+}
+
+/**
+ * @brief Constructor. Makes the account current.
+ * @param account The account.
+ */
+MemoryAccount::Scope::Scope(MemoryAccount& account) : previous{ current_account } {
+    current_account = &account;
+}
+
+/**
+ * @brief Destructor. Makes the previous account current again.
+ */
+MemoryAccount::Scope::~Scope() {
+    current_account = previous;
+}
+
+/**
+ * @brief Constructor. The caller holds the one reference that release drops.
+ * @param upstream Where the blocks come from.
+ * @param budget The most bytes the account may hold, headers included.
+ */
+MemoryAccount::MemoryAccount(Allocator& upstream, size_t budget) :
+    upstream{ upstream },
+    budget{ budget },
+    total{ 0 },
+    peak{ 0 },
+    refused{ 0 },
+    by_structure{},
+    references{ 1 } {}
+
+/**
+ * @brief Drops the owner's reference; the last reference deletes the account.
+ */
+void MemoryAccount::release() {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; // No blocks left
+}
+
+/**
+ * @brief Returns the account current on the calling thread.
+ * @return The account of the innermost Scope, or the global account.
+ */
+MemoryAccount& MemoryAccount::current() {
+    return current_account != nullptr ? *current_account : global();
+}
+
+/**
+ * @brief Returns the account used outside any Scope.
+ * @return The account.
+ */
+MemoryAccount& MemoryAccount::global() {
+    static MemoryAccount* account = new MemoryAccount(); // Never released, so blocks freed during exit still find it
+    return *account;
+}
+
+/**
+ * @brief Allocates a block and charges it to this account. The budget is reserved before the allocator is
+ * asked, so that concurrent allocations cannot overshoot it together.
+ * @param bytes The size of the block.
+ * @param structure What the block is for.
+ * @return The block.
+ */
+void* MemoryAccount::allocate(size_t bytes, Structure structure) {
+    size_t charged = HEADER + bytes;
+    size_t held = total.fetch_add(charged, std::memory_order_relaxed) + charged;
+    if (held > budget.load(std::memory_order_relaxed) || held < charged) { // Over budget, or so large it wrapped
+        total.fetch_sub(charged, std::memory_order_relaxed);
+        refused.fetch_add(1, std::memory_order_relaxed);
+        throw MemoryBudgetExceeded();
+    }
+
+    char* block;
+    try {
+        block = static_cast<char*>(upstream.allocate(charged));
+    } catch (...) {
+        total.fetch_sub(charged, std::memory_order_relaxed);
+        throw;
+    }
+
+    MemoryAccount* self = this;
+    std::memcpy(block, &self, sizeof self); // The header: who to credit when the block is freed
+    references.fetch_add(1, std::memory_order_relaxed);
+    by_structure[static_cast<size_t>(structure)].fetch_add(bytes, std::memory_order_relaxed);
+    size_t highest = peak.load(std::memory_order_relaxed);
+    while (held > highest && !peak.compare_exchange_weak(highest, held, std::memory_order_relaxed)) {} // Raise the peak
+    return block + HEADER;
+}
+
+/**
+ * @brief Frees a block and credits it to the account named in its header.
+ * @param block The block, or nullptr.
+ * @param bytes The size it was allocated with.
+ * @param structure What it was allocated for.
+ */
+void MemoryAccount::deallocate(void* block, size_t bytes, Structure structure) noexcept {
+    if (block == nullptr) return;
+    char* start = static_cast<char*>(block) - HEADER;
+    MemoryAccount* account;
+    std::memcpy(&account, start, sizeof account);
+
+    account->by_structure[static_cast<size_t>(structure)].fetch_sub(bytes, std::memory_order_relaxed);
+    account->total.fetch_sub(HEADER + bytes, std::memory_order_relaxed);
+    account->upstream.deallocate(start, HEADER + bytes);
+    if (account->references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete account; // Released, and this was its last block
+}
+
+/**
+ * @brief Returns where the blocks come from.
+ * @return The allocator.
+ */
+Allocator& MemoryAccount::getAllocator() const {
+    return upstream;
+}
+
+/**
+ * @brief Sets the budget.
+ * @param bytes The most bytes the account may hold, or UNLIMITED.
+ */
+void MemoryAccount::setBudget(size_t bytes) {
+    budget.store(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the budget.
+ * @return The most bytes the account may hold, or UNLIMITED.
+ */
+size_t MemoryAccount::getBudget() const {
+    return budget.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the bytes held, headers included.
+ * @return The size in bytes.
+ */
+size_t MemoryAccount::totalBytes() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the bytes held for one structure, without headers.
+ * @param structure The structure.
+ * @return The size in bytes.
+ */
+size_t MemoryAccount::bytes(Structure structure) const {
+    return by_structure[static_cast<size_t>(structure)].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the most bytes the account has held at once.
+ * @return The size in bytes.
+ */
+size_t MemoryAccount::peakBytes() const {
+    return peak.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of allocations refused for the budget.
+ * @return The number of allocations.
+ */
+size_t MemoryAccount::refusedCount() const {
+    return refused.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the name of a structure, for reports.
+ * @param structure The structure.
+ * @return The name.
+ */
+const char* MemoryAccount::structureName(Structure structure) {
+    switch (structure) {
+        case Structure::Words: return "Word buffers";
+        case Structure::Nodes: return "List and tree nodes";
+        case Structure::Categories: return "Category arrays";
+        case Structure::Indexes: return "Indexes and filters";
+        default: return "Other";
+    }
+}
@@ -0,0 +1,222 @@
+// MemoryAccount.h
+#ifndef MEMORYACCOUNT_H_
+#define MEMORYACCOUNT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+/**
+ * @class Allocator
+ * @brief Where a MemoryAccount gets its memory from. Override it to place the vocabulary's memory in a pool,
+ * an arena or a memory-mapped region; the default uses the global operator new and delete.
+ */
+class Allocator {
+public:
+    /**
+     * @brief Destructor.
+     */
+    virtual ~Allocator() = default;
+
+    /**
+     * @brief Allocates a block aligned for any fundamental type.
+     * @param bytes The size of the block
+     * @return The block
+     * @throws std::bad_alloc if there is no memory.
+     */
+    virtual void* allocate(size_t bytes) = 0;
+
+    /**
+     * @brief Frees a block returned by allocate.
+     * @param block The block
+     * @param bytes The size it was allocated with
+     */
+    virtual void deallocate(void* block, size_t bytes) noexcept = 0;
+
+    /**
+     * @brief Returns the allocator that uses the global operator new and delete.
+     * @return The allocator
+     */
+    static Allocator& heap();
+};
+
+/**
+ * @class MemoryBudgetExceeded
+ * @brief Thrown instead of allocating when an allocation would take a MemoryAccount over its budget.
+ */
+class MemoryBudgetExceeded : public std::bad_alloc {
+public:
+    /**
+     * @brief Returns a description of the error.
+     * @return The description
+     */
+    const char* what() const noexcept override;
+};
+
+/**
+ * @class MemoryAccount
+ * @brief Counts the bytes a vocabulary's core structures hold, by structure, and can refuse to go over a budget.
+ *
+ * Word buffers, WordList pools, tree nodes, Bloom filters and WordCatVec arrays allocate through the account that
+ * is current on the calling thread: the one of the innermost Scope, or the global account outside any scope.
+ * Each WordCatVec has its own account and enters its scope while it changes, so every vocabulary counts its own
+ * memory. Every block starts with a pointer to the account that allocated it, so it is credited back to that
+ * account wherever it is freed; the account lives on until its owner has released it and its last block is
+ * freed. The header costs HEADER bytes per block.
+ *
+ * The budget is checked on every allocation, before asking the allocator: an allocation that would go over it
+ * throws MemoryBudgetExceeded, a std::bad_alloc, so a load runs out of its budget long before the host runs out
+ * of memory, and unwinds like any failed allocation.
+ */
+class MemoryAccount {
+public:
+    static constexpr size_t UNLIMITED = static_cast<size_t>(-1); ///< The budget of an account without one
+    static constexpr size_t HEADER = 8; ///< Bytes before each block, holding its account; blocks are 8-byte aligned
+
+    /**
+     * @brief The structures that allocate through an account.
+     */
+    enum class Structure {
+        Words, ///< Heap buffers of words too long to be stored inline
+        Nodes, ///< WordList pools and PersistentWordList nodes
+        Categories, ///< WordCatVec arrays of categories
+        Indexes, ///< Name indexes, Bloom filters, folded indexes and hit counters
+        COUNT ///< The number of structures
+    };
+
+    /**
+     * @class Scope
+     * @brief Makes an account the current one of the calling thread until the scope ends.
+     */
+    class Scope {
+    private:
+        MemoryAccount* previous; ///< The account that was current before
+
+    public:
+        /**
+         * @brief Constructor. Makes the account current.
+         * @param account The account
+         */
+        explicit Scope(MemoryAccount& account);
+
+        /**
+         * @brief Destructor. Makes the previous account current again.
+         */
+        ~Scope();
+
+        Scope(const Scope& other) = delete;
+        Scope& operator=(const Scope& other) = delete;
+    };
+
+private:
+    Allocator& upstream; ///< Where the blocks come from
+    std::atomic<size_t> budget; ///< The most bytes the account may hold, headers included
+    std::atomic<size_t> total; ///< Bytes held, headers included
+    std::atomic<size_t> peak; ///< The most bytes held at once
+    std::atomic<size_t> refused; ///< Allocations refused for the budget
+    std::atomic<size_t> by_structure[static_cast<size_t>(Structure::COUNT)]; ///< Bytes held by each structure, without headers
+    std::atomic<size_t> references; ///< The owner's reference plus one per live block
+
+    /**
+     * @brief Destructor. Private: an account deletes itself when released (see release).
+     */
+    ~MemoryAccount() = default;
+
+public:
+    /**
+     * @brief Constructor. The caller holds the one reference that release drops.
+     * @param upstream Where the blocks come from; it must outlive every block of the account
+     * @param budget The most bytes the account may hold, headers included
+     */
+    explicit MemoryAccount(Allocator& upstream = Allocator::heap(), size_t budget = UNLIMITED);
+
+    MemoryAccount(const MemoryAccount& other) = delete;
+    MemoryAccount& operator=(const MemoryAccount& other) = delete;
+
+    /**
+     * @brief Drops the owner's reference. The account is deleted now if it holds no blocks, and otherwise when
+     * its last block is freed.
+     */
+    void release();
+
+    /**
+     * @brief Returns the account current on the calling thread.
+     * @return The account of the innermost Scope, or the global account
+     */
+    static MemoryAccount& current();
+
+    /**
+     * @brief Returns the account used outside any Scope. It is never deleted.
+     * @return The account
+     */
+    static MemoryAccount& global();
+
+    /**
+     * @brief Allocates a block and charges it to this account.
+     * @param bytes The size of the block
+     * @param structure What the block is for
+     * @return The block, 8-byte aligned
+     * @throws MemoryBudgetExceeded if the block would take the account over its budget.
+     */
+    void* allocate(size_t bytes, Structure structure);
+
+    /**
+     * @brief Frees a block and credits it to the account that allocated it.
+     * @param block The block, or nullptr
+     * @param bytes The size it was allocated with
+     * @param structure What it was allocated for
+     */
+    static void deallocate(void* block, size_t bytes, Structure structure) noexcept;
+
+    /**
+     * @brief Returns where the blocks come from.
+     * @return The allocator
+     */
+    Allocator& getAllocator() const;
+
+    /**
+     * @brief Sets the budget. Bytes already held are kept even if they are over it.
+     * @param bytes The most bytes the account may hold, or UNLIMITED
+     */
+    void setBudget(size_t bytes);
+
+    /**
+     * @brief Returns the budget.
+     * @return The most bytes the account may hold, or UNLIMITED
+     */
+    size_t getBudget() const;
+
+    /**
+     * @brief Returns the bytes held, headers included.
+     * @return The size in bytes
+     */
+    size_t totalBytes() const;
+
+    /**
+     * @brief Returns the bytes held for one structure, without headers.
+     * @param structure The structure
+     * @return The size in bytes
+     */
+    size_t bytes(Structure structure) const;
+
+    /**
+     * @brief Returns the most bytes the account has held at once.
+     * @return The size in bytes
+     */
+    size_t peakBytes() const;
+
+    /**
+     * @brief Returns the number of allocations refused for the budget.
+     * @return The number of allocations
+     */
+    size_t refusedCount() const;
+
+    /**
+     * @brief Returns the name of a structure, for reports.
+     * @param structure The structure
+     * @return The name
+     */
+    static const char* structureName(Structure structure);
+};
+
+#endif // MEMORYACCOUNT_H_
@@ -0,0 +1,126 @@
+// MinHash.cpp
+#include "MinHash.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath> // For std::pow
+
+/**
+ * @brief Constructor. Every set starts empty.
+ * @param count The number of sets.
+ */
+MinHash::MinHash(size_t count) : count{ count }, signatures{ new uint64_t[count * HASH_COUNT] } {
+    std::fill(signatures, signatures + count * HASH_COUNT, EMPTY); // No minimum yet
+}
+
+/**
+ * @brief Destructor.
+ */
+MinHash::~MinHash() {
+    delete[] signatures;
+}
+
+/**
+ * @brief Scrambles a 64-bit value (the finalizer of MurmurHash3).
+ * @param value The value.
+ * @return The scrambled value.
+ */
+uint64_t MinHash::mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+/**
+ * @brief Chooses the width of the bands for a similarity threshold: the widest band whose rise,
+ * at (1 / bands)^(1 / rows), is not above the threshold.
+ * @param threshold The least similarity of the pairs wanted.
+ * @return The number of positions per band, a divisor of HASH_COUNT.
+ */
+size_t MinHash::rowsPerBand(double threshold) {
+    size_t rows = 1;
+    while (rows * 2 <= HASH_COUNT) {
+        size_t wider = rows * 2;
+        double rise = std::pow(1.0 / static_cast<double>(HASH_COUNT / wider), 1.0 / static_cast<double>(wider));
+        if (rise > threshold) break; // Pairs just above the threshold would be missed too often
+        rows = wider;
+    }
+    return rows;
+}
+
+/**
+ * @brief Adds an element to a set. Each position hashes the element with its own seed.
+ * @param set The index of the set.
+ * @param element The hash of the element.
+ */
+void MinHash::add(size_t set, uint64_t element) {
+    uint64_t* signature = signatures + set * HASH_COUNT;
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+        uint64_t value = mix(element + (i + 1) * 0x9E3779B97F4A7C15ULL); // A different hash function per position
+        if (value < signature[i]) signature[i] = value;
+    }
+}
+
+/**
+ * @brief Estimates the Jaccard similarity of two sets from their signatures.
+ * @param first The index of one set.
+ * @param second The index of the other.
+ * @return The fraction of positions on which the signatures agree; 0 if either set is empty.
+ */
+double MinHash::similarity(size_t first, size_t second) const {
+    const uint64_t* a = signatures + first * HASH_COUNT;
+    const uint64_t* b = signatures + second * HASH_COUNT;
+    if (a[0] == EMPTY || b[0] == EMPTY) return 0.0; // Nothing to compare
+    size_t agree = 0;
+    for (size_t i = 0; i < HASH_COUNT; ++i) agree += a[i] == b[i];
+    return static_cast<double>(agree) / HASH_COUNT;
+}
+
+/**
+ * @brief Finds the pairs of non-empty sets that may be at least as similar as a threshold. Each band
+ * is bucketed by sorting the sets on a hash of their band, in parallel, and every two sets of a bucket
+ * whose bands really are equal become a candidate.
+ * @param threshold The least similarity of the pairs wanted.
+ * @return The candidate pairs (first < second), sorted and without duplicates.
+ */
+std::vector<std::pair<size_t, size_t>> MinHash::candidates(double threshold) const {
+    size_t rows = rowsPerBand(threshold);
+    size_t bands = HASH_COUNT / rows;
+    std::vector<std::vector<std::pair<size_t, size_t>>> found(bands); // The pairs of each band
+
+    ThreadPool::shared().parallelFor(bands, [this, rows, &found](size_t begin, size_t end) {
+        std::vector<std::pair<uint64_t, size_t>> keys; // (band hash, set), reused by the bands of this chunk
+        for (size_t band = begin; band < end; ++band) {
+            keys.clear();
+            for (size_t set = 0; set < count; ++set) {
+                if (signatures[set * HASH_COUNT] == EMPTY) continue; // An empty set is similar to nothing
+                const uint64_t* rows_of_set = signatures + set * HASH_COUNT + band * rows;
+                uint64_t key = 0;
+                for (size_t r = 0; r < rows; ++r) key = mix(key ^ rows_of_set[r]);
+                keys.emplace_back(key, set);
+            }
+            std::sort(keys.begin(), keys.end());
+
+            for (size_t first = 0; first < keys.size();) { // One bucket per run of equal keys
+                size_t last = first + 1;
+                while (last < keys.size() && keys[last].first == keys[first].first) last++;
+                for (size_t i = first; i < last; ++i) {
+                    const uint64_t* a = signatures + keys[i].second * HASH_COUNT + band * rows;
+                    for (size_t j = i + 1; j < last; ++j) {
+                        const uint64_t* b = signatures + keys[j].second * HASH_COUNT + band * rows;
+                        if (std::equal(a, a + rows, b)) found[band].emplace_back(keys[i].second, keys[j].second); // Sorted by set, so i's set is the smaller
+                    }
+                }
+                first = last;
+            }
+        }
+    }, 1);
+
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (const std::vector<std::pair<size_t, size_t>>& band_pairs : found) pairs.insert(pairs.end(), band_pairs.begin(), band_pairs.end());
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end()); // A pair may share several bands
+    return pairs;
+}
@@ -0,0 +1,85 @@
+// MinHash.h
+#ifndef MINHASH_H_
+#define MINHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class MinHash
+ * @brief MinHash signatures of a number of sets, and locality-sensitive hashing to find the similar pairs.
+ *
+ * The signature of a set holds, for each of HASH_COUNT hash functions, the least hash of its elements. Two
+ * sets agree on a given position with probability equal to their Jaccard similarity |A ∩ B| / |A ∪ B|, so
+ * the fraction of positions they agree on estimates it with a standard error of about 1 / sqrt(HASH_COUNT).
+ *
+ * To avoid comparing all pairs, the signatures are cut into bands of a few positions each. Sets whose band
+ * is identical land in the same bucket and become candidates; a pair with similarity s is a candidate with
+ * probability 1 - (1 - s^rows)^bands, which rises steeply around (1 / bands)^(1 / rows). The band width is
+ * chosen from the threshold so that this rise lies below it, trading a few extra candidates for recall.
+ */
+class MinHash {
+public:
+    static constexpr size_t HASH_COUNT = 128; ///< Positions of a signature
+    static constexpr uint64_t EMPTY = UINT64_MAX; ///< Every position of the signature of an empty set
+
+private:
+    size_t count; ///< Number of sets
+    uint64_t* signatures; ///< count rows of HASH_COUNT minima
+
+    /**
+     * @brief Scrambles a 64-bit value (the finalizer of MurmurHash3).
+     * @param value The value
+     * @return The scrambled value
+     */
+    static uint64_t mix(uint64_t value);
+
+    /**
+     * @brief Chooses the width of the bands for a similarity threshold.
+     * @param threshold The least similarity of the pairs wanted
+     * @return The number of positions per band, a divisor of HASH_COUNT
+     */
+    static size_t rowsPerBand(double threshold);
+
+public:
+    /**
+     * @brief Constructor. Every set starts empty.
+     * @param count The number of sets
+     */
+    explicit MinHash(size_t count);
+
+    /**
+     * @brief Destructor.
+     */
+    ~MinHash();
+
+    MinHash(const MinHash& other) = delete;
+    MinHash& operator=(const MinHash& other) = delete;
+
+    /**
+     * @brief Adds an element to a set. Different sets may be filled from different threads at once.
+     * @param set The index of the set
+     * @param element The hash of the element; equal elements must have equal hashes
+     */
+    void add(size_t set, uint64_t element);
+
+    /**
+     * @brief Estimates the Jaccard similarity of two sets from their signatures.
+     * @param first The index of one set
+     * @param second The index of the other
+     * @return The fraction of positions on which the signatures agree; 0 if either set is empty
+     */
+    double similarity(size_t first, size_t second) const;
+
+    /**
+     * @brief Finds the pairs of non-empty sets that may be at least as similar as a threshold, by banding.
+     * The bands are bucketed in parallel on the shared thread pool.
+     * @param threshold The least similarity of the pairs wanted
+     * @return The candidate pairs (first < second), sorted and without duplicates
+     */
+    std::vector<std::pair<size_t, size_t>> candidates(double threshold) const;
+};
+
+#endif // MINHASH_H_
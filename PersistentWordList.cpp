@@ -0,0 +1,609 @@
+// PersistentWordList.cpp
+#include "PersistentWordList.h"
+#include "WordFormatter.h"
+#include "MemoryAccount.h"
+#include <cstring>
+#include <new> // For placement new
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Returns the number of words in a subtree.
+ * @param node The subtree, or nullptr.
+ * @return Its word count.
+ */
+template <typename N>
+static inline uint32_t countOf(const N* node) {
+    return node == nullptr ? 0 : node->count;
+}
+
+/**
+ * @brief Returns the height of a subtree.
+ * @param node The subtree, or nullptr.
+ * @return Its height; 0 for an empty subtree.
+ */
+template <typename N>
+static inline int heightOf(const N* node) {
+    return node == nullptr ? 0 : node->height;
+}
+
+/**
+ * @brief Default constructor. Initializes an empty list.
+ */
+PersistentWordList::PersistentWordList() : root{ nullptr } {}
+
+/**
+ * @brief Destructor. Releases the tree.
+ */
+PersistentWordList::~PersistentWordList() {
+    release(root);
+}
+
+/**
+ * @brief Copy constructor. Shares the other list's tree.
+ * @param other The list to copy.
+ */
+PersistentWordList::PersistentWordList(const PersistentWordList& other) : root{ retain(other.root) } {}
+
+/**
+ * @brief Copy assignment operator. Shares the other list's tree.
+ * @param other The list to copy.
+ * @return A reference to this object.
+ */
+PersistentWordList& PersistentWordList::operator=(const PersistentWordList& other) {
+    Node* shared = retain(other.root); // Retain first, so that self-assignment keeps the tree alive
+    release(root);
+    root = shared;
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Takes over another list's tree.
+ * @param other The list to move from.
+ */
+PersistentWordList::PersistentWordList(PersistentWordList&& other) noexcept : root{ other.root } {
+    other.root = nullptr; // The other list becomes empty
+}
+
+/**
+ * @brief Move assignment operator. Takes over another list's tree.
+ * @param other The list to move from.
+ * @return A reference to this object.
+ */
+PersistentWordList& PersistentWordList::operator=(PersistentWordList&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        release(root);
+        root = other.root;
+        other.root = nullptr; // The other list becomes empty
+    }
+    return *this;
+}
+
+/**
+ * @brief Creates a node with a reference count of 1 and takes over one reference to each child.
+ * If the node cannot be allocated, the references to the children are dropped instead.
+ * @param word The word of the node.
+ * @param left The left subtree.
+ * @param right The right subtree.
+ * @return The new node.
+ */
+PersistentWordList::Node* PersistentWordList::makeNode(const Word& word, Node* left, Node* right) {
+    void* block = nullptr;
+    Node* node;
+    try {
+        block = MemoryAccount::current().allocate(sizeof(Node), MemoryAccount::Structure::Nodes);
+        node = new (block) Node{ word, left, right, 0, 0, { 1 } };
+    } catch (...) { // The node or the word's buffer was refused
+        MemoryAccount::deallocate(block, sizeof(Node), MemoryAccount::Structure::Nodes);
+        release(left);
+        release(right);
+        throw;
+    }
+    update(node);
+    return node;
+}
+
+/**
+ * @brief Adds a reference to a node.
+ * @param node The node, or nullptr.
+ * @return The node.
+ */
+PersistentWordList::Node* PersistentWordList::retain(Node* node) {
+    if (node != nullptr) node->refs.fetch_add(1, std::memory_order_relaxed); // The caller already holds a reference
+    return node;
+}
+
+/**
+ * @brief Drops a reference to a node, freeing it and releasing its children when it was the last one.
+ * @param node The node, or nullptr.
+ */
+void PersistentWordList::release(Node* node) {
+    while (node != nullptr && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) { // The last reference
+        release(node->left);
+        Node* right = node->right; // Released by the loop, so that long right spines do not recurse
+        node->~Node();
+        MemoryAccount::deallocate(node, sizeof(Node), MemoryAccount::Structure::Nodes);
+        node = right;
+    }
+}
+
+/**
+ * @brief Turns an owned reference into a node that may be changed.
+ * A count of 1 means the caller's reference is the only one, and the caller reached the node through
+ * nodes it could change, so no other list can see the node. The caller stores the result in the link
+ * it passed the node from, so the link never points to a released node; if the copy cannot be made,
+ * nothing changes.
+ * @param node An owned reference.
+ * @return An owned reference to a node only the caller can reach.
+ */
+PersistentWordList::Node* PersistentWordList::unshare(Node* node) {
+    if (node->refs.load(std::memory_order_acquire) == 1) return node; // Ours alone: change it in place
+    Node* copy = makeNode(node->word, retain(node->left), retain(node->right)); // Share the children
+    release(node); // Give up our reference to the shared original
+    return copy;
+}
+
+/**
+ * @brief Recomputes the count and height of a node from its children.
+ * @param node The node.
+ */
+void PersistentWordList::update(Node* node) {
+    node->count = countOf(node->left) + countOf(node->right) + 1;
+    int left = heightOf(node->left), right = heightOf(node->right);
+    node->height = static_cast<uint8_t>((left > right ? left : right) + 1);
+}
+
+/**
+ * @brief Rotates a subtree to the right.
+ * @param node An owned, unshared node with a left child.
+ * @return The owned new root.
+ */
+PersistentWordList::Node* PersistentWordList::rotateRight(Node* node) {
+    Node* pivot = unshare(node->left); // Its right link changes
+    node->left = pivot->right;
+    pivot->right = node;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+/**
+ * @brief Rotates a subtree to the left.
+ * @param node An owned, unshared node with a right child.
+ * @return The owned new root.
+ */
+PersistentWordList::Node* PersistentWordList::rotateLeft(Node* node) {
+    Node* pivot = unshare(node->right); // Its left link changes
+    node->right = pivot->left;
+    pivot->left = node;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+/**
+ * @brief Restores the AVL balance of a node.
+ * @param node An owned, unshared node.
+ * @return The owned root of the balanced subtree.
+ */
+PersistentWordList::Node* PersistentWordList::rebalance(Node* node) {
+    update(node);
+    int balance = heightOf(node->left) - heightOf(node->right);
+    if (balance > 1) { // Left-heavy
+        if (heightOf(node->left->left) < heightOf(node->left->right)) {
+            node->left = rotateLeft(unshare(node->left)); // Left-right case
+        }
+        return rotateRight(node);
+    }
+    if (balance < -1) { // Right-heavy
+        if (heightOf(node->right->right) < heightOf(node->right->left)) {
+            node->right = rotateRight(unshare(node->right)); // Right-left case
+        }
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+/**
+ * @brief Unshares the nodes that rebalancing may rotate once a word is removed below one side of a node:
+ * the other child when it is the taller one, and its inner child when the rotation would be a double one.
+ * Those subtrees do not change with the removal, so the choice is exact, and after the removal rebalancing
+ * allocates nothing.
+ * @param node An unshared node.
+ * @param from_left True if the word is removed from the left subtree.
+ */
+void PersistentWordList::unshareForRemoval(Node* node, bool from_left) {
+    Node*& sibling = from_left ? node->right : node->left;
+    Node* removed_side = from_left ? node->left : node->right;
+    if (heightOf(sibling) <= heightOf(removed_side)) return; // Removing cannot unbalance the node
+    sibling = unshare(sibling);
+    Node*& outer = from_left ? sibling->right : sibling->left;
+    Node*& inner = from_left ? sibling->left : sibling->right;
+    if (heightOf(outer) < heightOf(inner)) inner = unshare(inner); // It becomes the root of a double rotation
+}
+
+/**
+ * @brief Inserts a word that is not in a subtree, copying the shared nodes on its path.
+ * Each shared node is replaced by its copy in the link leading to it before anything below it changes, and
+ * a copy holds the same words, so if an allocation fails the subtree still holds the same words. Once the
+ * word is in, rebalancing only rotates nodes of the path, which are unshared by then, so it cannot fail.
+ * @param link The link to the subtree, in a node only this list can reach, or the root.
+ * @param word The word to insert.
+ */
+void PersistentWordList::insert(Node*& link, const Word& word) {
+    if (link == nullptr) {
+        link = makeNode(word, nullptr, nullptr);
+        return;
+    }
+    link = unshare(link);
+    Node* node = link;
+    insert(strcmp(word.c_str(), node->word.c_str()) < 0 ? node->left : node->right, word);
+    link = rebalance(node);
+}
+
+/**
+ * @brief Removes the smallest word of a subtree, copying the shared nodes on its path.
+ * Allocation only happens on the way down, before any word is removed, as in erase.
+ * @param link The link to a non-empty subtree, in a node only this list can reach.
+ * @param smallest Receives the removed word.
+ */
+void PersistentWordList::eraseSmallest(Node*& link, Word& smallest) {
+    link = unshare(link);
+    Node* node = link;
+    if (node->left == nullptr) { // This is the smallest word
+        smallest = std::move(node->word);
+        link = node->right; // The link takes over the node's reference to its right subtree
+        node->right = nullptr;
+        release(node);
+        return;
+    }
+    unshareForRemoval(node, true);
+    eraseSmallest(node->left, smallest);
+    link = rebalance(node);
+}
+
+/**
+ * @brief Removes a word that is in a subtree, copying the shared nodes on its path.
+ * The path and the nodes rebalancing may rotate are unshared on the way down, in the links leading to them,
+ * so if an allocation fails the subtree still holds the same words, and nothing is allocated on the way up.
+ * @param link The link to the subtree, in a node only this list can reach, or the root.
+ * @param word The word to remove.
+ */
+void PersistentWordList::erase(Node*& link, const Word& word) {
+    link = unshare(link);
+    Node* node = link;
+    int cmp = strcmp(word.c_str(), node->word.c_str());
+    if (cmp < 0) {
+        unshareForRemoval(node, true);
+        erase(node->left, word);
+    } else if (cmp > 0) {
+        unshareForRemoval(node, false);
+        erase(node->right, word);
+    } else if (node->left == nullptr || node->right == nullptr) { // At most one child takes its place
+        link = node->left != nullptr ? node->left : node->right; // The link takes over the node's reference to it
+        node->left = node->right = nullptr;
+        release(node);
+        return;
+    } else { // Replace the word with its successor
+        unshareForRemoval(node, false);
+        eraseSmallest(node->right, node->word);
+    }
+    link = rebalance(node);
+}
+
+/**
+ * @brief Builds a balanced subtree from sorted words.
+ * @param words The words, in sorted order and without duplicates.
+ * @param count The number of words.
+ * @return The owned subtree.
+ */
+PersistentWordList::Node* PersistentWordList::build(const Word* words, size_t count) {
+    if (count == 0) return nullptr;
+    size_t middle = count / 2;
+    Node* left = build(words, middle);
+    Node* right;
+    try {
+        right = build(words + middle + 1, count - middle - 1);
+    } catch (...) {
+        release(left);
+        throw;
+    }
+    return makeNode(words[middle], left, right); // Releases both subtrees if it throws
+}
+
+/**
+ * @brief Replaces the contents with the words of a sorted list.
+ * @param sortedWords The words, in sorted order and without duplicates.
+ */
+void PersistentWordList::assign(const WordList& sortedWords) {
+    size_t count = sortedWords.length();
+    Word* words = new Word[count]; // The words as an array, to split at the middle
+    Node* built;
+    try {
+        size_t i = 0;
+        sortedWords.forEach([&](const Word& word) { words[i++] = word; });
+        built = build(words, count);
+    } catch (...) { // The list keeps its words
+        delete[] words;
+        throw;
+    }
+    delete[] words;
+    release(root);
+    root = built;
+}
+
+/**
+ * @brief Copies the words into a new sorted WordList.
+ * @return The words as a list.
+ */
+WordList PersistentWordList::toWordList() const {
+    WordList words;
+    forEach([&words](const Word& word) { words.push_back(word); });
+    return words;
+}
+
+/**
+ * @brief Inserts a word in sorted position.
+ * The word is looked up first, so that inserting a word already present copies nothing.
+ * @param word The word to insert.
+ * @return True if the word was inserted, false if it was already present.
+ */
+bool PersistentWordList::insertSorted(const Word& word) {
+    if (lookup(word)) return false;
+    insert(root, word); // Leaves the words as they were if it throws
+    return true;
+}
+
+/**
+ * @brief Removes a word.
+ * The word is looked up first, so that removing a missing word copies nothing.
+ * @param word The word to remove.
+ * @return True if the word was found and removed, false otherwise.
+ */
+bool PersistentWordList::remove(const Word& word) {
+    if (!lookup(word)) return false;
+    erase(root, word); // Leaves the words as they were if it throws
+    return true;
+}
+
+/**
+ * @brief Removes all words from this list.
+ */
+void PersistentWordList::clear() {
+    release(root);
+    root = nullptr;
+}
+
+/**
+ * @brief Checks if the given word is in the list.
+ * @param word The word to look up.
+ * @return True if the word is found, false otherwise.
+ */
+bool PersistentWordList::lookup(const Word& word) const {
+    const char* key = word.c_str();
+    for (const Node* node = root; node != nullptr;) {
+        int cmp = strcmp(key, node->word.c_str());
+        if (cmp == 0) return true;
+        node = cmp < 0 ? node->left : node->right;
+    }
+    return false;
+}
+
+/**
+ * @brief Looks up a batch of words, one descent each.
+ * @param words The words to look up.
+ * @param count The number of words.
+ * @param found Array of count elements; found[i] is set to whether words[i] is in the list.
+ */
+void PersistentWordList::lookupMany(const Word* words, size_t count, bool* found) const {
+    for (size_t i = 0; i < count; ++i) found[i] = lookup(words[i]);
+}
+
+/**
+ * @brief Returns a copy of the word at the given index, steering by the subtree counts.
+ * @param index The index of the word, in sorted order.
+ * @return A copy of the word.
+ */
+Word PersistentWordList::fetchWord(size_t index) const {
+    if (index >= length()) throw std::runtime_error("Index out of range");
+    const Node* node = root;
+    while (true) {
+        size_t left = countOf(node->left);
+        if (index == left) return node->word;
+        if (index < left) {
+            node = node->left;
+        } else {
+            index -= left + 1;
+            node = node->right;
+        }
+    }
+}
+
+/**
+ * @brief Appends words of a subtree to a list, skipping and stopping as page does.
+ * Subtrees that lie wholly before the page are skipped by their counts without being visited.
+ * @param node The subtree.
+ * @param skip Words still to skip.
+ * @param limit Words still to collect.
+ * @param out The list to append to.
+ */
+void PersistentWordList::collect(const Node* node, size_t& skip, size_t& limit, WordList& out) {
+    while (node != nullptr && limit > 0) {
+        size_t left = countOf(node->left);
+        if (skip < left) {
+            collect(node->left, skip, limit, out); // Uses up the rest of skip
+        } else {
+            skip -= left; // The whole left subtree comes before the page
+        }
+        if (limit == 0) return;
+        if (skip > 0) {
+            skip--;
+        } else {
+            out.push_back(node->word);
+            limit--;
+        }
+        node = node->right;
+    }
+}
+
+/**
+ * @brief Returns the words at positions [offset, offset + limit), in sorted order.
+ * @param offset The position of the first word.
+ * @param limit The maximum number of words.
+ * @return The words of the page; empty when offset is past the end.
+ */
+WordList PersistentWordList::page(size_t offset, size_t limit) const {
+    WordList words;
+    collect(root, offset, limit, words);
+    return words;
+}
+
+/**
+ * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+ * @param from Where to start.
+ * @param limit The maximum number of words.
+ * @return The words of the page.
+ */
+WordList PersistentWordList::range(const Word& from, size_t limit) const {
+    return page(rank(from), limit);
+}
+
+/**
+ * @brief Counts the words less than a given word.
+ * @param word The word to rank.
+ * @return The number of words that sort before it.
+ */
+size_t PersistentWordList::rank(const Word& word) const {
+    const char* key = word.c_str();
+    size_t before = 0;
+    for (const Node* node = root; node != nullptr;) {
+        int cmp = strcmp(key, node->word.c_str());
+        if (cmp <= 0) {
+            if (cmp == 0) return before + countOf(node->left);
+            node = node->left;
+        } else {
+            before += countOf(node->left) + 1; // The node and everything left of it
+            node = node->right;
+        }
+    }
+    return before;
+}
+
+/**
+ * @brief Counts the words whose first byte is less than a given byte.
+ * @param letter The byte.
+ * @return The number of words that sort before every word starting with the byte.
+ */
+size_t PersistentWordList::rankOfLetter(unsigned char letter) const {
+    size_t before = 0;
+    for (const Node* node = root; node != nullptr;) {
+        if (static_cast<unsigned char>(node->word.c_str()[0]) < letter) { // An empty word has first byte 0 and sorts first
+            before += countOf(node->left) + 1;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return before;
+}
+
+/**
+ * @brief Returns the words starting with the given letter.
+ * @param letter The initial letter of the words to return.
+ * @return A sorted list of the matching words.
+ */
+WordList PersistentWordList::wordsStartingWith(const char letter) const {
+    unsigned char first = static_cast<unsigned char>(letter);
+    if (first == 0) return WordList(); // No word starts with the terminator
+    size_t begin = rankOfLetter(first);
+    size_t end = first == 0xFF ? length() : rankOfLetter(static_cast<unsigned char>(first + 1));
+    return page(begin, end - begin);
+}
+
+/**
+ * @brief Calls a function on every word of a subtree, in sorted order.
+ * @param node The subtree.
+ * @param visit The function to call.
+ */
+void PersistentWordList::visitInOrder(const Node* node, const std::function<void(const Word&)>& visit) {
+    while (node != nullptr) {
+        visitInOrder(node->left, visit);
+        visit(node->word);
+        node = node->right; // Loop on the right, so that only the height recurses
+    }
+}
+
+/**
+ * @brief Calls a function on every word, in sorted order.
+ * @param visit The function to call with each word.
+ */
+void PersistentWordList::forEach(const std::function<void(const Word&)>& visit) const {
+    visitInOrder(root, visit);
+}
+
+/**
+ * @brief Calls a function on every word this list alone can reach, in sorted order, so that it can share
+ * the word's buffer. A node with more than one reference is reachable from a copy, and so is everything
+ * below it, so such subtrees are skipped: a copy may be read on another thread, and sharing a buffer frees
+ * the word's old one.
+ * @param visit The function to call with each word.
+ */
+void PersistentWordList::forEachStored(const std::function<void(Word&)>& visit) {
+    auto owned = [](Node* node) { // Nothing but this list can reach the node
+        return node != nullptr && node->refs.load(std::memory_order_acquire) == 1;
+    };
+    std::vector<Node*> path; // Nodes whose left subtree is being visited
+    Node* node = owned(root) ? root : nullptr;
+    while (node != nullptr || !path.empty()) {
+        for (; node != nullptr; node = owned(node->left) ? node->left : nullptr) path.push_back(node);
+        node = path.back();
+        path.pop_back();
+        visit(node->word);
+        node = owned(node->right) ? node->right : nullptr;
+    }
+}
+
+/**
+ * @brief Prints the words with a maximum of n words per line, in the same layout as WordList::print.
+ * @param sout The output stream to print to.
+ * @param n The maximum number of words per line.
+ * @return The total number of words printed.
+ */
+int PersistentWordList::print(std::ostream& sout, const int n) const {
+    WordFormatter formatter(sout, n);
+    forEach([&formatter](const Word& word) { formatter.put(word.c_str(), word.length()); });
+    return formatter.finish();
+}
+
+/**
+ * @brief Returns the memory of the nodes reachable from this list.
+ * @return The size in bytes.
+ */
+size_t PersistentWordList::memoryBytes() const {
+    size_t bytes = length() * sizeof(Node);
+    forEach([&bytes](const Word& word) { bytes += word.heapBytes(); }); // Characters of words too long to be stored inline
+    return bytes;
+}
+
+/**
+ * @brief Counts the words whose node is shared with another list.
+ * A node with more than one reference is shared, and so is everything below it.
+ * @return The number of shared words.
+ */
+size_t PersistentWordList::sharedCount() const {
+    size_t shared = 0;
+    const Node* stack[128]; // Deeper than any AVL tree of 2^64 words
+    size_t depth = 0;
+    if (root != nullptr) stack[depth++] = root;
+    while (depth > 0) {
+        const Node* node = stack[--depth];
+        if (node->refs.load(std::memory_order_relaxed) > 1) {
+            shared += node->count; // The whole subtree
+            continue;
+        }
+        if (node->left != nullptr) stack[depth++] = node->left;
+        if (node->right != nullptr) stack[depth++] = node->right;
+    }
+    return shared;
+}
@@ -0,0 +1,328 @@
+// PersistentWordList.h
+#ifndef PERSISTENTWORDLIST_H_
+#define PERSISTENTWORDLIST_H_
+
+#include "Word.h"
+#include "WordList.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+
+/**
+ * @class PersistentWordList
+ * @brief A sorted set of words in a balanced search tree whose nodes are shared between copies.
+ *
+ * The tree is an AVL tree in which every node also counts the words below it, so positions (fetchWord,
+ * page, rank) are found in O(log N) like lookups. Nodes are reference counted and never changed while
+ * another tree can reach them: copying a list only takes a reference to its root, which makes copies
+ * O(1) whatever the size, and a copy is a snapshot that later changes to either list do not affect.
+ *
+ * A change copies only the nodes on the path from the root to the word (path copying), O(log N) of them;
+ * everything else stays shared. Nodes that this list alone can reach are changed in place instead, so a
+ * list that was never copied pays no copying at all. Reference counts are atomic, so copies of one list
+ * may be taken, used and destroyed on different threads; one list object still needs external
+ * synchronization between a writer and its readers, as WordList does.
+ */
+class PersistentWordList {
+private:
+    /**
+     * @brief One node of the tree, holding one word.
+     */
+    struct Node {
+        Word word; ///< The word
+        Node* left; ///< Words less than this one
+        Node* right; ///< Words greater than this one
+        uint32_t count; ///< Number of words in this subtree, this one included
+        uint8_t height; ///< Height of this subtree; 1 for a leaf
+        std::atomic<uint32_t> refs; ///< Parents and lists pointing here; shared (never changed) when above 1
+    };
+
+    Node* root; ///< The tree, or nullptr when the list is empty
+
+    /**
+     * @brief Creates a node with a reference count of 1 and takes over one reference to each child.
+     * @param word The word of the node
+     * @param left The left subtree
+     * @param right The right subtree
+     * @return The new node
+     */
+    static Node* makeNode(const Word& word, Node* left, Node* right);
+
+    /**
+     * @brief Adds a reference to a node.
+     * @param node The node, or nullptr
+     * @return The node
+     */
+    static Node* retain(Node* node);
+
+    /**
+     * @brief Drops a reference to a node, freeing it and releasing its children when it was the last one.
+     * @param node The node, or nullptr
+     */
+    static void release(Node* node);
+
+    /**
+     * @brief Turns an owned reference into a node that may be changed: the node itself if nobody else
+     * references it, otherwise a private copy sharing its children.
+     * @param node An owned reference
+     * @return An owned reference to a node only the caller can reach
+     */
+    static Node* unshare(Node* node);
+
+    /**
+     * @brief Recomputes the count and height of a node from its children.
+     * @param node The node
+     */
+    static void update(Node* node);
+
+    /**
+     * @brief Restores the AVL balance of a node whose subtrees differ in height by at most 2.
+     * @param node An owned, unshared node
+     * @return The owned root of the balanced subtree
+     */
+    static Node* rebalance(Node* node);
+
+    /**
+     * @brief Rotates a subtree to the right; its left child becomes its root.
+     * @param node An owned, unshared node with a left child
+     * @return The owned new root
+     */
+    static Node* rotateRight(Node* node);
+
+    /**
+     * @brief Rotates a subtree to the left; its right child becomes its root.
+     * @param node An owned, unshared node with a right child
+     * @return The owned new root
+     */
+    static Node* rotateLeft(Node* node);
+
+    /**
+     * @brief Unshares the nodes that rebalancing may rotate once a word is removed below one side of a node.
+     * @param node An unshared node
+     * @param from_left True if the word is removed from the left subtree
+     */
+    static void unshareForRemoval(Node* node, bool from_left);
+
+    /**
+     * @brief Inserts a word that is not in a subtree. If an allocation fails, the subtree keeps its words.
+     * @param link The link to the subtree, in a node only this list can reach, or the root; receives the new subtree
+     * @param word The word to insert
+     */
+    static void insert(Node*& link, const Word& word);
+
+    /**
+     * @brief Removes a word that is in a subtree. If an allocation fails, the subtree keeps its words.
+     * @param link The link to the subtree, in a node only this list can reach, or the root; receives the new subtree
+     * @param word The word to remove
+     */
+    static void erase(Node*& link, const Word& word);
+
+    /**
+     * @brief Removes the smallest word of a subtree. If an allocation fails, the subtree keeps its words.
+     * @param link The link to a non-empty subtree, in a node only this list can reach; receives the new subtree
+     * @param smallest Receives the removed word
+     */
+    static void eraseSmallest(Node*& link, Word& smallest);
+
+    /**
+     * @brief Builds a balanced subtree from sorted words.
+     * @param words The words, in sorted order and without duplicates
+     * @param count The number of words
+     * @return The owned subtree
+     */
+    static Node* build(const Word* words, size_t count);
+
+    /**
+     * @brief Appends words of a subtree to a list, skipping and stopping as page does.
+     * @param node The subtree
+     * @param skip Words still to skip before the first one collected; decremented as they are passed
+     * @param limit Words still to collect; decremented as they are collected
+     * @param out The list to append to
+     */
+    static void collect(const Node* node, size_t& skip, size_t& limit, WordList& out);
+
+    /**
+     * @brief Calls a function on every word of a subtree, in sorted order.
+     * @param node The subtree
+     * @param visit The function to call
+     */
+    static void visitInOrder(const Node* node, const std::function<void(const Word&)>& visit);
+
+    /**
+     * @brief Counts the words whose first byte is less than a given byte.
+     * @param letter The byte
+     * @return The number of words that sort before every word starting with the byte
+     */
+    size_t rankOfLetter(unsigned char letter) const;
+
+public:
+    /**
+     * @brief Default constructor. Initializes an empty list.
+     */
+    PersistentWordList();
+
+    /**
+     * @brief Destructor. Releases the tree; nodes still shared with copies stay alive.
+     */
+    ~PersistentWordList();
+
+    /**
+     * @brief Copy constructor. Shares the other list's tree: O(1).
+     * @param other The list to copy
+     */
+    PersistentWordList(const PersistentWordList& other);
+
+    /**
+     * @brief Copy assignment operator. Shares the other list's tree: O(1).
+     * @param other The list to copy
+     * @return A reference to this object
+     */
+    PersistentWordList& operator=(const PersistentWordList& other);
+
+    /**
+     * @brief Move constructor. Takes over another list's tree.
+     * @param other The list to move from
+     */
+    PersistentWordList(PersistentWordList&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator. Takes over another list's tree.
+     * @param other The list to move from
+     * @return A reference to this object
+     */
+    PersistentWordList& operator=(PersistentWordList&& other) noexcept;
+
+    /**
+     * @brief Replaces the contents with the words of a sorted list, building a balanced tree in O(N).
+     * @param sortedWords The words, in sorted order and without duplicates
+     */
+    void assign(const WordList& sortedWords);
+
+    /**
+     * @brief Copies the words into a new sorted WordList.
+     * @return The words as a list
+     */
+    WordList toWordList() const;
+
+    /**
+     * @brief Inserts a word in sorted position, copying only the nodes on its path that are shared. O(log N).
+     * @param word The word to insert
+     * @return true if the word was inserted, false if it was already present
+     */
+    bool insertSorted(const Word& word);
+
+    /**
+     * @brief Removes a word, copying only the nodes on its path that are shared. O(log N).
+     * @param word The word to remove
+     * @return true if the word was found and removed, false otherwise
+     */
+    bool remove(const Word& word);
+
+    /**
+     * @brief Removes all words from this list. Copies keep theirs.
+     */
+    void clear();
+
+    /**
+     * @brief Checks if the given word is in the list. O(log N).
+     * @param word The word to look up
+     * @return true if the word is found, false otherwise
+     */
+    bool lookup(const Word& word) const;
+
+    /**
+     * @brief Looks up a batch of words.
+     * @param words The words to look up
+     * @param count The number of words
+     * @param found Array of count elements; found[i] is set to whether words[i] is in the list
+     */
+    void lookupMany(const Word* words, size_t count, bool* found) const;
+
+    /**
+     * @brief Returns a copy of the word at the given index. O(log N).
+     * @param index The index of the word, in sorted order
+     * @return A copy of the word
+     * @throws std::runtime_error if the index is out of range.
+     */
+    Word fetchWord(size_t index) const;
+
+    /**
+     * @brief Returns the words at positions [offset, offset + limit), in sorted order. O(log N + limit).
+     * @param offset The position of the first word
+     * @param limit The maximum number of words
+     * @return The words of the page; empty when offset is past the end
+     */
+    WordList page(size_t offset, size_t limit) const;
+
+    /**
+     * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+     * @param from Where to start; it need not be in the list
+     * @param limit The maximum number of words
+     * @return The words of the page
+     */
+    WordList range(const Word& from, size_t limit) const;
+
+    /**
+     * @brief Counts the words less than a given word. O(log N).
+     * @param word The word to rank; it need not be in the list
+     * @return The number of words that sort before it
+     */
+    size_t rank(const Word& word) const;
+
+    /**
+     * @brief Determines whether the list is empty.
+     * @return True if the list has no words, false otherwise
+     */
+    inline bool isEmpty() const { return root == nullptr; }
+
+    /**
+     * @brief Returns the number of words.
+     * @return The number of words
+     */
+    inline size_t length() const { return root == nullptr ? 0 : root->count; }
+
+    /**
+     * @brief Returns the words starting with the given letter, found by two rank descents.
+     * @param letter The initial letter of the words to return
+     * @return A sorted list of the matching words
+     */
+    WordList wordsStartingWith(const char letter) const;
+
+    /**
+     * @brief Calls a function on every word, in sorted order.
+     * @param visit The function to call with each word
+     */
+    void forEach(const std::function<void(const Word&)>& visit) const;
+
+    /**
+     * @brief Calls a function on every stored word, in sorted order, so that it can share the word's buffer
+     * with an equal word (see Word::shareBuffer). The function must not change the characters. Subtrees shared
+     * with copies are skipped, since the copies may be read on other threads meanwhile.
+     * @param visit The function to call with each word
+     */
+    void forEachStored(const std::function<void(Word&)>& visit);
+
+    /**
+     * @brief Prints the words with a maximum of n words per line, in the same layout as WordList::print.
+     * @param sout The output stream to print to
+     * @param n The maximum number of words per line, or WordFormatter::FIT_TERMINAL to fit the terminal width
+     * @return The total number of words printed
+     */
+    int print(std::ostream& sout, const int n = 5) const;
+
+    /**
+     * @brief Returns the memory of the nodes reachable from this list, including nodes shared with copies.
+     * @return The size in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Counts the nodes this list shares with other lists, directly or through a shared ancestor.
+     * @return The number of words whose node is shared
+     */
+    size_t sharedCount() const;
+};
+
+#endif // PERSISTENTWORDLIST_H_
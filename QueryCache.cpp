@@ -0,0 +1,130 @@
+// QueryCache.cpp
+#include "QueryCache.h"
+#include <utility>
+
+/**
+ * @brief Constructor.
+ * @param capacity Maximum number of entries; 0 disables caching.
+ */
+QueryCache::QueryCache(size_t capacity) : capacity{ capacity }, hits{ 0 }, misses{ 0 }, invalidations{ 0 } {}
+
+/**
+ * @brief Builds the key of a query: one byte for the kind, then the argument.
+ * @param kind The kind of query.
+ * @param argument The bytes of the argument.
+ * @param length The number of bytes.
+ * @return The key.
+ */
+std::string QueryCache::makeKey(Kind kind, const char* argument, size_t length) {
+    std::string key(1, static_cast<char>(kind));
+    key.append(argument, length);
+    return key;
+}
+
+/**
+ * @brief Returns the cached result of a query if it was computed from categories with the given stamps.
+ * @param kind The kind of query.
+ * @param argument The bytes of the argument.
+ * @param length The number of bytes.
+ * @param versions The current stamp of each category.
+ * @param count The number of categories.
+ * @return The result, or nullptr if it must be computed.
+ */
+std::shared_ptr<const QueryCache::Result> QueryCache::find(Kind kind, const char* argument, size_t length,
+                                                           const uint64_t* versions, size_t count) {
+    std::string key = makeKey(kind, argument, length);
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    std::list<Entry>::iterator entry = found->second;
+    bool current = entry->versions.size() == count;
+    for (size_t i = 0; current && i < count; ++i) current = entry->versions[i] == versions[i];
+    if (!current) { // Some category changed, or categories were added, removed or reordered
+        index.erase(found);
+        entries.erase(entry);
+        invalidations++;
+        misses++;
+        return nullptr;
+    }
+
+    entries.splice(entries.begin(), entries, entry); // Now the most recently used
+    hits++;
+    return entry->result;
+}
+
+/**
+ * @brief Caches the result of a query, dropping the least recently used entry if the cache is full.
+ * @param kind The kind of query.
+ * @param argument The bytes of the argument.
+ * @param length The number of bytes.
+ * @param versions The stamp of each category the result was computed from.
+ * @param count The number of categories.
+ * @param result The result.
+ */
+void QueryCache::store(Kind kind, const char* argument, size_t length, const uint64_t* versions, size_t count,
+                       std::shared_ptr<const Result> result) {
+    if (capacity == 0) return; // Caching is off
+    std::string key = makeKey(kind, argument, length);
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto found = index.find(key);
+    if (found != index.end()) { // Computed concurrently by another caller: keep the newer one
+        entries.erase(found->second);
+        index.erase(found);
+    } else if (entries.size() == capacity) { // Full: drop the least recently used
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+
+    entries.push_front(Entry{ key, std::vector<uint64_t>(versions, versions + count), std::move(result) });
+    index.emplace(std::move(key), entries.begin());
+}
+
+/**
+ * @brief Drops every entry. The statistics are kept.
+ */
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    index.clear();
+    entries.clear();
+}
+
+/**
+ * @brief Returns the number of lookups answered from the cache.
+ * @return The number of hits.
+ */
+size_t QueryCache::hitCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return hits;
+}
+
+/**
+ * @brief Returns the number of lookups that had to compute their result.
+ * @return The number of misses.
+ */
+size_t QueryCache::missCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return misses;
+}
+
+/**
+ * @brief Returns the number of misses caused by a category changing since the result was computed.
+ * @return The number of invalidated entries.
+ */
+size_t QueryCache::invalidationCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return invalidations;
+}
+
+/**
+ * @brief Returns the number of cached results.
+ * @return The number of entries.
+ */
+size_t QueryCache::length() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
@@ -0,0 +1,139 @@
+// QueryCache.h
+#ifndef QUERYCACHE_H_
+#define QUERYCACHE_H_
+
+#include "WordList.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class QueryCache
+ * @brief A bounded, least-recently-used cache of the results of queries over all categories.
+ *
+ * An entry is keyed by the kind of query and its argument, and records the version stamp of every
+ * category at the time the result was computed (see WordCat::getVersion). A lookup returns the entry
+ * only if the categories still have exactly those stamps, so a result is reused until one of the
+ * categories it was computed from changes, and never after. Entries are shared with the callers,
+ * who read the result in place: a repeated query costs one hash lookup and one pass over the stamps.
+ *
+ * All members lock an internal mutex, so const queries on different threads may share one cache.
+ */
+class QueryCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64; ///< Entries kept before the least recently used is dropped
+
+    /**
+     * @brief The queries whose results are cached.
+     */
+    enum class Kind : char {
+        Lookup = 'l', ///< Which categories have a word (one flag per category)
+        StartingWith = 's' ///< The words of each category starting with a letter (one list per category)
+    };
+
+    /**
+     * @brief The result of one query over all categories, in category order.
+     */
+    struct Result {
+        size_t count{ 0 }; ///< Number of categories
+        std::unique_ptr<bool[]> found; ///< Lookup: found[i] tells whether category i has the word
+        std::unique_ptr<WordList[]> lists; ///< StartingWith: lists[i] holds the matching words of category i
+    };
+
+private:
+    /**
+     * @brief One cached result and what it was computed from.
+     */
+    struct Entry {
+        std::string key; ///< The kind followed by the argument
+        std::vector<uint64_t> versions; ///< Stamp of each category when the result was computed
+        std::shared_ptr<const Result> result; ///< The result, shared with callers still reading it
+    };
+
+    size_t capacity; ///< Maximum number of entries
+    std::list<Entry> entries; ///< The entries, most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index; ///< The entries by key
+    size_t hits; ///< Lookups answered from the cache
+    size_t misses; ///< Lookups that found no entry
+    size_t invalidations; ///< Lookups that found an entry computed from older contents
+    mutable std::mutex lock; ///< Serializes every member
+
+    /**
+     * @brief Builds the key of a query.
+     * @param kind The kind of query
+     * @param argument The bytes of the argument
+     * @param length The number of bytes
+     * @return The key
+     */
+    static std::string makeKey(Kind kind, const char* argument, size_t length);
+
+public:
+    /**
+     * @brief Constructor.
+     * @param capacity Maximum number of entries; 0 disables caching
+     */
+    explicit QueryCache(size_t capacity = DEFAULT_CAPACITY);
+
+    QueryCache(const QueryCache& other) = delete; // Owners start a fresh cache instead
+    QueryCache& operator=(const QueryCache& other) = delete;
+
+    /**
+     * @brief Returns the cached result of a query if it was computed from categories with the given stamps.
+     * An entry computed from other stamps is dropped.
+     * @param kind The kind of query
+     * @param argument The bytes of the argument
+     * @param length The number of bytes
+     * @param versions The current stamp of each category
+     * @param count The number of categories
+     * @return The result, or nullptr if it must be computed
+     */
+    std::shared_ptr<const Result> find(Kind kind, const char* argument, size_t length, const uint64_t* versions, size_t count);
+
+    /**
+     * @brief Caches the result of a query, dropping the least recently used entry if the cache is full.
+     * @param kind The kind of query
+     * @param argument The bytes of the argument
+     * @param length The number of bytes
+     * @param versions The stamp of each category the result was computed from
+     * @param count The number of categories
+     * @param result The result
+     */
+    void store(Kind kind, const char* argument, size_t length, const uint64_t* versions, size_t count,
+               std::shared_ptr<const Result> result);
+
+    /**
+     * @brief Drops every entry. The statistics are kept.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of lookups answered from the cache.
+     * @return The number of hits
+     */
+    size_t hitCount() const;
+
+    /**
+     * @brief Returns the number of lookups that had to compute their result, including invalidated ones.
+     * @return The number of misses
+     */
+    size_t missCount() const;
+
+    /**
+     * @brief Returns the number of misses caused by a category changing since the result was computed.
+     * @return The number of invalidated entries
+     */
+    size_t invalidationCount() const;
+
+    /**
+     * @brief Returns the number of cached results.
+     * @return The number of entries
+     */
+    size_t length() const;
+};
+
+#endif // QUERYCACHE_H_
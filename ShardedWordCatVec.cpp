@@ -0,0 +1,177 @@
+// ShardedWordCatVec.cpp
+#include "ShardedWordCatVec.h"
+#include "ThreadPool.h"
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Constructor. Creates the given number of empty shards.
+ * @param shard_count The number of shards. 0 selects one shard per hardware thread.
+ */
+ShardedWordCatVec::ShardedWordCatVec(size_t shard_count) : shards{ nullptr }, shard_count{ shard_count } {
+    if (this->shard_count == 0) this->shard_count = std::thread::hardware_concurrency(); // One shard per core
+    if (this->shard_count == 0) this->shard_count = 1; // hardware_concurrency may be unknown
+    shards = new Shard[this->shard_count]; // Allocate the shards
+}
+
+/**
+ * @brief Destructor. Deallocates the shards and their categories.
+ */
+ShardedWordCatVec::~ShardedWordCatVec() {
+    delete[] shards; // Deletes the shards to free memory
+    shard_count = 0; // Resets the shard count
+}
+
+/**
+ * @brief Returns the shard responsible for the given category name.
+ * The hash is mixed before taking the remainder so that each shard's own name index
+ * still sees well-distributed low bits.
+ * @param category The category name.
+ * @return The shard that owns the category.
+ */
+ShardedWordCatVec::Shard& ShardedWordCatVec::shardFor(const Word& category) const {
+    size_t h = category.hash(); // Hash of the category name
+    return shards[((h >> 16) ^ (h >> 7)) % shard_count]; // Pick the shard from the mixed hash
+}
+
+/**
+ * @brief Returns the number of shards.
+ * @return The number of shards.
+ */
+size_t ShardedWordCatVec::shardCount() const {
+    return shard_count;
+}
+
+/**
+ * @brief Adds a copy of a category to its shard.
+ * @param new_category The new category to add.
+ * @return True if the category was added successfully, false if it already exists.
+ */
+bool ShardedWordCatVec::addCategory(const WordCat& new_category) {
+    return addCategory(WordCat(new_category)); // Copy outside the lock, then move the copy in
+}
+
+/**
+ * @brief Adds a category to its shard by moving it in.
+ * @param new_category The new category to add.
+ * @return True if the category was added successfully, false if it already exists.
+ */
+bool ShardedWordCatVec::addCategory(WordCat&& new_category) {
+    Shard& shard = shardFor(new_category.getCategoryName()); // Shard owning the category
+    std::unique_lock<std::shared_mutex> guard(shard.lock); // Exclusive access to the shard
+    return shard.categories.addCategory(std::move(new_category)); // Move the category into the shard
+}
+
+/**
+ * @brief Removes a category from its shard. The order of the remaining categories is not preserved.
+ * @param category_to_remove The name of the category to remove.
+ * @return True if the category was removed successfully, false otherwise.
+ */
+bool ShardedWordCatVec::removeCategory(const Word& category_to_remove) {
+    Shard& shard = shardFor(category_to_remove); // Shard owning the category
+    std::unique_lock<std::shared_mutex> guard(shard.lock); // Exclusive access to the shard
+    return shard.categories.removeCategory(category_to_remove, false); // O(1) swap-remove
+}
+
+/**
+ * @brief Checks if a category exists.
+ * @param category The category to check for.
+ * @return True if the category exists, false otherwise.
+ */
+bool ShardedWordCatVec::lookup(const Word& category) const {
+    Shard& shard = shardFor(category); // Shard owning the category
+    std::shared_lock<std::shared_mutex> guard(shard.lock); // Shared access to the shard
+    return shard.categories.lookup(category);
+}
+
+/**
+ * @brief Returns the total number of categories across all shards.
+ * @return The number of categories.
+ */
+size_t ShardedWordCatVec::categoryCount() const {
+    size_t count{ 0 }; // Running total
+
+    for (size_t i = 0; i < shard_count; ++i) { // Loop through each shard
+        std::shared_lock<std::shared_mutex> guard(shards[i].lock); // Shared access to the shard
+        count += shards[i].categories.categoryCount(); // Add its category count
+    }
+
+    return count; // Return the total
+}
+
+/**
+ * @brief Inserts a word into the given category. Only the category's shard is locked.
+ * @param category The name of the category.
+ * @param word The word to insert.
+ * @return True if the word was inserted, false if the category does not exist or already has the word.
+ */
+bool ShardedWordCatVec::insertWord(const Word& category, const Word& word) {
+    Shard& shard = shardFor(category); // Shard owning the category
+    std::unique_lock<std::shared_mutex> guard(shard.lock); // Exclusive access to the shard
+    return shard.categories.insertWord(category, word);
+}
+
+/**
+ * @brief Removes a word from the given category. Only the category's shard is locked.
+ * @param category The name of the category.
+ * @param word The word to remove.
+ * @return True if the word was removed, false if the category does not exist or does not have the word.
+ */
+bool ShardedWordCatVec::removeWord(const Word& category, const Word& word) {
+    Shard& shard = shardFor(category); // Shard owning the category
+    std::unique_lock<std::shared_mutex> guard(shard.lock); // Exclusive access to the shard
+    return shard.categories.removeWord(category, word);
+}
+
+/**
+ * @brief Checks if the given category has a word.
+ * @param category The name of the category.
+ * @param word The word to look up.
+ * @return True if the category exists and has the word, false otherwise.
+ */
+bool ShardedWordCatVec::lookupWord(const Word& category, const Word& word) const {
+    Shard& shard = shardFor(category); // Shard owning the category
+    std::shared_lock<std::shared_mutex> guard(shard.lock); // Shared access to the shard
+    return shard.categories.lookupWord(category, word);
+}
+
+/**
+ * @brief Finds every category that has the given word.
+ * Each shard is searched as its own task on the shared thread pool under a shared lock;
+ * the per-shard results are then spliced together in shard order.
+ * @param word The word to search for.
+ * @return The names of the categories that have the word, grouped by shard.
+ */
+WordList ShardedWordCatVec::categoriesContaining(const Word& word) const {
+    WordList* partial_results = new WordList[shard_count]; // One result list per shard
+
+    ThreadPool::shared().parallelFor(shard_count, [this, &word, partial_results](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) { // Shards of this task
+            std::shared_lock<std::shared_mutex> guard(shards[i].lock); // Shared access to the shard
+            partial_results[i] = shards[i].categories.categoriesContaining(word);
+        }
+    }, 1);
+
+    WordList found_in; // The combined result
+    for (size_t i = 0; i < shard_count; ++i) {
+        found_in.append(std::move(partial_results[i])); // Splice the shard's result onto the combined list
+    }
+
+    delete[] partial_results; // Free the (now empty) partial lists
+    return found_in; // Return the combined result
+}
+
+/**
+ * @brief Overloads the << operator to print every shard's categories.
+ * @param sout The output stream.
+ * @param swcv The ShardedWordCatVec to print.
+ * @return The output stream.
+ */
+std::ostream& operator<<(std::ostream& sout, const ShardedWordCatVec& swcv) {
+    for (size_t i = 0; i < swcv.shard_count; ++i) { // Loop through the shards
+        std::shared_lock<std::shared_mutex> guard(swcv.shards[i].lock); // Shared access to the shard
+        sout << swcv.shards[i].categories; // Output the shard's categories
+    }
+    return sout; // Return the ostream object
+}
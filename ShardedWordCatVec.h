@@ -0,0 +1,130 @@
+// ShardedWordCatVec.h
+#ifndef SHARDEDWORDCATVEC_H_
+#define SHARDEDWORDCATVEC_H_
+
+#include "WordCatVec.h"
+#include <shared_mutex>
+
+/**
+ * @class ShardedWordCatVec
+ * @brief A thread-safe collection of WordCat objects, hash-partitioned by category name across independent shards.
+ *
+ * Each shard is a WordCatVec guarded by its own reader/writer lock, so writes to categories that live in
+ * different shards proceed in parallel. Queries over all categories visit the shards concurrently.
+ */
+class ShardedWordCatVec {
+private:
+    /**
+     * @brief One partition of the categories together with the lock that guards it.
+     */
+    struct Shard {
+        mutable std::shared_mutex lock; ///< Shared for readers, exclusive for writers
+        WordCatVec categories; ///< The categories that hash to this shard
+    };
+
+    Shard* shards; ///< The dynamic array of shards
+    size_t shard_count; ///< The number of shards
+
+    /**
+     * @brief Returns the shard responsible for the given category name.
+     * @param category The category name
+     * @return The shard that owns the category
+     */
+    Shard& shardFor(const Word& category) const;
+
+public:
+    /**
+     * @brief Constructor. Creates the given number of empty shards.
+     * @param shard_count The number of shards. 0 selects one shard per hardware thread.
+     */
+    explicit ShardedWordCatVec(size_t shard_count = 0);
+
+    /**
+     * @brief Destructor. Deallocates the shards and their categories.
+     */
+    ~ShardedWordCatVec();
+
+    ShardedWordCatVec(const ShardedWordCatVec& other) = delete; // Locks cannot be copied
+    ShardedWordCatVec& operator=(const ShardedWordCatVec& other) = delete; // Locks cannot be copied
+
+    /**
+     * @brief Returns the number of shards.
+     * @return The number of shards
+     */
+    size_t shardCount() const;
+
+    /**
+     * @brief Adds a copy of a category to its shard.
+     * @param new_category The new category to add
+     * @return true if the category was added successfully, false if it already exists
+     */
+    bool addCategory(const WordCat& new_category);
+
+    /**
+     * @brief Adds a category to its shard by moving it in.
+     * @param new_category The new category to add
+     * @return true if the category was added successfully, false if it already exists
+     */
+    bool addCategory(WordCat&& new_category);
+
+    /**
+     * @brief Removes a category from its shard. The order of the remaining categories is not preserved.
+     * @param category_to_remove The name of the category to remove
+     * @return true if the category was removed successfully, false otherwise
+     */
+    bool removeCategory(const Word& category_to_remove);
+
+    /**
+     * @brief Checks if a category exists.
+     * @param category The category to check for
+     * @return true if the category exists, false otherwise
+     */
+    bool lookup(const Word& category) const;
+
+    /**
+     * @brief Returns the total number of categories across all shards.
+     * @return The number of categories
+     */
+    size_t categoryCount() const;
+
+    /**
+     * @brief Inserts a word into the given category. Only the category's shard is locked.
+     * @param category The name of the category
+     * @param word The word to insert
+     * @return true if the word was inserted, false if the category does not exist or already has the word
+     */
+    bool insertWord(const Word& category, const Word& word);
+
+    /**
+     * @brief Removes a word from the given category. Only the category's shard is locked.
+     * @param category The name of the category
+     * @param word The word to remove
+     * @return true if the word was removed, false if the category does not exist or does not have the word
+     */
+    bool removeWord(const Word& category, const Word& word);
+
+    /**
+     * @brief Checks if the given category has a word.
+     * @param category The name of the category
+     * @param word The word to look up
+     * @return true if the category exists and has the word, false otherwise
+     */
+    bool lookupWord(const Word& category, const Word& word) const;
+
+    /**
+     * @brief Finds every category that has the given word. The shards are searched in parallel.
+     * @param word The word to search for
+     * @return The names of the categories that have the word, grouped by shard
+     */
+    WordList categoriesContaining(const Word& word) const;
+
+    /**
+     * @brief Overloads the << operator to print every shard's categories.
+     * @param sout The output stream to print to
+     * @param swcv The ShardedWordCatVec object to print
+     * @return The output stream
+     */
+    friend std::ostream& operator<<(std::ostream& sout, const ShardedWordCatVec& swcv);
+};
+
+#endif // SHARDEDWORDCATVEC_H_
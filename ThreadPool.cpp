@@ -0,0 +1,184 @@
+// ThreadPool.cpp
+#include "ThreadPool.h"
+#include "MemoryAccount.h"
+
+/**
+ * @brief Constructor. Starts the given number of worker threads.
+ * @param thread_count The number of workers. 0 selects one worker per hardware thread.
+ */
+ThreadPool::ThreadPool(size_t thread_count) :
+    workers{ nullptr },
+    queues{ nullptr },
+    worker_count{ thread_count },
+    queued{ 0 },
+    stopping{ false } {
+    if (worker_count == 0) worker_count = std::thread::hardware_concurrency(); // One worker per core
+    if (worker_count == 0) worker_count = 1; // hardware_concurrency may be unknown
+
+    queues = new Queue[worker_count]; // One deque per worker
+    workers = new std::thread[worker_count]; // Worker handles
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers[i] = std::thread(&ThreadPool::workerLoop, this, i); // Start the worker
+    }
+}
+
+/**
+ * @brief Destructor. Lets the workers drain their queues, then joins them.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        stopping = true; // Ask the workers to finish
+    }
+    wake.notify_all(); // Wake every sleeping worker
+
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers[i].join(); // Wait for the worker to exit
+    }
+
+    delete[] workers; // Free the worker handles
+    delete[] queues; // Free the deques
+    worker_count = 0; // Resets the worker count
+}
+
+/**
+ * @brief Returns the number of worker threads.
+ * @return The number of workers.
+ */
+size_t ThreadPool::threadCount() const {
+    return worker_count;
+}
+
+/**
+ * @brief The loop run by each worker thread.
+ * @param index The worker's index.
+ */
+void ThreadPool::workerLoop(size_t index) {
+    Task task; // The task being run
+    while (true) {
+        if (takeTask(index, task)) { // Own work first, then stolen work
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleep_lock); // Nothing to do: sleep until tasks are queued
+        wake.wait(guard, [this]() { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return; // Exit once the queues are drained
+    }
+}
+
+/**
+ * @brief Takes a task, preferring the newest task of the given queue and otherwise stealing the oldest task of another.
+ * @param home The index of the queue to try first.
+ * @param task Receives the task.
+ * @return True if a task was taken, false if every queue was empty.
+ */
+bool ThreadPool::takeTask(size_t home, Task& task) {
+    {
+        Queue& own = queues[home]; // The preferred queue
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back(); // Newest task: its data is most likely still in cache
+            own.tasks.pop_back();
+            queued--; // One fewer task waiting
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < worker_count; ++offset) { // Try every other queue once
+        Queue& victim = queues[(home + offset) % worker_count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front(); // Oldest task: usually the largest remaining share of work
+            victim.tasks.pop_front();
+            queued--; // One fewer task waiting
+            return true;
+        }
+    }
+
+    return false; // Every queue was empty
+}
+
+/**
+ * @brief Runs a task and reports its completion to its batch.
+ * The batch lives on the stack of the parallelFor caller, so it is only touched while holding its lock.
+ * @param task The task to run.
+ */
+void ThreadPool::runTask(const Task& task) {
+    std::exception_ptr error; // Exception thrown by the body, if any
+    try {
+        MemoryAccount::Scope scope(*task.batch->account); // Charge the chunk to the caller's account, on any thread
+        (*task.body)(task.begin, task.end); // Run the chunk
+    } catch (...) {
+        error = std::current_exception(); // Keep it for the caller
+    }
+
+    std::lock_guard<std::mutex> guard(task.batch->lock);
+    if (error && !task.batch->error) task.batch->error = error; // Report only the first failure
+    if (--task.batch->remaining == 0) {
+        task.batch->done.notify_all(); // The last chunk wakes the caller
+    }
+}
+
+/**
+ * @brief Runs body over [0, count) in chunks spread across the workers, and waits for all of them.
+ * @param count The number of indices.
+ * @param body The loop body, called once per chunk.
+ * @param grain The number of indices per chunk. 0 picks a chunk size that gives each worker several chunks.
+ */
+void ThreadPool::parallelFor(size_t count, const RangeBody& body, size_t grain) {
+    if (count == 0) return; // Nothing to do
+
+    if (grain == 0) grain = count / (worker_count * 4); // About four chunks per worker balances well under stealing
+    if (grain == 0) grain = 1; // At least one index per chunk
+
+    size_t chunk_count = (count + grain - 1) / grain; // Number of tasks
+    if (chunk_count == 1) { // Not worth a hand-off
+        body(0, count);
+        return;
+    }
+
+    Batch batch; // Completion state of this loop
+    batch.remaining = chunk_count;
+    batch.account = &MemoryAccount::current();
+
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) { // Deal the chunks round-robin across the queues
+        size_t begin = chunk * grain;
+        size_t end = begin + grain < count ? begin + grain : count;
+        Queue& queue = queues[chunk % worker_count];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(Task{ &body, begin, end, &batch });
+        queued++; // One more task waiting
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock); // Pairs with the workers' wait predicate
+    }
+    wake.notify_all(); // Wake sleeping workers
+
+    Task task; // The calling thread helps until its own loop is done
+    size_t home = std::hash<std::thread::id>()(std::this_thread::get_id()) % worker_count;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(batch.lock);
+            if (batch.remaining == 0) break; // Every chunk has finished
+        }
+        if (takeTask(home, task)) { // Run any queued task, even one of another loop
+            runTask(task);
+        } else { // The remaining chunks are running elsewhere
+            std::unique_lock<std::mutex> guard(batch.lock);
+            batch.done.wait(guard, [&batch]() { return batch.remaining == 0; });
+            break;
+        }
+    }
+
+    if (batch.error) std::rethrow_exception(batch.error); // Surface the first failure
+}
+
+/**
+ * @brief Returns the process-wide pool, started on first use with one worker per hardware thread.
+ * @return The shared pool.
+ */
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool; // Constructed once, thread-safely, on first use
+    return pool;
+}
@@ -0,0 +1,127 @@
+// ThreadPool.h
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class MemoryAccount;
+
+/**
+ * @class ThreadPool
+ * @brief A fixed set of worker threads that execute index ranges of a parallel loop with work stealing.
+ *
+ * Every worker owns a task deque. A worker pops its newest task first and, when its deque is empty,
+ * steals the oldest task of another worker. The thread that calls parallelFor helps run tasks until
+ * its loop is finished, so parallel loops may be nested without deadlocking the pool.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief The body of a parallel loop. Called with a half-open index range [begin, end).
+     */
+    using RangeBody = std::function<void(size_t begin, size_t end)>;
+
+private:
+    /**
+     * @brief Completion state shared by all tasks of one parallelFor call.
+     */
+    struct Batch {
+        std::mutex lock; ///< Guards remaining and error
+        std::condition_variable done; ///< Signalled when remaining reaches zero
+        size_t remaining; ///< Number of tasks not yet finished
+        std::exception_ptr error; ///< The first exception thrown by a task, if any
+        MemoryAccount* account; ///< The caller's current account, made current while its tasks run
+    };
+
+    /**
+     * @brief One chunk of a parallel loop.
+     */
+    struct Task {
+        const RangeBody* body; ///< The loop body
+        size_t begin; ///< First index of the chunk
+        size_t end; ///< One past the last index of the chunk
+        Batch* batch; ///< The loop the chunk belongs to
+    };
+
+    /**
+     * @brief A worker's task deque.
+     */
+    struct Queue {
+        std::mutex lock; ///< Guards tasks
+        std::deque<Task> tasks; ///< The owner pops from the back, thieves take from the front
+    };
+
+    std::thread* workers; ///< The dynamic array of worker threads
+    Queue* queues; ///< The dynamic array of task deques, one per worker
+    size_t worker_count; ///< The number of worker threads
+
+    std::mutex sleep_lock; ///< Guards the sleeping workers' wake-up condition
+    std::condition_variable wake; ///< Signalled when tasks are queued or the pool stops
+    std::atomic<size_t> queued; ///< Number of tasks sitting in the deques
+    bool stopping; ///< Set by the destructor to end the workers
+
+    /**
+     * @brief The loop run by each worker thread.
+     * @param index The worker's index
+     */
+    void workerLoop(size_t index);
+
+    /**
+     * @brief Takes a task, preferring the newest task of the given queue and otherwise stealing the oldest task of another.
+     * @param home The index of the queue to try first
+     * @param task Receives the task
+     * @return true if a task was taken, false if every queue was empty
+     */
+    bool takeTask(size_t home, Task& task);
+
+    /**
+     * @brief Runs a task and reports its completion to its batch.
+     * @param task The task to run
+     */
+    static void runTask(const Task& task);
+
+public:
+    /**
+     * @brief Constructor. Starts the given number of worker threads.
+     * @param thread_count The number of workers. 0 selects one worker per hardware thread.
+     */
+    explicit ThreadPool(size_t thread_count = 0);
+
+    /**
+     * @brief Destructor. Lets the workers drain their queues, then joins them.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool& other) = delete; // Threads cannot be copied
+    ThreadPool& operator=(const ThreadPool& other) = delete; // Threads cannot be copied
+
+    /**
+     * @brief Returns the number of worker threads.
+     * @return The number of workers
+     */
+    size_t threadCount() const;
+
+    /**
+     * @brief Runs body over [0, count) in chunks spread across the workers, and waits for all of them.
+     * @param count The number of indices
+     * @param body The loop body, called once per chunk
+     * @param grain The number of indices per chunk. 0 picks a chunk size that gives each worker several chunks.
+     * @throws Rethrows the first exception thrown by the body, after every chunk has finished.
+     */
+    void parallelFor(size_t count, const RangeBody& body, size_t grain = 0);
+
+    /**
+     * @brief Returns the process-wide pool, started on first use with one worker per hardware thread.
+     * @return The shared pool
+     */
+    static ThreadPool& shared();
+};
+
+#endif // THREADPOOL_H_
@@ -0,0 +1,171 @@
+// VocabularyWatcher.cpp
+#include "VocabularyWatcher.h"
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Constructor. Splits the path into the directory to watch and the file name to look for.
+ * @param filename The path to the vocabulary file.
+ * @param debounce_ms Milliseconds without further changes to wait before reloading.
+ */
+VocabularyWatcher::VocabularyWatcher(const char* filename, int debounce_ms) :
+    path(filename),
+    debounce_ms{ debounce_ms },
+    reload_count{ 0 },
+    inotify_fd{ -1 },
+    wake_pipe{ -1, -1 } {
+    size_t slash = path.rfind('/'); // Last separator, if any
+    if (slash == std::string::npos) { // A file in the working directory
+        directory = ".";
+        file_name = path;
+    } else {
+        directory = slash == 0 ? "/" : path.substr(0, slash);
+        file_name = path.substr(slash + 1);
+    }
+}
+
+/**
+ * @brief Destructor. Stops watching.
+ */
+VocabularyWatcher::~VocabularyWatcher() {
+    stop();
+}
+
+/**
+ * @brief Loads the file and starts watching it.
+ * The watch is set up before the initial load, so that a change made while loading is not missed.
+ * @return True if the file is being watched.
+ */
+bool VocabularyWatcher::start() {
+    if (worker.joinable()) return true; // Already watching
+
+    std::ifstream probe(path); // Fail early, before publishing an empty vocabulary
+    if (!probe) {
+        std::cerr << "Error opening file: " << path << std::endl;
+        return false;
+    }
+    probe.close();
+
+#ifdef __linux__
+    inotify_fd = inotify_init1(IN_CLOEXEC);
+    bool watching = inotify_fd >= 0 && pipe(wake_pipe) == 0 &&
+        inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) >= 0;
+    if (!watching) closeDescriptors(); // Load once without watching
+#else
+    bool watching = false; // No inotify here
+#endif
+
+    auto initial = std::make_shared<WordCatVec>(); // Loaded eagerly; see the header
+    initial->loadFromFile(path.c_str());
+    std::atomic_store(&current, std::shared_ptr<const WordCatVec>(std::move(initial))); // Publish it
+    reload_count = 0;
+
+    if (!watching) {
+        std::cerr << "Cannot watch " << path << " for changes; it was loaded once" << std::endl;
+        return false;
+    }
+
+    worker = std::thread(&VocabularyWatcher::watch, this); // Wait for changes in the background
+    return true;
+}
+
+/**
+ * @brief Stops watching and waits for a reload in progress to finish.
+ */
+void VocabularyWatcher::stop() {
+    if (worker.joinable()) {
+#ifdef __linux__
+        char wake = 0;
+        while (write(wake_pipe[1], &wake, 1) < 0 && errno == EINTR) {} // Wake the worker
+#endif
+        worker.join();
+    }
+    closeDescriptors();
+}
+
+/**
+ * @brief Returns the current vocabulary. Safe to call from any thread at any time.
+ * @return The latest published snapshot, or nullptr before start().
+ */
+std::shared_ptr<const WordCatVec> VocabularyWatcher::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+/**
+ * @brief Returns the number of reloads published since start().
+ * @return The reload count.
+ */
+size_t VocabularyWatcher::reloadCount() const {
+    return reload_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief The worker loop: waits for change events, debounces them and reloads.
+ * Without a pending change the loop sleeps in poll() until an event or a wake-up arrives. Each event
+ * that names the watched file restarts the quiet period; once debounce_ms pass without one, the
+ * vocabulary is rebuilt.
+ */
+void VocabularyWatcher::watch() {
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096]; // Room for many events per read
+    bool pending = false; // A change was seen and not reloaded yet
+
+    while (true) {
+        pollfd fds[2] = { { inotify_fd, POLLIN, 0 }, { wake_pipe[0], POLLIN, 0 } };
+        int ready = poll(fds, 2, pending ? debounce_ms : -1); // Wait forever unless a reload is pending
+        if (ready < 0) {
+            if (errno == EINTR) continue; // Interrupted by a signal
+            break; // The descriptors are unusable
+        }
+        if (fds[1].revents != 0) break; // stop() was called
+
+        if (ready == 0) { // The quiet period is over
+            pending = false;
+            rebuild();
+            continue;
+        }
+
+        ssize_t length = read(inotify_fd, buffer, sizeof buffer);
+        for (ssize_t offset = 0; offset < length;) { // Look for events about the watched file
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len != 0 && file_name == event->name) pending = true;
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Builds an up-to-date copy of the current vocabulary and publishes it.
+ * The copy is taken while readers keep using the original. Their lookups only change it by rebuilding a stale
+ * filter or parsing a lazy category, under locks that the copy takes too.
+ */
+void VocabularyWatcher::rebuild() {
+    auto next = std::make_shared<WordCatVec>(*snapshot()); // Start from what is published
+    if (!next->reloadFromFile(path.c_str())) return; // The file is missing, e.g. between a delete and a rename
+
+    std::atomic_store(&current, std::shared_ptr<const WordCatVec>(std::move(next))); // Swap it in
+    reload_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Closes the inotify instance and the wake pipe.
+ */
+void VocabularyWatcher::closeDescriptors() {
+#ifdef __linux__
+    if (inotify_fd >= 0) close(inotify_fd);
+    if (wake_pipe[0] >= 0) close(wake_pipe[0]);
+    if (wake_pipe[1] >= 0) close(wake_pipe[1]);
+#endif
+    inotify_fd = -1;
+    wake_pipe[0] = -1;
+    wake_pipe[1] = -1;
+}
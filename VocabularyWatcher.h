@@ -0,0 +1,98 @@
+// VocabularyWatcher.h
+#ifndef VOCABULARYWATCHER_H_
+#define VOCABULARYWATCHER_H_
+
+#include "WordCatVec.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+
+/**
+ * @class VocabularyWatcher
+ * @brief Keeps a loaded vocabulary in step with its source file, reloading it in the background when the file changes.
+ *
+ * Readers call snapshot() and work on the WordCatVec it returns for as long as they like. A change to the
+ * file never touches a published snapshot: the watcher copies the current one, brings the copy up to date
+ * with WordCatVec::reloadFromFile (which applies only the per-category differences), and then publishes the
+ * copy with one atomic pointer swap. A reader therefore sees either the old vocabulary or the new one, never
+ * a half-loaded one, and the old one is freed when its last reader lets go of it.
+ *
+ * Changes are detected with inotify on the file's directory, so editors that save by writing a new file and
+ * renaming it over the old one are followed too. A burst of events is debounced into one reload.
+ * File watching is only available on Linux; elsewhere start() loads the file once and reports that it will
+ * not be watched.
+ */
+class VocabularyWatcher {
+private:
+    std::string path; ///< The watched file
+    std::string directory; ///< The directory that contains it
+    std::string file_name; ///< Its name within the directory
+    int debounce_ms; ///< Quiet period after the last change event before reloading
+
+    std::shared_ptr<const WordCatVec> current; ///< The published vocabulary; only accessed through std::atomic_load/atomic_store
+    std::atomic<size_t> reload_count; ///< Number of reloads published since start()
+
+    std::thread worker; ///< The thread waiting for change events
+    int inotify_fd; ///< The inotify instance, or -1
+    int wake_pipe[2]; ///< Written by stop() to wake the worker; -1 when closed
+
+    /**
+     * @brief The worker loop: waits for change events, debounces them and reloads.
+     */
+    void watch();
+
+    /**
+     * @brief Builds an up-to-date copy of the current vocabulary and publishes it.
+     */
+    void rebuild();
+
+    /**
+     * @brief Closes the inotify instance and the wake pipe.
+     */
+    void closeDescriptors();
+
+public:
+    /**
+     * @brief Constructor. Nothing is loaded or watched until start() is called.
+     * @param filename The path to the vocabulary file
+     * @param debounce_ms Milliseconds without further changes to wait before reloading
+     */
+    explicit VocabularyWatcher(const char* filename, int debounce_ms = 200);
+
+    /**
+     * @brief Destructor. Stops watching.
+     */
+    ~VocabularyWatcher();
+
+    VocabularyWatcher(const VocabularyWatcher& other) = delete; // The worker thread refers to this object
+    VocabularyWatcher& operator=(const VocabularyWatcher& other) = delete;
+
+    /**
+     * @brief Loads the file and starts watching it.
+     * The initial load is eager: lazily loaded categories would point into a file that is about to change.
+     * @return true if the file is being watched, false if it could not be opened or watched (a snapshot
+     *         is still published if the file could be read)
+     */
+    bool start();
+
+    /**
+     * @brief Stops watching and waits for a reload in progress to finish. The last snapshot stays available.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the current vocabulary. Safe to call from any thread at any time.
+     * @return The latest published snapshot, or nullptr before start()
+     */
+    std::shared_ptr<const WordCatVec> snapshot() const;
+
+    /**
+     * @brief Returns the number of reloads published since start().
+     * @return The reload count
+     */
+    size_t reloadCount() const;
+};
+
+#endif // VOCABULARYWATCHER_H_
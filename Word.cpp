@@ -1,38 +1,369 @@
 #include "Word.h"
+#include "MemoryAccount.h"
+#include <atomic> // For the count of a shared buffer
+#include <new> // For placement new
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+/**
+ * @brief A canonical composition: a base letter followed by a combining mark, and the letter that replaces them.
+ */
+struct Composition {
+    uint32_t base; ///< The base letter
+    uint32_t mark; ///< The combining mark that follows it
+    uint32_t composed; ///< The precomposed letter
+};
+
+/**
+ * @brief The NFC compositions of the ASCII letters with the common combining marks (grave, acute,
+ * circumflex, tilde, macron, breve, dot above, diaeresis, ring, double acute, caron, cedilla, ogonek)
+ * whose result is in Latin-1, Latin Extended-A or Latin Extended-B. Sorted by base, then mark.
+ */
+static const Composition COMPOSITIONS[] = {
+    { 0x0041, 0x0300, 0x00C0 }, { 0x0041, 0x0301, 0x00C1 }, { 0x0041, 0x0302, 0x00C2 }, { 0x0041, 0x0303, 0x00C3 },
+    { 0x0041, 0x0304, 0x0100 }, { 0x0041, 0x0306, 0x0102 }, { 0x0041, 0x0307, 0x0226 }, { 0x0041, 0x0308, 0x00C4 },
+    { 0x0041, 0x030A, 0x00C5 }, { 0x0041, 0x030C, 0x01CD }, { 0x0041, 0x0328, 0x0104 }, { 0x0043, 0x0301, 0x0106 },
+    { 0x0043, 0x0302, 0x0108 }, { 0x0043, 0x0307, 0x010A }, { 0x0043, 0x030C, 0x010C }, { 0x0043, 0x0327, 0x00C7 },
+    { 0x0044, 0x030C, 0x010E }, { 0x0045, 0x0300, 0x00C8 }, { 0x0045, 0x0301, 0x00C9 }, { 0x0045, 0x0302, 0x00CA },
+    { 0x0045, 0x0304, 0x0112 }, { 0x0045, 0x0306, 0x0114 }, { 0x0045, 0x0307, 0x0116 }, { 0x0045, 0x0308, 0x00CB },
+    { 0x0045, 0x030C, 0x011A }, { 0x0045, 0x0327, 0x0228 }, { 0x0045, 0x0328, 0x0118 }, { 0x0047, 0x0301, 0x01F4 },
+    { 0x0047, 0x0302, 0x011C }, { 0x0047, 0x0306, 0x011E }, { 0x0047, 0x0307, 0x0120 }, { 0x0047, 0x030C, 0x01E6 },
+    { 0x0047, 0x0327, 0x0122 }, { 0x0048, 0x0302, 0x0124 }, { 0x0048, 0x030C, 0x021E }, { 0x0049, 0x0300, 0x00CC },
+    { 0x0049, 0x0301, 0x00CD }, { 0x0049, 0x0302, 0x00CE }, { 0x0049, 0x0303, 0x0128 }, { 0x0049, 0x0304, 0x012A },
+    { 0x0049, 0x0306, 0x012C }, { 0x0049, 0x0307, 0x0130 }, { 0x0049, 0x0308, 0x00CF }, { 0x0049, 0x030C, 0x01CF },
+    { 0x0049, 0x0328, 0x012E }, { 0x004A, 0x0302, 0x0134 }, { 0x004B, 0x030C, 0x01E8 }, { 0x004B, 0x0327, 0x0136 },
+    { 0x004C, 0x0301, 0x0139 }, { 0x004C, 0x030C, 0x013D }, { 0x004C, 0x0327, 0x013B }, { 0x004E, 0x0300, 0x01F8 },
+    { 0x004E, 0x0301, 0x0143 }, { 0x004E, 0x0303, 0x00D1 }, { 0x004E, 0x030C, 0x0147 }, { 0x004E, 0x0327, 0x0145 },
+    { 0x004F, 0x0300, 0x00D2 }, { 0x004F, 0x0301, 0x00D3 }, { 0x004F, 0x0302, 0x00D4 }, { 0x004F, 0x0303, 0x00D5 },
+    { 0x004F, 0x0304, 0x014C }, { 0x004F, 0x0306, 0x014E }, { 0x004F, 0x0307, 0x022E }, { 0x004F, 0x0308, 0x00D6 },
+    { 0x004F, 0x030B, 0x0150 }, { 0x004F, 0x030C, 0x01D1 }, { 0x004F, 0x0328, 0x01EA }, { 0x0052, 0x0301, 0x0154 },
+    { 0x0052, 0x030C, 0x0158 }, { 0x0052, 0x0327, 0x0156 }, { 0x0053, 0x0301, 0x015A }, { 0x0053, 0x0302, 0x015C },
+    { 0x0053, 0x030C, 0x0160 }, { 0x0053, 0x0327, 0x015E }, { 0x0054, 0x030C, 0x0164 }, { 0x0054, 0x0327, 0x0162 },
+    { 0x0055, 0x0300, 0x00D9 }, { 0x0055, 0x0301, 0x00DA }, { 0x0055, 0x0302, 0x00DB }, { 0x0055, 0x0303, 0x0168 },
+    { 0x0055, 0x0304, 0x016A }, { 0x0055, 0x0306, 0x016C }, { 0x0055, 0x0308, 0x00DC }, { 0x0055, 0x030A, 0x016E },
+    { 0x0055, 0x030B, 0x0170 }, { 0x0055, 0x030C, 0x01D3 }, { 0x0055, 0x0328, 0x0172 }, { 0x0057, 0x0302, 0x0174 },
+    { 0x0059, 0x0301, 0x00DD }, { 0x0059, 0x0302, 0x0176 }, { 0x0059, 0x0304, 0x0232 }, { 0x0059, 0x0308, 0x0178 },
+    { 0x005A, 0x0301, 0x0179 }, { 0x005A, 0x0307, 0x017B }, { 0x005A, 0x030C, 0x017D }, { 0x0061, 0x0300, 0x00E0 },
+    { 0x0061, 0x0301, 0x00E1 }, { 0x0061, 0x0302, 0x00E2 }, { 0x0061, 0x0303, 0x00E3 }, { 0x0061, 0x0304, 0x0101 },
+    { 0x0061, 0x0306, 0x0103 }, { 0x0061, 0x0307, 0x0227 }, { 0x0061, 0x0308, 0x00E4 }, { 0x0061, 0x030A, 0x00E5 },
+    { 0x0061, 0x030C, 0x01CE }, { 0x0061, 0x0328, 0x0105 }, { 0x0063, 0x0301, 0x0107 }, { 0x0063, 0x0302, 0x0109 },
+    { 0x0063, 0x0307, 0x010B }, { 0x0063, 0x030C, 0x010D }, { 0x0063, 0x0327, 0x00E7 }, { 0x0064, 0x030C, 0x010F },
+    { 0x0065, 0x0300, 0x00E8 }, { 0x0065, 0x0301, 0x00E9 }, { 0x0065, 0x0302, 0x00EA }, { 0x0065, 0x0304, 0x0113 },
+    { 0x0065, 0x0306, 0x0115 }, { 0x0065, 0x0307, 0x0117 }, { 0x0065, 0x0308, 0x00EB }, { 0x0065, 0x030C, 0x011B },
+    { 0x0065, 0x0327, 0x0229 }, { 0x0065, 0x0328, 0x0119 }, { 0x0067, 0x0301, 0x01F5 }, { 0x0067, 0x0302, 0x011D },
+    { 0x0067, 0x0306, 0x011F }, { 0x0067, 0x0307, 0x0121 }, { 0x0067, 0x030C, 0x01E7 }, { 0x0067, 0x0327, 0x0123 },
+    { 0x0068, 0x0302, 0x0125 }, { 0x0068, 0x030C, 0x021F }, { 0x0069, 0x0300, 0x00EC }, { 0x0069, 0x0301, 0x00ED },
+    { 0x0069, 0x0302, 0x00EE }, { 0x0069, 0x0303, 0x0129 }, { 0x0069, 0x0304, 0x012B }, { 0x0069, 0x0306, 0x012D },
+    { 0x0069, 0x0308, 0x00EF }, { 0x0069, 0x030C, 0x01D0 }, { 0x0069, 0x0328, 0x012F }, { 0x006A, 0x0302, 0x0135 },
+    { 0x006A, 0x030C, 0x01F0 }, { 0x006B, 0x030C, 0x01E9 }, { 0x006B, 0x0327, 0x0137 }, { 0x006C, 0x0301, 0x013A },
+    { 0x006C, 0x030C, 0x013E }, { 0x006C, 0x0327, 0x013C }, { 0x006E, 0x0300, 0x01F9 }, { 0x006E, 0x0301, 0x0144 },
+    { 0x006E, 0x0303, 0x00F1 }, { 0x006E, 0x030C, 0x0148 }, { 0x006E, 0x0327, 0x0146 }, { 0x006F, 0x0300, 0x00F2 },
+    { 0x006F, 0x0301, 0x00F3 }, { 0x006F, 0x0302, 0x00F4 }, { 0x006F, 0x0303, 0x00F5 }, { 0x006F, 0x0304, 0x014D },
+    { 0x006F, 0x0306, 0x014F }, { 0x006F, 0x0307, 0x022F }, { 0x006F, 0x0308, 0x00F6 }, { 0x006F, 0x030B, 0x0151 },
+    { 0x006F, 0x030C, 0x01D2 }, { 0x006F, 0x0328, 0x01EB }, { 0x0072, 0x0301, 0x0155 }, { 0x0072, 0x030C, 0x0159 },
+    { 0x0072, 0x0327, 0x0157 }, { 0x0073, 0x0301, 0x015B }, { 0x0073, 0x0302, 0x015D }, { 0x0073, 0x030C, 0x0161 },
+    { 0x0073, 0x0327, 0x015F }, { 0x0074, 0x030C, 0x0165 }, { 0x0074, 0x0327, 0x0163 }, { 0x0075, 0x0300, 0x00F9 },
+    { 0x0075, 0x0301, 0x00FA }, { 0x0075, 0x0302, 0x00FB }, { 0x0075, 0x0303, 0x0169 }, { 0x0075, 0x0304, 0x016B },
+    { 0x0075, 0x0306, 0x016D }, { 0x0075, 0x0308, 0x00FC }, { 0x0075, 0x030A, 0x016F }, { 0x0075, 0x030B, 0x0171 },
+    { 0x0075, 0x030C, 0x01D4 }, { 0x0075, 0x0328, 0x0173 }, { 0x0077, 0x0302, 0x0175 }, { 0x0079, 0x0301, 0x00FD },
+    { 0x0079, 0x0302, 0x0177 }, { 0x0079, 0x0304, 0x0233 }, { 0x0079, 0x0308, 0x00FF }, { 0x007A, 0x0301, 0x017A },
+    { 0x007A, 0x0307, 0x017C }, { 0x007A, 0x030C, 0x017E }
+};
+
+/**
+ * @brief Decodes one UTF-8 sequence and advances past it.
+ * @param p The position to read from; moved past the sequence when it is valid.
+ * @param end The end of the characters.
+ * @param code_point Receives the decoded code point.
+ * @return False if the bytes at p are not a well-formed sequence.
+ */
+static bool decodeUtf8(const unsigned char*& p, const unsigned char* end, uint32_t& code_point) {
+    unsigned char lead = *p;
+    size_t extra; // Number of continuation bytes
+    uint32_t minimum; // Smallest code point allowed for this length, to reject overlong forms
+    if (lead < 0x80) { code_point = lead; p++; return true; }
+    else if ((lead & 0xE0) == 0xC0) { extra = 1; minimum = 0x80; code_point = lead & 0x1F; }
+    else if ((lead & 0xF0) == 0xE0) { extra = 2; minimum = 0x800; code_point = lead & 0x0F; }
+    else if ((lead & 0xF8) == 0xF0) { extra = 3; minimum = 0x10000; code_point = lead & 0x07; }
+    else return false; // A continuation byte, or a lead byte no longer in use
+
+    if (static_cast<size_t>(end - p) <= extra) return false; // Truncated
+    for (size_t i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) return false; // Not a continuation byte
+        code_point = (code_point << 6) | (p[i] & 0x3F);
+    }
+    if (code_point < minimum || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) return false;
+    p += extra + 1;
+    return true;
+}
+
+/**
+ * @brief Appends the UTF-8 encoding of a code point.
+ * @param out The string to append to.
+ * @param code_point The code point to encode.
+ */
+static void encodeUtf8(std::string& out, uint32_t code_point) {
+    if (code_point < 0x80) {
+        out.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+/**
+ * @brief Looks up the precomposed form of a letter followed by a combining mark.
+ * @param base The letter.
+ * @param mark The combining mark.
+ * @return The precomposed letter, or 0 if the pair has none in COMPOSITIONS.
+ */
+static uint32_t compose(uint32_t base, uint32_t mark) {
+    size_t low = 0, high = sizeof COMPOSITIONS / sizeof COMPOSITIONS[0];
+    while (low < high) { // Binary search by (base, mark)
+        size_t mid = low + (high - low) / 2;
+        const Composition& entry = COMPOSITIONS[mid];
+        if (entry.base < base || (entry.base == base && entry.mark < mark)) low = mid + 1;
+        else high = mid;
+    }
+    bool found = low < sizeof COMPOSITIONS / sizeof COMPOSITIONS[0] && COMPOSITIONS[low].base == base && COMPOSITIONS[low].mark == mark;
+    return found ? COMPOSITIONS[low].composed : 0;
+}
+
+/**
+ * @brief Appends a lowercase letter without its diacritics: the base letter of a composition in
+ * COMPOSITIONS, a few letters with a stroke or ligatures spelled out, nothing for a combining mark.
+ * Other code points are appended unchanged.
+ * @param out The string to append to.
+ * @param c The code point, already case-folded.
+ */
+static void appendUnaccented(std::string& out, uint32_t c) {
+    if (c >= 0x300 && c <= 0x36F) return; // A combining mark left over after composition
+    switch (c) {
+        case 0xE6: out += "ae"; return;
+        case 0x153: out += "oe"; return;
+        case 0xF8: out += 'o'; return;
+        case 0x111: out += 'd'; return;
+        case 0x142: out += 'l'; return;
+        case 0x131: out += 'i'; return;
+        default: break;
+    }
+    if (c >= 0xC0) { // Precomposed letters start in Latin-1
+        for (const Composition& entry : COMPOSITIONS) {
+            if (entry.composed == c) {
+                char base = static_cast<char>(entry.base);
+                out += base >= 'A' && base <= 'Z' ? static_cast<char>(base + 0x20) : base; // Lowercase even if folding missed the letter
+                return;
+            }
+        }
+    }
+    encodeUtf8(out, c);
+}
+
+/**
+ * @brief Appends the case-folded form of a code point: simple folding for Latin (ASCII, Latin-1,
+ * Latin Extended-A, the letter pairs of Latin Extended-B), Greek and Cyrillic, plus the full folding
+ * of ß and ẞ to "ss".
+ * Other code points are appended unchanged.
+ * @param out The string to append to.
+ * @param c The code point to fold.
+ */
+static void appendFolded(std::string& out, uint32_t c) {
+    if (c == 0xDF || c == 0x1E9E) { out += "ss"; return; } // Sharp s folds to two letters
+    if ((c >= 'A' && c <= 'Z') || (c >= 0xC0 && c <= 0xDE && c != 0xD7)) c += 0x20; // ASCII and Latin-1
+    else if (c == 0x130) c = 'i'; // Capital I with dot above
+    else if (c == 0x178) c = 0xFF; // Capital Y with diaeresis
+    else if (c == 0x17F) c = 's'; // Long s
+    else if ((c >= 0x100 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) c |= 1; // Latin Extended-A pairs, capital first on even
+    else if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) c += c & 1; // Latin Extended-A pairs, capital first on odd
+    else if (c >= 0x1CD && c <= 0x1DC) c += c & 1; // Latin Extended-B pairs with caron and diaeresis, capital first on odd
+    else if ((c >= 0x1DE && c <= 0x1EF) || (c >= 0x1F4 && c <= 0x1F5) || (c >= 0x1F8 && c <= 0x21F) || (c >= 0x222 && c <= 0x233)) c |= 1; // Latin Extended-B pairs, capital first on even
+    else if (c >= 0x391 && c <= 0x3A9 && c != 0x3A2) c += 0x20; // Greek capitals
+    else if (c == 0x3C2) c = 0x3C3; // Final sigma folds to sigma
+    else if (c >= 0x400 && c <= 0x40F) c += 0x50; // Cyrillic capitals with marks
+    else if (c >= 0x410 && c <= 0x42F) c += 0x20; // Cyrillic basic capitals
+    encodeUtf8(out, c);
+}
+
+/**
+ * @brief Reads the heap pointer of a long word out of 'storage'.
+ * @return The pointer to the heap buffer.
+ */
+char* Word::heapPtr() const {
+    char* ptr;
+    std::memcpy(&ptr, storage, sizeof ptr); // The pointer is kept unaligned in the first bytes of storage
+    return ptr;
+}
+
+/**
+ * @brief Replaces the contents with a copy of the given characters and key, allocating only when they do not fit inline.
+ * The previous contents must already have been released.
+ * @param str The characters to copy (need not be '\0'-terminated).
+ * @param length The number of characters.
+ * @param key The folded key to store after the characters, or nullptr when it equals the characters.
+ * @param key_length The number of characters of the key.
+ */
+void Word::assign(const char* str, size_t length, const char* key, size_t key_length) {
+    if (length > LENGTH_MASK) throw std::length_error("Word too long"); // The length is stored in 28 bits
+    size_t bytes = length + 1 + (key ? key_length + 1 : 0); // The characters, then the key, each '\0'-terminated
+    char* dest = storage; // Short word: keep everything inside the object
+    if (bytes > sizeof storage) { // Long word: allocate a buffer and keep its pointer inside the object
+        dest = static_cast<char*>(MemoryAccount::current().allocate(bytes, MemoryAccount::Structure::Words));
+        std::memcpy(storage, &dest, sizeof dest);
+    }
+    std::memcpy(dest, str, length);
+    dest[length] = '\0';
+    if (key) {
+        std::memcpy(dest + length + 1, key, key_length);
+        dest[length + 1 + key_length] = '\0';
+    }
+    // Set the size last so isInline() describes the new contents
+    size = static_cast<uint32_t>(length) | (dest != storage ? HEAP_FLAG : 0) | (key ? KEY_FLAG : 0);
+}
+
+/**
+ * @brief Replaces the contents with the NFC form of the given characters and computes their folded key.
+ * ASCII, the common case, is recognized in one pass and copied as it is; a short ASCII word with
+ * capitals is marked so that its key is lowercased when needed instead of stored. Characters that are
+ * not valid UTF-8 are kept as they are, with only their ASCII letters folded.
+ * The previous contents must already have been released.
+ * @param str The characters (need not be '\0'-terminated).
+ * @param length The number of characters.
+ */
+void Word::build(const char* str, size_t length) {
+    bool ascii = true; // No multibyte characters, so nothing to compose
+    bool capitals = false;
+    for (size_t i = 0; i < length && ascii; i++) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        ascii = c < 0x80;
+        capitals |= c >= 'A' && c <= 'Z';
+    }
+    if (ascii && (!capitals || length <= INLINE_CAPACITY)) {
+        assign(str, length);
+        if (capitals) size |= ASCII_KEY_FLAG; // The key would not fit inline with the word
+        return;
+    }
+
+    std::string composed; // The NFC form of the characters
+    std::string folded; // Its folded key
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+    const unsigned char* end = p + length;
+    if (isValidUtf8(str, length)) {
+        uint32_t previous = 0; // The last code point decoded, while it may still compose with a mark
+        bool has_previous = false;
+        auto flush = [&]() {
+            if (has_previous) {
+                encodeUtf8(composed, previous);
+                appendFolded(folded, previous);
+            }
+        };
+        while (p < end) {
+            uint32_t c;
+            decodeUtf8(p, end, c);
+            uint32_t combined = has_previous ? compose(previous, c) : 0;
+            if (combined != 0) { // The mark merges into the letter before it
+                previous = combined;
+                continue;
+            }
+            flush();
+            previous = c;
+            has_previous = true;
+        }
+        flush();
+    } else { // Not UTF-8: keep the bytes, fold only ASCII
+        composed.assign(str, length);
+        folded = composed;
+        for (char& c : folded) if (c >= 'A' && c <= 'Z') c = static_cast<char>(c + ('a' - 'A'));
+    }
+
+    if (folded == composed) assign(composed.data(), composed.size());
+    else assign(composed.data(), composed.size(), folded.data(), folded.size());
+}
+
+/**
+ * @brief Frees the heap buffer of a long word and makes the word empty.
+ */
+void Word::release() {
+    if (!isInline()) freeHeap(); // Only long words own a buffer
+    storage[0] = '\0';
+    size = 0;
+}
+
+/**
+ * @brief Returns the count of words using a shared buffer, kept in the header before its characters.
+ * @param chars The characters of the buffer.
+ * @param header The size of the header.
+ * @return The count.
+ */
+static std::atomic<uint32_t>& useCount(char* chars, size_t header) {
+    return *reinterpret_cast<std::atomic<uint32_t>*>(chars - header);
+}
+
+/**
+ * @brief Frees the heap buffer, or drops this word's use of it if it is shared.
+ */
+void Word::freeHeap() {
+    char* chars = heapPtr();
+    if ((size & SHARED_FLAG) == 0) { // Owned alone
+        MemoryAccount::deallocate(chars, contentBytes(), MemoryAccount::Structure::Words);
+        return;
+    }
+    std::atomic<uint32_t>& users = useCount(chars, SHARED_HEADER);
+    if (users.fetch_sub(1, std::memory_order_acq_rel) == 1) { // The last word using it
+        users.~atomic();
+        MemoryAccount::deallocate(chars - SHARED_HEADER, SHARED_HEADER + contentBytes(), MemoryAccount::Structure::Words);
+    }
+}
 
 /**
  * @brief Default constructor. Initializes to empty word.
  */
-Word::Word() : word_ptr(nullptr), size(0) {
-    // Initialize word_ptr to nullptr and size to 0
+Word::Word() : storage{}, size(0) {
+    // An empty word is stored inline as ""
 }
 
 /**
  * @brief Conversion constructor. Converts C-string to Word object.
  * @param str The C-string to convert.
  */
-Word::Word(const char* str) : word_ptr(new char[strlen(str) + 1]), size(strlen(str)) {
-    // Allocate memory for word_ptr and copy the C-string into it
-    std::strcpy(word_ptr, str); // Copy the input string into word_ptr
+Word::Word(const char* str) : size(0) {
+    build(str, std::strlen(str)); // Normalize the input string and copy it inline or into a new buffer
 }
 
 /**
  * @brief Copy constructor. Performs deep copy of another Word object.
  * @param source The source Word object.
  */
-Word::Word(const Word& source) : word_ptr(new char[source.size + 1]), size(source.size) {
-    // Allocate memory for word_ptr and copy the content from source
-    std::strcpy(word_ptr, source.word_ptr); // Copy the source string into word_ptr
+Word::Word(const Word& source) : size(0) {
+    if (source.size & SHARED_FLAG) { // Use the same buffer: no allocation
+        useCount(source.heapPtr(), SHARED_HEADER).fetch_add(1, std::memory_order_relaxed);
+        std::memcpy(storage, source.storage, sizeof storage);
+        size = source.size;
+        return;
+    }
+    const char* key = (source.size & KEY_FLAG) ? source.c_str() + source.length() + 1 : nullptr; // Already normalized and folded
+    assign(source.c_str(), source.length(), key, key ? std::strlen(key) : 0); // Copy the content from source
+    size |= source.size & ASCII_KEY_FLAG; // An unstored key stays unstored
 }
 
 /**
  * @brief Move constructor. Transfers ownership of resources from another Word object.
  * @param source The source Word object.
  */
-Word::Word(Word&& source) noexcept : word_ptr(source.word_ptr), size(source.size) {
-    // Transfer ownership of word_ptr and size from source to this object
-    source.word_ptr = nullptr; // Set source's word_ptr to nullptr
-    source.size = 0; // Set source's size to 0
+Word::Word(Word&& source) noexcept : size(source.size) {
+    // Inline characters are copied; a heap pointer is transferred
+    std::memcpy(storage, source.storage, sizeof storage);
+    source.storage[0] = '\0'; // Leave the source as an empty word
+    source.size = 0;
 }
 
 /**
@@ -42,10 +373,8 @@ Word::Word(Word&& source) noexcept : word_ptr(source.word_ptr), size(source.size
  */
 Word& Word::operator=(const Word& source) {
     if (this != &source) { // Avoid self-assignment
-        delete[] word_ptr; // Free existing resource
-        word_ptr = new char[source.size + 1]; // Allocate new memory for word_ptr
-        size = source.size; // Copy size from source
-        std::strcpy(word_ptr, source.word_ptr); // Copy content from source to word_ptr
+        Word copy(source); // Copy first so that this object is unchanged if allocation fails
+        *this = std::move(copy); // Take over the copy
     }
     return *this; // Return the current object
 }
@@ -57,11 +386,11 @@ Word& Word::operator=(const Word& source) {
  */
 Word& Word::operator=(Word&& source) noexcept {
     if (this != &source) { // Avoid self-assignment
-        delete[] word_ptr; // Free existing resource
-        word_ptr = source.word_ptr; // Transfer ownership of word_ptr from source
-        size = source.size; // Transfer ownership of size from source
-        source.word_ptr = nullptr; // Set source's word_ptr to nullptr
-        source.size = 0; // Set source's size to 0
+        release(); // Free existing resource
+        std::memcpy(storage, source.storage, sizeof storage); // Take the characters or the heap pointer
+        size = source.size;
+        source.storage[0] = '\0'; // Leave the source as an empty word
+        source.size = 0;
     }
     return *this; // Return the current object
 }
@@ -70,7 +399,7 @@ Word& Word::operator=(Word&& source) noexcept {
  * @brief Destructor. Deallocates dynamically allocated memory.
  */
 Word::~Word() {
-    delete[] word_ptr; // Deallocate memory assigned to word_ptr
+    if (!isInline()) freeHeap(); // Only long words own a buffer
 }
 
 /**
@@ -78,15 +407,15 @@ Word::~Word() {
  * @return The length of the word.
  */
 size_t Word::length() const {
-    return size; // Return the size of the word
+    return size & LENGTH_MASK; // Return the size of the word, without the flags
 }
 
 /**
  * @brief Gets the C-style string representation of the word.
- * @return The C-style string.
+ * @return The C-style string. Never nullptr; an empty word yields "".
  */
 const char* Word::c_str() const {
-    return word_ptr; // Return the C-string representation of the word
+    return isInline() ? storage : heapPtr(); // Return the C-string representation of the word
 }
 
 /**
@@ -112,12 +441,12 @@ void Word::changeWord(const char* newWord) {
  * @return The concatenated Word object.
  */
 Word Word::concat(const Word& other, const char* delimiter) const {
-    size_t newSize = size + std::strlen(delimiter) + other.size; // Calculate the size of the new concatenated word
+    size_t newSize = length() + std::strlen(delimiter) + other.length(); // Calculate the size of the new concatenated word
     char* newStr = new char[newSize + 1]; // Allocate memory for the new word
 
-    std::strcpy(newStr, word_ptr); // Copy the current word into the new word
+    std::strcpy(newStr, c_str()); // Copy the current word into the new word
     std::strcat(newStr, delimiter); // Append the delimiter to the new word
-    std::strcat(newStr, other.word_ptr); // Append the other word to the new word
+    std::strcat(newStr, other.c_str()); // Append the other word to the new word
 
     Word newWord(newStr); // Create a new Word object with the concatenated string
     delete[] newStr; // Deallocate the temporary buffer
@@ -130,7 +459,128 @@ Word Word::concat(const Word& other, const char* delimiter) const {
  * @return True if this word is less than the other.
  */
 bool Word::isLess(const Word& other) const {
-    return std::strcmp(word_ptr, other.word_ptr) < 0; // Compare this word with the other word
+    return std::strcmp(c_str(), other.c_str()) < 0; // strcmp compares bytes as unsigned, which orders UTF-8 by code point
+}
+
+/**
+ * @brief Gets the case-folded key of the word.
+ * @param scratch Receives the key of a word whose key is not stored.
+ * @return The key. Equal to c_str() when folding changes nothing.
+ */
+const char* Word::foldedKey(char (&scratch)[INLINE_CAPACITY + 1]) const {
+    const char* chars = c_str();
+    if (size & ASCII_KEY_FLAG) { // Lowercase the word; it is short, so this is cheap
+        size_t n = length();
+        for (size_t i = 0; i < n; i++) scratch[i] = chars[i] >= 'A' && chars[i] <= 'Z' ? static_cast<char>(chars[i] + ('a' - 'A')) : chars[i];
+        scratch[n] = '\0';
+        return scratch;
+    }
+    return (size & KEY_FLAG) ? chars + length() + 1 : chars; // The key follows the characters' '\0'
+}
+
+/**
+ * @brief Compares case-insensitively with another Word object: by folded key, then by the characters.
+ * @param other The other Word object.
+ * @return Negative, zero or positive as this word sorts before, with or after the other.
+ */
+int Word::compareFolded(const Word& other) const {
+    char mine[INLINE_CAPACITY + 1], theirs[INLINE_CAPACITY + 1];
+    int cmp = std::strcmp(foldedKey(mine), other.foldedKey(theirs));
+    return cmp != 0 ? cmp : std::strcmp(c_str(), other.c_str()); // "Apple" before "apple", so the order is total
+}
+
+/**
+ * @brief Checks whether two words are equal when case is ignored.
+ * @param other The other Word object.
+ * @return True if both words have the same folded key.
+ */
+bool Word::equalsFolded(const Word& other) const {
+    char mine[INLINE_CAPACITY + 1], theirs[INLINE_CAPACITY + 1];
+    return std::strcmp(foldedKey(mine), other.foldedKey(theirs)) == 0;
+}
+
+/**
+ * @brief Builds the key under which case and accents are ignored.
+ * @return The folded key without diacritics, as a Word.
+ */
+Word Word::searchKey() const {
+    char scratch[INLINE_CAPACITY + 1];
+    const char* key = foldedKey(scratch);
+    size_t key_length = std::strlen(key);
+    bool plain = true; // ASCII keys have no accents to remove
+    for (size_t i = 0; i < key_length && plain; i++) plain = static_cast<unsigned char>(key[i]) < 0x80;
+    if (plain || !isValidUtf8(key, key_length)) return key != c_str() ? Word(key) : *this;
+
+    std::string unaccented;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(key);
+    const unsigned char* end = p + key_length;
+    while (p < end) {
+        uint32_t c;
+        decodeUtf8(p, end, c);
+        appendUnaccented(unaccented, c);
+    }
+    return Word(unaccented.c_str());
+}
+
+/**
+ * @brief Hashes the search key without building it. The key's bytes are fed to the hash as searchKey
+ * would produce them, one code point at a time, so the result matches searchKey().hash().
+ * @return The hash value.
+ */
+size_t Word::searchKeyHash() const {
+    char scratch[INLINE_CAPACITY + 1];
+    const char* key = foldedKey(scratch);
+    size_t key_length = std::strlen(key);
+    unsigned long long h = 14695981039346656037ULL; // FNV-1a offset basis, as in hash
+    auto mix = [&h](const char* bytes, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(bytes[i]);
+            h *= 1099511628211ULL;
+        }
+    };
+    bool plain = true;
+    for (size_t i = 0; i < key_length && plain; i++) plain = static_cast<unsigned char>(key[i]) < 0x80;
+    if (plain || !isValidUtf8(key, key_length)) { // The key is the folded key itself
+        mix(key, key_length);
+        return static_cast<size_t>(h);
+    }
+
+    std::string unaccented; // One code point's worth at a time, short enough to stay in the string itself
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(key);
+    const unsigned char* end = p + key_length;
+    while (p < end) {
+        uint32_t c;
+        decodeUtf8(p, end, c);
+        unaccented.clear();
+        appendUnaccented(unaccented, c);
+        mix(unaccented.data(), unaccented.size());
+    }
+    return static_cast<size_t>(h);
+}
+
+/**
+ * @brief Checks that the characters are well-formed UTF-8.
+ * @param str The characters to check.
+ * @param length The number of characters.
+ * @return True if the characters are valid UTF-8.
+ */
+bool Word::isValidUtf8(const char* str, size_t length) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+    const unsigned char* end = p + length;
+    uint32_t code_point;
+    while (p < end) {
+        if (*p < 0x80) { p++; continue; } // ASCII needs no decoding
+        if (!decodeUtf8(p, end, code_point)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that the word is well-formed UTF-8.
+ * @return True if the word is valid UTF-8.
+ */
+bool Word::isValidUtf8() const {
+    return isValidUtf8(c_str(), length());
 }
 
 /**
@@ -140,24 +590,102 @@ bool Word::isLess(const Word& other) const {
  * @throws std::out_of_range If index is out of bounds.
  */
 char Word::at(size_t n) const {
-    if (n >= size) throw std::out_of_range("Index out of range"); // Throw exception if index is out of range
-    return word_ptr[n]; // Return the character at the specified position
+    if (n >= length()) throw std::out_of_range("Index out of range"); // Throw exception if index is out of range
+    return c_str()[n]; // Return the character at the specified position
+}
+
+/**
+ * @brief Computes a hash of the word's characters (64-bit FNV-1a).
+ * @return The hash value. Equal words always hash to the same value.
+ */
+size_t Word::hash() const {
+    const char* chars = c_str(); // The characters to hash
+    unsigned long long h = 14695981039346656037ULL; // FNV-1a offset basis
+    for (size_t i = 0, n = length(); i < n; ++i) {
+        h ^= static_cast<unsigned char>(chars[i]); // Mix in the next byte
+        h *= 1099511628211ULL; // Multiply by the FNV prime
+    }
+    return static_cast<size_t>(h); // Return the hash value
+}
+
+/**
+ * @brief Gets the number of bytes the word has allocated on the heap.
+ * @return 0 for a word stored inline, otherwise the size of its buffer, including the folded key if any.
+ */
+size_t Word::heapBytes() const {
+    if (isInline()) return 0;
+    size_t bytes = contentBytes();
+    if ((size & SHARED_FLAG) == 0) return bytes;
+    size_t users = useCount(heapPtr(), SHARED_HEADER).load(std::memory_order_relaxed);
+    return (SHARED_HEADER + bytes + users - 1) / users; // This word's share of the buffer
+}
+
+/**
+ * @brief Gets the size of the heap buffer's contents: the characters and the key, each with its '\0'.
+ * @return The size in bytes, not counting the header of a shared buffer.
+ */
+size_t Word::contentBytes() const {
+    size_t bytes = length() + 1; // The characters plus the '\0'
+    if (size & KEY_FLAG) bytes += std::strlen(c_str() + length() + 1) + 1; // And the key
+    return bytes;
 }
 
 /**
- * @brief Reads a word from an input stream.
+ * @brief Gets the number of bytes a separate copy of the word would allocate on the heap.
+ * @return 0 for a word stored inline, otherwise the size of an unshared buffer.
+ */
+size_t Word::copyBytes() const {
+    return isInline() ? 0 : contentBytes();
+}
+
+/**
+ * @brief Checks whether the word's heap buffer is shared with other words.
+ * @return True if the buffer is counted, even if this word is its only user.
+ */
+bool Word::isShared() const {
+    return (size & SHARED_FLAG) != 0;
+}
+
+/**
+ * @brief Makes this word use the heap buffer of an equal word, turning that buffer into a shared one first if needed.
+ * @param equal A word with the same characters; this word itself only has its buffer turned into a shared one.
+ * @return The heap bytes freed, less those added by turning equal's buffer into a shared one.
+ */
+std::ptrdiff_t Word::shareBuffer(Word& equal) {
+    if (equal.isInline()) return 0; // Nothing on the heap to share
+    std::ptrdiff_t freed = 0;
+    if ((equal.size & SHARED_FLAG) == 0) { // Move equal's characters into a counted buffer
+        freed -= static_cast<std::ptrdiff_t>(SHARED_HEADER);
+        size_t bytes = equal.contentBytes();
+        char* block = static_cast<char*>(MemoryAccount::current().allocate(SHARED_HEADER + bytes, MemoryAccount::Structure::Words));
+        new (block) std::atomic<uint32_t>(1); // equal is its only user so far
+        char* chars = block + SHARED_HEADER;
+        std::memcpy(chars, equal.heapPtr(), bytes);
+        MemoryAccount::deallocate(equal.heapPtr(), bytes, MemoryAccount::Structure::Words);
+        std::memcpy(equal.storage, &chars, sizeof chars);
+        equal.size |= SHARED_FLAG;
+    }
+    if (!isInline() && heapPtr() == equal.heapPtr()) return freed; // Already using it
+
+    if ((size & SHARED_FLAG) == 0) { // This word's own buffer goes
+        freed += static_cast<std::ptrdiff_t>(contentBytes());
+    } else if (useCount(heapPtr(), SHARED_HEADER).load(std::memory_order_relaxed) == 1) { // So does a shared one it alone used
+        freed += static_cast<std::ptrdiff_t>(SHARED_HEADER + contentBytes());
+    }
+    *this = equal; // The copy takes a use of the buffer
+    return freed;
+}
+
+/**
+ * @brief Reads a word from an input stream: the rest of the current line, whatever its length.
  * @param sin The input stream.
  */
 void Word::read(std::istream& sin) {
-    static char buffer[LONGEST_WORD_PLUS_ONE]; // Static buffer for input
-    sin.getline(buffer, LONGEST_WORD_PLUS_ONE - 1); // Read input into buffer ensuring null-termination
-    buffer[LONGEST_WORD_PLUS_ONE - 1] = '\0'; // Ensure buffer is null-terminated
-
-    if (word_ptr) delete[] word_ptr; // Avoid memory leak by deleting existing word_ptr
+    thread_local std::string buffer; // Reused, so reading allocates only when a line is longer than any before
+    std::getline(sin, buffer); // The whole line, however long
 
-    word_ptr = new char[std::strlen(buffer) + 1]; // Allocate space for the new word
-    size = std::strlen(buffer); // Set size to the length of the buffer
-    std::strcpy(word_ptr, buffer); // Copy buffer into word_ptr
+    release(); // Avoid memory leak by freeing the existing word
+    build(buffer.data(), buffer.size()); // Normalize buffer and copy it inline or into a new allocation
 }
 
 /**
@@ -165,7 +693,7 @@ void Word::read(std::istream& sin) {
  * @param out The output stream.
  */
 void Word::print(std::ostream& out) const {
-    if (word_ptr != nullptr) out << word_ptr; // Print the word to the output stream if not null
+    out << c_str(); // Print the word to the output stream
 }
 
 /**
@@ -197,5 +725,5 @@ std::istream& operator>>(std::istream& in, Word& word) {
  * @return True if both words are equal.
  */
 bool operator==(const Word& lhs, const Word& rhs) {
-    return std::strcmp(lhs.word_ptr, rhs.word_ptr) == 0; // Compare the C-string representations of the two words
+    return lhs.length() == rhs.length() && std::memcmp(lhs.c_str(), rhs.c_str(), lhs.length()) == 0; // Compare the C-string representations of the two words
 }
@@ -4,19 +4,98 @@
 
 #include <iostream> // Provides input and output stream functionalities
 #include <cstring>  // Provides functions for C-style string manipulation
+#include <cstddef>  // Provides std::ptrdiff_t
+#include <cstdint>  // Provides fixed-width integer types
 
 /**
  * @class Word
- * @brief Class to represent a dynamically allocated word.
+ * @brief Class to represent a word. Short words are stored inside the object; longer ones are dynamically allocated.
+ *
+ * A Word occupies 16 bytes. Words of up to INLINE_CAPACITY characters keep their characters (and the
+ * terminating '\0') in 'storage' and need no allocation at all. Longer words keep a pointer to a
+ * heap buffer in the first bytes of 'storage' instead.
+ *
+ * Words are UTF-8. A word built from characters is composed to NFC for the accented Latin letters, so
+ * that "é" typed as e + combining acute and "é" typed precomposed are the same word with the same bytes.
+ * Each word also carries its case-folded key, computed once when the word is built: compareFolded() and
+ * equalsFolded() are then a strcmp of two keys, with no folding per comparison. The key is stored only
+ * when it differs from the word (for example "Paris" has the key "paris"), after the word's '\0' in the
+ * same inline storage or heap buffer, so lowercase words cost nothing extra. A short ASCII word does not
+ * store its key either: the key is the word in lowercase, written out when it is needed, so that a
+ * capitalized word such as "London" stays inline instead of moving to the heap with its key.
+ *
+ * A heap buffer may be shared by equal words (see shareBuffer), to store a word that is in many
+ * categories once. A shared buffer starts with an atomic count of the words using it, and copying a
+ * word that uses one only increments the count; the characters of a shared buffer are never changed.
  */
 class Word {
 private:
-    char* word_ptr; ///< Pointer to the dynamically allocated array of characters
-    size_t size; ///< Size of the word
+    static constexpr size_t INLINE_CAPACITY = 11; ///< Longest word whose characters fit inside the object
+    static constexpr uint32_t HEAP_FLAG = 0x80000000u; ///< Set in 'size' when the characters are on the heap
+    static constexpr uint32_t KEY_FLAG = 0x40000000u; ///< Set in 'size' when a folded key follows the characters
+    static constexpr uint32_t SHARED_FLAG = 0x20000000u; ///< Set in 'size' when the heap buffer is shared and counted
+    static constexpr uint32_t ASCII_KEY_FLAG = 0x10000000u; ///< Set in 'size' for an inline ASCII word with capitals, whose key is not stored
+    static constexpr uint32_t LENGTH_MASK = 0x0FFFFFFFu; ///< The bits of 'size' that hold the length
+    static constexpr size_t SHARED_HEADER = 8; ///< Bytes before the characters of a shared buffer, holding its count
 
-public:
-    static constexpr int LONGEST_WORD_PLUS_ONE = 65; ///< Maximum length of a word plus one
+    char storage[INLINE_CAPACITY + 1]; ///< The characters of a short word, or the heap pointer of a long word
+    uint32_t size; ///< Length of the word, plus the flags
+
+    /**
+     * @brief Checks whether the characters are stored inside the object.
+     * @return True when the word and its key, if any, fit in 'storage'.
+     */
+    inline bool isInline() const { return (size & HEAP_FLAG) == 0; }
+
+    /**
+     * @brief Reads the heap pointer of a long word out of 'storage'.
+     * @return The pointer to the heap buffer.
+     */
+    char* heapPtr() const;
+
+    /**
+     * @brief Replaces the contents with a copy of the given characters and key, allocating only when they do not fit inline.
+     * The previous contents must already have been released.
+     * @param str The characters to copy (need not be '\0'-terminated).
+     * @param length The number of characters.
+     * @param key The folded key to store after the characters, or nullptr when it equals the characters.
+     * @param key_length The number of characters of the key.
+     */
+    void assign(const char* str, size_t length, const char* key = nullptr, size_t key_length = 0);
+
+    /**
+     * @brief Replaces the contents with the NFC form of the given characters and computes their folded key.
+     * The previous contents must already have been released.
+     * @param str The characters (need not be '\0'-terminated).
+     * @param length The number of characters.
+     */
+    void build(const char* str, size_t length);
+
+    /**
+     * @brief Frees the heap buffer of a long word and makes the word empty.
+     */
+    void release();
 
+    /**
+     * @brief Frees the heap buffer, or drops this word's use of it if it is shared.
+     */
+    void freeHeap();
+
+    /**
+     * @brief Gets the case-folded key of the word, e.g. "strasse" for "Straße".
+     * @param scratch Receives the key of a word whose key is not stored
+     * @return The key: the stored one, the characters when folding changes nothing, or scratch.
+     *         Invalidated like c_str(), or when scratch goes away.
+     */
+    const char* foldedKey(char (&scratch)[INLINE_CAPACITY + 1]) const;
+
+    /**
+     * @brief Gets the size of the heap buffer's contents: the characters and the key, each with its '\0'.
+     * @return The size in bytes, not counting the header of a shared buffer.
+     */
+    size_t contentBytes() const;
+
+public:
     /**
      * @brief Default constructor. Initializes to empty word.
      */
@@ -29,7 +108,7 @@ public:
     Word(const char* str);
 
     /**
-     * @brief Copy constructor. Performs deep copy of another Word object.
+     * @brief Copy constructor. Performs deep copy of another Word object, or takes a use of its buffer if that is shared.
      * @param source The source Word object.
      */
     Word(const Word& source);
@@ -67,7 +146,7 @@ public:
 
     /**
      * @brief Gets the C-style string representation of the word.
-     * @return The C-style string.
+     * @return The C-style string. Never nullptr; an empty word yields "". Invalidated when the Word is modified or moved.
      */
     const char* c_str() const;
 
@@ -92,12 +171,55 @@ public:
     Word concat(const Word& other, const char* delimiter = " ") const;
 
     /**
-     * @brief Compares alphabetically with another Word object.
+     * @brief Compares alphabetically with another Word object, by code point.
+     * This is the order every sorted container keeps; see compareFolded() for a case-insensitive order.
      * @param other The other Word object.
      * @return True if this word is less than the other.
      */
     bool isLess(const Word& other) const;
 
+    /**
+     * @brief Compares case-insensitively with another Word object: by folded key, then by the characters.
+     * @param other The other Word object.
+     * @return Negative, zero or positive as this word sorts before, with or after the other.
+     */
+    int compareFolded(const Word& other) const;
+
+    /**
+     * @brief Checks whether two words are equal when case is ignored.
+     * @param other The other Word object.
+     * @return True if both words have the same folded key.
+     */
+    bool equalsFolded(const Word& other) const;
+
+    /**
+     * @brief Builds the key under which case and accents are ignored: the folded key with the diacritics
+     * of the Latin letters removed, e.g. "ecole" for "École". Computed on demand; it is not stored.
+     * @return The key, as a Word.
+     */
+    Word searchKey() const;
+
+    /**
+     * @brief Hashes the search key without building it, so that it allocates nothing.
+     * @return The same value as searchKey().hash().
+     */
+    size_t searchKeyHash() const;
+
+    /**
+     * @brief Checks that the characters are well-formed UTF-8: no stray continuation bytes, overlong
+     * forms, surrogates or code points beyond U+10FFFF.
+     * @param str The characters to check.
+     * @param length The number of characters.
+     * @return True if the characters are valid UTF-8.
+     */
+    static bool isValidUtf8(const char* str, size_t length);
+
+    /**
+     * @brief Checks that the word is well-formed UTF-8.
+     * @return True if the word is valid UTF-8.
+     */
+    bool isValidUtf8() const;
+
     /**
      * @brief Gets the character at a specific position.
      * @param n The position index.
@@ -106,7 +228,42 @@ public:
     char at(size_t n) const;
 
     /**
-     * @brief Reads a word from an input stream.
+     * @brief Computes a hash of the word's characters (64-bit FNV-1a).
+     * @return The hash value. Equal words always hash to the same value.
+     */
+    size_t hash() const;
+
+    /**
+     * @brief Gets the number of bytes the word has allocated on the heap.
+     * @return 0 for a word stored inline, otherwise the size of its buffer, including the folded key if any.
+     *         A word whose buffer is shared is charged its share of it, rounded up.
+     */
+    size_t heapBytes() const;
+
+    /**
+     * @brief Gets the number of bytes a separate copy of the word would allocate on the heap.
+     * @return 0 for a word stored inline, otherwise the size of an unshared buffer.
+     */
+    size_t copyBytes() const;
+
+    /**
+     * @brief Checks whether the word's heap buffer is shared with other words.
+     * @return True if the buffer is counted, even if this word is its only user.
+     */
+    bool isShared() const;
+
+    /**
+     * @brief Makes this word use the heap buffer of an equal word, turning that buffer into a shared one
+     * first if needed. Nothing changes for words stored inline, which have no buffer. Passing the word itself
+     * only turns its buffer into a shared one, so that later copies can take uses of it without changing it.
+     * A word whose buffer is replaced may not be in use on another thread.
+     * @param equal A word with the same characters, or this word.
+     * @return The heap bytes freed, less those added when equal's buffer had to be turned into a shared one.
+     */
+    std::ptrdiff_t shareBuffer(Word& equal);
+
+    /**
+     * @brief Reads a word from an input stream: the rest of the current line, whatever its length.
      * @param sin The input stream.
      */
     void read(std::istream& sin);
@@ -0,0 +1,383 @@
+// WordArena.cpp
+#include "WordArena.h"
+#include "WordFormatter.h"
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Default constructor. Initializes an empty arena.
+ */
+WordArena::WordArena() :
+    bytes{ nullptr }, byte_count{ 0 }, byte_capacity{ 0 }, garbage_bytes{ 0 },
+    entries{ nullptr }, entry_count{ 0 }, entry_capacity{ 0 } {}
+
+/**
+ * @brief Destructor. Deallocates the arena and the entries.
+ */
+WordArena::~WordArena() {
+    delete[] bytes; // Free the characters
+    delete[] entries; // Free the entries
+}
+
+/**
+ * @brief Copy constructor. Copies the words of another arena into a compact arena.
+ * @param other The arena to copy.
+ */
+WordArena::WordArena(const WordArena& other) : WordArena() {
+    size_t live_bytes = other.byte_count - other.garbage_bytes; // Characters of the words still present
+    bytes = new char[live_bytes > 0 ? live_bytes : 1];
+    byte_capacity = live_bytes > 0 ? live_bytes : 1;
+    entries = new Entry[other.entry_count > 0 ? other.entry_count : 1];
+    entry_capacity = other.entry_count > 0 ? other.entry_count : 1;
+
+    for (size_t i = 0; i < other.entry_count; ++i) { // Copy word by word, dropping garbage
+        Entry entry = other.entries[i];
+        std::memcpy(bytes + byte_count, other.text(entry), entry.length + 1); // Characters and '\0'
+        entry.offset = static_cast<uint32_t>(byte_count);
+        entries[entry_count++] = entry;
+        byte_count += entry.length + 1;
+    }
+}
+
+/**
+ * @brief Copy assignment operator. Copies the words of another arena.
+ * @param other The arena to copy.
+ * @return A reference to this object.
+ */
+WordArena& WordArena::operator=(const WordArena& other) {
+    if (this != &other) { // Avoid self-assignment
+        WordArena copy(other); // Copy first so that this object is unchanged if allocation fails
+        *this = std::move(copy); // Take ownership of the copy
+    }
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Takes ownership of another arena's buffers.
+ * @param other The arena to move from.
+ */
+WordArena::WordArena(WordArena&& other) noexcept :
+    bytes{ other.bytes }, byte_count{ other.byte_count }, byte_capacity{ other.byte_capacity }, garbage_bytes{ other.garbage_bytes },
+    entries{ other.entries }, entry_count{ other.entry_count }, entry_capacity{ other.entry_capacity } {
+    other.bytes = nullptr; // The other arena becomes empty
+    other.byte_count = other.byte_capacity = other.garbage_bytes = 0;
+    other.entries = nullptr;
+    other.entry_count = other.entry_capacity = 0;
+}
+
+/**
+ * @brief Move assignment operator. Takes ownership of another arena's buffers.
+ * @param other The arena to move from.
+ * @return A reference to this object.
+ */
+WordArena& WordArena::operator=(WordArena&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        delete[] bytes; // Free the old buffers
+        delete[] entries;
+
+        bytes = other.bytes; // Take ownership of the other's buffers
+        byte_count = other.byte_count;
+        byte_capacity = other.byte_capacity;
+        garbage_bytes = other.garbage_bytes;
+        entries = other.entries;
+        entry_count = other.entry_count;
+        entry_capacity = other.entry_capacity;
+
+        other.bytes = nullptr; // The other arena becomes empty
+        other.byte_count = other.byte_capacity = other.garbage_bytes = 0;
+        other.entries = nullptr;
+        other.entry_count = other.entry_capacity = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Replaces the contents with the words of a sorted list. Both arrays are sized exactly once.
+ * @param sortedWords The words, in sorted order and without duplicates.
+ */
+void WordArena::assign(const WordList& sortedWords) {
+    size_t total_bytes{ 0 }; // Characters needed, including terminators
+    sortedWords.forEach([&total_bytes](const Word& w) { total_bytes += w.length() + 1; });
+
+    WordArena fresh; // Build aside, then swap in
+    fresh.bytes = new char[total_bytes > 0 ? total_bytes : 1];
+    fresh.byte_capacity = total_bytes > 0 ? total_bytes : 1;
+    fresh.entries = new Entry[sortedWords.length() > 0 ? sortedWords.length() : 1];
+    fresh.entry_capacity = sortedWords.length() > 0 ? sortedWords.length() : 1;
+
+    sortedWords.forEach([&fresh](const Word& w) { // Append each word in order
+        std::memcpy(fresh.bytes + fresh.byte_count, w.c_str(), w.length() + 1); // Characters and '\0'
+        fresh.entries[fresh.entry_count++] = Entry{ static_cast<uint32_t>(fresh.byte_count), static_cast<uint32_t>(w.length()), static_cast<uint32_t>(w.hash()) };
+        fresh.byte_count += w.length() + 1;
+    });
+
+    *this = std::move(fresh); // Take over the new buffers
+}
+
+/**
+ * @brief Copies the words into a new sorted WordList.
+ * @return The words as a list.
+ */
+WordList WordArena::toWordList() const {
+    WordList words; // The result
+    for (size_t i = 0; i < entry_count; ++i) {
+        words.push_back(Word(text(entries[i]))); // Already sorted, so append
+    }
+    return words;
+}
+
+/**
+ * @brief Finds the first entry whose word is not less than the given characters.
+ * @param str The '\0'-terminated characters to search for.
+ * @return The index of that entry, or entry_count if every word is less.
+ */
+size_t WordArena::lowerBound(const char* str) const {
+    size_t low = 0, high = entry_count; // Search the half-open range [low, high)
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (std::strcmp(text(entries[mid]), str) < 0) {
+            low = mid + 1; // The word is in the upper half
+        } else {
+            high = mid; // The word is at mid or in the lower half
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Ensures the arena and the entry array can take one more word of the given length.
+ * Both buffers grow geometrically, so appends are amortized O(1).
+ * @param length The length of the word to add.
+ */
+void WordArena::reserveFor(size_t length) {
+    if (byte_count + length + 1 > byte_capacity) { // Not enough room for the characters
+        if (garbage_bytes * 2 > byte_count) compact(); // Reclaim space first when mostly garbage
+    }
+    if (byte_count + length + 1 > byte_capacity) { // Still not enough room
+        size_t new_capacity = byte_capacity > 0 ? byte_capacity * 2 : 64;
+        while (new_capacity < byte_count + length + 1) new_capacity *= 2;
+        if (new_capacity > UINT32_MAX) throw std::runtime_error("Word arena exceeds 4 GiB");
+
+        char* new_bytes = new char[new_capacity];
+        if (byte_count > 0) std::memcpy(new_bytes, bytes, byte_count); // Offsets stay valid
+        delete[] bytes;
+        bytes = new_bytes;
+        byte_capacity = new_capacity;
+    }
+
+    if (entry_count == entry_capacity) { // Not enough room for the entry
+        size_t new_capacity = entry_capacity > 0 ? entry_capacity * 2 : 16;
+        Entry* new_entries = new Entry[new_capacity];
+        if (entry_count > 0) std::memcpy(new_entries, entries, entry_count * sizeof(Entry));
+        delete[] entries;
+        entries = new_entries;
+        entry_capacity = new_capacity;
+    }
+}
+
+/**
+ * @brief Rewrites the arena without the characters of removed words.
+ */
+void WordArena::compact() {
+    char* new_bytes = new char[byte_capacity]; // Same capacity, so the growth policy is unaffected
+    size_t used{ 0 }; // Bytes written so far
+
+    for (size_t i = 0; i < entry_count; ++i) { // Copy live words in entry order
+        std::memcpy(new_bytes + used, text(entries[i]), entries[i].length + 1);
+        entries[i].offset = static_cast<uint32_t>(used);
+        used += entries[i].length + 1;
+    }
+
+    delete[] bytes;
+    bytes = new_bytes;
+    byte_count = used;
+    garbage_bytes = 0; // Every remaining byte is live
+}
+
+/**
+ * @brief Inserts a word in sorted position. Duplicates are ignored.
+ * The characters are appended to the arena; only the 12-byte entries after the insertion point move.
+ * @param word The word to insert.
+ * @return True if the word was inserted, false if it was already present.
+ */
+bool WordArena::insertSorted(const Word& word) {
+    size_t position = lowerBound(word.c_str()); // Sorted insertion point
+    if (position < entry_count && std::strcmp(text(entries[position]), word.c_str()) == 0) return false; // Already present
+
+    reserveFor(word.length()); // May compact or reallocate, which keeps positions valid
+    std::memcpy(bytes + byte_count, word.c_str(), word.length() + 1); // Append characters and '\0'
+
+    std::memmove(entries + position + 1, entries + position, (entry_count - position) * sizeof(Entry)); // Open a slot
+    entries[position] = Entry{ static_cast<uint32_t>(byte_count), static_cast<uint32_t>(word.length()), static_cast<uint32_t>(word.hash()) };
+    entry_count++;
+    byte_count += word.length() + 1;
+    return true;
+}
+
+/**
+ * @brief Removes a word. Its characters become garbage that is reclaimed by a later compaction.
+ * @param word The word to remove.
+ * @return True if the word was found and removed, false otherwise.
+ */
+bool WordArena::remove(const Word& word) {
+    size_t position = lowerBound(word.c_str()); // Where the word would be
+    if (position == entry_count || std::strcmp(text(entries[position]), word.c_str()) != 0) return false; // Not present
+
+    garbage_bytes += entries[position].length + 1; // Its characters are now unused
+    std::memmove(entries + position, entries + position + 1, (entry_count - position - 1) * sizeof(Entry)); // Close the slot
+    entry_count--;
+
+    if (entry_count == 0) clear(); // Nothing left: start the arena over
+    return true;
+}
+
+/**
+ * @brief Removes all words, keeping the allocated buffers.
+ */
+void WordArena::clear() {
+    byte_count = 0;
+    garbage_bytes = 0;
+    entry_count = 0;
+}
+
+/**
+ * @brief Checks if the given word is in the arena, by binary search.
+ * The final candidate is compared by length and hash before its characters.
+ * @param word The word to look up.
+ * @return True if the word is found, false otherwise.
+ */
+bool WordArena::lookup(const Word& word) const {
+    size_t position = lowerBound(word.c_str()); // Where the word would be
+    if (position == entry_count) return false;
+
+    const Entry& entry = entries[position];
+    return entry.length == word.length()
+        && entry.hash == static_cast<uint32_t>(word.hash())
+        && std::memcmp(text(entry), word.c_str(), entry.length) == 0;
+}
+
+/**
+ * @brief Looks up a batch of words with a single merge pass.
+ * @param words The words to look up.
+ * @param count The number of words.
+ * @param found Array of count elements; found[i] is set to whether words[i] is in the arena.
+ * @param order Optional ascending permutation of the words; computed when nullptr.
+ */
+void WordArena::lookupMany(const Word* words, size_t count, bool* found, const size_t* order) const {
+    size_t* own_order = order == nullptr ? WordList::sortedOrder(words, count) : nullptr; // Sort the probes if the caller did not
+    const size_t* probes = order != nullptr ? order : own_order; // Probe indices in ascending word order
+
+    size_t cursor{ 0 }; // Index into the sorted entries
+    for (size_t k = 0; k < count; ++k) { // Visit the probes in ascending order
+        const char* probe = words[probes[k]].c_str();
+        int cmp = 1; // Result of comparing the cursor's word with the probe
+        while (cursor < entry_count && (cmp = std::strcmp(text(entries[cursor]), probe)) < 0) {
+            cursor++; // Skip smaller words
+        }
+        found[probes[k]] = cursor < entry_count && cmp == 0;
+    }
+
+    delete[] own_order; // Free the order computed here (a no-op for nullptr)
+}
+
+/**
+ * @brief Returns a copy of the word at the given index.
+ * @param index The index of the word, in sorted order.
+ * @return A copy of the word.
+ * @throws std::runtime_error if the index is out of range.
+ */
+Word WordArena::fetchWord(size_t index) const {
+    return Word(wordAt(index));
+}
+
+/**
+ * @brief Returns the characters of the word at the given index without copying them.
+ * @param index The index of the word, in sorted order.
+ * @return The '\0'-terminated characters, valid until the arena is modified.
+ * @throws std::runtime_error if the index is out of range.
+ */
+const char* WordArena::wordAt(size_t index) const {
+    if (index >= entry_count) throw std::runtime_error("Index out of range");
+    return text(entries[index]);
+}
+
+/**
+ * @brief Returns the words at positions [offset, offset + limit), in sorted order.
+ * @param offset The position of the first word.
+ * @param limit The maximum number of words.
+ * @return The words of the page; empty when offset is past the end.
+ */
+WordList WordArena::page(size_t offset, size_t limit) const {
+    WordList words;
+    for (size_t i = offset; i < entry_count && i - offset < limit; ++i) { // Entries are indexed directly
+        words.push_back(Word(text(entries[i])));
+    }
+    return words;
+}
+
+/**
+ * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+ * @param from Where to start; it need not be in the arena.
+ * @param limit The maximum number of words.
+ * @return The words of the page.
+ */
+WordList WordArena::range(const Word& from, size_t limit) const {
+    return page(lowerBound(from.c_str()), limit);
+}
+
+/**
+ * @brief Counts the words less than a given word, by binary search.
+ * @param word The word to rank; it need not be in the arena.
+ * @return The number of words that sort before it.
+ */
+size_t WordArena::rank(const Word& word) const {
+    return lowerBound(word.c_str());
+}
+
+/**
+ * @brief Returns the words starting with the given letter. They are found by binary search.
+ * @param letter The initial letter of the words to return.
+ * @return A sorted list of the matching words.
+ */
+WordList WordArena::wordsStartingWith(const char letter) const {
+    WordList initialLetterWords; // Words starting with the given letter
+    const char prefix[2] = { letter, '\0' }; // The smallest word starting with the letter
+
+    for (size_t i = lowerBound(prefix); i < entry_count && text(entries[i])[0] == letter; ++i) { // The matches are contiguous
+        initialLetterWords.push_back(Word(text(entries[i])));
+    }
+
+    return initialLetterWords;
+}
+
+/**
+ * @brief Calls a function on every word, in sorted order.
+ * @param visit The function to call with each word.
+ */
+void WordArena::forEach(const std::function<void(const Word&)>& visit) const {
+    for (size_t i = 0; i < entry_count; ++i) {
+        visit(Word(text(entries[i])));
+    }
+}
+
+/**
+ * @brief Prints the words with a maximum of n words per line, in the same layout as WordList::print.
+ * Lines are assembled in a local buffer straight from the arena and written in large blocks.
+ * @param sout The output stream to print to.
+ * @param n The maximum number of words per line.
+ * @return The total number of words printed.
+ */
+int WordArena::print(std::ostream& sout, const int n) const {
+    WordFormatter formatter(sout, n);
+    for (size_t i = 0; i < entry_count; ++i) formatter.put(text(entries[i]), entries[i].length); // Straight from the arena
+    return formatter.finish();
+}
+
+/**
+ * @brief Returns the memory allocated by the arena and its entries.
+ * @return The allocated size in bytes.
+ */
+size_t WordArena::memoryBytes() const {
+    return byte_capacity + entry_capacity * sizeof(Entry);
+}
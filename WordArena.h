@@ -0,0 +1,227 @@
+// WordArena.h
+#ifndef WORDARENA_H_
+#define WORDARENA_H_
+
+#include "Word.h"
+#include "WordList.h"
+#include <cstdint>
+#include <functional>
+#include <iostream>
+
+/**
+ * @class WordArena
+ * @brief A sorted set of words stored as one contiguous byte arena plus a parallel array of entries.
+ *
+ * The characters of every word live back to back (each followed by '\0') in a single buffer, and
+ * a sorted array of (offset, length, hash) entries indexes them. Scans walk two flat arrays instead
+ * of chasing a pointer per node and another per string, lookups are binary searches, and fetching
+ * the i-th word is O(1). Offsets are 32-bit, so one arena holds at most 4 GiB of characters.
+ */
+class WordArena {
+private:
+    /**
+     * @brief Location and fingerprint of one word in the arena.
+     */
+    struct Entry {
+        uint32_t offset; ///< Position of the word's first character in bytes
+        uint32_t length; ///< Number of characters, excluding the terminating '\0'
+        uint32_t hash; ///< Low 32 bits of Word::hash(), used to reject unequal words cheaply
+    };
+
+    char* bytes; ///< The character arena
+    size_t byte_count; ///< Bytes in use, including removed words not yet compacted
+    size_t byte_capacity; ///< Allocated size of the arena
+    size_t garbage_bytes; ///< Bytes belonging to removed words
+
+    Entry* entries; ///< The entries, sorted by word
+    size_t entry_count; ///< Number of words
+    size_t entry_capacity; ///< Allocated number of entries
+
+    /**
+     * @brief Returns a pointer to the characters of an entry.
+     * @param entry The entry
+     * @return The '\0'-terminated characters
+     */
+    inline const char* text(const Entry& entry) const { return bytes + entry.offset; }
+
+    /**
+     * @brief Finds the first entry whose word is not less than the given characters.
+     * @param str The '\0'-terminated characters to search for
+     * @return The index of that entry, or entry_count if every word is less
+     */
+    size_t lowerBound(const char* str) const;
+
+    /**
+     * @brief Ensures the arena and the entry array can take one more word of the given length.
+     * @param length The length of the word to add
+     */
+    void reserveFor(size_t length);
+
+    /**
+     * @brief Rewrites the arena without the characters of removed words.
+     */
+    void compact();
+
+public:
+    /**
+     * @brief Default constructor. Initializes an empty arena.
+     */
+    WordArena();
+
+    /**
+     * @brief Destructor. Deallocates the arena and the entries.
+     */
+    ~WordArena();
+
+    /**
+     * @brief Copy constructor. Copies the words of another arena into a compact arena.
+     * @param other The arena to copy
+     */
+    WordArena(const WordArena& other);
+
+    /**
+     * @brief Copy assignment operator. Copies the words of another arena.
+     * @param other The arena to copy
+     * @return A reference to this object
+     */
+    WordArena& operator=(const WordArena& other);
+
+    /**
+     * @brief Move constructor. Takes ownership of another arena's buffers.
+     * @param other The arena to move from
+     */
+    WordArena(WordArena&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator. Takes ownership of another arena's buffers.
+     * @param other The arena to move from
+     * @return A reference to this object
+     */
+    WordArena& operator=(WordArena&& other) noexcept;
+
+    /**
+     * @brief Replaces the contents with the words of a sorted list. Both arrays are sized exactly once.
+     * @param sortedWords The words, in sorted order and without duplicates
+     */
+    void assign(const WordList& sortedWords);
+
+    /**
+     * @brief Copies the words into a new sorted WordList.
+     * @return The words as a list
+     */
+    WordList toWordList() const;
+
+    /**
+     * @brief Inserts a word in sorted position. Duplicates are ignored.
+     * @param word The word to insert
+     * @return true if the word was inserted, false if it was already present
+     */
+    bool insertSorted(const Word& word);
+
+    /**
+     * @brief Removes a word.
+     * @param word The word to remove
+     * @return true if the word was found and removed, false otherwise
+     */
+    bool remove(const Word& word);
+
+    /**
+     * @brief Removes all words, keeping the allocated buffers.
+     */
+    void clear();
+
+    /**
+     * @brief Checks if the given word is in the arena, by binary search.
+     * @param word The word to look up
+     * @return true if the word is found, false otherwise
+     */
+    bool lookup(const Word& word) const;
+
+    /**
+     * @brief Looks up a batch of words with a single merge pass.
+     * @param words The words to look up
+     * @param count The number of words
+     * @param found Array of count elements; found[i] is set to whether words[i] is in the arena
+     * @param order Optional ascending permutation of the words (see WordList::sortedOrder); computed when nullptr
+     */
+    void lookupMany(const Word* words, size_t count, bool* found, const size_t* order = nullptr) const;
+
+    /**
+     * @brief Returns a copy of the word at the given index.
+     * @param index The index of the word, in sorted order
+     * @return A copy of the word
+     * @throws std::runtime_error if the index is out of range.
+     */
+    Word fetchWord(size_t index) const;
+
+    /**
+     * @brief Returns the characters of the word at the given index without copying them.
+     * @param index The index of the word, in sorted order
+     * @return The '\0'-terminated characters, valid until the arena is modified
+     */
+    const char* wordAt(size_t index) const;
+
+    /**
+     * @brief Returns the words at positions [offset, offset + limit), in sorted order. Costs only the words copied.
+     * @param offset The position of the first word
+     * @param limit The maximum number of words
+     * @return The words of the page; empty when offset is past the end
+     */
+    WordList page(size_t offset, size_t limit) const;
+
+    /**
+     * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+     * @param from Where to start, found by binary search; it need not be in the arena
+     * @param limit The maximum number of words
+     * @return The words of the page
+     */
+    WordList range(const Word& from, size_t limit) const;
+
+    /**
+     * @brief Counts the words less than a given word, by binary search.
+     * @param word The word to rank; it need not be in the arena
+     * @return The number of words that sort before it
+     */
+    size_t rank(const Word& word) const;
+
+    /**
+     * @brief Determines whether the arena is empty.
+     * @return True if the arena has no words, false otherwise
+     */
+    inline bool isEmpty() const { return entry_count == 0; }
+
+    /**
+     * @brief Returns the number of words.
+     * @return The number of words
+     */
+    inline size_t length() const { return entry_count; }
+
+    /**
+     * @brief Returns the words starting with the given letter. They are found by binary search.
+     * @param letter The initial letter of the words to return
+     * @return A sorted list of the matching words
+     */
+    WordList wordsStartingWith(const char letter) const;
+
+    /**
+     * @brief Calls a function on every word, in sorted order.
+     * @param visit The function to call with each word
+     */
+    void forEach(const std::function<void(const Word&)>& visit) const;
+
+    /**
+     * @brief Prints the words with a maximum of n words per line, in the same layout as WordList::print.
+     * @param sout The output stream to print to
+     * @param n The maximum number of words per line, or WordFormatter::FIT_TERMINAL to fit the terminal width
+     * @return The total number of words printed
+     */
+    int print(std::ostream& sout, const int n = 5) const;
+
+    /**
+     * @brief Returns the memory allocated by the arena and its entries.
+     * @return The allocated size in bytes
+     */
+    size_t memoryBytes() const;
+};
+
+#endif // WORDARENA_H_
@@ -1 +1,1088 @@
+// WordCat.cpp
+#include "WordCat.h"
+#include "WordFormatter.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <utility>
 
+/**
+ * @brief Default constructor. Initializes category and wordList to their default values.
+ */
+WordCat::WordCat() :
+    storage_mode{ StorageMode::List },
+    filter_stale{ false },
+    filter_rejections{ 0 },
+    filter_false_positives{ 0 },
+    folded_index_enabled{ false },
+    hit_counting{ false },
+    version{ newVersion() },
+    loaded{ true } {}
+
+/**
+ * @brief Conversion constructor. Initializes category to the input Word and wordList to its default value.
+ * @param category The Word to convert.
+ */
+WordCat::WordCat(const Word& category) :
+    category(category),
+    storage_mode{ StorageMode::List },
+    filter_stale{ false },
+    filter_rejections{ 0 },
+    filter_false_positives{ 0 },
+    folded_index_enabled{ false },
+    hit_counting{ false },
+    version{ newVersion() },
+    loaded{ true } {}
+
+/**
+ * @brief Constructor. Initializes category to the input Word and takes ownership of an already sorted word list.
+ * @param category The category name.
+ * @param sortedWords The words of the category, in sorted order and without duplicates.
+ */
+WordCat::WordCat(const Word& category, WordList&& sortedWords) :
+    category(category),
+    wordList(std::move(sortedWords)),
+    storage_mode{ StorageMode::List },
+    filter_stale{ !wordList.isEmpty() }, // The filter is built on first use
+    filter_rejections{ 0 },
+    filter_false_positives{ 0 },
+    folded_index_enabled{ false },
+    hit_counting{ false },
+    version{ newVersion() },
+    loaded{ true } {}
+
+/**
+ * @brief Constructor. Initializes category to the input Word and takes ownership of front-coded words.
+ * @param category The category name.
+ * @param words The words of the category.
+ */
+WordCat::WordCat(const Word& category, FrontCodedList&& words) :
+    category(category),
+    compressed(std::move(words)),
+    storage_mode{ StorageMode::Compressed },
+    filter_stale{ !compressed.isEmpty() }, // The filter is built on first use
+    filter_rejections{ 0 },
+    filter_false_positives{ 0 },
+    folded_index_enabled{ false },
+    hit_counting{ false },
+    version{ newVersion() },
+    loaded{ true } {}
+
+/**
+ * @brief Constructor for a lazily loaded category. Only the location of the words is recorded here.
+ * @param category The category name.
+ * @param source The bytes of the file that hold the words.
+ */
+WordCat::WordCat(const Word& category, const FileRange& source) :
+    category(category),
+    storage_mode{ StorageMode::List },
+    filter_stale{ false },
+    filter_rejections{ 0 },
+    filter_false_positives{ 0 },
+    folded_index_enabled{ false },
+    hit_counting{ false },
+    version{ newVersion() },
+    source(source),
+    loaded{ source.path == nullptr } {} // Nothing to parse without a file
+
+/**
+ * @brief Destructor. Deallocates any memory that was previously reserved by the WordCat object.
+ */
+WordCat::~WordCat() {}
+
+/**
+ * @brief Copy constructor. Initializes a new WordCat object as a copy of an existing one.
+ * A lazily loaded category is copied unparsed, so the copy parses the same bytes when it is first used.
+ * @param other The WordCat object to copy.
+ */
+WordCat::WordCat(const WordCat& other) : WordCat() {
+    *this = other; // Copy under other's load lock
+}
+
+/**
+ * @brief Copy assignment operator. Assigns the values of an existing WordCat object to another.
+ * @param other The WordCat object to copy.
+ * @return A reference to this object.
+ */
+WordCat& WordCat::operator=(const WordCat& other) {
+    if (this != &other) { // Avoid self-assignment
+        std::lock_guard<std::mutex> guard(other.load_lock); // A reader may be parsing other's words right now
+        category = other.category; // Copy the name
+        wordList = other.wordList; // Copy the words
+        arena = other.arena;
+        compressed = other.compressed;
+        persistent = other.persistent; // Shares the tree: O(1)
+        storage_mode = other.storage_mode;
+        {
+            std::lock_guard<std::mutex> filter_guard(other.filter_lock); // A reader may be rebuilding other's filter right now
+            filter = other.filter; // Copy the filter that matches them
+            filter_stale = other.filter_stale.load();
+        }
+        filter_rejections = 0; // Statistics start over
+        filter_false_positives = 0;
+        folded_index = other.folded_index; // Copy the index of the same words
+        folded_index_enabled = other.folded_index_enabled;
+        hit_counter = other.hit_counter; // Copy the counts of the same words
+        hit_counting = other.hit_counting;
+        version = other.version; // Same contents, same stamp
+        source = other.source; // Share the file location of words not parsed yet
+        loaded = other.loaded.load();
+    }
+    return *this;
+}
+
+/**
+ * @brief Move constructor. Initializes a new WordCat object by taking ownership of the data in an existing one.
+ * @param other The WordCat object to move.
+ */
+WordCat::WordCat(WordCat&& other) noexcept :
+    category(std::move(other.category)),
+    wordList(std::move(other.wordList)),
+    arena(std::move(other.arena)),
+    compressed(std::move(other.compressed)),
+    persistent(std::move(other.persistent)),
+    storage_mode{ other.storage_mode },
+    filter(std::move(other.filter)),
+    filter_stale{ other.filter_stale.load() },
+    filter_rejections{ other.filter_rejections.load() },
+    filter_false_positives{ other.filter_false_positives.load() },
+    folded_index(std::move(other.folded_index)),
+    folded_index_enabled{ other.folded_index_enabled },
+    hit_counter(std::move(other.hit_counter)),
+    hit_counting{ other.hit_counting },
+    version{ other.version },
+    source(std::move(other.source)),
+    loaded{ other.loaded.load() } {
+    other.version = newVersion(); // The moved-from category no longer has those contents
+    other.filter_stale = false; // The moved-from category is empty, and so is its filter
+    other.source = FileRange(); // It has nothing left to load either
+    other.loaded = true;
+}
+
+/**
+ * @brief Move assignment operator. Assigns the values of an existing WordCat object to another by moving data, not copying it.
+ * @param other The WordCat object to move.
+ * @return A reference to this object.
+ */
+WordCat& WordCat::operator=(WordCat&& other) noexcept {
+    if (this != &other) { // Avoid self-assignment
+        category = std::move(other.category); // Take the name
+        wordList = std::move(other.wordList); // Take the words
+        arena = std::move(other.arena);
+        compressed = std::move(other.compressed);
+        persistent = std::move(other.persistent);
+        storage_mode = other.storage_mode;
+        filter = std::move(other.filter); // Take the filter that matches them
+        filter_stale = other.filter_stale.load();
+        filter_rejections = other.filter_rejections.load();
+        filter_false_positives = other.filter_false_positives.load();
+        folded_index = std::move(other.folded_index); // Take the index of the same words
+        folded_index_enabled = other.folded_index_enabled;
+        hit_counter = std::move(other.hit_counter); // Take the counts of the same words
+        hit_counting = other.hit_counting;
+        version = other.version;
+        source = std::move(other.source); // Take the words not parsed yet
+        loaded = other.loaded.load();
+        other.version = newVersion(); // The moved-from category no longer has those contents
+        other.filter_stale = false; // The moved-from category is empty, and so is its filter
+        other.source = FileRange(); // It has nothing left to load either
+        other.loaded = true;
+    }
+    return *this;
+}
+
+/**
+ * @brief Returns the name of the category.
+ * @return A reference to the category name, valid as long as the WordCat is not modified.
+ */
+const Word& WordCat::getCategoryName() const {
+    return category; // Return the category name without copying it
+}
+
+/**
+ * @brief Empties the category by clearing the word list.
+ */
+void WordCat::emptyCategory() {
+    wordList.clear(); // Remove every word
+    arena.clear();
+    compressed.clear();
+    persistent.clear();
+    filter = BloomFilter(); // An empty filter rejects every word, which matches the empty list
+    filter_stale = false;
+    folded_index.clear(); // The index stays enabled, with nothing in it
+    hit_counter.clear(); // So does counting
+    source = FileRange(); // Words not parsed yet are dropped too
+    loaded = true;
+    version = newVersion();
+}
+
+/**
+ * @brief Returns a version stamp that no category has had before.
+ * @return The stamp, unique within the process.
+ */
+uint64_t WordCat::newVersion() {
+    static std::atomic<uint64_t> next{ 1 }; // Shared by every category, so stamps never repeat
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the version stamp of the category's contents.
+ * @return The stamp.
+ */
+uint64_t WordCat::getVersion() const {
+    return version;
+}
+
+/**
+ * @brief Parses the words of a lazily loaded category on first use.
+ * Uses the same double-checked locking as refreshFilter(): once the words are loaded, readers
+ * only pay for one atomic load.
+ */
+void WordCat::ensureLoaded() const {
+    if (!loaded.load(std::memory_order_acquire)) { // The words are still in the file
+        std::lock_guard<std::mutex> guard(load_lock);
+        if (!loaded.load(std::memory_order_relaxed)) { // No other reader parsed them meanwhile
+            const_cast<WordCat*>(this)->loadWords(); // Parsing only materializes words the category already has
+            loaded.store(true, std::memory_order_release); // Publish the parsed words
+        }
+    }
+}
+
+/**
+ * @brief Reads the bytes in 'source' and inserts their words, one per line, as WordCatVec::loadFromFile does.
+ */
+void WordCat::loadWords() {
+    std::ifstream file(*source.path, std::ios::binary); // Binary, so that offsets are exact byte positions
+    if (!file) { // The file went away since it was opened
+        std::cerr << "Error opening file: " << *source.path << std::endl;
+        source = FileRange();
+        return; // The category stays empty
+    }
+
+    size_t length = static_cast<size_t>(source.length);
+    char* bytes = new char[length + 1]; // The category's lines
+    file.seekg(source.offset);
+    file.read(bytes, source.length);
+    length = static_cast<size_t>(file.gcount()); // Fewer bytes if the file was truncated since
+    bytes[length] = '\0';
+
+    WordCat parsed(category); // Fill an eagerly loaded category, so that duplicates and the filter are handled as usual
+    char* line = bytes;
+    while (line < bytes + length) { // One word per line
+        char* end = static_cast<char*>(std::memchr(line, '\n', bytes + length - line));
+        if (end == nullptr) end = bytes + length; // The last line need not end with a newline
+        *end = '\0';
+
+        trim(line); // Trim leading and trailing spaces from the line
+        if (line[0] != '\0' && line[0] != '#') parsed.insertWord(Word(line)); // Skip empty lines
+        line = end + 1; // Move to the next line
+    }
+    delete[] bytes;
+
+    parsed.setStorageMode(storage_mode); // Store the words the way this category does
+    wordList = std::move(parsed.wordList);
+    arena = std::move(parsed.arena);
+    compressed = std::move(parsed.compressed);
+    persistent = std::move(parsed.persistent);
+    filter = std::move(parsed.filter);
+    filter_stale = parsed.filter_stale.load();
+    source = FileRange(); // Nothing left in the file for this category
+}
+
+/**
+ * @brief Rebuilds the membership filter if a mutation made it stale.
+ * Uses double-checked locking: readers that find the filter current never take the lock, and
+ * mutations only happen under the caller's exclusive access, so a current filter is never written
+ * while it is being read.
+ */
+void WordCat::refreshFilter() const {
+    ensureLoaded(); // The filter describes the parsed words
+    if (filter_stale.load(std::memory_order_acquire)) { // A mutation invalidated the filter
+        std::lock_guard<std::mutex> guard(filter_lock);
+        if (filter_stale.load(std::memory_order_relaxed)) { // No other reader rebuilt it meanwhile
+            size_t count = wordCount(); // Words to add
+            filter.reset(count + count / 2); // Headroom so growth rebuilds only geometrically often
+            forEachWord([this](const Word& w) { filter.add(w); }); // Add every word
+            filter_stale.store(false, std::memory_order_release); // Publish the rebuilt filter
+        }
+    }
+}
+
+/**
+ * @brief Consults the membership filter, rebuilding it first if needed.
+ * @param word The word to test.
+ * @return False if the word is definitely not in the list, true if it may be.
+ */
+bool WordCat::filterMightContain(const Word& word) const {
+    refreshFilter(); // Make sure the filter matches the list
+    return filter.mightContain(word);
+}
+
+/**
+ * @brief Looks up a word in the word list. A word that is found gets a hit when hit counting is on.
+ * @param newWord The word to look up.
+ * @return True if the word exists in the list, false otherwise.
+ */
+bool WordCat::lookupWordInList(const Word& newWord) const {
+    if (!hit_counting) return contains(newWord);
+
+    uint64_t hash = HitCounter::hashOf(newWord);
+    hit_counter.prefetch(hash); // The counter's cache miss overlaps the lookup
+    bool found = contains(newWord);
+    if (found) hit_counter.touch(hash); // One relaxed add
+    return found;
+}
+
+/**
+ * @brief Looks up a word without counting a hit.
+ * The filter answers most misses from one cache line; only possible hits walk the list.
+ * @param newWord The word to look up.
+ * @return True if the word is in the category.
+ */
+bool WordCat::contains(const Word& newWord) const {
+    if (!filterMightContain(newWord)) { // Definitely absent
+        filter_rejections.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    bool found{ false }; // Confirm with the words
+    switch (storage_mode) {
+        case StorageMode::List: found = wordList.lookup(newWord); break;
+        case StorageMode::Arena: found = arena.lookup(newWord); break;
+        case StorageMode::Compressed: found = compressed.lookup(newWord); break;
+        case StorageMode::Persistent: found = persistent.lookup(newWord); break;
+    }
+    if (!found) filter_false_positives.fetch_add(1, std::memory_order_relaxed); // The filter was wrong
+    return found;
+}
+
+/**
+ * @brief Turns the index of words by search key on or off.
+ * @param enabled Whether to keep the index.
+ */
+void WordCat::setFoldedIndex(bool enabled) {
+    FoldedIndex index; // Built aside, so that a failure leaves the old index in place
+    if (enabled) forEachWord([&index](const Word& word) { index.add(word); }); // Parses a lazy category first
+    folded_index = std::move(index);
+    folded_index_enabled = enabled;
+}
+
+/**
+ * @brief Tells whether the index of words by search key is kept.
+ * @return True if setFoldedIndex(true) was called last.
+ */
+bool WordCat::hasFoldedIndex() const {
+    return folded_index_enabled;
+}
+
+/**
+ * @brief Looks up a word ignoring case and accents.
+ * @param word The word to look up.
+ * @return True if some word of the category matches.
+ */
+bool WordCat::lookupFolded(const Word& word) const {
+    if (folded_index_enabled) return folded_index.contains(word); // One probe sequence
+    return !findFolded(word).isEmpty();
+}
+
+/**
+ * @brief Returns the words that match a word when case and accents are ignored.
+ * Without the index every word's search key is built and compared.
+ * @param word The word to look up.
+ * @return A sorted list of the matching words, as stored.
+ */
+WordList WordCat::findFolded(const Word& word) const {
+    if (folded_index_enabled) return folded_index.find(word);
+    WordList matches;
+    Word key = word.searchKey();
+    forEachWord([&](const Word& candidate) {
+        if (candidate.searchKey() == key) matches.push_back(Word(candidate)); // Visited in order, so the list stays sorted
+    });
+    return matches;
+}
+
+/**
+ * @brief Turns hit counting on or off.
+ * @param enabled Whether to count hits.
+ */
+void WordCat::setHitCounting(bool enabled) {
+    hit_counter.clear();
+    hit_counting = enabled;
+    if (enabled) forEachWord([this](const Word& word) { hit_counter.add(word); }); // Parses a lazy category first
+}
+
+/**
+ * @brief Tells whether hits are counted.
+ * @return True if setHitCounting(true) was called last.
+ */
+bool WordCat::hasHitCounting() const {
+    return hit_counting;
+}
+
+/**
+ * @brief Records a use of a word without looking it up.
+ * @param word The word that was used.
+ * @return True if the word is in the category and hits are counted.
+ */
+bool WordCat::touch(const Word& word) const {
+    return hit_counting && hit_counter.touch(word);
+}
+
+/**
+ * @brief Returns the number of hits on a word.
+ * @param word The word.
+ * @return Its lookups and touches since counting started; 0 if it is not in the category or hits are not counted.
+ */
+uint64_t WordCat::hitCount(const Word& word) const {
+    return hit_counting ? hit_counter.hits(word) : 0;
+}
+
+/**
+ * @brief A word and its hits, as ranked by mostUsed and complete.
+ */
+struct RankedWord {
+    uint64_t hits; ///< Times the word was used
+    size_t position; ///< Where the word sorts, to break ties alphabetically
+    Word word; ///< The word
+};
+
+/**
+ * @brief Orders ranked words: more hits first, then sorted order.
+ * Used as the heap order, it puts the lowest ranked of the words kept so far on top.
+ * @param a A ranked word.
+ * @param b Another ranked word.
+ * @return True if a ranks before b.
+ */
+static bool ranksBefore(const RankedWord& a, const RankedWord& b) {
+    return a.hits != b.hits ? a.hits > b.hits : a.position < b.position;
+}
+
+/**
+ * @brief Offers a candidate to a heap holding the best 'limit' words seen so far.
+ * @param best The heap, with room for limit words.
+ * @param kept The number of words in the heap.
+ * @param limit The capacity of the heap, at least 1.
+ * @param candidate The word to offer.
+ * @return The new number of words in the heap.
+ */
+static size_t keepBest(RankedWord* best, size_t kept, size_t limit, RankedWord&& candidate) {
+    if (kept < limit) { // Room left: every word is kept
+        best[kept++] = std::move(candidate);
+        std::push_heap(best, best + kept, ranksBefore);
+    } else if (ranksBefore(candidate, best[0])) { // Better than the worst word kept: replace it
+        std::pop_heap(best, best + kept, ranksBefore);
+        best[kept - 1] = std::move(candidate);
+        std::push_heap(best, best + kept, ranksBefore);
+    }
+    return kept;
+}
+
+/**
+ * @brief Finds the k most used words with one pass over the words and a heap of k of them.
+ * @param k The number of words wanted.
+ * @param words Array of k elements; receives the words, most used first.
+ * @param hits Array of k elements; receives their hits.
+ * @return The number of words written, at most k.
+ */
+size_t WordCat::mostUsed(size_t k, Word* words, uint64_t* hits) const {
+    if (!hit_counting) return 0;
+    k = std::min(k, wordCount()); // No more words can rank
+    if (k == 0) return 0;
+
+    RankedWord* best = new RankedWord[k];
+    size_t kept{ 0 }, position{ 0 };
+    forEachWord([&](const Word& word) {
+        uint64_t count = hit_counter.hits(word);
+        if (count != 0) kept = keepBest(best, kept, k, RankedWord{ count, position, Word(word) }); // Unused words do not rank
+        position++;
+    });
+    std::sort_heap(best, best + kept, ranksBefore); // Best first
+
+    for (size_t i = 0; i < kept; ++i) {
+        words[i] = std::move(best[i].word);
+        hits[i] = best[i].hits;
+    }
+    delete[] best;
+    return kept;
+}
+
+/**
+ * @brief Returns the words that start with a prefix, most used first.
+ * The words with the prefix are contiguous, so they are read page by page from where the prefix would be.
+ * @param prefix The characters the words start with.
+ * @param limit The maximum number of words.
+ * @return The completions, in rank order.
+ */
+WordList WordCat::complete(const Word& prefix, size_t limit) const {
+    static constexpr size_t CHUNK = 256; // Words read at a time
+    WordList completions;
+    limit = std::min(limit, wordCount()); // There are no more words than that, whatever the caller asks for
+    if (limit == 0) return completions;
+
+    RankedWord* best = new RankedWord[limit];
+    size_t kept{ 0 };
+    size_t position = rank(prefix); // The first word not less than the prefix
+    bool done{ false };
+    while (!done) {
+        WordList chunk = page(position, CHUNK);
+        done = chunk.length() < CHUNK; // The last words of the category
+        while (!chunk.isEmpty()) {
+            Word word = chunk.pop_front();
+            if (std::strncmp(word.c_str(), prefix.c_str(), prefix.length()) != 0) { // Past the words with the prefix
+                done = true;
+                break;
+            }
+            kept = keepBest(best, kept, limit, RankedWord{ hitCount(word), position++, std::move(word) });
+        }
+        if (!hit_counting && kept == limit) done = true; // Without hits the first words are the answer
+    }
+    std::sort_heap(best, best + kept, ranksBefore); // Best first
+
+    for (size_t i = 0; i < kept; ++i) completions.push_back(std::move(best[i].word));
+    delete[] best;
+    return completions;
+}
+
+/**
+ * @brief Looks up a batch of words with a single merge pass over the sorted word list.
+ * @param words The words to look up.
+ * @param count The number of words.
+ * @param found Array of count elements; found[i] is set to whether words[i] is in the category.
+ * @param order Optional ascending permutation of the words; computed when nullptr.
+ */
+void WordCat::lookupMany(const Word* words, size_t count, bool* found, const size_t* order) const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::List: wordList.lookupMany(words, count, found, order); break; // The list keeps its words sorted
+        case StorageMode::Arena: arena.lookupMany(words, count, found, order); break; // The entries are sorted
+        case StorageMode::Compressed: compressed.lookupMany(words, count, found); break; // One binary search per word
+        case StorageMode::Persistent: persistent.lookupMany(words, count, found); break; // One descent per word
+    }
+    if (hit_counting) {
+        for (size_t i = 0; i < count; ++i) {
+            if (found[i]) hit_counter.touch(words[i]);
+        }
+    }
+}
+
+/**
+ * @brief Returns a list of words that start with a given letter.
+ * @param firstLetter The first letter of the words to return.
+ * @return The list of words that start with the given letter.
+ */
+WordList WordCat::getWordsStartingWithLetter(const char firstLetter) const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::Arena: return arena.wordsStartingWith(firstLetter);
+        case StorageMode::Compressed: return compressed.wordsStartingWith(firstLetter);
+        case StorageMode::Persistent: return persistent.wordsStartingWith(firstLetter);
+        default: return wordList.wordsStartingWith(firstLetter);
+    }
+}
+
+/**
+ * @brief Returns the words at positions [offset, offset + limit), in sorted order, whatever the storage mode.
+ * @param offset The position of the first word.
+ * @param limit The maximum number of words.
+ * @return The words of the page; empty when offset is past the end.
+ */
+WordList WordCat::page(size_t offset, size_t limit) const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::Arena: return arena.page(offset, limit);
+        case StorageMode::Compressed: return compressed.page(offset, limit);
+        case StorageMode::Persistent: return persistent.page(offset, limit);
+        default: {
+            std::lock_guard<std::mutex> guard(position_lock); // The list may rebuild its position index
+            return wordList.page(offset, limit);
+        }
+    }
+}
+
+/**
+ * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+ * @param from Where to start; it need not be in the category.
+ * @param limit The maximum number of words.
+ * @return The words of the page.
+ */
+WordList WordCat::range(const Word& from, size_t limit) const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::Arena: return arena.range(from, limit);
+        case StorageMode::Compressed: return compressed.range(from, limit);
+        case StorageMode::Persistent: return persistent.range(from, limit);
+        default: {
+            std::lock_guard<std::mutex> guard(position_lock); // The list may rebuild its position index
+            return wordList.range(from, limit);
+        }
+    }
+}
+
+/**
+ * @brief Counts the words less than a given word.
+ * @param word The word to rank; it need not be in the category.
+ * @return The number of words that sort before it.
+ */
+size_t WordCat::rank(const Word& word) const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::Arena: return arena.rank(word);
+        case StorageMode::Compressed: return compressed.rank(word);
+        case StorageMode::Persistent: return persistent.rank(word);
+        default: {
+            std::lock_guard<std::mutex> guard(position_lock); // The list may rebuild its position index
+            return wordList.rank(word);
+        }
+    }
+}
+
+/**
+ * @brief Inserts a word into the word list, keeping it sorted.
+ * If an allocation fails, the category is left as it was: the filter and the indexes take the word first,
+ * and give it back without allocating if the storage cannot take it.
+ * @param word The word to insert.
+ * @return True if the word was inserted, false if the category already has it or it is not valid UTF-8.
+ */
+bool WordCat::insertWord(const Word& word) {
+    if (!word.isValidUtf8()) return false; // Bytes that are not text would break ordering and folding
+    if (contains(word)) return false; // No duplicates; the filter makes this check cheap for new words
+
+    if (!filter_stale) {
+        filter.add(word); // Adding keeps the filter exact, so no rebuild is needed; an extra word would only be a false positive
+        if (filter.isOverfull()) filter_stale = true; // Resize on next use to keep the false-positive rate low
+    }
+    if (folded_index_enabled) folded_index.add(word);
+    try {
+        if (hit_counting) hit_counter.add(word); // A new word starts unused
+        switch (storage_mode) {
+            case StorageMode::List: wordList.insertSorted(word); break; // Insert in order
+            case StorageMode::Arena: arena.insertSorted(word); break; // Append the characters and insert the entry in order
+            case StorageMode::Compressed: compressed.insertSorted(word); break; // Re-encode with the word
+            case StorageMode::Persistent: persistent.insertSorted(word); break; // Copy the shared nodes on its path
+        }
+    } catch (...) { // The storage is unchanged; take the word back out of the indexes
+        if (hit_counting) hit_counter.remove(word);
+        if (folded_index_enabled) folded_index.remove(word);
+        throw;
+    }
+    version = newVersion();
+    return true;
+}
+
+/**
+ * @brief Removes a word from the word list.
+ * Only the storage can fail, and it is changed first, so a failure leaves the category as it was.
+ * @param word The word to remove.
+ * @return True if the word was removed successfully, false otherwise.
+ */
+bool WordCat::removeWord(const Word& word) {
+    ensureLoaded(); // Parse the words on first use
+    bool removed{ false };
+    switch (storage_mode) {
+        case StorageMode::List: removed = wordList.remove(word); break;
+        case StorageMode::Arena: removed = arena.remove(word); break;
+        case StorageMode::Compressed: removed = compressed.remove(word); break;
+        case StorageMode::Persistent: removed = persistent.remove(word); break;
+    }
+    if (!removed) return false; // The word was not there
+
+    filter_stale = true; // Bloom filters cannot forget a word; rebuild on next use
+    if (folded_index_enabled) folded_index.remove(word); // The index can, in place
+    if (hit_counting) hit_counter.remove(word);
+    version = newVersion();
+    return true;
+}
+
+/**
+ * @brief Returns the word list.
+ * @return The word list.
+ * @throws std::runtime_error if the category is not in List mode.
+ */
+const WordList& WordCat::getWordList() const {
+    if (storage_mode != StorageMode::List) throw std::runtime_error("Category is not stored in a word list");
+    ensureLoaded(); // Parse the words on first use
+    return wordList;
+}
+
+/**
+ * @brief Returns how the category stores its words.
+ * @return The storage mode.
+ */
+WordCat::StorageMode WordCat::getStorageMode() const {
+    return storage_mode;
+}
+
+/**
+ * @brief Converts the category's words to the given storage mode.
+ * The membership filter is unaffected, since the set of words does not change.
+ * @param mode The new storage mode.
+ */
+void WordCat::setStorageMode(StorageMode mode) {
+    if (mode == storage_mode) return; // Nothing to convert
+    if (!isLoaded()) { // The words are converted as they are parsed
+        storage_mode = mode;
+        return;
+    }
+
+    WordList words; // The words, unpacked from the current storage
+    switch (storage_mode) {
+        case StorageMode::List: words = std::move(wordList); break; // Already unpacked
+        case StorageMode::Arena: words = arena.toWordList(); arena = WordArena(); break; // Unpack and release the arena
+        case StorageMode::Compressed: words = compressed.toWordList(); compressed.clear(); break; // Decode and release the blocks
+        case StorageMode::Persistent: words = persistent.toWordList(); persistent.clear(); break; // Release this category's share of the tree
+    }
+
+    switch (mode) {
+        case StorageMode::List: wordList = std::move(words); break;
+        case StorageMode::Arena: arena.assign(words); break; // Pack the words into one arena
+        case StorageMode::Compressed: compressed.assign(words); break; // Front-code the words
+        case StorageMode::Persistent: persistent.assign(words); break; // Build a balanced tree
+    }
+    storage_mode = mode;
+}
+
+/**
+ * @brief Returns the number of words in the category.
+ * @return The number of words.
+ */
+size_t WordCat::wordCount() const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::Arena: return arena.length();
+        case StorageMode::Compressed: return compressed.length();
+        case StorageMode::Persistent: return persistent.length();
+        default: return wordList.length();
+    }
+}
+
+/**
+ * @brief Prints the words of the category with a maximum of n words per line, whatever the storage mode.
+ * @param sout The output stream to print to.
+ * @param n The maximum number of words per line.
+ * @return The number of words printed.
+ */
+int WordCat::printWords(std::ostream& sout, const int n) const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::Arena: return arena.print(sout, n);
+        case StorageMode::Compressed: return compressed.print(sout, n);
+        case StorageMode::Persistent: return persistent.print(sout, n);
+        default: return wordList.print(sout, n);
+    }
+}
+
+/**
+ * @brief Overloads the << operator to print a WordCat object: its name, then its words.
+ * @param sout The output stream to print to.
+ * @param wc The WordCat object to print.
+ * @return The output stream.
+ */
+std::ostream& operator<<(std::ostream& sout, const WordCat& wc) {
+    sout << wc.category << "\n"; // The category name
+    wc.printWords(sout, WordFormatter::FIT_TERMINAL); // Its words, as many per line as the terminal fits
+    return sout;
+}
+
+/**
+ * @brief Returns the memory used to store the words, in whichever storage mode.
+ * @return The size in bytes.
+ */
+size_t WordCat::storageMemoryBytes() const {
+    if (!isLoaded()) return 0; // The words are still in the file
+    switch (storage_mode) {
+        case StorageMode::Arena: return arena.memoryBytes();
+        case StorageMode::Compressed: return compressed.memoryBytes();
+        case StorageMode::Persistent: return persistent.memoryBytes(); // Including nodes shared with copies
+        default: return wordList.memoryBytes();
+    }
+}
+
+/**
+ * @brief Writes the name and the front-coded words in binary form.
+ * A category that is not in Compressed mode is front-coded for the occasion.
+ * @param out The binary output stream to write to.
+ */
+void WordCat::writeCompressed(std::ostream& out) const {
+    uint64_t name_length = category.length();
+    out.write(reinterpret_cast<const char*>(&name_length), sizeof name_length);
+    out.write(category.c_str(), static_cast<std::streamsize>(name_length));
+
+    ensureLoaded(); // Parse the words on first use
+    if (storage_mode == StorageMode::Compressed) {
+        compressed.write(out); // Already encoded
+        return;
+    }
+    WordList words; // The words in order, to encode them
+    forEachWord([&words](const Word& word) { words.push_back(word); });
+    FrontCodedList encoded;
+    encoded.assign(words);
+    encoded.write(out);
+}
+
+/**
+ * @brief Returns the memory used by the membership filter.
+ * @return The size of the filter's bit array in bytes.
+ */
+size_t WordCat::filterMemoryBytes() const {
+    if (!isLoaded()) return 0; // No filter until the words are parsed
+    refreshFilter(); // Report the size the filter has when current
+    return filter.memoryBytes();
+}
+
+/**
+ * @brief Prints one line of statistics: word count, filter size, and estimated and observed filter false-positive rates.
+ * @param sout The output stream to print to.
+ */
+void WordCat::printStats(std::ostream& sout) const {
+    if (!isLoaded()) { // Reporting must not parse the words
+        sout << std::left << std::setw(20) << category << std::right << std::setw(10) << "-" << "  (not loaded)\n";
+        return;
+    }
+    refreshFilter(); // Bring a stale filter up to date so its figures are meaningful
+
+    size_t rejections = filter_rejections.load(std::memory_order_relaxed); // Misses caught by the filter
+    size_t false_positives = filter_false_positives.load(std::memory_order_relaxed); // Misses the filter let through
+    size_t misses = rejections + false_positives; // Every lookup of an absent word
+
+    sout << std::left << std::setw(20) << category << std::right
+         << std::setw(10) << wordCount()
+         << std::setw(13) << storageMemoryBytes()
+         << std::setw(12) << filter.memoryBytes()
+         << std::setw(11) << std::fixed << std::setprecision(3) << filter.estimatedFalsePositiveRate() * 100 << "%";
+    if (misses != 0) {
+        sout << std::setw(11) << static_cast<double>(false_positives) * 100 / static_cast<double>(misses) << "%";
+    } else {
+        sout << std::setw(12) << "-";
+    }
+    sout << std::defaultfloat << "\n";
+}
+
+/**
+ * @brief Calls a function on every word of the category, in sorted order, whatever the storage mode.
+ * @param visit The function to call with each word.
+ */
+void WordCat::forEachWord(const std::function<void(const Word&)>& visit) const {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::List: wordList.forEach(visit); break;
+        case StorageMode::Arena: arena.forEach(visit); break;
+        case StorageMode::Compressed: compressed.forEach(visit); break;
+        case StorageMode::Persistent: persistent.forEach(visit); break;
+    }
+}
+
+/**
+ * @brief Calls a function on every stored word, so that it can share the word's buffer with an equal word.
+ * The characters stay the same, so the version, the filter and the position index remain valid.
+ * @param visit The function to call with each word.
+ * @return False if the storage mode has no Word objects to visit.
+ */
+bool WordCat::forEachStored(const std::function<void(Word&)>& visit) {
+    ensureLoaded(); // Parse the words on first use
+    switch (storage_mode) {
+        case StorageMode::List: wordList.forEachStored(visit); return true;
+        case StorageMode::Persistent: persistent.forEachStored(visit); return true;
+        default: return false; // Arena and Compressed have no separate words
+    }
+}
+
+/**
+ * @brief Parses a lazily loaded category, then takes the locks that copies and lazy rebuilds read its words under.
+ * They are taken in the order the copy assignment takes them. Once the words are parsed, forEachStored no
+ * longer needs the load lock.
+ * @return The locks, released when destroyed.
+ */
+WordCat::ReaderLocks WordCat::lockReaders() const {
+    ensureLoaded(); // Parse first, so that nothing needs the load lock afterwards
+    ReaderLocks locks;
+    locks.load = std::unique_lock<std::mutex>(load_lock); // A copy may be reading the words right now
+    locks.filter = std::unique_lock<std::mutex>(filter_lock); // A reader may be rebuilding the filter from them
+    locks.position = std::unique_lock<std::mutex>(position_lock); // A reader may be paging through them
+    return locks;
+}
+
+/**
+ * @brief Makes the category hold exactly the given words, changing only what differs.
+ * @param words The new words, in any order and possibly with duplicates.
+ * @param count The number of words.
+ * @param order Ascending permutation of the words.
+ * @param added Receives the number of words inserted.
+ * @param removed Receives the number of words removed.
+ */
+void WordCat::syncWords(const Word* words, size_t count, const size_t* order, size_t& added, size_t& removed) {
+    if (!isLoaded()) { // The bytes the category would parse are out of date
+        source = FileRange();
+        loaded = true;
+        version = newVersion(); // The category is now empty
+    }
+
+    WordList to_add; // New words missing from the category, in sorted order
+    WordList to_remove; // Current words missing from the new words, in sorted order
+    size_t k = 0; // Next new word, in sorted order
+    const Word* previous = nullptr; // Last new word consumed, to skip duplicates
+
+    auto addUpTo = [&](const Word* bound) { // Queue every new word less than bound (all of them if nullptr)
+        while (k < count && (bound == nullptr || words[order[k]].isLess(*bound))) {
+            const Word& word = words[order[k++]];
+            if ((previous == nullptr || !(*previous == word)) && word.isValidUtf8()) to_add.push_back(word); // As insertWord would
+            previous = &word;
+        }
+    };
+
+    forEachWord([&](const Word& current) { // Merge against the current words
+        addUpTo(&current); // New words before the current one are additions
+        if (k < count && words[order[k]] == current) { // The current word stays
+            previous = &words[order[k]];
+            while (k < count && words[order[k]] == current) ++k; // Skip its duplicates
+        } else {
+            to_remove.push_back(current); // The current word is gone
+        }
+    });
+    addUpTo(nullptr); // New words after the last current one
+
+    added = to_add.length();
+    removed = to_remove.length();
+    if (added + removed == 0) return; // Unchanged
+
+    if ((added + removed) * 8 <= wordCount()) { // Small delta: update the storage and filter in place, one word at a time
+        // Each step leaves the category consistent if it fails, with the words changed so far changed
+        to_remove.forEach([this](const Word& word) { removeWord(word); });
+        to_add.forEach([this](const Word& word) { insertWord(word); });
+        return;
+    }
+
+    WordList merged; // Large delta: one more merge builds the new words in order
+    forEachWord([&](const Word& current) {
+        while (!to_add.isEmpty() && to_add.front().isLess(current)) merged.push_back(to_add.pop_front());
+        if (!to_remove.isEmpty() && to_remove.front() == current) {
+            to_remove.pop_front(); // Leave the removed word out
+        } else {
+            merged.push_back(current);
+        }
+    });
+    while (!to_add.isEmpty()) merged.push_back(to_add.pop_front());
+
+    // Build the new indexes before the storage changes, so that a failure leaves the category as it was
+    FoldedIndex index; // The index has no stale flag, so it is rebuilt now
+    if (folded_index_enabled) merged.forEach([&index](const Word& word) { index.add(word); });
+    HitCounter counts; // Carry over the hits of the words that stay
+    if (hit_counting) merged.forEach([&](const Word& word) { counts.add(word, hit_counter.hits(word)); });
+
+    switch (storage_mode) {
+        case StorageMode::List: wordList = std::move(merged); break;
+        case StorageMode::Arena: arena.assign(merged); break; // Repack the arena once
+        case StorageMode::Compressed: compressed.assign(merged); break; // Re-encode once
+        case StorageMode::Persistent: persistent.assign(merged); break; // Rebuild the tree once
+    }
+    filter_stale = true; // Rebuild the filter on next use
+    folded_index = std::move(index);
+    hit_counter = std::move(counts);
+    version = newVersion();
+}
+
+/**
+ * @brief Builds a copy of the category with some words inserted and others removed, in one merge pass.
+ * @param inserts The words to insert, in ascending order and without duplicates.
+ * @param insert_count The number of words to insert.
+ * @param removes The words to remove, in ascending order and without duplicates.
+ * @param remove_count The number of words to remove.
+ * @param added Receives the number of words actually inserted.
+ * @param removed Receives the number of words actually removed.
+ * @return The changed copy.
+ */
+WordCat WordCat::withChanges(const Word* inserts, size_t insert_count, const Word* removes, size_t remove_count,
+                             size_t& added, size_t& removed) const {
+    if (storage_mode == StorageMode::Persistent && (insert_count + remove_count) * 8 <= wordCount()) {
+        WordCat changed(*this); // Shares the tree, so a small delta copies only the paths it changes
+        added = removed = 0;
+        for (size_t i = 0; i < insert_count; ++i) added += changed.insertWord(inserts[i]);
+        for (size_t i = 0; i < remove_count; ++i) removed += changed.removeWord(removes[i]);
+        return changed;
+    }
+
+    WordList merged; // The words of the copy, built in order
+    size_t i = 0; // Next word to insert
+    size_t j = 0; // Next word to remove
+    added = removed = 0;
+
+    auto insertUpTo = [&](const Word* bound) { // Insert every new word less than bound (all of them if nullptr)
+        while (i < insert_count && (bound == nullptr || inserts[i].isLess(*bound))) {
+            if (inserts[i].isValidUtf8()) { // As insertWord would
+                merged.push_back(inserts[i]);
+                added++;
+            }
+            i++;
+        }
+    };
+
+    forEachWord([&](const Word& current) { // Parses a lazy category first
+        insertUpTo(&current);
+        if (i < insert_count && inserts[i] == current) i++; // Already present
+        while (j < remove_count && removes[j].isLess(current)) j++; // Not present
+        if (j < remove_count && removes[j] == current) { // Leave the removed word out
+            j++;
+            removed++;
+        } else {
+            merged.push_back(current);
+        }
+    });
+    insertUpTo(nullptr); // New words after the last current one
+
+    WordCat changed(category, std::move(merged));
+    changed.setStorageMode(storage_mode); // Pack the words as this category does
+    if (folded_index_enabled) changed.setFoldedIndex(true);
+    if (hit_counting) { // Carry over the hits of the words that stay
+        changed.hit_counting = true;
+        changed.forEachWord([&](const Word& word) { changed.hit_counter.add(word, hit_counter.hits(word)); });
+    }
+    return changed;
+}
+
+/**
+ * @brief Checks whether the words of the category are in memory.
+ * @return False for a lazily loaded category that has not been used yet, true otherwise.
+ */
+bool WordCat::isLoaded() const {
+    return loaded.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Checks for ASCII whitespace. Unlike isspace, never matches a byte of a UTF-8 sequence,
+ * whatever the locale.
+ * @param c The character to check.
+ * @return True for space, tab, newline, vertical tab, form feed and carriage return.
+ */
+static bool isAsciiSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * @brief Trims leading and trailing spaces from a string in place.
+ * 
+ * This function modifies the input string by removing leading and trailing
+ * ASCII whitespace, so multibyte UTF-8 characters are never cut. It also shifts
+ * the trimmed content to the start of the original string buffer if necessary.
+ * 
+ * @param str The input string to be trimmed.
+ */
+void trim(char* str) {
+    char* start = str; // Pointer to the start of the string
+    char* end = str + strlen(str) - 1; // Pointer to the end of the string
+
+    // Trim leading spaces
+    while (isAsciiSpace(*start)) start++; // Move start pointer past any leading spaces
+
+    // Trim trailing spaces
+    while (end > start && isAsciiSpace(*end)) end--; // Move end pointer before any trailing spaces
+
+    // Null terminate after the last non-space character
+    *(end + 1) = '\0'; // Place the null terminator right after the last non-space character
+
+    // Move the adjusted string to the start if necessary
+    if (start > str) { // If the start pointer moved past the beginning of the original string
+        memmove(str, start, end - start + 2); // Shift the trimmed string to the beginning (including null terminator)
+    }
+}
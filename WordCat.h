@@ -4,16 +4,106 @@
 
 #include "Word.h"
 #include "WordList.h"
+#include "BloomFilter.h"
+#include "WordArena.h"
+#include "FrontCodedList.h"
+#include "FoldedIndex.h"
+#include "HitCounter.h"
+#include "PersistentWordList.h"
+#include <atomic>
+#include <functional>
+#include <ios>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
 
 /**
  * @class WordCat
  * @brief A class to represent a word category.
  */
 class WordCat {
+public:
+    /**
+     * @brief How a category stores its words. Every mode answers the same queries.
+     */
+    enum class StorageMode {
+        List, ///< A sorted doubly linked list of Words (the default)
+        Arena, ///< One contiguous character arena with a sorted (offset, length, hash) entry array
+        Compressed, ///< Front-coded blocks searched in place; smallest, but every mutation re-encodes the words
+        Persistent ///< A balanced tree shared between copies; copying the words is O(1), changes are O(log N)
+    };
+
+    /**
+     * @brief The bytes of a file that hold the words of a category not parsed yet (see WordCatVec::loadFromFile).
+     */
+    struct FileRange {
+        std::shared_ptr<const std::string> path; ///< The file, shared by every category opened from it; null when there is nothing to load
+        std::streamoff offset{ 0 }; ///< Position of the first line after the category's header
+        std::streamoff length{ 0 }; ///< Number of bytes up to the next header or the end of the file
+    };
+
 private:
     Word category; ///< The name of the category
-    WordList wordList; ///< The list of words in the category
+    WordList wordList; ///< The list of words in the category (List mode)
+    WordArena arena; ///< The words of the category (Arena mode)
+    FrontCodedList compressed; ///< The words of the category (Compressed mode)
+    PersistentWordList persistent; ///< The words of the category (Persistent mode)
+    StorageMode storage_mode; ///< Which of wordList, arena, compressed and persistent holds the words
+
+    mutable BloomFilter filter; ///< Approximate membership filter over wordList, consulted before scanning the list
+    mutable std::atomic<bool> filter_stale; ///< True when filter must be rebuilt from wordList before its next use
+    mutable std::mutex filter_lock; ///< Serializes lazy rebuilds of filter by concurrent readers
+    mutable std::atomic<size_t> filter_rejections; ///< Lookups answered by the filter alone
+    mutable std::atomic<size_t> filter_false_positives; ///< Lookups the filter passed but the list did not have
+
+    FoldedIndex folded_index; ///< The words by search key, for lookups that ignore case and accents
+    bool folded_index_enabled; ///< True when folded_index is kept up to date
+
+    HitCounter hit_counter; ///< How often each word was looked up or touched
+    bool hit_counting; ///< True when hit_counter is kept up to date
+
+    uint64_t version; ///< Stamp replaced whenever the words change; equal stamps mean equal words
+
+    FileRange source; ///< Where the words of a lazily loaded category still are; cleared once they are parsed
+    mutable std::atomic<bool> loaded; ///< False until the words in 'source' have been parsed
+    mutable std::mutex load_lock; ///< Serializes the first parse by concurrent readers
+    mutable std::mutex position_lock; ///< Serializes lazy rebuilds of wordList's position index by concurrent readers
+
+    /**
+     * @brief Returns a version stamp that no category has had before.
+     * @return The stamp, unique within the process
+     */
+    static uint64_t newVersion();
+
+    /**
+     * @brief Parses the words of a lazily loaded category on first use. Safe to call from concurrent readers.
+     */
+    void ensureLoaded() const;
+
+    /**
+     * @brief Reads the bytes in 'source' and inserts their words, one per line, as WordCatVec::loadFromFile does.
+     */
+    void loadWords();
+
+    /**
+     * @brief Rebuilds the membership filter if a mutation made it stale. Safe to call from concurrent readers.
+     */
+    void refreshFilter() const;
+
+    /**
+     * @brief Consults the membership filter, rebuilding it first if a mutation made it stale.
+     * @param word The word to test
+     * @return false if the word is definitely not in the list, true if it may be
+     */
+    bool filterMightContain(const Word& word) const;
+
+    /**
+     * @brief Looks up a word without counting a hit: the filter first, then the storage.
+     * @param word The word to look up
+     * @return True if the word is in the category
+     */
+    bool contains(const Word& word) const;
 
     /**
      * @brief Displays a menu to the user and returns the user's choice.
@@ -39,6 +129,27 @@ public:
      */
     WordCat(const Word& category);
 
+    /**
+     * @brief Constructor. Initializes category to the input Word and takes ownership of an already sorted word list.
+     * @param category The category name
+     * @param sortedWords The words of the category, in sorted order and without duplicates
+     */
+    WordCat(const Word& category, WordList&& sortedWords);
+
+    /**
+     * @brief Constructor. Initializes category to the input Word and takes ownership of front-coded words (Compressed mode).
+     * @param category The category name
+     * @param words The words of the category
+     */
+    WordCat(const Word& category, FrontCodedList&& words);
+
+    /**
+     * @brief Constructor for a lazily loaded category. Its words are parsed from the file the first time they are needed.
+     * @param category The category name
+     * @param source The bytes of the file that hold the words
+     */
+    WordCat(const Word& category, const FileRange& source);
+
     /**
      * @brief Destructor. Deallocates any memory that was previously reserved by the WordCat object.
      */
@@ -78,9 +189,18 @@ public:
 
     /**
      * @brief Returns the name of the category.
-     * @return The category name.
+     * @return A reference to the category name.
      */
-    Word getCategoryName() const;
+    const Word& getCategoryName() const;
+
+    /**
+     * @brief Returns the version stamp of the category's words. Every successful insertWord, removeWord,
+     * emptyCategory or sync replaces it with a stamp never used before, and a copy shares the stamp
+     * of the category it was copied from. Results computed from a category therefore stay valid exactly as
+     * long as its stamp is unchanged.
+     * @return The stamp
+     */
+    uint64_t getVersion() const;
 
     /**
      * @brief Modifies the name of the category.
@@ -94,12 +214,95 @@ public:
     void emptyCategory();
 
     /**
-     * @brief Looks up a word in the word list.
+     * @brief Looks up a word in the word list. A word that is found gets a hit when hit counting is on.
      * @param newWord The word to look up.
      * @return True if the word exists in the list, false otherwise.
      */
     bool lookupWordInList(const Word& newWord) const;
 
+    /**
+     * @brief Turns the index of words by search key on or off. Turning it on parses a lazily loaded
+     * category and indexes every word; from then on insertWord and removeWord keep it up to date.
+     * @param enabled Whether to keep the index
+     */
+    void setFoldedIndex(bool enabled);
+
+    /**
+     * @brief Tells whether the index of words by search key is kept.
+     * @return True if setFoldedIndex(true) was called last
+     */
+    bool hasFoldedIndex() const;
+
+    /**
+     * @brief Looks up a word ignoring case and accents: "apple", "Apple" and "APPLE" all find "Apple".
+     * One hash probe with the index; a scan of every word without it.
+     * @param word The word to look up
+     * @return True if some word of the category matches
+     */
+    bool lookupFolded(const Word& word) const;
+
+    /**
+     * @brief Returns the words that match a word when case and accents are ignored.
+     * @param word The word to look up
+     * @return A sorted list of the matching words, as stored
+     */
+    WordList findFolded(const Word& word) const;
+
+    /**
+     * @brief Turns hit counting on or off. Turning it on parses a lazily loaded category and starts every
+     * word at zero hits; turning it off forgets the counts. From then on insertWord and removeWord keep
+     * the counters in step with the words.
+     * @param enabled Whether to count hits
+     */
+    void setHitCounting(bool enabled);
+
+    /**
+     * @brief Tells whether hits are counted.
+     * @return True if setHitCounting(true) was called last
+     */
+    bool hasHitCounting() const;
+
+    /**
+     * @brief Records a use of a word without looking it up. Safe to call from concurrent readers.
+     * @param word The word that was used
+     * @return True if the word is in the category and hits are counted
+     */
+    bool touch(const Word& word) const;
+
+    /**
+     * @brief Returns the number of hits on a word.
+     * @param word The word
+     * @return Its lookups and touches since counting started; 0 if it is not in the category or hits are not counted
+     */
+    uint64_t hitCount(const Word& word) const;
+
+    /**
+     * @brief Finds the k most used words. Words that were never used are left out.
+     * @param k The number of words wanted
+     * @param words Array of k elements; receives the words, most used first (ties in sorted order)
+     * @param hits Array of k elements; receives their hits
+     * @return The number of words written, at most k
+     */
+    size_t mostUsed(size_t k, Word* words, uint64_t* hits) const;
+
+    /**
+     * @brief Returns the words that start with a prefix, most used first and ties in sorted order.
+     * Without hit counting these are simply the first words with the prefix.
+     * @param prefix The characters the words start with
+     * @param limit The maximum number of words
+     * @return The completions, in rank order
+     */
+    WordList complete(const Word& prefix, size_t limit) const;
+
+    /**
+     * @brief Looks up a batch of words with a single merge pass over the sorted word list.
+     * @param words The words to look up
+     * @param count The number of words
+     * @param found Array of count elements; found[i] is set to whether words[i] is in the category
+     * @param order Optional ascending permutation of the words (see WordList::sortedOrder); computed when nullptr
+     */
+    void lookupMany(const Word* words, size_t count, bool* found, const size_t* order = nullptr) const;
+
     /**
      * @brief Returns a list of words that start with a given letter.
      * @param firstLetter The first letter of the words to return.
@@ -108,13 +311,40 @@ public:
     WordList getWordsStartingWithLetter(const char firstLetter) const;
 
     /**
-     * @brief Inserts a word into the word list.
+     * @brief Returns the words at positions [offset, offset + limit), in sorted order, whatever the storage mode.
+     * Reaching the offset costs O(log n) or a short bounded walk, so listing a page costs about the page size.
+     * @param offset The position of the first word
+     * @param limit The maximum number of words
+     * @return The words of the page; empty when offset is past the end
+     */
+    WordList page(size_t offset, size_t limit) const;
+
+    /**
+     * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+     * A cursor that stays valid across insertions and removals: to resume, ask for one word more than
+     * needed and pass the extra word as the next 'from'.
+     * @param from Where to start; it need not be in the category
+     * @param limit The maximum number of words
+     * @return The words of the page
+     */
+    WordList range(const Word& from, size_t limit) const;
+
+    /**
+     * @brief Counts the words less than a given word. For a word in the category, this is its position.
+     * @param word The word to rank; it need not be in the category
+     * @return The number of words that sort before it, which is the offset of its page
+     */
+    size_t rank(const Word& word) const;
+
+    /**
+     * @brief Inserts a word into the word list. If an allocation fails, the category is unchanged.
      * @param word The word to insert.
+     * @return True if the word was inserted, false if the category already has it or it is not valid UTF-8.
      */
     bool insertWord(const Word& word);
 
     /**
-     * @brief Removes a word from the word list.
+     * @brief Removes a word from the word list. If an allocation fails, the category is unchanged.
      * @param word The word to remove.
      * @return True if the word was removed successfully, false otherwise.
      */
@@ -156,10 +386,138 @@ public:
     /**
      * @brief Returns the word list.
      * @return The word list.
+     * @throws std::runtime_error if the category is not in List mode.
      */
     const WordList& getWordList() const;
+
+    /**
+     * @brief Returns how the category stores its words.
+     * @return The storage mode
+     */
+    StorageMode getStorageMode() const;
+
+    /**
+     * @brief Converts the category's words to the given storage mode.
+     * @param mode The new storage mode
+     */
+    void setStorageMode(StorageMode mode);
+
+    /**
+     * @brief Returns the number of words in the category.
+     * @return The number of words
+     */
+    size_t wordCount() const;
+
+    /**
+     * @brief Prints the words of the category with a maximum of n words per line, whatever the storage mode.
+     * @param sout The output stream to print to
+     * @param n The maximum number of words per line, or WordFormatter::FIT_TERMINAL to fit the terminal width
+     * @return The number of words printed
+     */
+    int printWords(std::ostream& sout, const int n = 5) const;
+
+    /**
+     * @brief Returns the memory used to store the words, in whichever storage mode.
+     * @return The size in bytes
+     */
+    size_t storageMemoryBytes() const;
+
+    /**
+     * @brief Writes the name and the front-coded words in binary form (see WordCatVec::saveCompressed).
+     * @param out The binary output stream to write to
+     */
+    void writeCompressed(std::ostream& out) const;
+
+    /**
+     * @brief Returns the memory used by the membership filter.
+     * @return The size of the filter's bit array in bytes
+     */
+    size_t filterMemoryBytes() const;
+
+    /**
+     * @brief Prints one line of statistics: word count, storage size, filter size, and estimated and observed filter false-positive rates.
+     * @param sout The output stream to print to
+     */
+    void printStats(std::ostream& sout) const;
+
+    /**
+     * @brief Calls a function on every word of the category, in sorted order, whatever the storage mode.
+     * @param visit The function to call with each word
+     */
+    void forEachWord(const std::function<void(const Word&)>& visit) const;
+
+    /**
+     * @brief Calls a function on every stored word, so that it can share the word's buffer with an equal word
+     * (see Word::shareBuffer). Only List and Persistent storage keep one Word per word; Arena and Compressed
+     * storage already pack the words of the category into shared blocks.
+     * @param visit The function to call with each word; it must not change the characters
+     * @return false if the storage mode has no Word objects to visit
+     */
+    bool forEachStored(const std::function<void(Word&)>& visit);
+
+    /**
+     * @brief The locks under which copies and lazy rebuilds read the words of a category (see lockReaders).
+     */
+    struct ReaderLocks {
+        std::unique_lock<std::mutex> load; ///< Held by copies and by the first parse
+        std::unique_lock<std::mutex> filter; ///< Held by copies of the filter and by its lazy rebuilds
+        std::unique_lock<std::mutex> position; ///< Held by paging and ranking in List storage
+    };
+
+    /**
+     * @brief Parses a lazily loaded category, then takes the locks that copies and lazy rebuilds read its words
+     * under, so that a mutation that keeps the characters (see forEachStored) can free buffers they would read.
+     * Lookups take no lock, so they must still not run meanwhile.
+     * @return The locks, released when destroyed
+     */
+    ReaderLocks lockReaders() const;
+
+    /**
+     * @brief Makes the category hold exactly the given words, changing only what differs.
+     * One merge pass against the current sorted words finds the additions and removals. Small deltas are
+     * applied with insertWord and removeWord, so the storage and the filter are updated in place; a delta
+     * larger than an eighth of the category rebuilds the storage from the merge instead.
+     * An unparsed lazily loaded category is treated as empty, since its file range is out of date.
+     * If an allocation fails, a rebuild leaves the category as it was; a small delta keeps the words changed
+     * before the failure, each with its filter, indexes and version up to date.
+     * @param words The new words, in any order and possibly with duplicates
+     * @param count The number of words
+     * @param order Ascending permutation of the words (see WordList::sortedOrder)
+     * @param added Receives the number of words inserted
+     * @param removed Receives the number of words removed
+     */
+    void syncWords(const Word* words, size_t count, const size_t* order, size_t& added, size_t& removed);
+
+    /**
+     * @brief Builds a copy of the category with some words inserted and others removed, in one merge pass.
+     * In Persistent mode a delta of at most an eighth of the words is applied to an O(1) copy instead.
+     * The copy keeps the name, storage mode, search-key index and hit counts (for the words that stay) of
+     * this category, and gets a new version stamp; this category is left unchanged. Words to insert that
+     * are already present, invalid UTF-8 (see insertWord) or absent words to remove are ignored.
+     * @param inserts The words to insert, in ascending order and without duplicates
+     * @param insert_count The number of words to insert
+     * @param removes The words to remove, in ascending order, without duplicates and none of them in inserts
+     * @param remove_count The number of words to remove
+     * @param added Receives the number of words actually inserted
+     * @param removed Receives the number of words actually removed
+     * @return The changed copy
+     */
+    WordCat withChanges(const Word* inserts, size_t insert_count, const Word* removes, size_t remove_count,
+                        size_t& added, size_t& removed) const;
+
+    /**
+     * @brief Checks whether the words of the category are in memory.
+     * @return false for a lazily loaded category that has not been used yet, true otherwise
+     */
+    bool isLoaded() const;
 };
 
+/**
+ * @brief Removes leading and trailing whitespace from a C-string, in place.
+ * @param str The string to trim.
+ */
+void trim(char* str);
+
 /**
  * @brief Helper function to check if a character indicates 'yes'.
  * 
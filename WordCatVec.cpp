@@ -1,37 +1,94 @@
 // WordCatVec.cpp
 #include "WordCatVec.h"
+#include "ThreadPool.h"
+#include "LineReader.h"
+#include "WordFormatter.h"
+#include "MinHash.h"
+#include <algorithm> // For std::partial_sort and std::stable_sort
 #include <iostream>
 #include <fstream> // To handle files
+#include <iomanip> // For std::setw
+#include <cstdint>
 #include <cstring> 
+#include <cstdlib> // For std::strtoul
+#include <memory> // For std::make_shared
+#include <string>
+#include <limits> // For std::numeric_limits
+#include <new> // For placement new
+#include <unordered_map> // For compactDuplicates
+#include <utility> // For std::move
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h> // For open
+#include <unistd.h> // For write, fsync and close
+#endif
 
 /**
  * @brief Default constructor. Initializes the WordCatVec with a capacity of 1 and size 0.
  */
-WordCatVec::WordCatVec() : word_category_array{ new WordCat[1] }, capacity{ 1 }, size{ 0 } {}
+WordCatVec::WordCatVec() : WordCatVec(Allocator::heap()) {}
 
 /**
- * @brief Destructor. Deallocates the memory used by the word_category_array.
+ * @brief Constructor. Initializes an empty WordCatVec whose memory comes from the given allocator, within a budget.
+ * @param allocator Where the memory comes from.
+ * @param budget The most bytes the vocabulary may hold.
+ */
+WordCatVec::WordCatVec(Allocator& allocator, size_t budget) :
+    account{ new MemoryAccount(allocator, budget) },
+    word_category_array{ nullptr },
+    capacity{ 0 },
+    size{ 0 },
+    name_index{ nullptr },
+    index_capacity{ 0 },
+    query_cache{},
+    history{} {
+    try {
+        word_category_array = allocateStorage(1);
+        capacity = 1;
+        rebuildIndex(); // Start with an empty name index
+    } catch (...) { // Even an empty vocabulary does not fit in the budget
+        releaseStorage(word_category_array, 0, capacity);
+        account->release();
+        throw;
+    }
+}
+
+/**
+ * @brief Destructor. Destroys the categories and deallocates the memory used by the word_category_array.
  */
 WordCatVec::~WordCatVec() {
-    delete[] word_category_array; // Deletes the array to free memory
+    releaseStorage(word_category_array, size, capacity); // Destroys the categories and frees the storage
+    releaseIndex(name_index, index_capacity); // Frees the name index
     capacity = 0; // Resets capacity to 0
     size = 0; // Resets size to 0
+    if (account) account->release(); // Deleted once categories moved out of this object are gone too
 }
 
 /**
  * @brief Copy constructor. Initializes a new WordCatVec object as a copy of an existing one.
  * @param other The WordCatVec to copy from.
  */
-WordCatVec::WordCatVec(const WordCatVec& other) : 
-    word_category_array{ new WordCat[other.capacity] }, 
-    capacity{ other.capacity }, 
-    size{ other.size } {
-    for (size_t i = 0; i < other.size; ++i) { // Iterates over each element
-        if (i < other.capacity) { // Checks if the index is within the capacity
-            word_category_array[i] = other.word_category_array[i]; // Copies the element
-        } else {
-            throw std::runtime_error("Size exceeds capacity in copy constructor"); // Throws an error if size exceeds capacity
+WordCatVec::WordCatVec(const WordCatVec& other) :
+    account{ new MemoryAccount(other.memory().getAllocator(), other.memory().getBudget()) }, // Same allocator and budget, own totals
+    word_category_array{ nullptr },
+    capacity{ 0 },
+    size{ 0 },
+    name_index{ nullptr },
+    index_capacity{ 0 },
+    query_cache{}, // Cached results are not copied; the copy builds its own
+    history{} { // The copy starts with no edits to undo
+    try {
+        MemoryAccount::Scope scope(*account); // The copied words are charged to the copy
+        word_category_array = allocateStorage(other.capacity);
+        capacity = other.capacity;
+        for (; size < other.size; ++size) { // Iterates over each element
+            new (&word_category_array[size]) WordCat(other.word_category_array[size]); // Copy-constructs the element in place
         }
+        rebuildIndex(); // Indexes the copied categories
+    } catch (...) {
+        releaseStorage(word_category_array, size, capacity); // Destroys the elements copied so far
+        account->release();
+        throw; // Rethrows the error
     }
 }
 
@@ -42,20 +99,8 @@ WordCatVec::WordCatVec(const WordCatVec& other) :
  */
 WordCatVec& WordCatVec::operator=(const WordCatVec& other) {
     if (this != &other) { // Checks for self-assignment
-        delete[] word_category_array; // Deletes the old array
-        capacity = 0; // Resets capacity
-        size = 0; // Resets size
-
-        word_category_array = new WordCat[other.capacity]; // Allocates memory for the new array
-        capacity = other.capacity; // Sets the new capacity
-        size = other.size; // Sets the new size
-        for (size_t i = 0; i < other.size; ++i) { // Copies the elements
-            if (i < other.capacity) {
-                word_category_array[i] = other.word_category_array[i];
-            } else {
-                throw std::runtime_error("Size exceeds capacity in copy assignment operator"); // Throws an error if size exceeds capacity
-            }
-        }
+        WordCatVec copy(other); // Copies first so that this object is unchanged if copying fails
+        *this = std::move(copy); // Takes ownership of the copy
     }
     return *this; // Returns a reference to the current object
 }
@@ -64,10 +109,21 @@ WordCatVec& WordCatVec::operator=(const WordCatVec& other) {
  * @brief Move constructor. Initializes a new WordCatVec object by taking ownership of the data in an existing one.
  * @param other The WordCatVec to move from.
  */
-WordCatVec::WordCatVec(WordCatVec&& other) noexcept : word_category_array(other.word_category_array), capacity(other.capacity), size(other.size) {
+WordCatVec::WordCatVec(WordCatVec&& other) noexcept :
+    account(other.account),
+    word_category_array(other.word_category_array),
+    capacity(other.capacity),
+    size(other.size),
+    name_index(other.name_index),
+    index_capacity(other.index_capacity),
+    query_cache{}, // Cached results stay with the other object, whose categories they no longer describe
+    history(std::move(other.history)) {
+    other.account = nullptr; // The other object gets a new account if it is used again
     other.word_category_array = nullptr; // Sets the other's array pointer to null
     other.capacity = 0; // Resets the other's capacity
     other.size = 0; // Resets the other's size
+    other.name_index = nullptr; // Sets the other's index pointer to null
+    other.index_capacity = 0; // Resets the other's index capacity
 }
 
 /**
@@ -77,21 +133,179 @@ WordCatVec::WordCatVec(WordCatVec&& other) noexcept : word_category_array(other.
  */
 WordCatVec& WordCatVec::operator=(WordCatVec&& other) noexcept {
     if (this != &other) {
-        delete[] word_category_array; // Deletes the old array
-        capacity = 0; // Resets capacity
-        size = 0; // Resets size
+        releaseStorage(word_category_array, size, capacity); // Destroys the old categories and frees the old array
+        releaseIndex(name_index, index_capacity); // Frees the old name index
+        if (account) account->release(); // Credited for the freed memory, and gone once its last block is
 
+        account = other.account; // Takes over the account that counts the other's memory
         word_category_array = other.word_category_array; // Takes ownership of the other's array
         capacity = other.capacity; // Takes ownership of the other's capacity
         size = other.size; // Takes ownership of the other's size
+        name_index = other.name_index; // Takes ownership of the other's name index
+        index_capacity = other.index_capacity; // Takes ownership of the other's index capacity
 
+        other.account = nullptr; // The other object gets a new account if it is used again
         other.word_category_array = nullptr; // Sets the other's array pointer to null
         other.capacity = 0; // Resets the other's capacity
         other.size = 0; // Resets the other's size
+        other.name_index = nullptr; // Sets the other's index pointer to null
+        other.index_capacity = 0; // Resets the other's index capacity
+
+        query_cache.clear(); // Cached results described the old categories
+        other.query_cache.clear(); // The other object has no categories left
+        history = std::move(other.history); // The edits that led to these categories
     }
     return *this; // Returns a reference to the current object
 }
 
+/**
+ * @brief Returns the memory account, creating a new one if this object was moved from.
+ * @return The account.
+ */
+MemoryAccount& WordCatVec::memory() const {
+    if (account == nullptr) account = new MemoryAccount(); // Moved from: the object starts counting afresh
+    return *account;
+}
+
+/**
+ * @brief Allocates raw storage for the given number of WordCat objects without constructing them.
+ * @param count The number of WordCat slots to allocate.
+ * @return A pointer to the uninitialized storage.
+ */
+WordCat* WordCatVec::allocateStorage(size_t count) {
+    static_assert(alignof(WordCat) <= MemoryAccount::HEADER, "Accounted blocks are only 8-byte aligned");
+    return static_cast<WordCat*>(memory().allocate(count * sizeof(WordCat), MemoryAccount::Structure::Categories)); // Raw memory; objects are constructed on demand
+}
+
+/**
+ * @brief Destroys the first 'count' WordCat objects in the storage and releases it.
+ * @param storage The storage to release.
+ * @param count The number of constructed objects at the start of the storage.
+ * @param slots The number of slots it was allocated with.
+ */
+void WordCatVec::releaseStorage(WordCat* storage, size_t count, size_t slots) {
+    for (size_t i = 0; i < count; ++i) {
+        storage[i].~WordCat(); // Destroys each constructed category
+    }
+    MemoryAccount::deallocate(storage, slots * sizeof(WordCat), MemoryAccount::Structure::Categories); // Frees the raw memory (a no-op for nullptr)
+}
+
+/**
+ * @brief Allocates a zeroed name index table, charged to the memory account.
+ * @param table_capacity The number of slots.
+ * @return The table.
+ */
+size_t* WordCatVec::allocateIndex(size_t table_capacity) {
+    size_t* table = static_cast<size_t*>(memory().allocate(table_capacity * sizeof(size_t), MemoryAccount::Structure::Indexes));
+    std::fill(table, table + table_capacity, 0); // 0 marks an empty slot
+    return table;
+}
+
+/**
+ * @brief Frees a table allocated by allocateIndex.
+ * @param table The table, or nullptr.
+ * @param table_capacity The number of slots it was allocated with.
+ */
+void WordCatVec::releaseIndex(size_t* table, size_t table_capacity) {
+    MemoryAccount::deallocate(table, table_capacity * sizeof(size_t), MemoryAccount::Structure::Indexes);
+}
+
+/**
+ * @brief Moves the constructed categories into new storage of the given capacity.
+ * Only the WordCat shells are moved; the word lists they own are never copied.
+ * @param new_capacity The new capacity, which must be at least size.
+ */
+void WordCatVec::reallocate(size_t new_capacity) {
+    if (new_capacity < size) throw std::runtime_error("Size exceeds capacity"); // Never drop constructed categories
+
+    WordCat* new_category_array = allocateStorage(new_capacity); // Allocate the new storage
+    for (size_t i = 0; i < size; ++i) {
+        new (&new_category_array[i]) WordCat(std::move(word_category_array[i])); // Move each category into place (noexcept)
+    }
+
+    releaseStorage(word_category_array, size, capacity); // Destroy the moved-from shells and free the old storage
+    word_category_array = new_category_array; // Point to the new storage
+    capacity = new_capacity; // Update the capacity
+}
+
+/**
+ * @brief Finds the name_index slot holding the given category name, or the empty slot where it would be inserted.
+ * @param category The category name to look for.
+ * @return A pointer into name_index.
+ */
+size_t* WordCatVec::indexSlot(const Word& category) const {
+    size_t mask = index_capacity - 1; // index_capacity is a power of two
+    size_t slot = category.hash() & mask; // Home slot of the name
+
+    while (name_index[slot] != 0) { // Linear probing until an empty slot is reached
+        if (word_category_array[name_index[slot] - 1].getCategoryName() == category) {
+            break; // Found the slot holding this name
+        }
+        slot = (slot + 1) & mask; // Probe the next slot
+    }
+    return &name_index[slot]; // Return the matching or empty slot
+}
+
+/**
+ * @brief Removes the name_index entry of the category at the given position.
+ * Later entries of the same probe run are shifted back so that no tombstones are needed.
+ * @param position The array position of the category whose entry is removed.
+ */
+void WordCatVec::indexErase(size_t position) {
+    size_t mask = index_capacity - 1; // index_capacity is a power of two
+    size_t hole = indexSlot(word_category_array[position].getCategoryName()) - name_index; // Slot being emptied
+    size_t next = hole; // Slot being examined
+
+    while (true) {
+        next = (next + 1) & mask; // Examine the next slot of the run
+        if (name_index[next] == 0) break; // End of the probe run
+
+        size_t home = word_category_array[name_index[next] - 1].getCategoryName().hash() & mask; // Home slot of the entry
+        bool home_in_range = (hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next); // Cyclic (hole, next]
+        if (!home_in_range) { // The entry can move back into the hole without breaking its probe sequence
+            name_index[hole] = name_index[next];
+            hole = next;
+        }
+    }
+    name_index[hole] = 0; // Empty the final hole
+}
+
+/**
+ * @brief Rebuilds name_index from scratch with room for the current categories.
+ * The table is kept at most half full.
+ */
+void WordCatVec::rebuildIndex() {
+    size_t new_capacity = indexCapacityFor(size);
+    installIndex(allocateIndex(new_capacity), new_capacity); // Allocate a zeroed table
+}
+
+/**
+ * @brief Returns the name_index size for a number of categories, keeping the load factor at most one half.
+ * @param count The number of categories.
+ * @return A power of two at least 8 and at least twice count.
+ */
+size_t WordCatVec::indexCapacityFor(size_t count) {
+    size_t table_capacity = 8; // Smallest table size
+    while (table_capacity < count * 2) table_capacity *= 2; // Keep the load factor at most one half
+    return table_capacity;
+}
+
+/**
+ * @brief Replaces name_index with a zeroed table and indexes the current categories in it.
+ * Split from rebuildIndex so that a transaction can allocate the table before it commits.
+ * @param table A zeroed table from allocateIndex.
+ * @param table_capacity Its number of slots.
+ */
+void WordCatVec::installIndex(size_t* table, size_t table_capacity) noexcept {
+    releaseIndex(name_index, index_capacity); // Free the old table
+    name_index = table;
+    index_capacity = table_capacity; // Update the table size
+
+    for (size_t i = 0; i < size; ++i) {
+        *indexSlot(word_category_array[i].getCategoryName()) = i + 1; // Re-insert each category
+    }
+}
+
 /**
  * @brief Displays a menu to the user and returns the user's choice.
  * @return The user's menu choice.
@@ -113,6 +327,19 @@ int WordCatVec::menu() const {
     std::cout << "7. Show all the words starting with a given letter\n";
     std::cout << "8. Load from a text file\n";
     std::cout << "9. Save to a text file\n";
+    std::cout << "10. Show category statistics\n";
+    std::cout << "11. Reload from a changed text file\n";
+    std::cout << "12. Save to a compressed file\n";
+    std::cout << "13. Load from a compressed file\n";
+    std::cout << "14. Search all categories ignoring case and accents\n";
+    std::cout << "15. Browse a category page by page\n";
+    std::cout << "16. Show the most used words\n";
+    std::cout << "17. Suggest words that start with some letters\n";
+    std::cout << "18. Undo the last edit\n";
+    std::cout << "19. Redo the last undone edit\n";
+    std::cout << "20. Compare categories\n";
+    std::cout << "21. Find duplicate words\n";
+    std::cout << "22. Show the memory report\n";
     std::cout << "0. Exit the program\n";
     std::cout << "===========================\n";
 
@@ -124,7 +351,7 @@ int WordCatVec::menu() const {
         }
 
         std::cin >> choice; // Read the user's choice
-        if (std::cin.fail() || !(choice >= 0 && choice <= 9)) { // Check for input failure or choice not in the valid range
+        if (std::cin.fail() || !(choice >= 0 && choice <= 22)) { // Check for input failure or choice not in the valid range
             std::cin.clear(); // Clear the error flags
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore the rest of the line
 
@@ -146,6 +373,7 @@ int WordCatVec::menu() const {
  * @param choice The user's menu choice.
  */
 void WordCatVec::perform(const int choice) {
+    MemoryAccount::Scope scope(memory()); // Whatever the choice allocates is charged to this vocabulary
     switch (choice) {
         case 1: {
             std::cout << "\n*** Printing all the category names ***\n";
@@ -166,6 +394,7 @@ void WordCatVec::perform(const int choice) {
             int inserted_word_count{ 0 }; // Counter for the number of words added
 
             std::cout << "\n*** Adding new category names ***\n";
+            editHistory().beginStep(); // The names added here are undone together
             while (true) { // Infinite loop to keep asking for input
                 std::cout << "Please enter the name of a category (or press ENTER to stop): ";
 
@@ -177,8 +406,12 @@ void WordCatVec::perform(const int choice) {
                 }
 
                 WordCat new_category(input);
-                if (addCategory(new_category)) inserted_word_count++; // Increment the count if the word was successfully added
+                if (addCategory(new_category)) { // If the category was added
+                    inserted_word_count++; // Increment the count
+                    editHistory().record(EditHistory::Operation::AddCategory, input);
+                }
             }
+            editHistory().endStep();
 
             std::cout << "\n" << inserted_word_count << " new category name(s) added. ";
             break;
@@ -202,7 +435,13 @@ void WordCatVec::perform(const int choice) {
             std::cin >> user_confirmation; // Get the user's confirmation
 
             if (isYes(user_confirmation)) { // If the user confirms the removal
-                if (this->removeCategory(input)) { // If the category is removed successfully
+                const WordCat* doomed = this->search(input); // Journaled with its words, so that undo can restore them
+                if (doomed != nullptr) { // If the category is found
+                    editHistory().beginStep();
+                    recordWords(*doomed, EditHistory::Operation::RemoveWord);
+                    editHistory().record(EditHistory::Operation::RemoveCategory, input);
+                    this->removeCategory(input);
+                    editHistory().endStep();
                     std::cout << "\n'" << input << "' was successfully removed. ";
                 } else { // If the category is not found
                     std::cout << "\n'" << input << "' could not be found. ";
@@ -234,6 +473,9 @@ void WordCatVec::perform(const int choice) {
                 std::cin >> user_confirmation; // Get the user's confirmation
 
                 if (isYes(user_confirmation)) { // Proceed if the user confirms with 'Y' or 'y'
+                    editHistory().beginStep();
+                    recordWords(*found_category, EditHistory::Operation::RemoveWord);
+                    editHistory().endStep();
                     found_category->emptyCategory(); // Clear the category
                 } else { // If the user cancels the clearing
                     std::cout << "\nClearing Operation cancelled. ";
@@ -262,7 +504,20 @@ void WordCatVec::perform(const int choice) {
 
             if (found_category != nullptr) { // If the category is found
                 std::cout << "\nModifying the category '" << input << "'\n\n";
-                found_category->run(); // Run the WordCat menu
+                WordCat before(*found_category); // What the session changed is journaled as one step
+                auto journal = [&]() {
+                    editHistory().beginStep();
+                    recordChanges(before, *found_category);
+                    editHistory().endStep();
+                    rebuildIndex(); // The category may have been renamed
+                };
+                try {
+                    found_category->run(); // Run the WordCat menu
+                } catch (...) { // The edits made before the failure stay, so journal them too
+                    journal();
+                    throw;
+                }
+                journal();
             } else { // If the category is not found
                 std::cout << "\n'" << input << "' could not be found. ";
             }
@@ -283,11 +538,13 @@ void WordCatVec::perform(const int choice) {
                 break; // Exit the loop if input is empty
             }
 
-            for (size_t i = 0; i < size; ++i) { // Loop through each category
-                WordCat category_to_search(word_category_array[i]); // Create a WordCat object for searching
-                Word category_to_search_name = category_to_search.getCategoryName(); // Get the name of the category
+            std::shared_ptr<const QueryCache::Result> result = cachedLookup(input); // Search all categories in parallel, or reuse the last search
+            const bool* found = result->found.get(); // Per-category result of the search
+
+            for (size_t i = 0; i < size; ++i) { // Report in category order
+                const Word& category_to_search_name = word_category_array[i].getCategoryName(); // Get the name of the category
 
-                if (category_to_search.lookupWordInList(input)) { // If the word is found in the category
+                if (found[i]) { // If the word is found in the category
                     std::cout << "\nCategory '" << category_to_search_name << "' has word " << input;
                 } else { // If the word is not found in the category
                     std::cout << "\nCategory '" << category_to_search_name << "' does not have word " << input;
@@ -308,15 +565,15 @@ void WordCatVec::perform(const int choice) {
             std::cin >> first_letter; // Read the first letter from the user
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore the rest of the line
 
-            for (size_t i = 0; i < size; ++i) { // Loop through each category
-                WordCat category_to_search(word_category_array[i]); // Create a WordCat object for searching
-                Word category_to_search_name = category_to_search.getCategoryName(); // Get the name of the category
+            std::shared_ptr<const QueryCache::Result> result = cachedStartingWith(first_letter); // Search all categories in parallel, or reuse the last search
+            const WordList* same_first_letter_words = result->lists.get(); // Per-category words starting with the given letter
 
-                WordList same_first_letter_words = category_to_search.getWordsStartingWithLetter(first_letter); // Get words starting with the given letter
+            for (size_t i = 0; i < size; ++i) { // Report in category order
+                const Word& category_to_search_name = word_category_array[i].getCategoryName(); // Get the name of the category
 
-                if (!same_first_letter_words.isEmpty()) { // If there are words starting with the given letter
+                if (!same_first_letter_words[i].isEmpty()) { // If there are words starting with the given letter
                     std::cout << "\nWord(s) beginning with '" << first_letter << "' in the category '" << category_to_search_name << "':\n";
-                    std::cout << same_first_letter_words; // Print the words
+                    std::cout << same_first_letter_words[i]; // Print the words
                 } else { // If there are no words starting with the given letter
                     std::cout << "\nSorry, no words beginning with '" << first_letter << "' in the category '" << category_to_search_name << "'.\n";
                 }
@@ -326,24 +583,323 @@ void WordCatVec::perform(const int choice) {
         }
 
         case 8: {
-            char file_path[256]; // Array to store the file path
+            std::string file_path; // The file path, of any length
 
             std::cout << "\n*** Loading categories and words from a text file ***\n";
             std::cout << "Please enter the path to the file containing categories and words (or press ENTER to cancel): ";
-            std::cin.getline(file_path, 256); // Get the file path from the user
+            std::getline(std::cin, file_path); // Get the file path from the user
+
+            char load_lazily; // Whether to defer parsing each category's words
+            std::cout << "Load each category's words only when it is first used? (Y / N) : ";
+            std::cin >> load_lazily;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore the rest of the line
 
-            loadFromFile(file_path);
+            loadFromFile(file_path.c_str(), isYes(load_lazily));
+            if (history) history->clear(); // Edits made before the load cannot be undone over it
             break;
         }
 
         case 9: {
-            char file_path[256]; // Array to store the file path
+            std::string file_path; // The file path, of any length
 
             std::cout << "\n*** Saving categories and words to a text file ***\n";
             std::cout << "Please enter the path to the file where you want to save categories and words (or press ENTER to cancel): ";
-            std::cin.getline(file_path, 256); // Get the file path from the user
+            std::getline(std::cin, file_path); // Get the file path from the user
+
+            saveToFile(file_path.c_str());
+            break;
+        }
+
+        case 10: {
+            std::cout << "\n*** Category statistics ***\n";
+            printStats(std::cout);
+            std::cout << "\n";
+            break;
+        }
+
+        case 11: {
+            std::string file_path; // The file path, of any length
+
+            std::cout << "\n*** Reloading categories and words from a changed text file ***\n";
+            std::cout << "Please enter the path to the file containing categories and words (or press ENTER to cancel): ";
+            std::getline(std::cin, file_path); // Get the file path from the user
+
+            reloadFromFile(file_path.c_str());
+            if (history) history->clear(); // Edits made before the reload cannot be undone over it
+            break;
+        }
+
+        case 12: {
+            std::string file_path; // The file path, of any length
+
+            std::cout << "\n*** Saving categories and words to a compressed file ***\n";
+            std::cout << "Please enter the path to the file where you want to save categories and words (or press ENTER to cancel): ";
+            std::getline(std::cin, file_path); // Get the file path from the user
+
+            saveCompressed(file_path.c_str());
+            break;
+        }
+
+        case 13: {
+            std::string file_path; // The file path, of any length
+
+            std::cout << "\n*** Loading categories and words from a compressed file ***\n";
+            std::cout << "Please enter the path to the compressed file (or press ENTER to cancel): ";
+            std::getline(std::cin, file_path); // Get the file path from the user
+
+            loadCompressed(file_path.c_str());
+            if (history) history->clear(); // Edits made before the load cannot be undone over it
+            break;
+        }
+
+        case 14: {
+            Word input; // Variable to hold the user's input
+
+            std::cout << "\n*** Searching all categories for a word, ignoring case and accents ***\n";
+            std::cout << "Please enter the word to search for in all categories (or press ENTER to cancel): ";
+
+            std::cin >> input; // Read the word
+
+            if (input.length() == 0) { // Check if the input is empty (user pressed ENTER)
+                std::cout << "\n";
+                break; // Exit the loop if input is empty
+            }
+
+            for (size_t i = 0; i < size; ++i) {
+                WordCat& category = word_category_array[i];
+                if (!category.hasFoldedIndex()) category.setFoldedIndex(true); // Index once; later searches are one probe
+
+                WordList matches = category.findFolded(input);
+                if (!matches.isEmpty()) { // If some spelling of the word is found
+                    std::cout << "\nCategory '" << category.getCategoryName() << "' has:\n" << matches;
+                } else {
+                    std::cout << "\nCategory '" << category.getCategoryName() << "' has no word like " << input << "\n";
+                }
+            }
+            std::cout << "\n";
+            break;
+        }
+
+        case 15: {
+            Word input; // Variable to hold the user's input
+
+            std::cout << "\n*** Browsing a category page by page ***\n";
+            std::cout << "Please enter the name of the category to browse (or press ENTER to cancel): ";
+
+            std::cin >> input; // Read the word
+
+            if (input.length() == 0) { // Check if the input is empty (user pressed ENTER)
+                std::cout << "\n";
+                break; // Exit the loop if input is empty
+            }
+
+            const WordCat* found_category = this->search(input); // Search for the category
+            if (found_category == nullptr) {
+                std::cout << "\n'" << input << "' could not be found. ";
+                break;
+            }
+
+            const int per_line = WordFormatter::wordsPerLine(WordFormatter::terminalWidth()); // Fill the terminal's width
+            const size_t page_size = static_cast<size_t>(per_line) * 20; // And 20 lines of it
+            size_t offset{ 0 }; // Position of the first word on the page
+
+            while (true) {
+                size_t total = found_category->wordCount(); // Recounted for every page
+                if (offset > total) offset = total;
+                WordList words = found_category->page(offset, page_size); // Costs the page, not the words before it
+
+                std::cout << "\nWords " << (words.isEmpty() ? offset : offset + 1) << " to " << offset + words.length() << " of " << total << ":\n";
+                words.print(std::cout, per_line);
+                std::cout << "\nPress ENTER for the next page, '-' for the previous one, '#' and a number to go to that page,\n"
+                          << "a word to go to where it would be, or '.' to stop: ";
+
+                std::cin >> input; // Read the command
+                const char* command = input.c_str();
+                if (std::strcmp(command, ".") == 0) break;
+                if (input.length() == 0) { // Next page
+                    if (offset + page_size >= total) break; // That was the last one
+                    offset += page_size;
+                } else if (std::strcmp(command, "-") == 0) { // Previous page
+                    offset = offset > page_size ? offset - page_size : 0;
+                } else if (command[0] == '#') { // Page number, counted from 1
+                    unsigned long number = std::strtoul(command + 1, nullptr, 10);
+                    offset = number > 1 ? (number - 1) * page_size : 0;
+                } else { // The page that starts where the word is or would be
+                    offset = found_category->rank(input);
+                }
+            }
+            std::cout << "\n";
+            break;
+        }
+
+        case 16: {
+            std::cout << "\n*** Most used words ***\n";
+            if (!hasHitCounting()) { // Counting costs memory, so it starts on first request
+                setHitCounting(true);
+                std::cout << "Word use is counted from now on: every word found by a search counts as a use.\n\n";
+                break;
+            }
+
+            const size_t k{ 20 }; // Words to show
+            Word* words = new Word[k];
+            Word* categories = new Word[k];
+            uint64_t* hits = new uint64_t[k];
+            size_t found = mostUsed(k, words, categories, hits);
+            if (found == 0) std::cout << "No word has been used yet\n";
+            for (size_t i = 0; i < found; ++i) {
+                std::cout << std::setw(10) << hits[i] << "  " << words[i] << " (" << categories[i] << ")\n";
+            }
+            delete[] words;
+            delete[] categories;
+            delete[] hits;
+            std::cout << "\n";
+            break;
+        }
+
+        case 17: {
+            Word input; // Variable to hold the user's input
+
+            std::cout << "\n*** Suggesting words that start with some letters ***\n";
+            std::cout << "Please enter the first letters of the word (or press ENTER to cancel): ";
+
+            std::cin >> input; // Read the prefix
+
+            if (input.length() == 0) { // Check if the input is empty (user pressed ENTER)
+                std::cout << "\n";
+                break; // Exit the loop if input is empty
+            }
+
+            for (size_t i = 0; i < size; ++i) {
+                const WordCat& category = word_category_array[i];
+                WordList suggestions = category.complete(input, 10); // Most used first when hits are counted
+                if (!suggestions.isEmpty()) {
+                    std::cout << "\nCategory '" << category.getCategoryName() << "':\n" << suggestions;
+                }
+            }
+            std::cout << "\n";
+            break;
+        }
+
+        case 18: {
+            std::cout << "\n*** Undoing the last edit ***\n";
+            if (!history || history->undoCount() == 0) {
+                std::cout << "Nothing to undo.\n\n";
+            } else if (undo()) {
+                std::cout << "Undid the last edit.\n\n";
+            } else { // The categories were changed some other way since
+                std::cout << "The last edit could only be partly undone.\n\n";
+            }
+            break;
+        }
+
+        case 19: {
+            std::cout << "\n*** Redoing the last undone edit ***\n";
+            if (!history || history->redoCount() == 0) {
+                std::cout << "Nothing to redo.\n\n";
+            } else if (redo()) {
+                std::cout << "Redid the last undone edit.\n\n";
+            } else {
+                std::cout << "The edit could only be partly redone.\n\n";
+            }
+            break;
+        }
+
+        case 20: {
+            Word first, second; // The categories to compare
+
+            std::cout << "\n*** Comparing categories ***\n";
+            std::cout << "Please enter the name of the first category (or press ENTER to find all similar pairs): ";
+            std::cin >> first; // Read the word
+
+            if (first.length() == 0) { // Report every pair that overlaps enough
+                int percent; // The least similarity wanted
+                std::cout << "Show the pairs that share at least what percentage of their words? (1 - 100) : ";
+                std::cin >> percent;
+                if (std::cin.fail() || percent < 1 || percent > 100) {
+                    std::cin.clear(); // Clear the error flags
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore the rest of the line
+                    std::cout << "\nInvalid percentage. ";
+                    break;
+                }
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore the rest of the line
+
+                std::vector<Similarity> pairs = similarCategories(percent / 100.0); // Estimated from signatures
+                for (const Similarity& pair : pairs) {
+                    std::cout << "\n'" << pair.first << "' and '" << pair.second << "': about "
+                              << static_cast<int>(pair.jaccard * 100 + 0.5) << "% similar, "
+                              << static_cast<int>(pair.overlap * 100 + 0.5) << "% overlap";
+                }
+                std::cout << "\n\n" << pairs.size() << " similar pair(s) found.\n\n";
+                break;
+            }
+
+            std::cout << "Please enter the name of the second category: ";
+            std::cin >> second; // Read the word
+
+            Similarity similarity;
+            WordList shared; // Words of both categories
+            if (!compareCategories(first, second, similarity) || !intersectCategories(first, second, shared)) {
+                std::cout << "\nBoth categories must exist. ";
+                break;
+            }
+            std::cout << "\n'" << first << "' and '" << second << "' are " << static_cast<int>(similarity.jaccard * 100 + 0.5)
+                      << "% similar, " << static_cast<int>(similarity.overlap * 100 + 0.5) << "% overlap\n";
+            std::cout << "Words in both (" << shared.length() << "):\n" << shared << "\n";
+            break;
+        }
+
+        case 21: {
+            std::string file_path; // The file path, of any length
+            DuplicateReport report;
+
+            std::cout << "\n*** Finding words in more than one category ***\n";
+            std::cout << "Please enter the path to a file to analyze without loading it (or press ENTER for the loaded categories): ";
+            std::getline(std::cin, file_path); // Get the file path from the user
 
-            saveToFile(file_path);
+            if (!file_path.empty()) {
+                if (!analyzeFile(file_path.c_str(), report)) break;
+            } else {
+                report = analyzeDuplicates();
+            }
+
+            std::cout << "\n" << report.categories << " categories, " << report.words << " words, " << report.distinct << " different\n";
+            std::cout << report.duplicated << " word(s) in more than one category, " << report.copies << " extra copies, "
+                      << report.copy_bytes << " bytes of separate buffers\n";
+
+            if (file_path.empty() && report.copy_bytes > 0) {
+                char confirm; // Whether to share the buffers
+                std::cout << "Make the copies of each word share one buffer? (Y / N) : ";
+                std::cin >> confirm;
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore the rest of the line
+                if (isYes(confirm)) {
+                    report = compactDuplicates();
+                    std::cout << report.saved_bytes << " bytes freed.\n";
+                }
+            }
+            std::cout << "\n";
+            break;
+        }
+
+        case 22: {
+            std::string budget; // The new budget, if any
+            std::cout << "\n*** Memory report ***\n";
+            printMemoryReport(std::cout);
+
+            std::cout << "\nPlease enter a new memory budget in bytes, 0 for none (or press ENTER to keep it): ";
+            std::getline(std::cin, budget);
+            if (budget.empty()) {
+                std::cout << "\n";
+                break;
+            }
+            char* end = nullptr;
+            unsigned long long bytes = std::strtoull(budget.c_str(), &end, 10);
+            if (end == budget.c_str() || *end != '\0') {
+                std::cout << "\nInvalid budget. ";
+                break;
+            }
+            setMemoryBudget(bytes == 0 ? MemoryAccount::UNLIMITED : static_cast<size_t>(bytes));
+            if (bytes != 0 && memoryAccount().totalBytes() > bytes) std::cout << "The vocabulary already holds more; nothing more can be loaded until some is freed.\n";
+            std::cout << "\n";
             break;
         }
 
@@ -359,7 +915,11 @@ void WordCatVec::perform(const int choice) {
 void WordCatVec::run() {
     int choice = this->menu(); // Call the menu function and get the user's choice
     while (choice != 0) { // Continue until the user chooses to exit (option 0)
-        perform(choice); // Perform the action corresponding to the user's choice
+        try {
+            perform(choice); // Perform the action corresponding to the user's choice
+        } catch (const MemoryBudgetExceeded&) { // The operation stopped before allocating past the budget
+            std::cerr << "The memory budget is exceeded; the operation was not completed\n";
+        }
         std::cout << "Returning to menu...\n\n"; // Inform the user that the program is returning to the menu
         choice = this->menu(); // Call the menu function again to get the next choice
     }
@@ -378,38 +938,46 @@ void WordCatVec::run() {
 }
 
 /**
- * @brief Adds a new category to the array.
+ * @brief Adds a copy of a category to the array.
  * @param new_category The new category to add.
  * @return True if the category was successfully added, false otherwise.
  */
 bool WordCatVec::addCategory(const WordCat& new_category) {
+    if (lookup(new_category.getCategoryName())) { // Check before copying so duplicates cost nothing
+        std::cout << "\nThe category '" << new_category.getCategoryName() << "' already exists!\n";
+        return false; // Return false as the category was not added
+    }
+    MemoryAccount::Scope scope(memory()); // The copy's words are charged to this vocabulary
+    return addCategory(WordCat(new_category)); // Copy once, then move the copy into place
+}
+
+/**
+ * @brief Adds a category to the array by moving it in.
+ * Growth doubles the capacity, so adding n categories costs O(n) moves in total. Everything is allocated
+ * before the category moves in, so a refused allocation leaves both unchanged. The category's words stay
+ * charged to the account they were allocated under.
+ * @param new_category The new category to add.
+ * @return True if the category was successfully added, false otherwise.
+ */
+bool WordCatVec::addCategory(WordCat&& new_category) {
     if (lookup(new_category.getCategoryName())) { // Check if the category already exists
         std::cout << "\nThe category '" << new_category.getCategoryName() << "' already exists!\n";
         return false; // Return false as the category was not added
     }
 
     if (size == capacity) { // If the array is full
-        size_t new_capacity = capacity * 2; // Double the capacity
-        WordCat* new_category_array = new WordCat[new_capacity]; // Create a new array with the new capacity
-
-        for (size_t i = 0; i < size; ++i) { // Loop through each category
-            if (i < new_capacity) {
-                new_category_array[i] = word_category_array[i]; // Copy each category
-            } else {
-                throw std::runtime_error("Size exceeds capacity"); // Throw an error if the size exceeds the new capacity
-            }
-        }
-
-        delete[] word_category_array; // Delete the old array
-
-        word_category_array = new_category_array; // Set the pointer to the new array
-        capacity = new_capacity; // Update the capacity
+        reallocate(capacity == 0 ? 1 : capacity * 2); // Double the capacity, moving the existing categories
     }
-
-    if (size < capacity) { // If there is space in the array
-        word_category_array[size++] = new_category; // Add the new category and increment the size
+    if ((size + 1) * 2 > index_capacity) { // Keep the name index at most half full
+        size_t table_capacity = indexCapacityFor(size + 1);
+        size_t* table = allocateIndex(table_capacity); // Grow the name index
+        new (&word_category_array[size]) WordCat(std::move(new_category)); // Construct the new category in place
+        size++; // Count it before indexing
+        installIndex(table, table_capacity);
     } else {
-        throw std::runtime_error("Size exceeds capacity"); // Throw an error if there is no space left in the array
+        new (&word_category_array[size]) WordCat(std::move(new_category)); // Construct the new category in place
+        *indexSlot(word_category_array[size].getCategoryName()) = size + 1; // Index it
+        size++; // Increment the size
     }
 
     return true; // Return true as the category was successfully added
@@ -417,40 +985,47 @@ bool WordCatVec::addCategory(const WordCat& new_category) {
 
 /**
  * @brief Removes a category from the array.
+ * The capacity is halved only when the array is at most a quarter full, so alternating
+ * adds and removes around a power of two never trigger repeated reallocations.
  * @param category_to_remove The name of the category to remove.
+ * @param preserve_order True to shift later categories down, false to move the last category into the freed slot.
  * @return True if the category was successfully removed, false otherwise.
  */
-bool WordCatVec::removeCategory(const Word& category_to_remove) {
-    for (size_t i = 0; i < size; ++i) { // Loop through the categories
-        if (word_category_array[i].getCategoryName() == category_to_remove) { // Compare the category to remove with the current category
-            for (size_t j = i; j < size - 1; ++j) { // Shift all elements to the left
-                word_category_array[j] = word_category_array[j + 1];
-            }
-            size--; // Decrement the size of the array
-
-            if (size < capacity / 2) { // If the size is less than half the capacity, resize the array
-                size_t new_capacity = (capacity / 2 > 1) ? capacity / 2 : 1; // Calculate the new capacity
-
-                WordCat* new_category_array = new WordCat[new_capacity]; // Create a new array with the new capacity
+bool WordCatVec::removeCategory(const Word& category_to_remove, bool preserve_order) {
+    WordCat* found_category = search(category_to_remove); // Find the category via the name index
+    if (found_category == nullptr) {
+        return false; // Return false if the category was not found
+    }
 
-                for (size_t i = 0; i < size; ++i) { // Loop through each category
-                    if (i < new_capacity) {
-                        new_category_array[i] = word_category_array[i];// Copy the categories to the new array
-                    } else {
-                        throw std::runtime_error("Size exceeds capacity"); // Error if the new capacity is exceeded
-                    }
-                }
+    size_t position = found_category - word_category_array; // Position of the category to remove
+    size_t last = size - 1; // Position of the last category
+    indexErase(position); // Drop its name from the index
 
-                delete[] word_category_array; // Delete the old array
+    if (preserve_order) {
+        for (size_t slot = 0; slot < index_capacity; ++slot) { // Later categories move down by one position
+            if (name_index[slot] > position + 1) name_index[slot]--;
+        }
+        for (size_t j = position + 1; j <= last; ++j) { // Shift all later elements to the left
+            word_category_array[j - 1] = std::move(word_category_array[j]); // Move, never copy, the category
+        }
+    } else if (position != last) {
+        *indexSlot(word_category_array[last].getCategoryName()) = position + 1; // The last category takes the freed slot
+        word_category_array[position] = std::move(word_category_array[last]); // Move it into place
+    }
 
-                word_category_array = new_category_array; // Point to the new array
-                capacity = new_capacity; // Update the capacity
-            }
+    word_category_array[last].~WordCat(); // Destroy the now unused last slot
+    size--; // Decrement the size of the array
 
-            return true; // Return true if the category was removed
+    try {
+        if (capacity > 1 && size <= capacity / SHRINK_FACTOR) { // Shrink only when the array is mostly empty
+            reallocate(capacity / 2 > 1 ? capacity / 2 : 1); // Halve the capacity, moving the remaining categories
         }
-    }
-    return false; // Return false if the category was not found
+        if (index_capacity > 8 && size * 8 <= index_capacity) { // Shrink the name index with the same hysteresis
+            rebuildIndex();
+        }
+    } catch (const std::bad_alloc&) {} // No room for the smaller copy (over the memory budget): keep the larger one
+
+    return true; // Return true if the category was removed
 }
 
 /**
@@ -459,12 +1034,10 @@ bool WordCatVec::removeCategory(const Word& category_to_remove) {
  * @return A pointer to the found WordCat, or nullptr if not found.
  */
 WordCat* WordCatVec::search(const Word& category) const {
-    for (size_t i = 0; i < size; ++i) { // Loop through the categories
-        if (word_category_array[i].getCategoryName() == category) { // Compare the category to search with the current category
-            return &word_category_array[i]; // Return a pointer to the found WordCat
-        }
-    }
-    return nullptr; // Return nullptr if the WordCat is not found
+    if (index_capacity == 0) return nullptr; // A moved-from object has no categories
+
+    size_t position = *indexSlot(category); // Position + 1 of the category, or 0 if absent
+    return position != 0 ? &word_category_array[position - 1] : nullptr; // Return a pointer to the found WordCat
 }
 
 /**
@@ -477,89 +1050,1091 @@ bool WordCatVec::lookup(const Word& category) const {
 }
 
 /**
- * @brief Overloads the << operator to print a WordCatVec object.
- * @param sout The output stream.
- * @param wcv The WordCatVec to print.
- * @return The output stream.
+ * @brief Returns the number of categories in the array.
+ * @return The number of categories.
  */
-std::ostream& operator<<(std::ostream& sout, const WordCatVec& wcv) {
-    for (size_t i = 0; i < wcv.size; ++i) { // Loop through the categories
-        sout << wcv.word_category_array[i] << "\n"; // Output each category
-    }
-    return sout; // Return the ostream object
+size_t WordCatVec::categoryCount() const {
+    return size; // Return the current size of the array
 }
 
 /**
- * @brief Trims leading and trailing spaces from a string in place.
- * 
- * This function modifies the input string by removing leading and trailing
- * spaces. It also shifts the trimmed content to the start of the original
- * string buffer if necessary.
- * 
- * @param str The input string to be trimmed.
+ * @brief Inserts a word into the given category.
+ * @param category The name of the category.
+ * @param word The word to insert.
+ * @return True if the word was inserted, false if the category does not exist or already has the word.
  */
-void trim(char* str) {
-    char* start = str; // Pointer to the start of the string
-    char* end = str + strlen(str) - 1; // Pointer to the end of the string
+bool WordCatVec::insertWord(const Word& category, const Word& word) {
+    MemoryAccount::Scope scope(memory());
+    WordCat* found_category = search(category); // Find the category via the name index
+    return found_category != nullptr && found_category->insertWord(word); // Insert the word if the category exists
+}
 
-    // Trim leading spaces
-    while (isspace((unsigned char)*start)) start++; // Move start pointer past any leading spaces
+/**
+ * @brief Removes a word from the given category.
+ * @param category The name of the category.
+ * @param word The word to remove.
+ * @return True if the word was removed, false if the category does not exist or does not have the word.
+ */
+bool WordCatVec::removeWord(const Word& category, const Word& word) {
+    MemoryAccount::Scope scope(memory()); // Removing from a shared tree copies the nodes on the path
+    WordCat* found_category = search(category); // Find the category via the name index
+    return found_category != nullptr && found_category->removeWord(word); // Remove the word if the category exists
+}
 
-    // Trim trailing spaces
-    while (end > start && isspace((unsigned char)*end)) end--; // Move end pointer before any trailing spaces
+/**
+ * @brief Checks if the given category has a word.
+ * @param category The name of the category.
+ * @param word The word to look up.
+ * @return True if the category exists and has the word, false otherwise.
+ */
+bool WordCatVec::lookupWord(const Word& category, const Word& word) const {
+    const WordCat* found_category = search(category); // Find the category via the name index
+    return found_category != nullptr && found_category->lookupWordInList(word); // Look up the word if the category exists
+}
 
-    // Null terminate after the last non-space character
-    *(end + 1) = '\0'; // Place the null terminator right after the last non-space character
+/**
+ * @brief Looks up a batch of words in one category with a single merge pass.
+ * @param category The name of the category.
+ * @param words The words to look up.
+ * @param count The number of words.
+ * @param found Array of count elements; found[i] is set to whether the category has words[i].
+ * @return True if the category exists, false otherwise.
+ */
+bool WordCatVec::lookupMany(const Word& category, const Word* words, size_t count, bool* found) const {
+    const WordCat* found_category = search(category); // Find the category via the name index
+    if (found_category == nullptr) return false; // No such category
 
-    // Move the adjusted string to the start if necessary
-    if (start > str) { // If the start pointer moved past the beginning of the original string
-        memmove(str, start, end - start + 2); // Shift the trimmed string to the beginning (including null terminator)
-    }
+    found_category->lookupMany(words, count, found); // One merge pass over the category's words
+    return true;
 }
 
 /**
- * @brief Loads categories and words from a file.
- * 
- * This function reads from a specified file, processing lines to categorize
- * words under appropriate categories indicated by lines starting with '#'.
- * It trims spaces from each line and processes only non-empty lines.
- * 
- * @param filename The path to the file to load from.
+ * @brief Looks up a batch of words in all categories.
+ * The probes are sorted once and shared by every category. Each pool task merges its chunk of
+ * categories into a private result buffer; the buffers are OR-ed together at the end, so tasks
+ * never write to shared memory.
+ * @param words The words to look up.
+ * @param count The number of words.
+ * @param found Array of count elements; found[i] is set to whether any category has words[i].
+ * @param parallel If false, the categories are scanned on the calling thread only.
  */
-void WordCatVec::loadFromFile(const char* filename) {
-    std::ifstream file(filename); // Open the file for reading
-    if (!file) { // Check if the file was opened successfully
-        std::cerr << "Error opening file: " << filename << std::endl; // Print error message if file cannot be opened
-        return; // Exit the function
-    }
+void WordCatVec::lookupMany(const Word* words, size_t count, bool* found, bool parallel) const {
+    for (size_t i = 0; i < count; ++i) found[i] = false; // Nothing found yet
+    if (count == 0 || size == 0) return; // Nothing to do
+
+    size_t* order = WordList::sortedOrder(words, count); // Sort the probes once for all categories
+    size_t chunk_count = parallel ? ThreadPool::shared().threadCount() : 1; // One private buffer per chunk
+    if (chunk_count > size) chunk_count = size; // No empty chunks
+    size_t grain = (size + chunk_count - 1) / chunk_count; // Categories per chunk
+    chunk_count = (size + grain - 1) / grain; // Chunks actually produced by that grain
+
+    bool* chunk_found = new bool[chunk_count * count](); // Per-chunk results, all false
+    ThreadPool::RangeBody body = [&](size_t begin, size_t end) {
+        bool* mine = chunk_found + (begin / grain) * count; // This chunk's private results
+        bool* hits = new bool[count]; // Results for one category
+        for (size_t i = begin; i < end; ++i) { // Categories of this chunk
+            word_category_array[i].lookupMany(words, count, hits, order);
+            for (size_t j = 0; j < count; ++j) mine[j] = mine[j] || hits[j]; // Accumulate
+        }
+        delete[] hits; // Free the per-category results
+    };
 
-    char line[256]; // Buffer to store each line read from the file
-    WordCat* currentCategory = nullptr; // Pointer to keep track of the current category
-    while (file.getline(line, 256)) { // Read each line from the file
-        trim(line); // Trim leading and trailing spaces from the line
+    if (chunk_count > 1) {
+        ThreadPool::shared().parallelFor(size, body, grain); // One task per chunk of categories
+    } else {
+        body(0, size); // Scan on the calling thread
+    }
+
+    for (size_t c = 0; c < chunk_count; ++c) { // Combine the chunks' results
+        for (size_t j = 0; j < count; ++j) found[j] = found[j] || chunk_found[c * count + j];
+    }
+
+    delete[] chunk_found; // Free the per-chunk results
+    delete[] order; // Free the probe order
+}
+
+/**
+ * @brief Finds every category that has the given word.
+ * @param word The word to search for.
+ * @return The names of the categories that have the word, in category order.
+ */
+WordList WordCatVec::categoriesContaining(const Word& word) const {
+    std::shared_ptr<const QueryCache::Result> result = cachedLookup(word); // Per-category result, filled in parallel or reused
+
+    WordList found_in; // Names of the categories that have the word
+    for (size_t i = 0; i < size; ++i) { // Gather in category order
+        if (result->found[i]) found_in.push_back(word_category_array[i].getCategoryName()); // Record the category name
+    }
+
+    return found_in; // Return the matching category names
+}
+
+/**
+ * @brief Collects the words starting with a given letter from every category.
+ * @param letter The first letter of the words to collect.
+ * @return A WordCatVec with one category per category of this object, in the same order, holding its matching words.
+ */
+WordCatVec WordCatVec::wordsStartingWith(const char letter) const {
+    std::shared_ptr<const QueryCache::Result> result = cachedStartingWith(letter); // Per-category result, filled in parallel or reused
+
+    WordCatVec matches; // One result category per category, in order
+    matches.reallocate(size > 1 ? size : 1); // Size the result once
+    for (size_t i = 0; i < size; ++i) {
+        WordList words(result->lists[i]); // Copy the words; the cached result stays intact
+        matches.addCategory(WordCat(word_category_array[i].getCategoryName(), std::move(words)));
+    }
+
+    return matches; // Return the result categories
+}
+
+/**
+ * @brief Looks a word up in every category, in parallel on the shared thread pool.
+ * Each task writes only its own slots of 'found', so no synchronization is needed.
+ * @param word The word to look up.
+ * @param found Array of size elements; found[i] is set to whether category i has the word.
+ */
+void WordCatVec::lookupInAll(const Word& word, bool* found) const {
+    ThreadPool::shared().parallelFor(size, [this, &word, found](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) { // Categories of this chunk
+            found[i] = word_category_array[i].lookupWordInList(word);
+        }
+    });
+}
+
+/**
+ * @brief Collects the words starting with a letter from every category, in parallel on the shared thread pool.
+ * Each task writes only its own slots of 'results', so no synchronization is needed.
+ * @param letter The first letter of the words to collect.
+ * @param results Array of size lists; results[i] receives the matching words of category i.
+ */
+void WordCatVec::collectStartingWith(const char letter, WordList* results) const {
+    ThreadPool::shared().parallelFor(size, [this, letter, results](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) { // Categories of this chunk
+            results[i] = word_category_array[i].getWordsStartingWithLetter(letter);
+        }
+    });
+}
+
+/**
+ * @brief Fills an array with the version stamp of every category.
+ * @param versions Array of size elements.
+ */
+void WordCatVec::collectVersions(uint64_t* versions) const {
+    for (size_t i = 0; i < size; ++i) versions[i] = word_category_array[i].getVersion();
+}
+
+/**
+ * @brief Looks a word up in every category, reusing the result of an earlier identical search if no category has changed since.
+ * @param word The word to look up.
+ * @return The result; found[i] tells whether category i has the word.
+ */
+std::shared_ptr<const QueryCache::Result> WordCatVec::cachedLookup(const Word& word) const {
+    uint64_t* versions = new uint64_t[size]; // The stamps the result must match
+    collectVersions(versions);
+
+    std::shared_ptr<const QueryCache::Result> cached = query_cache.find(QueryCache::Kind::Lookup, word.c_str(), word.length(), versions, size);
+    if (cached) {
+        for (size_t i = 0; i < size; ++i) { // Count the uses a real search would have counted
+            if (cached->found[i]) word_category_array[i].touch(word);
+        }
+        delete[] versions;
+        return cached;
+    }
+
+    std::shared_ptr<QueryCache::Result> result = std::make_shared<QueryCache::Result>();
+    result->count = size;
+    result->found.reset(new bool[size]);
+    lookupInAll(word, result->found.get()); // Search all categories in parallel
+    query_cache.store(QueryCache::Kind::Lookup, word.c_str(), word.length(), versions, size, result);
+    delete[] versions;
+    return result;
+}
+
+/**
+ * @brief Collects the words starting with a letter from every category, reusing the result of an earlier identical search if no category has changed since.
+ * @param letter The first letter of the words to collect.
+ * @return The result; lists[i] holds the matching words of category i.
+ */
+std::shared_ptr<const QueryCache::Result> WordCatVec::cachedStartingWith(const char letter) const {
+    uint64_t* versions = new uint64_t[size]; // The stamps the result must match
+    collectVersions(versions);
+
+    std::shared_ptr<const QueryCache::Result> cached = query_cache.find(QueryCache::Kind::StartingWith, &letter, 1, versions, size);
+    if (cached) {
+        delete[] versions;
+        return cached;
+    }
+
+    std::shared_ptr<QueryCache::Result> result = std::make_shared<QueryCache::Result>();
+    result->count = size;
+    result->lists.reset(new WordList[size]);
+    collectStartingWith(letter, result->lists.get()); // Search all categories in parallel
+    query_cache.store(QueryCache::Kind::StartingWith, &letter, 1, versions, size, result);
+    delete[] versions;
+    return result;
+}
+
+/**
+ * @brief Returns the number of searches over all categories answered from the query cache.
+ * @return The number of cache hits.
+ */
+size_t WordCatVec::queryCacheHits() const {
+    return query_cache.hitCount();
+}
+
+/**
+ * @brief Returns the number of searches over all categories that had to search the categories.
+ * @return The number of cache misses.
+ */
+size_t WordCatVec::queryCacheMisses() const {
+    return query_cache.missCount();
+}
+
+/**
+ * @brief Turns hit counting on or off in every category.
+ * @param enabled Whether to count hits.
+ */
+void WordCatVec::setHitCounting(bool enabled) {
+    MemoryAccount::Scope scope(memory()); // The counter tables are charged to this vocabulary
+    for (size_t i = 0; i < size; ++i) word_category_array[i].setHitCounting(enabled);
+}
+
+/**
+ * @brief Tells whether any category counts hits.
+ * @return True if at least one category has hit counting on.
+ */
+bool WordCatVec::hasHitCounting() const {
+    for (size_t i = 0; i < size; ++i) {
+        if (word_category_array[i].hasHitCounting()) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief A word of some category and its hits, as merged by mostUsed.
+ */
+struct CategoryHits {
+    uint64_t hits; ///< Times the word was used
+    size_t category; ///< Index of the word's category
+    size_t rank; ///< Rank of the word within its category
+    Word word; ///< The word
+};
+
+/**
+ * @brief Finds the k most used words across all categories.
+ * The global k best are among the k best of each category, so at most k words per category are merged.
+ * @param k The number of words wanted.
+ * @param words Array of k elements; receives the words, most used first.
+ * @param categories Array of k elements; receives the name of each word's category.
+ * @param hits Array of k elements; receives their hits.
+ * @return The number of words written, at most k.
+ */
+size_t WordCatVec::mostUsed(size_t k, Word* words, Word* categories, uint64_t* hits) const {
+    if (k == 0 || size == 0) return 0;
+
+    CategoryHits* candidates = new CategoryHits[size * k]; // The best k of every category
+    Word* category_words = new Word[k];
+    uint64_t* category_hits = new uint64_t[k];
+    size_t candidate_count{ 0 };
+    for (size_t i = 0; i < size; ++i) {
+        size_t found = word_category_array[i].mostUsed(k, category_words, category_hits);
+        for (size_t j = 0; j < found; ++j) {
+            candidates[candidate_count++] = CategoryHits{ category_hits[j], i, j, std::move(category_words[j]) };
+        }
+    }
+    delete[] category_words;
+    delete[] category_hits;
+
+    size_t kept = candidate_count < k ? candidate_count : k;
+    std::partial_sort(candidates, candidates + kept, candidates + candidate_count,
+        [](const CategoryHits& a, const CategoryHits& b) { // More hits first, then category order, then each category's order
+            if (a.hits != b.hits) return a.hits > b.hits;
+            return a.category != b.category ? a.category < b.category : a.rank < b.rank;
+        });
+    for (size_t i = 0; i < kept; ++i) {
+        words[i] = std::move(candidates[i].word);
+        categories[i] = word_category_array[candidates[i].category].getCategoryName();
+        hits[i] = candidates[i].hits;
+    }
+    delete[] candidates;
+    return kept;
+}
+
+/**
+ * @brief Where a word met by mergeWords is.
+ */
+enum class Side {
+    First, // Only in the first category
+    Both, // In both categories
+    Second // Only in the second category
+};
+
+/**
+ * @brief Walks the words of two categories together in sorted order, whatever their storage modes.
+ * @param first One category; its words are gathered into a list first.
+ * @param second The other category.
+ * @param visit Called with every word of either category, once, and where it is.
+ */
+static void mergeWords(const WordCat& first, const WordCat& second, const std::function<void(const Word&, Side)>& visit) {
+    WordList pending; // The words of first not yet passed
+    first.forEachWord([&](const Word& word) { pending.push_back(word); });
+    second.forEachWord([&](const Word& word) {
+        while (!pending.isEmpty() && pending.front().isLess(word)) visit(pending.pop_front(), Side::First);
+        if (!pending.isEmpty() && pending.front() == word) {
+            pending.pop_front();
+            visit(word, Side::Both);
+        } else {
+            visit(word, Side::Second);
+        }
+    });
+    while (!pending.isEmpty()) visit(pending.pop_front(), Side::First);
+}
+
+/**
+ * @brief Computes both similarities of two categories from their sizes and the words they share.
+ * @param shared The number of words in both.
+ * @param first_count The number of words of one category.
+ * @param second_count The number of words of the other.
+ * @param result Receives jaccard and overlap.
+ */
+static void measure(double shared, size_t first_count, size_t second_count, WordCatVec::Similarity& result) {
+    double either = static_cast<double>(first_count + second_count) - shared;
+    size_t smaller = std::min(first_count, second_count);
+    result.jaccard = either > 0 ? shared / either : 0.0;
+    result.overlap = smaller > 0 ? std::min(1.0, shared / static_cast<double>(smaller)) : 0.0;
+}
+
+/**
+ * @brief Collects the words two categories have in common, with one merge pass over both.
+ * @param first The name of one category.
+ * @param second The name of the other.
+ * @param result Receives the words, sorted.
+ * @return True if both categories exist.
+ */
+bool WordCatVec::intersectCategories(const Word& first, const Word& second, WordList& result) const {
+    const WordCat* a = search(first);
+    const WordCat* b = search(second);
+    if (a == nullptr || b == nullptr) return false;
+    WordList words;
+    mergeWords(*a, *b, [&words](const Word& word, Side side) { if (side == Side::Both) words.push_back(word); });
+    result = std::move(words);
+    return true;
+}
+
+/**
+ * @brief Collects the words of either of two categories, with one merge pass over both.
+ * @param first The name of one category.
+ * @param second The name of the other.
+ * @param result Receives the words, sorted and without duplicates.
+ * @return True if both categories exist.
+ */
+bool WordCatVec::uniteCategories(const Word& first, const Word& second, WordList& result) const {
+    const WordCat* a = search(first);
+    const WordCat* b = search(second);
+    if (a == nullptr || b == nullptr) return false;
+    WordList words;
+    mergeWords(*a, *b, [&words](const Word& word, Side) { words.push_back(word); });
+    result = std::move(words);
+    return true;
+}
+
+/**
+ * @brief Collects the words of one category that another does not have, with one merge pass over both.
+ * @param first The name of the category whose words are kept.
+ * @param second The name of the category whose words are taken away.
+ * @param result Receives the words, sorted.
+ * @return True if both categories exist.
+ */
+bool WordCatVec::subtractCategories(const Word& first, const Word& second, WordList& result) const {
+    const WordCat* a = search(first);
+    const WordCat* b = search(second);
+    if (a == nullptr || b == nullptr) return false;
+    WordList words;
+    mergeWords(*a, *b, [&words](const Word& word, Side side) { if (side == Side::First) words.push_back(word); });
+    result = std::move(words);
+    return true;
+}
+
+/**
+ * @brief Measures exactly how much two categories overlap, with one merge pass over both.
+ * @param first The name of one category.
+ * @param second The name of the other.
+ * @param result Receives the names and the similarities.
+ * @return True if both categories exist.
+ */
+bool WordCatVec::compareCategories(const Word& first, const Word& second, Similarity& result) const {
+    const WordCat* a = search(first);
+    const WordCat* b = search(second);
+    if (a == nullptr || b == nullptr) return false;
+    size_t counts[3] = { 0, 0, 0 }; // Words met on each Side
+    mergeWords(*a, *b, [&counts](const Word&, Side side) { counts[static_cast<int>(side)]++; });
+    result.first = a->getCategoryName();
+    result.second = b->getCategoryName();
+    size_t shared = counts[static_cast<int>(Side::Both)];
+    measure(static_cast<double>(shared), counts[static_cast<int>(Side::First)] + shared,
+            counts[static_cast<int>(Side::Second)] + shared, result);
+    return true;
+}
 
-        if (line[0] == '#') { // Check if the line indicates a new category
-            if (currentCategory != nullptr) { // If there's an existing category being processed
-                addCategory(*currentCategory); // Add the existing category to the list
-                delete currentCategory; // Delete the current category to free memory
+/**
+ * @brief Finds the pairs of categories that are at least as similar as a threshold. The signatures are
+ * built and the candidates measured in parallel on the shared thread pool; each task writes only its own slots.
+ * @param threshold The least Jaccard similarity of the pairs wanted.
+ * @param exact If true, the candidates are measured by merging their words.
+ * @return The pairs found, most similar first.
+ */
+std::vector<WordCatVec::Similarity> WordCatVec::similarCategories(double threshold, bool exact) const {
+    MinHash signatures(size);
+    size_t* counts = new size_t[size]; // The number of words of each category
+    ThreadPool::shared().parallelFor(size, [this, &signatures, counts](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) { // Categories of this chunk
+            word_category_array[i].forEachWord([&signatures, i](const Word& word) { signatures.add(i, word.hash()); });
+            counts[i] = word_category_array[i].wordCount();
+        }
+    });
+
+    std::vector<std::pair<size_t, size_t>> candidates = signatures.candidates(threshold);
+    std::vector<Similarity> measured(candidates.size());
+    ThreadPool::shared().parallelFor(candidates.size(), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) { // Candidates of this chunk
+            const WordCat& a = word_category_array[candidates[c].first];
+            const WordCat& b = word_category_array[candidates[c].second];
+            Similarity& result = measured[c];
+            result.first = a.getCategoryName();
+            result.second = b.getCategoryName();
+            double shared; // Words in both, counted or estimated
+            if (exact) {
+                size_t both = 0;
+                mergeWords(a, b, [&both](const Word&, Side side) { both += side == Side::Both; });
+                shared = static_cast<double>(both);
+            } else { // J = s / (|A| + |B| - s), solved for s
+                double jaccard = signatures.similarity(candidates[c].first, candidates[c].second);
+                shared = jaccard * static_cast<double>(counts[candidates[c].first] + counts[candidates[c].second]) / (1.0 + jaccard);
             }
-            // Create a new category, ensuring the category name is also trimmed
-            char* categoryName = line + 1; // Skip the '#' character to get the category name
-            trim(categoryName); // Trim spaces from the category name
-            currentCategory = new WordCat(Word(categoryName)); // Create a new WordCat object for the category
-        } else if (currentCategory != nullptr && line[0] != '\0') { // Check if line is not empty and there's an active category
-            currentCategory->insertWord(Word(line)); // Add the word to the current category
+            measure(shared, counts[candidates[c].first], counts[candidates[c].second], result);
+        }
+    });
+    delete[] counts;
+
+    std::vector<Similarity> similar;
+    for (Similarity& result : measured) {
+        if (result.jaccard >= threshold) similar.push_back(std::move(result));
+    }
+    std::stable_sort(similar.begin(), similar.end(), [](const Similarity& x, const Similarity& y) { return x.jaccard > y.jaccard; });
+    return similar;
+}
+
+/**
+ * @brief Counts, for a stream of categories and their words, how many words are in more than one category.
+ * Each different word is kept as its 64-bit hash in an open-addressing table, with the last category that
+ * had it and the number of categories that have it, so the memory grows with the different words only.
+ */
+class DuplicateCounter {
+private:
+    /**
+     * @brief One different word.
+     */
+    struct Slot {
+        uint64_t hash; ///< Hash of the word; 0 marks a free slot
+        uint32_t last_category; ///< The last category the word was counted in, to skip repeats within it
+        uint32_t categories; ///< The number of categories that have the word
+    };
+
+    Slot* slots; ///< The table; its capacity is a power of two
+    size_t capacity; ///< Number of slots
+    WordCatVec::DuplicateReport& report; ///< The counts being gathered
+
+    /**
+     * @brief Doubles the table and reinserts the words.
+     */
+    void grow() {
+        Slot* old = slots;
+        size_t old_capacity = capacity;
+        capacity *= 2;
+        slots = new Slot[capacity]();
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old[i].hash == 0) continue;
+            size_t at = old[i].hash & (capacity - 1);
+            while (slots[at].hash != 0) at = (at + 1) & (capacity - 1); // Linear probing
+            slots[at] = old[i];
+        }
+        delete[] old;
+    }
+
+public:
+    /**
+     * @brief Constructor. Clears the report.
+     * @param report Receives the counts.
+     */
+    explicit DuplicateCounter(WordCatVec::DuplicateReport& report) : slots{ new Slot[1024]() }, capacity{ 1024 }, report{ report } {
+        report = WordCatVec::DuplicateReport{ 0, 0, 0, 0, 0, 0, 0 };
+    }
+
+    /**
+     * @brief Destructor.
+     */
+    ~DuplicateCounter() {
+        delete[] slots;
+    }
+
+    DuplicateCounter(const DuplicateCounter& other) = delete;
+    DuplicateCounter& operator=(const DuplicateCounter& other) = delete;
+
+    /**
+     * @brief Starts the next category.
+     */
+    void beginCategory() {
+        report.categories++;
+    }
+
+    /**
+     * @brief Counts a word of the current category.
+     * @param word The word.
+     */
+    void add(const Word& word) {
+        uint64_t hash = word.hash();
+        if (hash == 0) hash = 1; // 0 marks a free slot
+        uint32_t category = static_cast<uint32_t>(report.categories);
+        size_t at = hash & (capacity - 1);
+        while (slots[at].hash != 0 && slots[at].hash != hash) at = (at + 1) & (capacity - 1);
+
+        Slot& slot = slots[at];
+        if (slot.hash == 0) { // A new word
+            slot = Slot{ hash, category, 1 };
+            report.words++;
+            report.distinct++;
+            if (2 * report.distinct > capacity) grow(); // Keep the table at most half full
+            return;
+        }
+        if (slot.last_category == category) return; // Repeated within the category
+        slot.last_category = category;
+        if (++slot.categories == 2) report.duplicated++;
+        report.words++;
+        report.copies++;
+        report.copy_bytes += word.copyBytes();
+    }
+};
+
+/**
+ * @brief Hashes the word a pointer points to, to find equal words with compactDuplicates.
+ */
+struct WordPointerHash {
+    size_t operator()(const Word* word) const { return word->hash(); }
+};
+
+/**
+ * @brief Compares the words two pointers point to.
+ */
+struct WordPointerEqual {
+    bool operator()(const Word* a, const Word* b) const { return *a == *b; }
+};
+
+/**
+ * @brief Counts the words that are in more than one category, keeping only a hash and two counters per different word.
+ * @return The counts.
+ */
+WordCatVec::DuplicateReport WordCatVec::analyzeDuplicates() const {
+    DuplicateReport report;
+    DuplicateCounter counter(report);
+    for (size_t i = 0; i < size; ++i) {
+        counter.beginCategory();
+        word_category_array[i].forEachWord([&counter](const Word& word) { counter.add(word); });
+    }
+    return report;
+}
+
+/**
+ * @brief Makes the copies of each long word share one heap buffer. A first pass only reads the words, keeping
+ * the first copy met of each one in a hash map and noting whether it has others. A second pass then goes over
+ * the categories in the same order under each one's reader locks: a first copy with others turns its buffer
+ * into a shared one, and every later copy takes a use of it. A first copy always sits in an earlier category,
+ * or is the word itself, so only the category being changed needs to be locked.
+ * @return The counts after the compaction, with the heap bytes freed.
+ */
+WordCatVec::DuplicateReport WordCatVec::compactDuplicates() {
+    MemoryAccount::Scope scope(memory()); // The counted buffers are charged to this vocabulary
+    std::unordered_map<Word*, bool, WordPointerHash, WordPointerEqual> first_copies; // One per long word; true if it has others
+    for (size_t i = 0; i < size; ++i) {
+        word_category_array[i].forEachStored([&first_copies](Word& word) {
+            if (word.copyBytes() == 0) return; // Inline: nothing to share
+            auto inserted = first_copies.emplace(&word, false);
+            if (!inserted.second) inserted.first->second = true; // A later copy
+        });
+    }
+
+    std::ptrdiff_t freed = 0;
+    for (size_t i = 0; i < size; ++i) {
+        WordCat::ReaderLocks readers = word_category_array[i].lockReaders(); // Copies and lazy rebuilds wait for the category
+        word_category_array[i].forEachStored([&](Word& word) {
+            if (word.copyBytes() == 0) return; // Inline: nothing to share
+            auto first = first_copies.find(&word);
+            if (first->first != &word) freed += word.shareBuffer(*first->first); // Already shared: only its count changes
+            else if (first->second) freed += word.shareBuffer(word); // Replace the buffer while the category is locked
+        });
+    }
+
+    DuplicateReport report = analyzeDuplicates();
+    report.saved_bytes = freed > 0 ? static_cast<size_t>(freed) : 0;
+    return report;
+}
+
+/**
+ * @brief Counts the words that are in more than one category of a file, streaming it line by line.
+ * Lines are read and trimmed as loadFromFile does, so the counts are those of the loaded categories.
+ * @param filename The path to the file.
+ * @param report Receives the counts.
+ * @return False if the file could not be opened.
+ */
+bool WordCatVec::analyzeFile(const char* filename, DuplicateReport& report) {
+    std::ifstream file(filename); // Open the file for reading
+    if (!file) { // Check if the file was opened successfully
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    DuplicateReport counts;
+    DuplicateCounter counter(counts);
+    LineReader lines(file); // Hands out each line in place, however long
+    bool in_category = false; // A header has been read
+    while (char* line = lines.next()) { // Read each line from the file
+        trim(line); // Trim leading and trailing spaces from the line
+        if (line[0] == '#') { // A new category
+            counter.beginCategory();
+            in_category = true;
+        } else if (in_category && line[0] != '\0') {
+            Word word(line); // Normalized as loadFromFile would store it
+            if (word.isValidUtf8()) counter.add(word); // loadFromFile skips the rest
+        }
+    }
+    report = counts;
+    return true;
+}
+
+/**
+ * @brief Returns the edit history, creating it with the default budget on first use.
+ * @return The history.
+ */
+EditHistory& WordCatVec::editHistory() {
+    if (!history) history.reset(new EditHistory());
+    return *history;
+}
+
+/**
+ * @brief Records the same delta for every word of a category, in the open step of the edit history.
+ * @param category The category.
+ * @param operation EditHistory::Operation::InsertWord or EditHistory::Operation::RemoveWord.
+ */
+void WordCatVec::recordWords(const WordCat& category, EditHistory::Operation operation) {
+    EditHistory& journal = editHistory();
+    const Word& name = category.getCategoryName();
+    category.forEachWord([&](const Word& word) { journal.record(operation, name, word); });
+}
+
+/**
+ * @brief Records the differences between two states of a category, in the open step of the edit history.
+ * Both are walked once in sorted order, so only the words that differ are recorded.
+ * @param before The category before the edit.
+ * @param after The category after the edit.
+ */
+void WordCatVec::recordChanges(const WordCat& before, const WordCat& after) {
+    EditHistory& journal = editHistory();
+    const Word& name = after.getCategoryName();
+    if (!(before.getCategoryName() == name)) { // Renamed: undo must remove the new one and restore the old one
+        recordWords(before, EditHistory::Operation::RemoveWord);
+        journal.record(EditHistory::Operation::RemoveCategory, before.getCategoryName());
+        journal.record(EditHistory::Operation::AddCategory, name);
+        recordWords(after, EditHistory::Operation::InsertWord);
+        return;
+    }
+
+    WordList old_words; // The words before, consumed as the words after are walked
+    before.forEachWord([&](const Word& word) { old_words.push_back(word); });
+    after.forEachWord([&](const Word& word) {
+        while (!old_words.isEmpty() && old_words.front().isLess(word)) { // Gone from the category
+            journal.record(EditHistory::Operation::RemoveWord, name, old_words.pop_front());
+        }
+        if (!old_words.isEmpty() && old_words.front() == word) {
+            old_words.pop_front(); // Kept
+        } else {
+            journal.record(EditHistory::Operation::InsertWord, name, word); // New in the category
+        }
+    });
+    while (!old_words.isEmpty()) journal.record(EditHistory::Operation::RemoveWord, name, old_words.pop_front());
+}
+
+/**
+ * @brief Replaces the edit history with an empty one. Steps recorded so far are forgotten.
+ * @param budget Bytes of undo and redo steps to keep in memory.
+ * @param spill_path A file for the older steps beyond the budget, or nullptr to forget them.
+ */
+void WordCatVec::setEditHistory(size_t budget, const char* spill_path) {
+    history.reset(); // The old spill file is removed before a new history may reuse its path
+    history.reset(new EditHistory(budget, spill_path));
+}
+
+/**
+ * @brief Undoes the last edit made through the menu.
+ * @return False if there is nothing to undo, or the edit could only be partly undone.
+ */
+bool WordCatVec::undo() {
+    return history && history->undo(*this);
+}
+
+/**
+ * @brief Redoes the edit undone last.
+ * @return False if there is nothing to redo, or the edit could only be partly redone.
+ */
+bool WordCatVec::redo() {
+    return history && history->redo(*this);
+}
+
+/**
+ * @brief Overloads the << operator to print a WordCatVec object.
+ * @param sout The output stream.
+ * @param wcv The WordCatVec to print.
+ * @return The output stream.
+ */
+std::ostream& operator<<(std::ostream& sout, const WordCatVec& wcv) {
+    for (size_t i = 0; i < wcv.size; ++i) { // Loop through the categories
+        sout << wcv.word_category_array[i] << "\n"; // Output each category
+    }
+    return sout; // Return the ostream object
+}
+
+/**
+ * @brief Prints per-category statistics, including the memory and false-positive rate of each membership filter.
+ * @param sout The output stream to print to.
+ */
+void WordCatVec::printStats(std::ostream& sout) const {
+    sout << std::left << std::setw(20) << "Category" << std::right
+         << std::setw(10) << "Words"
+         << std::setw(13) << "Storage (B)"
+         << std::setw(12) << "Filter (B)"
+         << std::setw(12) << "Est. FPR"
+         << std::setw(12) << "Obs. FPR" << "\n";
+
+    size_t storage_bytes{ 0 }; // Total word storage
+    size_t filter_bytes{ 0 }; // Total filter memory
+    for (size_t i = 0; i < size; ++i) { // One line per category
+        word_category_array[i].printStats(sout);
+        storage_bytes += word_category_array[i].storageMemoryBytes();
+        filter_bytes += word_category_array[i].filterMemoryBytes();
+    }
+
+    sout << size << " categories, " << storage_bytes << " bytes of word storage, " << filter_bytes << " bytes of membership filters\n";
+
+    size_t hits = query_cache.hitCount();
+    size_t misses = query_cache.missCount();
+    sout << "Query cache: " << query_cache.length() << " results, " << hits << " hits, " << misses << " misses ("
+         << query_cache.invalidationCount() << " after a change)";
+    if (hits + misses > 0) sout << ", " << std::fixed << std::setprecision(1) << 100.0 * hits / (hits + misses) << "% hit rate" << std::defaultfloat;
+    sout << "\n";
+}
+
+/**
+ * @brief Sets the most bytes the vocabulary may hold.
+ * @param bytes The budget, or MemoryAccount::UNLIMITED.
+ */
+void WordCatVec::setMemoryBudget(size_t bytes) {
+    memory().setBudget(bytes);
+}
+
+/**
+ * @brief Returns the memory budget.
+ * @return The budget, or MemoryAccount::UNLIMITED.
+ */
+size_t WordCatVec::memoryBudget() const {
+    return memory().getBudget();
+}
+
+/**
+ * @brief Returns the memory account of the vocabulary.
+ * @return The account.
+ */
+const MemoryAccount& WordCatVec::memoryAccount() const {
+    return memory();
+}
+
+/**
+ * @brief Prints the memory held by the vocabulary, by structure and by category.
+ * The account's figures are exact, headers included; the per-category figures are those of printStats,
+ * which leave out the accounting headers and count a buffer shared between categories in each of them.
+ * @param sout The output stream to print to.
+ */
+void WordCatVec::printMemoryReport(std::ostream& sout) const {
+    const MemoryAccount& account = memory();
+    sout << "Held: " << account.totalBytes() << " bytes, peak " << account.peakBytes() << " bytes, budget ";
+    if (account.getBudget() == MemoryAccount::UNLIMITED) sout << "unlimited";
+    else sout << account.getBudget() << " bytes";
+    sout << ", " << account.refusedCount() << " allocation(s) refused\n";
+
+    for (size_t i = 0; i < static_cast<size_t>(MemoryAccount::Structure::COUNT); ++i) { // One line per structure
+        MemoryAccount::Structure structure = static_cast<MemoryAccount::Structure>(i);
+        sout << "  " << std::left << std::setw(22) << MemoryAccount::structureName(structure) << std::right
+             << std::setw(12) << account.bytes(structure) << " bytes\n";
+    }
+
+    sout << std::left << std::setw(20) << "Category" << std::right
+         << std::setw(10) << "Words"
+         << std::setw(13) << "Storage (B)"
+         << std::setw(12) << "Filter (B)"
+         << std::setw(12) << "Total (B)" << "\n";
+    for (size_t i = 0; i < size; ++i) { // One line per category
+        const WordCat& category = word_category_array[i];
+        sout << std::left << std::setw(20) << category.getCategoryName() << std::right;
+        if (!category.isLoaded()) { // Reporting must not parse the words
+            sout << std::setw(10) << "-" << "  (not loaded)\n";
+            continue;
+        }
+        size_t storage = category.storageMemoryBytes();
+        size_t filter = category.filterMemoryBytes();
+        sout << std::setw(10) << category.wordCount()
+             << std::setw(13) << storage
+             << std::setw(12) << filter
+             << std::setw(12) << sizeof(WordCat) + storage + filter << "\n";
+    }
+}
+
+/**
+ * @brief Tells the user how many word lines of a file were skipped because they are not valid UTF-8.
+ * @param filename The path to the file.
+ * @param skipped The number of lines skipped; nothing is printed for 0.
+ */
+static void reportInvalidLines(const char* filename, size_t skipped) {
+    if (skipped > 0) std::cerr << "Skipped " << skipped << " line(s) of " << filename << " that are not valid UTF-8" << std::endl;
+}
+
+/**
+ * @brief Loads categories and words from a file.
+ * 
+ * This function reads from a specified file, processing lines to categorize
+ * words under appropriate categories indicated by lines starting with '#'.
+ * It trims spaces from each line and processes only non-empty lines.
+ * Lines that are not valid UTF-8 are skipped, as insertWord would refuse them, and counted.
+ * In lazy mode the words are left in the file until each category is first used.
+ * 
+ * @param filename The path to the file to load from.
+ * @param lazy True to parse each category's words on first use.
+ */
+void WordCatVec::loadFromFile(const char* filename, bool lazy) {
+    MemoryAccount::Scope scope(memory()); // Everything loaded is charged to this vocabulary
+    if (lazy) { // Only record where each category's words are
+        try {
+            loadDirectory(filename);
+        } catch (const MemoryBudgetExceeded&) {
+            std::cerr << "Memory budget exceeded loading " << filename << "; the categories opened so far are kept" << std::endl;
         }
+        return;
     }
-    if (currentCategory != nullptr) { // After reading all lines, if there's an active category
-        addCategory(*currentCategory); // Add the final category to the list
-        delete currentCategory; // Delete the current category to free memory
+
+    std::ifstream file(filename); // Open the file for reading
+    if (!file) { // Check if the file was opened successfully
+        std::cerr << "Error opening file: " << filename << std::endl; // Print error message if file cannot be opened
+        return; // Exit the function
+    }
+
+    LineReader lines(file); // Hands out each line in place, however long
+    WordCat* currentCategory = nullptr; // Pointer to keep track of the current category
+    size_t invalid{ 0 }; // Word lines that are not valid UTF-8
+    try {
+        while (char* line = lines.next()) { // Read each line from the file
+            trim(line); // Trim leading and trailing spaces from the line
+
+            if (line[0] == '#') { // Check if the line indicates a new category
+                if (currentCategory != nullptr) { // If there's an existing category being processed
+                    addCategory(std::move(*currentCategory)); // Move the existing category into the list
+                    delete currentCategory; // Delete the current category to free memory
+                    currentCategory = nullptr;
+                }
+                // Create a new category, ensuring the category name is also trimmed
+                char* categoryName = line + 1; // Skip the '#' character to get the category name
+                trim(categoryName); // Trim spaces from the category name
+                currentCategory = new WordCat(Word(categoryName)); // Create a new WordCat object for the category
+            } else if (currentCategory != nullptr && line[0] != '\0') { // Check if line is not empty and there's an active category
+                Word word(line);
+                if (word.isValidUtf8()) currentCategory->insertWord(word); // Add the word to the current category
+                else invalid++;
+            }
+        }
+        if (currentCategory != nullptr) { // After reading all lines, if there's an active category
+            addCategory(std::move(*currentCategory)); // Move the final category into the list
+            delete currentCategory; // Delete the current category to free memory
+        }
+    } catch (const MemoryBudgetExceeded&) { // Stop at once rather than thrash: the rest would not fit either
+        delete currentCategory; // The category being read is dropped (a no-op for nullptr)
+        std::cerr << "Memory budget exceeded loading " << filename << "; the categories loaded so far are kept" << std::endl;
+        reportInvalidLines(filename, invalid);
+        return;
     }
 
     file.close(); // Close the file
+    reportInvalidLines(filename, invalid);
     std::cout << "Loaded categories from " << filename << std::endl; // Print confirmation message
 }
 
+/**
+ * @brief Adds a lazily loaded category for every header of a file.
+ * The file is read in large blocks and scanned byte by byte for lines whose first non-space character
+ * is '#'. Only header lines are copied; a category's range runs from the line after its header to the
+ * start of the next header line, so it holds exactly the lines loadFromFile would insert into it.
+ * @param filename The path to the file to scan.
+ */
+void WordCatVec::loadDirectory(const char* filename) {
+    std::ifstream file(filename, std::ios::binary); // Binary, so that offsets are exact byte positions
+    if (!file) { // Check if the file was opened successfully
+        std::cerr << "Error opening file: " << filename << std::endl; // Print error message if file cannot be opened
+        return; // Exit the function
+    }
+
+    auto path = std::make_shared<const std::string>(filename); // Shared by every category of the file
+    const size_t BLOCK_SIZE = 1 << 16; // Bytes read at a time
+    std::vector<char> block(BLOCK_SIZE); // Freed however the scan ends
+
+    std::string header; // Text of the header line being read, after the '#'
+    bool in_header = false; // The current line is a header
+    bool leading = true; // Only whitespace seen so far on the current line
+    std::streamoff position = 0; // File offset of block[0]
+    std::streamoff line_start = 0; // File offset of the current line
+    std::streamoff body_start = -1; // File offset of the current category's first line; -1 before the first header
+    Word name; // Name of the current category
+    size_t size_before = size; // To count the categories opened
+
+    auto finishCategory = [&](std::streamoff body_end) { // Add the current category, whose lines end at body_end
+        if (body_start >= 0) addCategory(WordCat(name, WordCat::FileRange{ path, body_start, body_end - body_start }));
+    };
+    auto startCategory = [&](std::streamoff start) { // The header line just read starts a new category
+        finishCategory(line_start); // The previous category ends where the header line starts
+        header.push_back('\0');
+        trim(&header[0]); // Trim spaces from the category name
+        name = Word(header.c_str());
+        body_start = start;
+    };
+
+    while (file.read(block.data(), BLOCK_SIZE) || file.gcount() > 0) {
+        size_t count = static_cast<size_t>(file.gcount()); // Bytes in this block
+        for (size_t i = 0; i < count; ++i) {
+            char c = block[i];
+            if (c == '\n') { // End of line
+                if (in_header) startCategory(position + static_cast<std::streamoff>(i) + 1);
+                in_header = false;
+                leading = true;
+                header.clear();
+                line_start = position + static_cast<std::streamoff>(i) + 1;
+            } else if (in_header) {
+                header.push_back(c); // Collect the header text
+            } else if (leading && !isspace(static_cast<unsigned char>(c))) {
+                in_header = c == '#'; // The first visible character decides whether this is a header
+                leading = false;
+            }
+        }
+        position += static_cast<std::streamoff>(count);
+    }
+
+    if (in_header) startCategory(position); // A header on the last line, without a newline
+    finishCategory(position); // The last category runs to the end of the file
+
+    file.close(); // Close the file
+    std::cout << "Opened " << size - size_before << " categories from " << filename << "; their words load on first use" << std::endl;
+}
+
+/**
+ * @brief Brings the categories in line with a file that was loaded before and has since changed.
+ * Lines are read and trimmed exactly as in loadFromFile. The words of each category are gathered,
+ * sorted once, and handed to WordCat::syncWords; categories whose header does not appear are removed
+ * at the end, and a repeated header is ignored, as loadFromFile does.
+ * @param filename The path to the file to reload from.
+ * @return False if the file could not be opened, or the memory budget ran out part of the way.
+ */
+bool WordCatVec::reloadFromFile(const char* filename) {
+    MemoryAccount::Scope scope(memory()); // Everything loaded is charged to this vocabulary
+    std::ifstream file(filename); // Open the file for reading
+    if (!file) { // Check if the file was opened successfully
+        std::cerr << "Error opening file: " << filename << std::endl; // Print error message if file cannot be opened
+        return false; // Nothing changes
+    }
+
+    size_t original_size = size; // Categories present before the reload
+    bool* seen = new bool[original_size](); // seen[i] is set once category i's header is read
+    size_t words_added{ 0 }, words_removed{ 0 }, categories_added{ 0 }, categories_removed{ 0 };
+
+    Word name; // Name of the category being read
+    bool in_category = false; // A header has been read
+    WordList incoming; // Words of the category being read, in file order
+    size_t invalid{ 0 }; // Word lines that are not valid UTF-8
+
+    auto finishCategory = [&]() { // Diff the category just read against the current one
+        if (!in_category) return;
+
+        size_t count = incoming.length();
+        Word* words = new Word[count]; // The words as an array, for sorting
+        for (size_t i = 0; i < count; ++i) words[i] = incoming.pop_front();
+        size_t* order = WordList::sortedOrder(words, count); // Sort once for the merge
+
+        size_t added{ 0 }, removed{ 0 };
+        try {
+            size_t position = *indexSlot(name); // Position + 1 of the category, or 0 if absent
+            if (position == 0) { // A new category
+                WordCat created(name);
+                created.syncWords(words, count, order, added, removed);
+                addCategory(std::move(created));
+                categories_added++;
+            } else if (position <= original_size && !seen[position - 1]) { // An existing category, first time in this file
+                seen[position - 1] = true;
+                word_category_array[position - 1].syncWords(words, count, order, added, removed);
+            } // Otherwise the header is repeated and loadFromFile would ignore it too
+        } catch (...) {
+            delete[] order;
+            delete[] words;
+            throw;
+        }
+        words_added += added;
+        words_removed += removed;
+
+        delete[] order;
+        delete[] words;
+    };
+
+    LineReader lines(file); // Hands out each line in place, however long
+    try {
+        while (char* line = lines.next()) { // Read each line from the file
+            trim(line); // Trim leading and trailing spaces from the line
+
+            if (line[0] == '#') { // Check if the line indicates a new category
+                finishCategory(); // Apply the previous category
+                char* categoryName = line + 1; // Skip the '#' character to get the category name
+                trim(categoryName); // Trim spaces from the category name
+                name = Word(categoryName);
+                in_category = true;
+            } else if (in_category && line[0] != '\0') { // Check if line is not empty and there's an active category
+                Word word(line);
+                if (word.isValidUtf8()) incoming.push_back(std::move(word)); // Collect the word
+                else invalid++;
+            }
+        }
+        finishCategory(); // Apply the final category
+    } catch (const MemoryBudgetExceeded&) { // Stop at once; no category is removed, since the rest of the file was not read
+        delete[] seen;
+        std::cerr << "Memory budget exceeded reloading " << filename << "; the categories reloaded so far are kept" << std::endl;
+        reportInvalidLines(filename, invalid);
+        return false;
+    }
+    file.close(); // Close the file
+    reportInvalidLines(filename, invalid);
+
+    for (size_t i = original_size; i-- > 0;) { // Remove the categories the file no longer has, last first
+        if (!seen[i]) {
+            Word gone = word_category_array[i].getCategoryName(); // Copy: the name goes away with the category
+            removeCategory(gone);
+            categories_removed++;
+        }
+    }
+    delete[] seen;
+
+    std::cout << "Reloaded " << filename << ": " << words_added << " words added, " << words_removed << " removed; "
+              << categories_added << " categories added, " << categories_removed << " removed" << std::endl;
+    return true;
+}
+
 /**
  * @brief Saves categories and words to a file.
  * @param filename The name of the file to save to.
@@ -573,7 +2148,7 @@ void WordCatVec::saveToFile(const char* filename) const {
 
     for (size_t i = 0; i < size; ++i) {
         file << "#" << word_category_array[i].getCategoryName() << "\n";
-        word_category_array[i].getWordList().print(file, 5); // Print up to 5 words per line
+        word_category_array[i].printWords(file, 5); // Print up to 5 words per line, whatever the storage mode
         file << "\n"; // Adding a new line after each category for better readability
     }
 
@@ -581,12 +2156,473 @@ void WordCatVec::saveToFile(const char* filename) const {
     std::cout << "Saved categories to " << filename << std::endl;
 }
 
+/**
+ * @brief Saves categories and words to a compressed binary file.
+ * The file starts with COMPRESSED_MAGIC and the number of categories; each category follows as
+ * written by WordCat::writeCompressed.
+ * @param filename The name of the file to save to.
+ */
+void WordCatVec::saveCompressed(const char* filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return;
+    }
+
+    file.write(COMPRESSED_MAGIC, sizeof COMPRESSED_MAGIC);
+    uint64_t count = size;
+    file.write(reinterpret_cast<const char*>(&count), sizeof count);
+    for (size_t i = 0; i < size; ++i) {
+        word_category_array[i].writeCompressed(file);
+    }
+
+    file.close();
+    std::cout << "Saved categories to " << filename << " (compressed)" << std::endl;
+}
+
+/**
+ * @brief Loads categories from a file written by saveCompressed. The categories stay in Compressed mode.
+ Reading stops at the first damaged category, including one holding words that are not valid UTF-8;
+ * the categories read before it are kept.
+ * @param filename The path to the file to load from.
+ */
+void WordCatVec::loadCompressed(const char* filename) {
+    MemoryAccount::Scope scope(memory()); // Everything loaded is charged to this vocabulary
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return;
+    }
+
+    char magic[sizeof COMPRESSED_MAGIC];
+    uint64_t count{ 0 };
+    if (!file.read(magic, sizeof magic) || std::memcmp(magic, COMPRESSED_MAGIC, sizeof magic) != 0 ||
+        !file.read(reinterpret_cast<char*>(&count), sizeof count)) {
+        std::cerr << filename << " is not a compressed vocabulary file" << std::endl;
+        return;
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t name_length{ 0 };
+        if (!file.read(reinterpret_cast<char*>(&name_length), sizeof name_length) || name_length > UINT32_MAX) {
+            std::cerr << "Damaged category header in " << filename << std::endl;
+            return;
+        }
+        char* name = new char[name_length + 1];
+        bool name_read = static_cast<bool>(file.read(name, static_cast<std::streamsize>(name_length)));
+        name[name_length] = '\0';
+
+        FrontCodedList words;
+        bool valid = name_read && words.read(file);
+        if (valid) words.forEach([&valid](const Word& word) { valid = valid && word.isValidUtf8(); }); // saveCompressed writes only words insertWord took
+        if (!valid) {
+            std::cerr << "Damaged category in " << filename << std::endl;
+            delete[] name;
+            return;
+        }
+        try {
+            addCategory(WordCat(Word(name), std::move(words))); // Duplicates are rejected as in loadFromFile
+        } catch (const MemoryBudgetExceeded&) {
+            std::cerr << "Memory budget exceeded loading " << filename << "; the categories loaded so far are kept" << std::endl;
+            delete[] name;
+            return;
+        }
+        delete[] name;
+    }
+
+    file.close();
+    std::cout << "Loaded categories from " << filename << " (compressed)" << std::endl;
+}
+
 /**
  * @brief Clears all categories from the array.
+ * The new storage and index are allocated first, so that if the memory budget refuses them nothing is cleared.
  */
 void WordCatVec::clearCategories() {
-    delete[] word_category_array;
-    word_category_array = new WordCat[1];
+    size_t table_capacity = indexCapacityFor(0);
+    WordCat* storage = allocateStorage(1);
+    size_t* table;
+    try {
+        table = allocateIndex(table_capacity);
+    } catch (...) {
+        releaseStorage(storage, 0, 1);
+        throw;
+    }
+    releaseStorage(word_category_array, size, capacity);
+    word_category_array = storage;
     capacity = 1;
     size = 0;
+    installIndex(table, table_capacity);
+}
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of some bytes, as Word::hash does for a word. Checksums log records.
+ * @param bytes The bytes to hash.
+ * @param length The number of bytes.
+ * @return The hash.
+ */
+static uint64_t checksum(const char* bytes, size_t length) {
+    uint64_t h = 14695981039346656037ULL; // FNV-1a offset basis
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<unsigned char>(bytes[i]); // Mix in the next byte
+        h *= 1099511628211ULL; // Multiply by the FNV prime
+    }
+    return h;
+}
+
+/**
+ * @brief Appends a fixed-size integer to a log record, in the machine's byte order as saveCompressed does.
+ * @param record The record being built.
+ * @param value The value to append.
+ */
+template <typename T>
+static void appendInteger(std::string& record, T value) {
+    record.append(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+/**
+ * @brief Appends a log record to a file and waits until it is on disk.
+ * @param filename The path to the log; created if missing.
+ * @param record The bytes to append.
+ * @return True if the whole record was written and flushed.
+ */
+static bool appendDurably(const char* filename, const std::string& record) {
+#ifdef __linux__
+    int fd = ::open(filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    size_t written = 0;
+    while (written < record.size()) { // write may stop short
+        ssize_t n = ::write(fd, record.data() + written, record.size() - written);
+        if (n < 0) {
+            ::close(fd);
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    bool synced = ::fsync(fd) == 0; // The commit must not get ahead of the disk
+    return ::close(fd) == 0 && synced;
+#else
+    std::ofstream file(filename, std::ios::binary | std::ios::app);
+    file.write(record.data(), static_cast<std::streamsize>(record.size()));
+    file.flush(); // Without fsync this only reaches the operating system
+    return static_cast<bool>(file);
+#endif
+}
+
+/**
+ * @brief What a transaction does to one category.
+ */
+struct CategoryPlan {
+    size_t position; // Position + 1 of the category before the commit, or 0 if it does not exist yet
+    bool drop; // The existing category goes away (removed, or removed and added again)
+    bool append; // 'category' is added at the end
+    bool replace; // 'category' replaces the existing one in place
+    size_t added_at; // Staging index of the change that added the category, to append in staging order
+    WordCat category; // The new contents, when append or replace
+};
+
+/**
+ * @brief Constructor. Starts an empty transaction on a vocabulary.
+ * @param target The vocabulary to commit to.
+ */
+WordCatVec::Transaction::Transaction(WordCatVec& target) : target(target) {}
+
+/**
+ * @brief Stages adding an empty category.
+ * @param category The name of the category.
+ */
+void WordCatVec::Transaction::addCategory(const Word& category) {
+    changes.push_back(Change{ Operation::AddCategory, category, Word() });
+}
+
+/**
+ * @brief Stages removing a category.
+ * @param category The name of the category.
+ */
+void WordCatVec::Transaction::removeCategory(const Word& category) {
+    changes.push_back(Change{ Operation::RemoveCategory, category, Word() });
+}
+
+/**
+ * @brief Stages inserting a word.
+ * @param category The name of the category.
+ * @param word The word to insert.
+ */
+void WordCatVec::Transaction::insertWord(const Word& category, const Word& word) {
+    changes.push_back(Change{ Operation::InsertWord, category, word });
+}
+
+/**
+ * @brief Stages removing a word.
+ * @param category The name of the category.
+ * @param word The word to remove.
+ */
+void WordCatVec::Transaction::removeWord(const Word& category, const Word& word) {
+    changes.push_back(Change{ Operation::RemoveWord, category, word });
+}
+
+/**
+ * @brief Returns the number of staged changes.
+ * @return The number of changes.
+ */
+size_t WordCatVec::Transaction::length() const {
+    return changes.size();
+}
+
+/**
+ * @brief Discards the staged changes.
+ */
+void WordCatVec::Transaction::rollback() {
+    changes.clear();
+}
+
+/**
+ * @brief Encodes the staged changes as one log record.
+ * @return The record.
+ */
+std::string WordCatVec::Transaction::encode() const {
+    std::string payload;
+    for (const Change& change : changes) {
+        payload.push_back(static_cast<char>(change.operation));
+        appendInteger(payload, static_cast<uint32_t>(change.category.length()));
+        payload.append(change.category.c_str(), change.category.length());
+        appendInteger(payload, static_cast<uint32_t>(change.word.length()));
+        payload.append(change.word.c_str(), change.word.length());
+    }
+
+    std::string record(TRANSACTION_MAGIC, sizeof TRANSACTION_MAGIC);
+    appendInteger(record, static_cast<uint64_t>(changes.size()));
+    appendInteger(record, static_cast<uint64_t>(payload.size()));
+    record += payload;
+    appendInteger(record, checksum(payload.data(), payload.size()));
+    return record;
+}
+
+/**
+ * @brief Applies the staged changes, all of them or none.
+ * First every category's changes are checked and reduced to a plan, building its new contents off to the
+ * side; then the new storage and name index are allocated and the record is logged. Only then is the
+ * vocabulary changed, with noexcept moves, so a failure or an exception at any earlier point leaves it as it was.
+ * @param log_filename The log to append to, or nullptr not to log.
+ * @return True if the changes were applied.
+ */
+bool WordCatVec::Transaction::commit(const char* log_filename) {
+    if (changes.empty()) return true; // Nothing to do
+    MemoryAccount::Scope scope(target.memory()); // The new categories, words and index are charged to the target
+
+    std::vector<size_t> order(changes.size()); // Staging indices grouped by category, in staging order within each
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return changes[a].category.isLess(changes[b].category);
+    });
+
+    std::vector<CategoryPlan> plans;
+    std::vector<size_t> word_changes; // Staging indices of the word changes of one category that still count
+    std::vector<Word> inserts; // Net insertions of one category, in order
+    std::vector<Word> removes; // Net removals of one category, in order
+    size_t dropped{ 0 }, appended{ 0 };
+
+    for (size_t begin = 0, end; begin < order.size(); begin = end) { // One group of changes per category
+        const Word& name = changes[order[begin]].category;
+        for (end = begin + 1; end < order.size() && changes[order[end]].category == name; ++end) {}
+
+        const WordCat* current = target.search(name);
+        size_t position = current != nullptr ? static_cast<size_t>(current - target.word_category_array) + 1 : 0;
+        bool exists = current != nullptr; // Whether the category exists at this point of the transaction
+        bool fresh = false; // Whether it was removed or added since, so its old words are gone
+        size_t added_at{ 0 };
+        word_changes.clear();
+
+        for (size_t k = begin; k < end; ++k) { // Replay the category's changes in staging order
+            switch (changes[order[k]].operation) {
+                case Operation::AddCategory:
+                    if (exists) return false; // As addCategory would refuse
+                    exists = fresh = true;
+                    added_at = order[k];
+                    word_changes.clear();
+                    break;
+                case Operation::RemoveCategory:
+                    if (!exists) return false;
+                    exists = false;
+                    fresh = true;
+                    word_changes.clear(); // The words go with the category
+                    break;
+                default: // InsertWord or RemoveWord
+                    if (!exists) return false;
+                    word_changes.push_back(order[k]);
+                    break;
+            }
+        }
+
+        // The last change to each word decides whether the category has it
+        std::stable_sort(word_changes.begin(), word_changes.end(), [this](size_t a, size_t b) {
+            return changes[a].word.isLess(changes[b].word);
+        });
+        inserts.clear();
+        removes.clear();
+        for (size_t k = 0; k < word_changes.size(); ++k) {
+            if (k + 1 < word_changes.size() && changes[word_changes[k + 1]].word == changes[word_changes[k]].word) continue; // Overridden
+            const Change& last = changes[word_changes[k]];
+            (last.operation == Operation::InsertWord ? inserts : removes).push_back(last.word);
+        }
+
+        CategoryPlan plan{ position, position != 0 && fresh, exists && fresh, false, added_at, WordCat() };
+        if (exists) {
+            size_t added{ 0 }, removed{ 0 };
+            if (fresh) { // Starts empty, like a category added with addCategory
+                plan.category = WordCat(name).withChanges(inserts.data(), inserts.size(), nullptr, 0, added, removed);
+            } else {
+                plan.category = current->withChanges(inserts.data(), inserts.size(), removes.data(), removes.size(), added, removed);
+            }
+            plan.replace = !fresh && added + removed > 0; // An unchanged category keeps its storage and stamp
+        }
+        if (plan.drop || plan.append || plan.replace) {
+            dropped += plan.drop;
+            appended += plan.append;
+            plans.push_back(std::move(plan));
+        }
+    }
+
+    // Allocate everything the installation needs, so that it cannot fail once the record is logged
+    size_t new_size = target.size - dropped + appended;
+    bool restructure = dropped + appended > 0; // Categories come or go: build a new array and index
+    size_t new_capacity = target.capacity;
+    while (new_capacity < new_size) new_capacity = new_capacity == 0 ? 1 : new_capacity * 2; // Grow as addCategory does
+    while (new_capacity > 1 && new_size <= new_capacity / SHRINK_FACTOR) new_capacity /= 2; // Shrink as removeCategory does
+    WordCat* storage = restructure ? target.allocateStorage(new_capacity) : nullptr;
+    size_t table_capacity = indexCapacityFor(new_size);
+    size_t* table = nullptr;
+    std::vector<WordCat*> replacements; // New contents of each existing category, or nullptr to keep or drop it
+    std::vector<bool> gone;
+    std::vector<CategoryPlan*> appends; // Categories to add, in staging order
+    try {
+        if (restructure) {
+            table = target.allocateIndex(table_capacity);
+            replacements.assign(target.size, nullptr);
+            gone.assign(target.size, false);
+            for (CategoryPlan& plan : plans) {
+                if (plan.drop) gone[plan.position - 1] = true;
+                if (plan.replace) replacements[plan.position - 1] = &plan.category;
+                if (plan.append) appends.push_back(&plan);
+            }
+            std::sort(appends.begin(), appends.end(), [](const CategoryPlan* a, const CategoryPlan* b) {
+                return a->added_at < b->added_at;
+            });
+        }
+        if (log_filename != nullptr && !appendDurably(log_filename, encode())) {
+            std::cerr << "Error writing transaction log: " << log_filename << std::endl;
+            releaseStorage(storage, 0, new_capacity);
+            releaseIndex(table, table_capacity);
+            return false;
+        }
+    } catch (...) {
+        releaseStorage(storage, 0, new_capacity); // Nothing was constructed in it
+        releaseIndex(table, table_capacity);
+        throw;
+    }
+
+    // Install: only moves from here on
+    if (!restructure) { // Same categories at the same positions: swap the changed ones in
+        for (CategoryPlan& plan : plans) {
+            target.word_category_array[plan.position - 1] = std::move(plan.category);
+        }
+    } else {
+        size_t n = 0;
+        for (size_t i = 0; i < target.size; ++i) { // The categories that stay, in order
+            if (gone[i]) continue;
+            new (&storage[n++]) WordCat(std::move(replacements[i] != nullptr ? *replacements[i] : target.word_category_array[i]));
+        }
+        for (CategoryPlan* plan : appends) { // Then the added ones
+            new (&storage[n++]) WordCat(std::move(plan->category));
+        }
+        releaseStorage(target.word_category_array, target.size, target.capacity); // Destroy the moved-from and dropped categories
+        target.word_category_array = storage;
+        target.capacity = new_capacity;
+        target.size = n;
+        target.installIndex(table, table_capacity);
+    }
+
+    changes.clear();
+    return true;
+}
+
+/**
+ * @brief Applies the transactions recorded in a log, in order, stopping at the first damaged record.
+ * @param filename The path to the log.
+ * @return The number of transactions applied.
+ */
+size_t WordCatVec::replayLog(const char* filename) {
+    MemoryAccount::Scope scope(memory()); // The replayed words are charged to this vocabulary
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return 0;
+    }
+
+    size_t applied{ 0 };
+    std::string payload;
+    char magic[sizeof TRANSACTION_MAGIC];
+    uint64_t count{ 0 }, length{ 0 }, sum{ 0 };
+    while (file.read(magic, sizeof magic)) {
+        if (std::memcmp(magic, TRANSACTION_MAGIC, sizeof magic) != 0 ||
+            !file.read(reinterpret_cast<char*>(&count), sizeof count) ||
+            !file.read(reinterpret_cast<char*>(&length), sizeof length) || length > UINT32_MAX) {
+            std::cerr << "Replay stopped at a damaged or incomplete record in " << filename << std::endl;
+            break;
+        }
+        payload.resize(static_cast<size_t>(length));
+        if (!file.read(&payload[0], static_cast<std::streamsize>(length)) ||
+            !file.read(reinterpret_cast<char*>(&sum), sizeof sum) || sum != checksum(payload.data(), payload.size())) {
+            std::cerr << "Replay stopped at a damaged or incomplete record in " << filename << std::endl; // Torn by a crash
+            break;
+        }
+
+        Transaction transaction(*this);
+        size_t at = 0; // Read position in the payload
+        auto readText = [&](std::string& text) { // A length-prefixed string
+            uint32_t text_length{ 0 };
+            if (payload.size() - at < sizeof text_length) return false;
+            std::memcpy(&text_length, payload.data() + at, sizeof text_length);
+            at += sizeof text_length;
+            if (payload.size() - at < text_length) return false;
+            text.assign(payload.data() + at, text_length);
+            at += text_length;
+            return true;
+        };
+        std::string category, word;
+        bool intact = true;
+        try {
+            for (uint64_t i = 0; intact && i < count; ++i) {
+                if (at == payload.size()) {
+                    intact = false;
+                    break;
+                }
+                Transaction::Operation operation = static_cast<Transaction::Operation>(payload[at++]);
+                if (!readText(category) || !readText(word)) {
+                    intact = false;
+                    break;
+                }
+                switch (operation) {
+                    case Transaction::Operation::AddCategory: transaction.addCategory(Word(category.c_str())); break;
+                    case Transaction::Operation::RemoveCategory: transaction.removeCategory(Word(category.c_str())); break;
+                    case Transaction::Operation::InsertWord: transaction.insertWord(Word(category.c_str()), Word(word.c_str())); break;
+                    case Transaction::Operation::RemoveWord: transaction.removeWord(Word(category.c_str()), Word(word.c_str())); break;
+                    default: intact = false; break;
+                }
+            }
+            intact = intact && at == payload.size() && transaction.commit();
+        } catch (const MemoryBudgetExceeded&) { // The commit changed nothing
+            std::cerr << "Transaction " << applied + 1 << " in " << filename << " exceeds the memory budget; replay stopped" << std::endl;
+            break;
+        }
+        if (!intact) {
+            std::cerr << "Transaction " << applied + 1 << " in " << filename << " does not apply; replay stopped" << std::endl;
+            break;
+        }
+        applied++;
+    }
+
+    file.close();
+    std::cout << "Replayed " << applied << " transactions from " << filename << std::endl;
+    return applied;
 }
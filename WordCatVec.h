@@ -3,6 +3,12 @@
 #define WORDCATVEC_H_
 
 #include "WordCat.h"
+#include "QueryCache.h"
+#include "EditHistory.h"
+#include "MemoryAccount.h"
+#include <memory>
+#include <string>
+#include <vector>
 
 /**
  * @class WordCatVec
@@ -10,10 +16,159 @@
  */
 class WordCatVec {
 private:
-    WordCat* word_category_array; // A pointer to the dynamic array of WordCat objects
+    mutable MemoryAccount* account; // Counts the memory of this vocabulary and enforces its budget; nullptr once moved from
+    WordCat* word_category_array; // A pointer to uninitialized storage; only the first 'size' slots hold constructed WordCat objects
     size_t capacity; // The capacity of the dynamic array
     size_t size; // The current size of the dynamic array
 
+    size_t* name_index; // Open-addressing hash table mapping category names to array positions (position + 1, 0 marks an empty slot)
+    size_t index_capacity; // The number of slots in name_index (always a power of two)
+
+    mutable QueryCache query_cache; // Results of recent searches over all categories, valid while the category versions match
+    std::unique_ptr<EditHistory> history; // Undo/redo steps of the edits made through the menu; created on the first edit
+
+    static constexpr size_t SHRINK_FACTOR = 4; // The array shrinks to half its capacity only once it is at most a quarter full
+    static constexpr char COMPRESSED_MAGIC[8] = { 'W', 'W', 'F', 'C', 'O', 'D', 'E', '1' }; // First bytes of a compressed vocabulary file
+    static constexpr char TRANSACTION_MAGIC[4] = { 'W', 'W', 'T', 'X' }; // First bytes of each transaction record in a log
+
+    /**
+     * @brief Returns the memory account, creating a new one if this object was moved from.
+     * @return The account
+     */
+    MemoryAccount& memory() const;
+
+    /**
+     * @brief Allocates raw storage for the given number of WordCat objects without constructing them.
+     * The storage is charged to the memory account.
+     * @param count The number of WordCat slots to allocate
+     * @return A pointer to the uninitialized storage
+     * @throws MemoryBudgetExceeded if the storage would take the account over its budget.
+     */
+    WordCat* allocateStorage(size_t count);
+
+    /**
+     * @brief Destroys the first 'count' WordCat objects in the storage and releases it.
+     * @param storage The storage to release
+     * @param count The number of constructed objects at the start of the storage
+     * @param slots The number of slots it was allocated with
+     */
+    static void releaseStorage(WordCat* storage, size_t count, size_t slots);
+
+    /**
+     * @brief Allocates a zeroed name index table, charged to the memory account.
+     * @param table_capacity The number of slots
+     * @return The table
+     */
+    size_t* allocateIndex(size_t table_capacity);
+
+    /**
+     * @brief Frees a table allocated by allocateIndex.
+     * @param table The table, or nullptr
+     * @param table_capacity The number of slots it was allocated with
+     */
+    static void releaseIndex(size_t* table, size_t table_capacity);
+
+    /**
+     * @brief Moves the constructed categories into new storage of the given capacity. No word data is copied.
+     * @param new_capacity The new capacity, which must be at least size
+     */
+    void reallocate(size_t new_capacity);
+
+    /**
+     * @brief Finds the name_index slot holding the given category name, or the empty slot where it would be inserted.
+     * @param category The category name to look for
+     * @return A pointer into name_index
+     */
+    size_t* indexSlot(const Word& category) const;
+
+    /**
+     * @brief Removes the name_index entry of the category at the given position, keeping the probe sequences intact.
+     * @param position The array position of the category whose entry is removed
+     */
+    void indexErase(size_t position);
+
+    /**
+     * @brief Rebuilds name_index from scratch with room for the current categories.
+     */
+    void rebuildIndex();
+
+    /**
+     * @brief Returns the name_index size for a number of categories.
+     * @param count The number of categories
+     * @return A power of two at least 8 and at least twice count
+     */
+    static size_t indexCapacityFor(size_t count);
+
+    /**
+     * @brief Replaces name_index with a zeroed table and indexes the current categories in it. Never allocates.
+     * @param table A table from allocateIndex, which this object takes ownership of
+     * @param table_capacity Its number of slots, a power of two larger than size
+     */
+    void installIndex(size_t* table, size_t table_capacity) noexcept;
+
+    /**
+     * @brief Looks a word up in every category, in parallel on the shared thread pool.
+     * @param word The word to look up
+     * @param found Array of size elements; found[i] is set to whether category i has the word
+     */
+    void lookupInAll(const Word& word, bool* found) const;
+
+    /**
+     * @brief Collects the words starting with a letter from every category, in parallel on the shared thread pool.
+     * @param letter The first letter of the words to collect
+     * @param results Array of size lists; results[i] receives the matching words of category i
+     */
+    void collectStartingWith(const char letter, WordList* results) const;
+
+    /**
+     * @brief Fills an array with the version stamp of every category (see WordCat::getVersion).
+     * @param versions Array of size elements
+     */
+    void collectVersions(uint64_t* versions) const;
+
+    /**
+     * @brief Looks a word up in every category, reusing the result of an earlier identical search if no
+     * category has changed since. A reused result still counts a hit in every category that has the word.
+     * @param word The word to look up
+     * @return The result; found[i] tells whether category i has the word
+     */
+    std::shared_ptr<const QueryCache::Result> cachedLookup(const Word& word) const;
+
+    /**
+     * @brief Collects the words starting with a letter from every category, reusing the result of an
+     * earlier identical search if no category has changed since.
+     * @param letter The first letter of the words to collect
+     * @return The result; lists[i] holds the matching words of category i
+     */
+    std::shared_ptr<const QueryCache::Result> cachedStartingWith(const char letter) const;
+
+    /**
+     * @brief Returns the edit history, creating it with the default budget on first use.
+     * @return The history
+     */
+    EditHistory& editHistory();
+
+    /**
+     * @brief Records the same delta for every word of a category, in the open step of the edit history.
+     * @param category The category
+     * @param operation EditHistory::Operation::InsertWord or EditHistory::Operation::RemoveWord
+     */
+    void recordWords(const WordCat& category, EditHistory::Operation operation);
+
+    /**
+     * @brief Records the differences between two states of a category, in the open step of the edit history.
+     * A renamed category is recorded as the old one removed and the new one added.
+     * @param before The category before the edit
+     * @param after The category after the edit
+     */
+    void recordChanges(const WordCat& before, const WordCat& after);
+
+    /**
+     * @brief Adds a lazily loaded category for every header of a file (see loadFromFile).
+     * @param filename The path to the file to scan
+     */
+    void loadDirectory(const char* filename);
+
     /**
      * @brief Displays a menu to the user and returns the user's choice.
      * @return The user's choice as an integer
@@ -27,7 +182,7 @@ private:
     void perform(const int choice);
 
     /**
-     * @brief Searches for a category in the array.
+     * @brief Searches for a category in the array. Runs in expected constant time using name_index.
      * @param category The category to search for
      * @return A pointer to the found category, or nullptr if the category was not found
      */
@@ -36,10 +191,148 @@ private:
 public:
 
     /**
-     * @brief Default constructor. Initializes word_category_array to a new array with capacity 1, and sets capacity to 1 and size to 0.
+     * @brief How much two categories overlap.
+     */
+    struct Similarity {
+        Word first; ///< The name of one category
+        Word second; ///< The name of the other
+        double jaccard; ///< Words in both over words in either, |A ∩ B| / |A ∪ B|
+        double overlap; ///< Words in both over the words of the smaller category, |A ∩ B| / min(|A|, |B|)
+    };
+
+    /**
+     * @brief How many words are in more than one category, and what their copies cost.
+     */
+    struct DuplicateReport {
+        size_t categories; ///< Categories scanned
+        size_t words; ///< Words over all categories; a word repeated within one category counts once
+        size_t distinct; ///< Different words
+        size_t duplicated; ///< Different words that are in more than one category
+        size_t copies; ///< Copies beyond the first of each word: words - distinct
+        size_t copy_bytes; ///< Heap bytes those copies need when each has its own buffer
+        size_t saved_bytes; ///< Heap bytes freed by compactDuplicates; 0 for an analysis
+    };
+
+    /**
+     * @class Transaction
+     * @brief A batch of changes to a WordCatVec that is applied all at once or not at all.
+     *
+     * Changes are only staged until commit(). The commit groups them by category, keeping each category's
+     * changes in the order they were staged, and reduces each group to its net effect: the last change to a
+     * word wins, and removing a category drops the changes staged for it before. Each changed category is then
+     * rebuilt with one merge pass (see WordCat::withChanges) instead of one insertWord or removeWord per word.
+     *
+     * Everything that can fail happens before the vocabulary is touched: checking that every change applies,
+     * building the new categories and storage, and appending the batch to the log. The new categories are then
+     * installed with moves that cannot fail, so the vocabulary holds either all of the changes or none of them.
+     * Readers on other threads must still not use the vocabulary during the commit; to serve them, commit on a
+     * copy and publish it, as VocabularyWatcher does for reloads.
+     */
+    class Transaction {
+    public:
+        /**
+         * @brief The changes a transaction can stage.
+         */
+        enum class Operation : char {
+            AddCategory = 'C', ///< Add an empty category
+            RemoveCategory = 'c', ///< Remove a category and its words
+            InsertWord = 'W', ///< Insert a word into a category
+            RemoveWord = 'w' ///< Remove a word from a category
+        };
+
+    private:
+        /**
+         * @brief One staged change.
+         */
+        struct Change {
+            Operation operation; ///< What to do
+            Word category; ///< The category it applies to
+            Word word; ///< The word, for InsertWord and RemoveWord
+        };
+
+        WordCatVec& target; ///< The vocabulary the changes are committed to
+        std::vector<Change> changes; ///< The staged changes, in staging order
+
+        /**
+         * @brief Encodes the staged changes as one log record: TRANSACTION_MAGIC, the number of changes, the
+         * payload length, the payload (operation byte, then length-prefixed category and word per change) and
+         * a 64-bit FNV-1a checksum of the payload.
+         * @return The record
+         */
+        std::string encode() const;
+
+    public:
+        /**
+         * @brief Constructor. Starts an empty transaction on a vocabulary.
+         * @param target The vocabulary to commit to; it must outlive the transaction
+         */
+        explicit Transaction(WordCatVec& target);
+
+        Transaction(const Transaction& other) = delete;
+        Transaction& operator=(const Transaction& other) = delete;
+
+        /**
+         * @brief Stages adding an empty category. The commit fails if the category exists at that point.
+         * @param category The name of the category
+         */
+        void addCategory(const Word& category);
+
+        /**
+         * @brief Stages removing a category. The commit fails if the category does not exist at that point.
+         * @param category The name of the category
+         */
+        void removeCategory(const Word& category);
+
+        /**
+         * @brief Stages inserting a word. Inserting a word the category has is not an error.
+         * The commit fails if the category does not exist at that point.
+         * @param category The name of the category
+         * @param word The word to insert
+         */
+        void insertWord(const Word& category, const Word& word);
+
+        /**
+         * @brief Stages removing a word. Removing a word the category does not have is not an error.
+         * The commit fails if the category does not exist at that point.
+         * @param category The name of the category
+         * @param word The word to remove
+         */
+        void removeWord(const Word& category, const Word& word);
+
+        /**
+         * @brief Returns the number of staged changes.
+         * @return The number of changes
+         */
+        size_t length() const;
+
+        /**
+         * @brief Discards the staged changes. The vocabulary is not touched.
+         */
+        void rollback();
+
+        /**
+         * @brief Applies the staged changes, all of them or none, and clears them on success.
+         * With a log file, the changes are appended to it as one record and flushed to disk before they are
+         * installed, so a record in the log is exactly a transaction that was committed (see replayLog).
+         * @param log_filename The log to append to, or nullptr not to log
+         * @return true if the changes were applied; false if one of them does not apply or the log could not
+         *         be written, in which case the vocabulary and the staged changes are unchanged
+         */
+        bool commit(const char* log_filename = nullptr);
+    };
+
+    /**
+     * @brief Default constructor. Initializes word_category_array to uninitialized storage with capacity 1, and sets capacity to 1 and size to 0.
      */
     WordCatVec();
 
+    /**
+     * @brief Constructor. Allocates the vocabulary's memory from the given allocator, within a budget.
+     * @param allocator Where the memory comes from; it must outlive the object and every category taken from it
+     * @param budget The most bytes the vocabulary may hold (see setMemoryBudget)
+     */
+    explicit WordCatVec(Allocator& allocator, size_t budget = MemoryAccount::UNLIMITED);
+
     /**
      * @brief Destructor. Deallocates the memory reserved by word_category_array and sets capacity and size to 0.
      */
@@ -79,18 +372,27 @@ public:
     void run();
 
     /**
-     * @brief Adds a new category to the array. If the array is full, it is resized.
+     * @brief Adds a copy of a category to the array. If the array is full, its capacity is doubled.
      * @param new_category The new category to add
      * @return true if the category was added successfully, false otherwise
      */
     bool addCategory(const WordCat& new_category);
 
     /**
-     * @brief Removes a category from the array. If the array is less than half full after the removal, it is resized.
+     * @brief Adds a category to the array by moving it in. If the array is full, its capacity is doubled.
+     * @param new_category The new category to add
+     * @return true if the category was added successfully, false otherwise (new_category is left untouched)
+     */
+    bool addCategory(WordCat&& new_category);
+
+    /**
+     * @brief Removes a category from the array. If the array is at most a quarter full after the removal, its capacity is halved.
      * @param category_to_remove The category to remove
+     * @param preserve_order If true, later categories are shifted down to keep their order. If false, the last category
+     *                       is moved into the freed slot, which makes the removal O(1).
      * @return true if the category was removed successfully, false otherwise
      */
-    bool removeCategory(const Word& category_to_remove);
+    bool removeCategory(const Word& category_to_remove, bool preserve_order = true);
 
     /**
      * @brief Checks if a category exists in the array.
@@ -99,6 +401,229 @@ public:
      */
     bool lookup(const Word& category) const;
 
+    /**
+     * @brief Returns the number of categories in the array.
+     * @return The number of categories
+     */
+    size_t categoryCount() const;
+
+    /**
+     * @brief Inserts a word into the given category.
+     * @param category The name of the category
+     * @param word The word to insert
+     * @return true if the word was inserted, false if the category does not exist or already has the word
+     */
+    bool insertWord(const Word& category, const Word& word);
+
+    /**
+     * @brief Removes a word from the given category.
+     * @param category The name of the category
+     * @param word The word to remove
+     * @return true if the word was removed, false if the category does not exist or does not have the word
+     */
+    bool removeWord(const Word& category, const Word& word);
+
+    /**
+     * @brief Checks if the given category has a word.
+     * @param category The name of the category
+     * @param word The word to look up
+     * @return true if the category exists and has the word, false otherwise
+     */
+    bool lookupWord(const Word& category, const Word& word) const;
+
+    /**
+     * @brief Looks up a batch of words in one category with a single merge pass.
+     * @param category The name of the category
+     * @param words The words to look up
+     * @param count The number of words
+     * @param found Array of count elements; found[i] is set to whether the category has words[i]
+     * @return true if the category exists, false otherwise (found is left untouched)
+     */
+    bool lookupMany(const Word& category, const Word* words, size_t count, bool* found) const;
+
+    /**
+     * @brief Looks up a batch of words in all categories. The probes are sorted once and the categories
+     * are merged against them in parallel.
+     * @param words The words to look up
+     * @param count The number of words
+     * @param found Array of count elements; found[i] is set to whether any category has words[i]
+     * @param parallel If false, the categories are scanned on the calling thread only
+     */
+    void lookupMany(const Word* words, size_t count, bool* found, bool parallel = true) const;
+
+    /**
+     * @brief Finds every category that has the given word. The categories are searched in parallel, and
+     * a repeated search is answered from the query cache until one of them changes.
+     * @param word The word to search for
+     * @return The names of the categories that have the word, in category order
+     */
+    WordList categoriesContaining(const Word& word) const;
+
+    /**
+     * @brief Collects the words starting with a given letter from every category. The categories are searched
+     * in parallel, and a repeated search is answered from the query cache until one of them changes.
+     * @param letter The first letter of the words to collect
+     * @return A WordCatVec with one category per category of this object, in the same order, holding its matching words
+     */
+    WordCatVec wordsStartingWith(const char letter) const;
+
+    /**
+     * @brief Turns hit counting on or off in every category (see WordCat::setHitCounting).
+     * @param enabled Whether to count hits
+     */
+    void setHitCounting(bool enabled);
+
+    /**
+     * @brief Tells whether any category counts hits.
+     * @return True if at least one category has hit counting on
+     */
+    bool hasHitCounting() const;
+
+    /**
+     * @brief Finds the k most used words across all categories. Each category ranks its own words with a
+     * heap of k, and the per-category rankings are merged.
+     * @param k The number of words wanted
+     * @param words Array of k elements; receives the words, most used first
+     * @param categories Array of k elements; receives the name of each word's category
+     * @param hits Array of k elements; receives their hits
+     * @return The number of words written, at most k
+     */
+    size_t mostUsed(size_t k, Word* words, Word* categories, uint64_t* hits) const;
+
+    /**
+     * @brief Returns the number of searches over all categories answered from the query cache.
+     * @return The number of cache hits
+     */
+    size_t queryCacheHits() const;
+
+    /**
+     * @brief Returns the number of searches over all categories that had to search the categories.
+     * @return The number of cache misses
+     */
+    size_t queryCacheMisses() const;
+
+    /**
+     * @brief Collects the words two categories have in common, with one merge pass over both.
+     * @param first The name of one category
+     * @param second The name of the other
+     * @param result Receives the words, sorted
+     * @return true if both categories exist, false otherwise (result is left untouched)
+     */
+    bool intersectCategories(const Word& first, const Word& second, WordList& result) const;
+
+    /**
+     * @brief Collects the words of either of two categories, with one merge pass over both.
+     * @param first The name of one category
+     * @param second The name of the other
+     * @param result Receives the words, sorted and without duplicates
+     * @return true if both categories exist, false otherwise (result is left untouched)
+     */
+    bool uniteCategories(const Word& first, const Word& second, WordList& result) const;
+
+    /**
+     * @brief Collects the words of one category that another does not have, with one merge pass over both.
+     * @param first The name of the category whose words are kept
+     * @param second The name of the category whose words are taken away
+     * @param result Receives the words, sorted
+     * @return true if both categories exist, false otherwise (result is left untouched)
+     */
+    bool subtractCategories(const Word& first, const Word& second, WordList& result) const;
+
+    /**
+     * @brief Measures exactly how much two categories overlap, with one merge pass over both.
+     * @param first The name of one category
+     * @param second The name of the other
+     * @param result Receives the names and the similarities; both are 0 when a category is empty
+     * @return true if both categories exist, false otherwise (result is left untouched)
+     */
+    bool compareCategories(const Word& first, const Word& second, Similarity& result) const;
+
+    /**
+     * @brief Finds the pairs of categories that are at least as similar as a threshold, without comparing
+     * every pair: the categories are summarized by MinHash signatures in parallel, and only the pairs that
+     * locality-sensitive hashing puts together are measured. A few pairs near the threshold may be missed.
+     * @param threshold The least Jaccard similarity of the pairs wanted, above 0
+     * @param exact If true, the candidate pairs are measured by merging their words instead of estimated
+     *              from their signatures, which is slower but exact
+     * @return The pairs found, most similar first; empty categories are similar to none
+     */
+    std::vector<Similarity> similarCategories(double threshold, bool exact = false) const;
+
+    /**
+     * @brief Counts the words that are in more than one category, in one pass that keeps only a 64-bit hash and
+     * two counters per different word. Two different words with equal hashes, which is very unlikely, count as one.
+     * @return The counts; saved_bytes is 0
+     */
+    DuplicateReport analyzeDuplicates() const;
+
+    /**
+     * @brief Makes the copies of each long word share one heap buffer (see Word::shareBuffer), across all the
+     * categories kept in List or Persistent storage. Words short enough to be stored inline have no buffer to
+     * share, and Persistent tree nodes shared with copies are left alone (see PersistentWordList::forEachStored).
+     * Each category is changed under its reader locks (see WordCat::lockReaders), so copies of the vocabulary,
+     * such as those VocabularyWatcher reloads into, and lazy rebuilds of filters and position indexes may run
+     * meanwhile; lookups take no lock, so they may not.
+     * @return The counts after the compaction, with the heap bytes freed in saved_bytes
+     */
+    DuplicateReport compactDuplicates();
+
+    /**
+     * @brief Counts the words that are in more than one category of a file in the format of loadFromFile, without
+     * loading it: the file is streamed line by line and only a hash per different word is kept, so files much
+     * larger than the memory their words would take can be analyzed.
+     * @param filename The path to the file
+     * @param report Receives the counts; saved_bytes is 0
+     * @return false if the file could not be opened (report is left untouched)
+     */
+    static bool analyzeFile(const char* filename, DuplicateReport& report);
+
+    /**
+     * @brief Replaces the edit history with an empty one. Steps recorded so far are forgotten.
+     * @param budget Bytes of undo and redo steps to keep in memory
+     * @param spill_path A file for the older steps beyond the budget, or nullptr to forget them
+     */
+    void setEditHistory(size_t budget, const char* spill_path = nullptr);
+
+    /**
+     * @brief Undoes the last edit made through the menu.
+     * @return false if there is nothing to undo, or the categories were changed another way since and the
+     *         edit could only be partly undone
+     */
+    bool undo();
+
+    /**
+     * @brief Redoes the edit undone last.
+     * @return false if there is nothing to redo, or it could only be partly redone
+     */
+    bool redo();
+
+    /**
+     * @brief Sets the most bytes the vocabulary may hold: its categories, words, nodes, filters and indexes,
+     * including 8 bytes of accounting per allocation. An operation that would go over it fails with
+     * MemoryBudgetExceeded before allocating, and a load stops there, keeping the categories loaded so far.
+     * @param bytes The budget, or MemoryAccount::UNLIMITED
+     */
+    void setMemoryBudget(size_t bytes);
+
+    /**
+     * @brief Returns the memory budget.
+     * @return The budget, or MemoryAccount::UNLIMITED
+     */
+    size_t memoryBudget() const;
+
+    /**
+     * @brief Returns the memory account of the vocabulary, for its totals by structure.
+     * @return The account
+     */
+    const MemoryAccount& memoryAccount() const;
+
+    /**
+     * @brief Prints the memory held by the vocabulary: the totals of its account by structure, then the
+     * storage and filter bytes of each category.
+     * @param sout The output stream to print to
+     */
+    void printMemoryReport(std::ostream& sout) const;
+
     /**
      * @brief Overloads the << operator to print the contents of the array.
      * @param sout The output stream to print to
@@ -107,11 +632,35 @@ public:
      */
     friend std::ostream& operator<<(std::ostream& sout, const WordCatVec& wcv);
 
+    /**
+     * @brief Prints per-category statistics, including the memory and false-positive rate of each membership filter.
+     * @param sout The output stream to print to
+     */
+    void printStats(std::ostream& sout) const;
+
     /**
      * @brief Loads categories from a file.
+     * In lazy mode only a directory of the file is built: one sequential scan finds each category header
+     * and records the byte range of its lines, without creating any words. A category's words are parsed
+     * the first time it is used, so opening a large file to look at a few categories parses only those.
+     * The file must not change while categories remain unparsed. Word lines that are not valid UTF-8 are
+     * skipped, as WordCat::insertWord would refuse them, and their number is reported.
      * @param filename The path to the file to load from
+     * @param lazy true to parse each category's words on first use, false to parse everything now
+     */
+    void loadFromFile(const char* filename, bool lazy = false);
+
+    /**
+     * @brief Brings the categories in line with a file that was loaded before and has since changed.
+     * The file is streamed one category at a time and each category is diffed against its current
+     * words (see WordCat::syncWords): only the words that differ are inserted or removed, so unchanged
+     * categories keep their storage, filters and index entries. Categories missing from the file are
+     * removed and new ones are appended.
+     * @param filename The path to the file to reload from
+     * @return false if the file could not be opened, in which case nothing changes, or if the memory budget ran
+     *         out, in which case the categories reloaded before are kept and none is removed
      */
-    void loadFromFile(const char* filename);
+    bool reloadFromFile(const char* filename);
 
     /**
      * @brief Saves categories and words to a file.
@@ -120,7 +669,35 @@ public:
     void saveToFile(const char* filename) const;
 
     /**
-     * @brief Clears all categories from the array.
+     * @brief Saves categories and words to a compressed binary file.
+     * Each category is written front-coded (see FrontCodedList), which for typical sorted vocabularies is
+     * several times smaller than the padded text of saveToFile.
+     * @param filename The path to the file to save to
+     */
+    void saveCompressed(const char* filename) const;
+
+    /**
+     * @brief Loads categories from a file written by saveCompressed.
+     * The categories are kept in WordCat::StorageMode::Compressed, so the words are never expanded in
+     * memory; lookups binary-search the compressed blocks directly. A category holding words that are not
+     * valid UTF-8 is damaged, since saveCompressed never writes one.
+     * @param filename The path to the file to load from
+     */
+    void loadCompressed(const char* filename);
+
+    /**
+     * @brief Applies the transactions recorded in a log by Transaction::commit, in order.
+     * The log must be replayed on the vocabulary it was written against, such as the file saved just before
+     * the log was started. Replay stops at a record that is incomplete or fails its checksum, which is what
+     * a crash in the middle of writing leaves behind; the transactions before it are applied.
+     * @param filename The path to the log
+     * @return The number of transactions applied
+     */
+    size_t replayLog(const char* filename);
+
+    /**
+     * @brief Clears all categories from the array. If the memory budget refuses the new, empty storage,
+     * the categories are kept.
      */
     void clearCategories();
 };
@@ -0,0 +1,147 @@
+// WordFormatter.cpp
+#include "WordFormatter.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Padding for the widest column, copied instead of written one space at a time.
+ */
+static const char SPACES[WordFormatter::COLUMN_WIDTH + 1] = "               ";
+
+/**
+ * @brief Counts the characters of UTF-8 text: every byte except continuation bytes starts one.
+ * @param text The text.
+ * @param length The number of bytes.
+ * @return The number of characters.
+ */
+static size_t characterCount(const char* text, size_t length) {
+    size_t characters = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) characters++;
+    }
+    return characters;
+}
+
+/**
+ * @brief Constructor.
+ * @param out The stream to write to.
+ * @param per_line Words per line, or FIT_TERMINAL.
+ */
+WordFormatter::WordFormatter(std::ostream& out, int per_line) :
+    out(out),
+    per_line{ per_line >= 1 ? per_line : wordsPerLine(&out == &std::cout ? terminalWidth() : DEFAULT_WIDTH) }, // FIT_TERMINAL, or nonsense treated like it; a file or string has no terminal
+    count{ 0 },
+    used{ 0 },
+    finished{ false } {}
+
+/**
+ * @brief Destructor. Finishes the output if finish() was not called.
+ */
+WordFormatter::~WordFormatter() {
+    if (!finished) finish();
+}
+
+/**
+ * @brief Copies bytes into the buffer, writing the buffer out first if they do not fit.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ */
+void WordFormatter::append(const char* data, size_t length) {
+    if (used + length > BUFFER_SIZE) {
+        flush();
+        if (length > BUFFER_SIZE) { // Larger than the whole buffer: write directly
+            out.write(data, static_cast<std::streamsize>(length));
+            return;
+        }
+    }
+    std::memcpy(buffer + used, data, length);
+    used += length;
+}
+
+/**
+ * @brief Writes the rendered bytes to the stream and empties the buffer.
+ */
+void WordFormatter::flush() {
+    out.write(buffer, static_cast<std::streamsize>(used));
+    used = 0;
+}
+
+/**
+ * @brief Formats one word: padding, the word, then a separator or a line break.
+ * @param word The characters of the word.
+ * @param length The number of bytes.
+ */
+void WordFormatter::put(const char* word, size_t length) {
+    size_t padding = 0;
+    if (per_line != 1 && length < COLUMN_WIDTH * 4) { // A character takes at most 4 bytes, so longer words fill the column
+        size_t characters = characterCount(word, length);
+        if (characters < COLUMN_WIDTH) padding = COLUMN_WIDTH - characters; // Right-align in the column; a long word needs none
+    }
+    const char separator = (++count % per_line == 0 || per_line == 1) ? '\n' : ' '; // Line break or separator
+    if (used + padding + length + 1 > BUFFER_SIZE) { // Rare: the buffer is full or the word is huge
+        append(SPACES, padding);
+        append(word, length);
+        append(&separator, 1);
+        return;
+    }
+    char* cursor = buffer + used; // Common case: one bounds check, then copies into the buffer
+    if (used + COLUMN_WIDTH <= BUFFER_SIZE) std::memcpy(cursor, SPACES, COLUMN_WIDTH); // Fixed size, so no library call; the word overwrites the excess
+    else std::memcpy(cursor, SPACES, padding);
+    std::memcpy(cursor + padding, word, length);
+    cursor[padding + length] = separator;
+    used += padding + length + 1;
+}
+
+/**
+ * @brief Formats one word.
+ * @param word The word.
+ */
+void WordFormatter::put(const Word& word) {
+    put(word.c_str(), word.length());
+}
+
+/**
+ * @brief Ends a partial last line and writes everything to the stream.
+ * @return The number of words formatted.
+ */
+int WordFormatter::finish() {
+    if (!finished) {
+        if (count % per_line != 0 && per_line != 1) append("\n", 1); // Finish a partial last line
+        flush();
+        finished = true;
+    }
+    return count;
+}
+
+/**
+ * @brief Returns the width of the terminal standard output is connected to.
+ * @return The number of columns: from the terminal if there is one, else from $COLUMNS, else 80.
+ */
+size_t WordFormatter::terminalWidth() {
+#if defined(__unix__) || defined(__APPLE__)
+    winsize size;
+    if (isatty(STDOUT_FILENO) && ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) return size.ws_col;
+#endif
+    const char* columns = std::getenv("COLUMNS"); // Set by most shells
+    if (columns != nullptr) {
+        long width = std::strtol(columns, nullptr, 10);
+        if (width > 0) return static_cast<size_t>(width);
+    }
+    return DEFAULT_WIDTH;
+}
+
+/**
+ * @brief Returns how many columns fit in a line of the given width.
+ * Each column takes COLUMN_WIDTH characters plus a separator, except that the last one's separator is the line break.
+ * @param width The line width in characters.
+ * @return The number of words per line, at least 1.
+ */
+int WordFormatter::wordsPerLine(size_t width) {
+    size_t columns = (width + 1) / (COLUMN_WIDTH + 1);
+    return columns > 1 ? static_cast<int>(columns) : 1;
+}
@@ -0,0 +1,100 @@
+// WordFormatter.h
+#ifndef WORDFORMATTER_H_
+#define WORDFORMATTER_H_
+
+#include "Word.h"
+#include <cstddef>
+#include <iostream>
+
+/**
+ * @class WordFormatter
+ * @brief Lays out words in right-aligned columns, several per line, and writes them in large blocks.
+ *
+ * This is the layout of WordList::print: each word is right-aligned in a COLUMN_WIDTH-character column,
+ * words on a line are separated by one space, and a line ends after the given number of words.
+ * Everything is rendered into a buffer inside the formatter and handed to the stream only when the
+ * buffer is full, so printing a word costs a few memcpys instead of a stream call per character.
+ * Padding is copied from a string of spaces rather than written one space at a time.
+ *
+ * Column widths count characters, not bytes, so words with multibyte UTF-8 characters stay aligned.
+ * Passing FIT_TERMINAL as the number of words per line fits as many columns as the terminal is wide
+ * when the stream is std::cout, and as many as DEFAULT_WIDTH characters hold for any other stream.
+ */
+class WordFormatter {
+public:
+    static constexpr int FIT_TERMINAL = 0; ///< Words per line: as many columns as fit the terminal
+    static constexpr size_t COLUMN_WIDTH = 15; ///< Characters a word is right-aligned in
+    static constexpr size_t DEFAULT_WIDTH = 80; ///< Line width without a terminal to measure
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 15; ///< Bytes rendered before they are written to the stream
+
+    std::ostream& out; ///< The stream to write to
+    int per_line; ///< Words per line; 1 prints each word on its own line without padding
+    int count; ///< Words formatted so far
+    size_t used; ///< Bytes of buffer in use
+    bool finished; ///< finish() was called
+    char buffer[BUFFER_SIZE]; ///< The rendered output not yet written
+
+    /**
+     * @brief Copies bytes into the buffer, writing the buffer out first if they do not fit.
+     * @param data The bytes
+     * @param length The number of bytes
+     */
+    void append(const char* data, size_t length);
+
+    /**
+     * @brief Writes the rendered bytes to the stream and empties the buffer.
+     */
+    void flush();
+
+public:
+    /**
+     * @brief Constructor.
+     * @param out The stream to write to; it must outlive the formatter
+     * @param per_line Words per line, or FIT_TERMINAL to fit the terminal when out is std::cout
+     */
+    WordFormatter(std::ostream& out, int per_line);
+
+    /**
+     * @brief Destructor. Finishes the output if finish() was not called.
+     */
+    ~WordFormatter();
+
+    WordFormatter(const WordFormatter& other) = delete; // The buffer would be written twice
+    WordFormatter& operator=(const WordFormatter& other) = delete;
+
+    /**
+     * @brief Formats one word.
+     * @param word The characters of the word (need not be '\0'-terminated)
+     * @param length The number of bytes
+     */
+    void put(const char* word, size_t length);
+
+    /**
+     * @brief Formats one word.
+     * @param word The word
+     */
+    void put(const Word& word);
+
+    /**
+     * @brief Ends a partial last line and writes everything to the stream. Nothing may be put afterwards.
+     * @return The number of words formatted
+     */
+    int finish();
+
+    /**
+     * @brief Returns the width of the terminal standard output is connected to.
+     * @return The number of columns: from the terminal if there is one, else from $COLUMNS, else DEFAULT_WIDTH
+     */
+    static size_t terminalWidth();
+
+    /**
+     * @brief Returns how many columns fit in a line of the given width.
+     * @param width The line width in characters
+     * @return The number of words per line, at least 1
+     */
+    static int wordsPerLine(size_t width);
+};
+
+#endif // WORDFORMATTER_H_
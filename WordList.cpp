@@ -1,9 +1,15 @@
 // WordList.cpp
 #include "WordList.h"
+#include "WordFormatter.h"
+#include "MemoryAccount.h"
+#include <algorithm> // For std::sort
 #include <iostream>
+#include <limits>
+#include <new>
 
 // Default constructor. Initializes an empty list.
-WordList::WordList() : head(nullptr), tail(nullptr), size(0) {}
+WordList::WordList() : nodes(nullptr), pool_used(0), pool_capacity(0), free_slot(NIL), head(NIL), tail(NIL), size(0),
+      samples(nullptr), sample_capacity(0), samples_valid(false) {}
 
 /**
  * @brief Destructor. Removes all nodes.
@@ -13,10 +19,11 @@ WordList::~WordList() {
 }
 
 /**
- * @brief Copy constructor. Initializes head and tail to nullptr and size to 0, then copies all nodes from 'other' to this list.
+ * @brief Copy constructor. Initializes an empty list, then copies all nodes from 'other' to this list.
  * @param other The WordList to copy from.
  */
-WordList::WordList(const WordList& other) : head(nullptr), tail(nullptr), size(0) {
+WordList::WordList(const WordList& other) : nodes(nullptr), pool_used(0), pool_capacity(0), free_slot(NIL), head(NIL), tail(NIL), size(0),
+      samples(nullptr), sample_capacity(0), samples_valid(false) {
     copy(other); // Copy all nodes from 'other' to this list
 }
 
@@ -37,7 +44,10 @@ WordList& WordList::operator=(const WordList& other) {
  * @brief Move constructor. Takes ownership from 'other' and releases ownership of 'other'.
  * @param other The WordList to move from.
  */
-WordList::WordList(WordList&& other) noexcept : head(other.head), tail(other.tail), size(other.size) {
+WordList::WordList(WordList&& other) noexcept
+    : nodes(other.nodes), pool_used(other.pool_used), pool_capacity(other.pool_capacity),
+      free_slot(other.free_slot), head(other.head), tail(other.tail), size(other.size),
+      samples(nullptr), sample_capacity(0), samples_valid(false) { // The index is rebuilt on demand
     other.releaseOwnership(); // Release ownership of 'other'
 }
 
@@ -49,6 +59,10 @@ WordList::WordList(WordList&& other) noexcept : head(other.head), tail(other.tai
 WordList& WordList::operator=(WordList&& other) noexcept {
     if (this != &other) { // Check for self-assignment
         clear(); // Clear this list
+        nodes = other.nodes; // Take ownership of the pool from 'other'
+        pool_used = other.pool_used;
+        pool_capacity = other.pool_capacity;
+        free_slot = other.free_slot;
         head = other.head; // Take ownership from 'other'
         tail = other.tail; // Take ownership from 'other'
         size = other.size; // Take ownership from 'other'
@@ -64,7 +78,7 @@ WordList& WordList::operator=(WordList&& other) noexcept {
  */
 const Word& WordList::front() const {
     if (isEmpty()) throw std::runtime_error("List is empty");
-    return head->theWord; // Return the word in the head node
+    return nodes[head].theWord; // Return the word in the head node
 }
 
 /**
@@ -74,7 +88,7 @@ const Word& WordList::front() const {
  */
 const Word& WordList::back() const {
     if (isEmpty()) throw std::runtime_error("List is empty");
-    return tail->theWord; // Return the word in the tail node
+    return nodes[tail].theWord; // Return the word in the tail node
 }
 
 /**
@@ -82,37 +96,23 @@ const Word& WordList::back() const {
  * @param word The word to insert.
  */
 void WordList::push_front(const Word& word) {
-    Node* newNode = new Node(word, head); // Create a new node
-    if (isEmpty()) {
-        head = tail = newNode; // If list is empty, head and tail are the new node
-    } else {
-        head->prev = newNode; // Update previous head's previous pointer
-        head = newNode; // Update head to new node
-    }
-    size++; // Increment size
+    uint32_t slot = allocateNode(Word(word), head, NIL); // Copy the word before the pool may move
+    linkNode(slot); // Link it in front of the old head
 }
 
 /**
- * @brief Removes the node at the head of this list and returns it.
- * This method provides direct access to the node, facilitating external use or reassignment.
- * @return Node* Pointer to the removed head node.
+ * @brief Removes the node at the head of this list and returns its word.
+ * @return Word The word of the removed head node.
  * @throws std::runtime_error if the list is empty, indicating no nodes to remove.
  */
-WordList::Node* WordList::pop_front() {
+Word WordList::pop_front() {
     if (isEmpty()) throw std::runtime_error("List is empty");
 
-    Node* oldHead = head; // Save the current head node
-    head = head->next; // Move the head pointer to the next node
-
-    if (head) {
-        head->prev = nullptr; // Set the new head's prev pointer to nullptr
-    } else {
-        tail = nullptr; // If the list becomes empty, also set tail to nullptr
-    }
-
-    oldHead->next = nullptr; // Disconnect the old head from the list
-    size--; // Decrement the size of the list
-    return oldHead; // Return the old head node
+    uint32_t oldHead = head; // Save the current head node
+    unlinkNode(oldHead); // Detach it from the list
+    Word word(std::move(nodes[oldHead].theWord)); // Take the word out of the node
+    releaseNode(oldHead); // Recycle the slot
+    return word; // Return the removed word
 }
 
 /**
@@ -120,43 +120,31 @@ WordList::Node* WordList::pop_front() {
  * @param word The word to insert.
  */
 void WordList::push_back(const Word& word) {
-    Node* newNode = new Node(word, nullptr, tail); // Create a new node
-
-    if (tail != nullptr) {
-        tail->next = newNode; // If the list isn't empty, set the next pointer of the current tail node to the new node.
-    }
-
-    tail = newNode; // The new node is now the tail of the list.
-
-    if (head == nullptr) {
-        head = newNode; // If the list was empty, the new node is also the head of the list.
-    }
+    push_back(Word(word)); // Copy the word before the pool may move
+}
 
-    size++; // Increment the size of the list.
+/**
+ * @brief Inserts a new node at the tail of this list, moving the word into it.
+ * @param word The word to insert.
+ */
+void WordList::push_back(Word&& word) {
+    uint32_t slot = allocateNode(std::move(word), NIL, tail); // Create a new node after the current tail
+    linkNode(slot); // Link it behind the old tail
 }
 
 /**
- * @brief Removes the node at the tail of this list and returns it.
- * This method allows for managing the node outside the WordList structure,
- * particularly useful for custom memory management or advanced manipulations.
- * @return Node* Pointer to the removed tail node.
+ * @brief Removes the node at the tail of this list and returns its word.
+ * @return Word The word of the removed tail node.
  * @throws std::runtime_error if the list is empty, indicating no nodes to remove.
  */
-WordList::Node* WordList::pop_back() {
+Word WordList::pop_back() {
     if (isEmpty()) throw std::runtime_error("List is empty");
 
-    Node* oldTail = tail; // Save the current tail node
-    tail = tail->prev; // Move the tail pointer to the previous node
-
-    if (tail) {
-        tail->next = nullptr; // Set the new tail's next pointer to nullptr
-    } else {
-        head = nullptr; // If the list becomes empty, also set head to nullptr
-    }
-
-    oldTail->prev = nullptr; // Disconnect the old tail from the list
-    size--; // Decrement the size of the list
-    return oldTail; // Return the old tail node
+    uint32_t oldTail = tail; // Save the current tail node
+    unlinkNode(oldTail); // Detach it from the list
+    Word word(std::move(nodes[oldTail].theWord)); // Take the word out of the node
+    releaseNode(oldTail); // Recycle the slot
+    return word; // Return the removed word
 }
 
 /**
@@ -164,39 +152,48 @@ WordList::Node* WordList::pop_back() {
  * @param word The word to insert.
  */
 void WordList::insertSorted(const Word& word) {
-    if (head == nullptr || word.isLess(front())) {
+    if (isEmpty() || word.isLess(front())) {
         push_front(word); // If the list is empty or the word is less than the head, use push_front
     } else if (back().isLess(word)) { // If the new node should be inserted at the end
         push_back(word); // Use push_back
     } else { // The new node should be inserted in the middle
-        Node* current = head->next; // Initialize current node as the second node
-        Node* previous = head; // Initialize previous node as head
+        uint32_t current = nodes[head].next; // Initialize current node as the second node
+        uint32_t previous = head; // Initialize previous node as head
 
-        while (current != nullptr && current->theWord.isLess(word)) { // Traverse the list to find the correct position
+        while (current != NIL && nodes[current].theWord.isLess(word)) { // Traverse the list to find the correct position
             previous = current; // Update previous to current
-            current = current->next; // Move to the next node
+            current = nodes[current].next; // Move to the next node
         }
 
-        Node* newNode = new Node(word, current, previous); // Create a new node for the word
-        previous->next = newNode; // The next pointer of the previous node points to the new node
-        
-        if (current != nullptr) {
-            current->prev = newNode; // The previous pointer of the current node points to the new node
-        } else {
-            tail = newNode; // The new node should be inserted at the end
-        }
+        uint32_t slot = allocateNode(Word(word), current, previous); // Create a new node for the word
+        linkNode(slot); // Link it between previous and current
+    }
+}
 
-        size++; // Increment the size of the list.
+/**
+ * @brief Moves all words of another list to the end of this list without copying any characters.
+ * @param other The list to take the words from. It is left empty.
+ */
+void WordList::append(WordList&& other) {
+    if (this == &other || other.isEmpty()) return; // Nothing to move
+
+    if (isEmpty()) {
+        *this = std::move(other); // This list simply takes over the other's pool
+        return;
     }
+
+    growPool(size + other.size); // Make room for every moved word at once
+    for (uint32_t slot = other.head; slot != NIL; slot = other.nodes[slot].next) {
+        push_back(std::move(other.nodes[slot].theWord)); // Move the word; only its 16 bytes are copied
+    }
+    other.clear(); // The other list is now empty
 }
 
 /**
- * @brief Removes all nodes from the list.
+ * @brief Removes all nodes from the list and frees the pool.
  */
 void WordList::clear() {
-    while (!isEmpty()) {
-        pop_front(); // Remove the front node of the list while the list is not empty
-    }
+    releasePool(); // Destroy every node and free the pool
 }
 
 /**
@@ -205,26 +202,14 @@ void WordList::clear() {
  * @return true if the word was found and removed, false otherwise.
  */
 bool WordList::remove(const Word& word) {
-    Node* node = search(word); // Search for the node containing the word
+    uint32_t slot = search(word); // Search for the node containing the word
 
-    if (node == nullptr) {
+    if (slot == NIL) {
         return false; // If the word is not found, return false
     }
 
-    if (node->prev != nullptr) {
-        node->prev->next = node->next; // If the node has a previous node, update the next pointer of the previous node
-    } else {
-        head = node->next; // If the node is the head of the list, update the head pointer
-    }
-
-    if (node->next != nullptr) {
-        node->next->prev = node->prev; // If the node has a next node, update the prev pointer of the next node
-    } else {
-        tail = node->prev; // If the node is the tail of the list, update the tail pointer
-    }
-
-    delete node; // Delete the node and decrement the size of the list
-    size--; // Decrement the size of the list
+    unlinkNode(slot); // Update the neighbours, or head and tail
+    releaseNode(slot); // Free the word and recycle the slot
 
     return true; // Return true to indicate successful removal
 }
@@ -236,9 +221,42 @@ bool WordList::remove(const Word& word) {
  * @throws std::runtime_error if the index is out of range.
  */
 Word WordList::fetchWord(int index) const {
-    Node* node = getWord(index); // Get the node at the given index
-    if (node == nullptr) throw std::runtime_error("Index out of range"); // If the node is nullptr, throw a runtime error
-    return node->theWord; // Return a copy of the word in the node
+    uint32_t slot = getWord(index); // Get the node at the given index
+    if (slot == NIL) throw std::runtime_error("Index out of range"); // If there is no such node, throw a runtime error
+    return nodes[slot].theWord; // Return a copy of the word in the node
+}
+
+/**
+ * @brief Returns the words at positions [offset, offset + limit), in list order.
+ * @param offset The position of the first word.
+ * @param limit The maximum number of words.
+ * @return The words of the page; empty when offset is past the end.
+ */
+WordList WordList::page(size_t offset, size_t limit) const {
+    if (offset >= size || limit == 0) return WordList(); // Nothing there
+    return copyFrom(slotAt(offset), limit);
+}
+
+/**
+ * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+ * @param from Where to start; it need not be in the list.
+ * @param limit The maximum number of words.
+ * @return The words of the page.
+ */
+WordList WordList::range(const Word& from, size_t limit) const {
+    size_t position;
+    return copyFrom(lowerBound(from, position), limit);
+}
+
+/**
+ * @brief Counts the words less than a given word.
+ * @param word The word to rank; it need not be in the list.
+ * @return The number of words that sort before it.
+ */
+size_t WordList::rank(const Word& word) const {
+    size_t position;
+    lowerBound(word, position);
+    return position;
 }
 
 // /**
@@ -246,16 +264,111 @@ Word WordList::fetchWord(int index) const {
 //  * @return true if the list is empty, false otherwise.
 //  */
 // inline bool WordList::isEmpty() const {
-//     return head == nullptr; // The list is empty if the head pointer is null or size == 0
+//     return head == NIL; // The list is empty if there is no head node or size == 0
 // }
 
+/**
+ * @brief Calls a function on every word of the list, from head to tail.
+ * @param visit The function to call with each word.
+ */
+void WordList::forEach(const std::function<void(const Word&)>& visit) const {
+    for (uint32_t slot = head; slot != NIL; slot = nodes[slot].next) { // Traverse the list until the end
+        visit(nodes[slot].theWord); // Hand the word to the caller
+    }
+}
+
+/**
+ * @brief Calls a function on every stored word, from head to tail, so that it can share the word's buffer.
+ * @param visit The function to call with each word.
+ */
+void WordList::forEachStored(const std::function<void(Word&)>& visit) {
+    for (uint32_t slot = head; slot != NIL; slot = nodes[slot].next) {
+        visit(nodes[slot].theWord); // The characters stay the same, so the order and the samples still hold
+    }
+}
+
+/**
+ * @brief Rebuilds the pool at exactly the current size, dropping free slots and growth slack.
+ */
+void WordList::shrinkToFit() {
+    if (size == pool_capacity) return; // No free slots and no slack
+
+    WordList compact; // The same words in a pool of exactly the right size
+    compact.growPool(size);
+    for (uint32_t slot = head; slot != NIL; slot = nodes[slot].next) {
+        compact.push_back(std::move(nodes[slot].theWord)); // Move each word into the next consecutive slot
+    }
+    *this = std::move(compact); // Take over the compact pool
+}
+
+/**
+ * @brief Returns the memory owned by the list: the node pool plus the heap buffers of long words.
+ * @return The size in bytes.
+ */
+size_t WordList::memoryBytes() const {
+    size_t bytes = static_cast<size_t>(pool_capacity) * sizeof(Node); // The pool, including unused slots
+    for (uint32_t slot = head; slot != NIL; slot = nodes[slot].next) {
+        bytes += nodes[slot].theWord.heapBytes(); // Characters of words too long to be stored inline
+    }
+    return bytes;
+}
+
 /**
  * @brief Checks if the given word is in the list.
  * @param word The word to check.
  * @return true if the word is found, false otherwise.
  */
 bool WordList::lookup(const Word& word) const {
-    return search(word) != nullptr; // If the word is found in the list, return true, otherwise, return false
+    return search(word) != NIL; // If the word is found in the list, return true, otherwise, return false
+}
+
+/**
+ * @brief Looks up a batch of words with a single pass over the list.
+ * The probes are visited in ascending order while one cursor walks the sorted list, so every node
+ * and every probe is visited at most once. The next node is prefetched while the current one is compared.
+ * @param words The words to look up.
+ * @param count The number of words.
+ * @param found Array of count elements; found[i] is set to whether words[i] is in the list.
+ * @param order Optional ascending permutation of the probes; computed here when nullptr.
+ */
+void WordList::lookupMany(const Word* words, size_t count, bool* found, const size_t* order) const {
+    size_t* own_order = order == nullptr ? sortedOrder(words, count) : nullptr; // Sort the probes if the caller did not
+    const size_t* probes = order != nullptr ? order : own_order; // Probe indices in ascending word order
+
+    uint32_t slot = head; // Cursor into the sorted list
+    for (size_t k = 0; k < count; ++k) { // Visit the probes in ascending order
+        const Word& probe = words[probes[k]];
+        int cmp = 1; // Result of comparing the cursor's word with the probe
+
+        while (slot != NIL && (cmp = strcmp(nodes[slot].theWord.c_str(), probe.c_str())) < 0) { // Skip smaller words
+#if defined(__GNUC__)
+            uint32_t next = nodes[slot].next;
+            if (next != NIL && nodes[next].next != NIL) __builtin_prefetch(&nodes[nodes[next].next]); // Start fetching the node after next
+#endif
+            slot = nodes[slot].next; // Advance the cursor
+        }
+
+        found[probes[k]] = slot != NIL && cmp == 0; // Hit only if the cursor stopped on an equal word
+    }
+
+    delete[] own_order; // Free the order computed here (a no-op for nullptr)
+}
+
+/**
+ * @brief Computes the permutation that visits a batch of words in ascending order.
+ * @param words The words to order.
+ * @param count The number of words.
+ * @return A new[]-allocated array of count indices into words, which the caller must delete[].
+ */
+size_t* WordList::sortedOrder(const Word* words, size_t count) {
+    size_t* order = new size_t[count]; // The permutation being built
+    for (size_t i = 0; i < count; ++i) order[i] = i; // Start from the identity
+
+    std::sort(order, order + count, [words](size_t a, size_t b) {
+        return strcmp(words[a].c_str(), words[b].c_str()) < 0; // Same ordering as Word::isLess
+    });
+
+    return order; // Return the permutation
 }
 
 /**
@@ -266,12 +379,12 @@ bool WordList::lookup(const Word& word) const {
 WordList WordList::wordsStartingWith(const char letter) const {
     WordList initialLetterWords; // Words starting with the given letter
 
-    Node* node = head; // Start at the head of the list
-    while (node != nullptr) { // Traverse the list until the end
-        if (node->theWord.at(0) == letter) { // If the word starts with the given letter
-            initialLetterWords.push_back(node->theWord); // Add it to the list of words starting with the given letter
+    uint32_t slot = head; // Start at the head of the list
+    while (slot != NIL) { // Traverse the list until the end
+        if (nodes[slot].theWord.at(0) == letter) { // If the word starts with the given letter
+            initialLetterWords.push_back(nodes[slot].theWord); // Add it to the list of words starting with the given letter
         }
-        node = node->next; // Move to the next node in the list
+        slot = nodes[slot].next; // Move to the next node in the list
     }
 
     return initialLetterWords; // Return the list of words starting with the given letter
@@ -284,36 +397,11 @@ WordList WordList::wordsStartingWith(const char letter) const {
  * @return The total number of words printed.
  */
 int WordList::print(std::ostream& sout, const int n) const {
-    int wordCount{ 0 }; // Initialize word count to 0
-
-    Node* node = head; // Start from the head of the list
-    while (node != nullptr) { // Traverse the list until the end
-        size_t len = node->theWord.length(); // Get the length of the word
-
-        if (n != 1) {
-            size_t padding = len >= 15 ? 0 : 15 - len; // Calculate the number of spaces needed
-
-            for (int i = 0; i < padding; ++i) {
-                sout << ' '; // Add spaces to the output stream
-            }
-        }
-
-        sout << node->theWord; // Output the word
-
-        if (++wordCount % n == 0 || n == 1) {
-            sout << "\n"; // Start a new line if the word count is a multiple of n or n equals 1
-        } else {
-            sout << " "; // Add a space after the word if n is not 1
-        }
-
-        node = node->next; // Move to the next node in the list
+    WordFormatter formatter(sout, n); // Renders into one buffer and writes it in large blocks
+    for (uint32_t slot = head; slot != NIL; slot = nodes[slot].next) { // Traverse the list until the end
+        formatter.put(nodes[slot].theWord);
     }
-
-    if (wordCount % n != 0 && n != 1) {
-        sout << "\n"; // Add a newline at the end if the last line contains less than n words and n is not 1
-    }
-
-    return wordCount; // Return the total number of words printed
+    return formatter.finish(); // Return the total number of words printed
 }
 
 /**
@@ -323,7 +411,7 @@ int WordList::print(std::ostream& sout, const int n) const {
  * @return The output stream.
  */
 std::ostream& operator<<(std::ostream& sout, const WordList& wl) {
-    wl.print(sout); // Call the print function of the WordList object
+    wl.print(sout, WordFormatter::FIT_TERMINAL); // As many words per line as the terminal fits
     return sout;  // Return the output stream
 }
 
@@ -331,73 +419,231 @@ std::ostream& operator<<(std::ostream& sout, const WordList& wl) {
  * @brief Releases ownership of all nodes in the list.
  */
 void WordList::releaseOwnership() {
-    head = nullptr; // Set the head pointer to nullptr, indicating that the list no longer has a first node
-    tail = nullptr; // Set the tail pointer to nullptr, indicating that the list no longer has a last node
+    nodes = nullptr; // The pool now belongs to another list
+    pool_used = 0;
+    pool_capacity = 0;
+    free_slot = NIL; // No free slots either
+    head = NIL; // The list no longer has a first node
+    tail = NIL; // The list no longer has a last node
     size = 0; // Set the size to 0, indicating that the list no longer contains any nodes
+    samples_valid = false; // The position index describes the old nodes
 }
 
 /**
- * @brief Copies all nodes from another list into this list.
- * @param other The WordList to copy from.
+ * @brief Destroys every node and frees the pool.
  */
-void WordList::copy(const WordList& other) {
-    head = nullptr; // This is an empty list, for now
-    tail = nullptr; // This is an empty list, for now
-    size = 0; // No nodes, yet
+void WordList::releasePool() {
+    for (uint32_t slot = 0; slot < pool_used; ++slot) {
+        nodes[slot].~Node(); // Free slots hold empty words, which are cheap to destroy
+    }
+    MemoryAccount::deallocate(nodes, pool_capacity * sizeof(Node), MemoryAccount::Structure::Nodes); // Free the raw storage (a no-op for nullptr)
+    delete[] samples; // And the position index
+    samples = nullptr;
+    sample_capacity = 0;
+    releaseOwnership(); // Back to an empty list without a pool
+}
 
-    if (other.isEmpty()) return; // Nothing to do
+/**
+ * @brief Grows the pool so that it has room for at least the given number of slots.
+ * The pool grows by half its size at a time, so a long run of insertions reallocates O(log n) times
+ * while the unused tail stays below a third of the pool.
+ * @param minimum The number of slots needed.
+ */
+void WordList::growPool(size_t minimum) {
+    if (minimum <= pool_capacity) return; // Already large enough
+    if (minimum >= NIL) throw std::length_error("WordList cannot hold more than 2^32 - 1 words"); // Slots are 32-bit
+
+    size_t new_capacity = pool_capacity + pool_capacity / 2; // Grow by half
+    if (new_capacity < 8) new_capacity = 8; // Start with a few slots
+    if (new_capacity < minimum) new_capacity = minimum; // Never less than requested
+    if (new_capacity >= NIL) new_capacity = NIL - 1; // NIL itself is never a valid slot
+
+    Node* new_nodes = static_cast<Node*>(MemoryAccount::current().allocate(new_capacity * sizeof(Node), MemoryAccount::Structure::Nodes)); // Raw storage for the new pool
+    for (uint32_t slot = 0; slot < pool_used; ++slot) {
+        new (&new_nodes[slot]) Node(std::move(nodes[slot].theWord), nodes[slot].next, nodes[slot].prev); // Slots keep their index
+        nodes[slot].~Node(); // Destroy the moved-from node
+    }
+    MemoryAccount::deallocate(nodes, pool_capacity * sizeof(Node), MemoryAccount::Structure::Nodes); // Free the old pool
+
+    nodes = new_nodes;
+    pool_capacity = static_cast<uint32_t>(new_capacity);
+}
+
+/**
+ * @brief Takes a slot from the free list or the pool and constructs a node in it.
+ * @param word The word to store; moved into the node.
+ * @param next Slot of the next node.
+ * @param prev Slot of the previous node.
+ * @return The slot of the new node.
+ */
+uint32_t WordList::allocateNode(Word&& word, uint32_t next, uint32_t prev) {
+    if (free_slot != NIL) { // Reuse the slot of a removed node
+        uint32_t slot = free_slot;
+        free_slot = nodes[slot].next; // Pop it off the free list
+        nodes[slot].theWord = std::move(word);
+        nodes[slot].next = next;
+        nodes[slot].prev = prev;
+        return slot;
+    }
+
+    if (pool_used == pool_capacity) growPool(static_cast<size_t>(pool_used) + 1); // The pool is full
+    new (&nodes[pool_used]) Node(std::move(word), next, prev); // Construct the node in the next unused slot
+    return pool_used++;
+}
+
+/**
+ * @brief Frees the word of an unlinked node and puts its slot on the free list.
+ * @param slot The slot to release.
+ */
+void WordList::releaseNode(uint32_t slot) {
+    nodes[slot].theWord = Word(); // Free the characters of a long word now
+    nodes[slot].prev = NIL;
+    nodes[slot].next = free_slot; // Push the slot onto the free list
+    free_slot = slot;
+}
 
-    Node* current = other.head; // First node to copy into this list
-    head = new Node(current->theWord, nullptr, nullptr); // First node copied
-    tail = head; // Both head and tail point to the first node
-    size = 1; // First node counted
+/**
+ * @brief Links a node between two neighbours, or at the ends of the list when they are NIL.
+ * @param slot The slot of the node to link; its next and prev must already be set.
+ */
+void WordList::linkNode(uint32_t slot) {
+    Node& node = nodes[slot];
+    if (node.prev != NIL) nodes[node.prev].next = slot; else head = slot; // Link from the previous node, or become the head
+    if (node.next != NIL) nodes[node.next].prev = slot; else tail = slot; // Link from the next node, or become the tail
+    size++; // Count the new node
+    samples_valid = false; // Positions after the node moved
+}
 
-    Node* lastNode = head; // Last node copied into this list
-    current = current->next; // Next node to copy into this list
-    while (current) { // While other list has nodes to copy into this list
-        Node* newNode = new Node(current->theWord, nullptr, lastNode); // Allocate a new node with current data and link to lastNode
-        lastNode->next = newNode; // Append the new node
-        tail = newNode; // Tail always points to the last node
+/**
+ * @brief Unlinks a node from its neighbours.
+ * @param slot The slot of the node to unlink.
+ */
+void WordList::unlinkNode(uint32_t slot) {
+    Node& node = nodes[slot];
+    if (node.prev != NIL) nodes[node.prev].next = node.next; else head = node.next; // Bypass the node going forward
+    if (node.next != NIL) nodes[node.next].prev = node.prev; else tail = node.prev; // Bypass the node going backward
+    size--; // The node no longer counts
+    samples_valid = false; // Positions after the node moved
+}
 
-        lastNode = newNode; // Update lastNode
-        current = current->next; // Advance to next node in other list
+/**
+ * @brief Copies all nodes from another list into this list.
+ * The copy is compact: its nodes occupy consecutive slots in list order and the pool is sized exactly.
+ * @param other The WordList to copy from.
+ */
+void WordList::copy(const WordList& other) {
+    if (other.isEmpty()) return; // Nothing to do
 
-        size++; // Count the newly added node
+    growPool(other.size); // One allocation for every node
+    for (uint32_t slot = other.head; slot != NIL; slot = other.nodes[slot].next) {
+        push_back(other.nodes[slot].theWord); // Append a copy of the word
     }
 }
 
 /**
  * @brief Searches for a node containing the given word in the list.
  * @param word The word to search for.
- * @return A pointer to the node containing the word, or nullptr if not found.
+ * @return The slot of the node containing the word, or NIL if not found.
  */
-WordList::Node* WordList::search(const Word& word) const {
-    Node* node = head; // Start at the head of the list
+uint32_t WordList::search(const Word& word) const {
+    uint32_t slot = head; // Start at the head of the list
 
-    while (node != nullptr) { // Traverse the list until the end
-        if (strcmp(node->theWord.c_str(), word.c_str()) == 0) {
-            return node; // If they match, return the current node
+    while (slot != NIL) { // Traverse the list until the end
+        if (nodes[slot].theWord == word) {
+            return slot; // If they match, return the current node
         }
-        node = node->next; // Move to the next node in the list
+        slot = nodes[slot].next; // Move to the next node in the list
     }
 
-    return nullptr; // If no match was found, return nullptr
+    return NIL; // If no match was found, return NIL
 }
 
 /**
- * @brief Returns a pointer to the node at the given index in the list.
+ * @brief Returns the slot of the node at the given index in the list.
  * @param n The index of the node.
- * @return A pointer to the node at the given index, or nullptr if out of range.
+ * @return The slot of the node at the given index, or NIL if out of range.
+ */
+uint32_t WordList::getWord(const int n) const {
+    if (n < 0 || static_cast<size_t>(n) >= size) { // Check if the index is valid
+        return NIL; // If the index is out of bounds, return NIL
+    }
+
+    return slotAt(static_cast<size_t>(n)); // Jump to the nearest sample at or before n, then follow the links
+}
+
+/**
+ * @brief Rebuilds the position index if a mutation made it stale.
+ * One walk over the list records the slot of every SAMPLE_INTERVAL-th node.
+ */
+void WordList::refreshSamples() const {
+    if (samples_valid) return; // Still describes the list
+
+    size_t count = (size + SAMPLE_INTERVAL - 1) / SAMPLE_INTERVAL; // One sample per started interval
+    if (count > sample_capacity) { // Grow the index; it is reused across rebuilds otherwise
+        delete[] samples;
+        samples = new uint32_t[count];
+        sample_capacity = count;
+    }
+
+    size_t position{ 0 };
+    for (uint32_t slot = head; slot != NIL; slot = nodes[slot].next, ++position) {
+        if (position % SAMPLE_INTERVAL == 0) samples[position / SAMPLE_INTERVAL] = slot;
+    }
+    samples_valid = true;
+}
+
+/**
+ * @brief Returns the slot of the node at the given position, through the position index.
+ * @param position The position, less than size.
+ * @return The slot of the node.
+ */
+uint32_t WordList::slotAt(size_t position) const {
+    refreshSamples(); // Rebuild the index after a mutation
+    uint32_t slot = samples[position / SAMPLE_INTERVAL]; // The nearest sample at or before the position
+    for (size_t i = position % SAMPLE_INTERVAL; i > 0; --i) {
+        slot = nodes[slot].next; // Fewer than SAMPLE_INTERVAL links
+    }
+    return slot;
+}
+
+/**
+ * @brief Finds the first node whose word is not less than the given word.
+ * A binary search over the sampled nodes finds the interval, and a walk of at most SAMPLE_INTERVAL nodes finds the node.
+ * @param word The word to search for.
+ * @param position Receives the position of that node, or size if every word is less.
+ * @return The slot of that node, or NIL if every word is less.
  */
-WordList::Node* WordList::getWord(const int n) const {
-    if (n < 0 || n >= size) { // Check if the index is valid
-        return nullptr; // If the index is out of bounds, return nullptr
+uint32_t WordList::lowerBound(const Word& word, size_t& position) const {
+    position = 0;
+    if (isEmpty()) return NIL;
+
+    refreshSamples(); // Rebuild the index after a mutation
+    size_t low{ 0 }, high{ (size + SAMPLE_INTERVAL - 1) / SAMPLE_INTERVAL }; // Find the first sample not less than word
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (nodes[samples[middle]].theWord.isLess(word)) low = middle + 1; else high = middle;
     }
+    if (low == 0) return head; // Even the first word is not less
 
-    Node* node = head; // Start at the head of the list
-    for (int i = 0; i < n; i++) {
-        node = node->next; // Follow the 'next' pointers n times to reach the nth node
+    uint32_t slot = samples[low - 1]; // The last sample less than word; the answer is in its interval or is the next sample
+    position = (low - 1) * SAMPLE_INTERVAL;
+    while (slot != NIL && nodes[slot].theWord.isLess(word)) {
+        slot = nodes[slot].next;
+        position++;
     }
+    return slot;
+}
 
-    return node; // Return a pointer to the nth node
+/**
+ * @brief Copies up to limit words, starting at a node, into a new list.
+ * @param slot The slot of the first node to copy, or NIL.
+ * @param limit The maximum number of words.
+ * @return The copied words.
+ */
+WordList WordList::copyFrom(uint32_t slot, size_t limit) const {
+    WordList words;
+    for (; slot != NIL && limit > 0; slot = nodes[slot].next, --limit) {
+        words.push_back(nodes[slot].theWord);
+    }
+    return words;
 }
@@ -3,47 +3,106 @@
 #define WORDLIST_H
 
 #include "Word.h"
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 
 /**
  * @class WordList
  * @brief A class to represent a doubly linked list of Words.
+ *
+ * The nodes live in one pool owned by the list and link to each other by 32-bit slot index rather
+ * than by pointer. Together with Word's inline storage for short words, a node costs 24 bytes and
+ * needs no allocation of its own: 12 bytes of characters, a 4-byte size and two 4-byte links.
+ * Slots of removed nodes are chained into a free list and reused by the next insertion.
+ *
+ * Positional access goes through a sampled index: the slot of every SAMPLE_INTERVAL-th node, built on
+ * the first positional call after a mutation. Reaching position i then costs one jump and fewer than
+ * SAMPLE_INTERVAL links, and finding a word costs a binary search over the samples and a short walk,
+ * so paging through a large list costs O(log n + page) per page instead of O(i).
  */
 class WordList {
 private:
+    static constexpr uint32_t NIL = UINT32_MAX; ///< Link value meaning "no node"
+    static constexpr size_t SAMPLE_INTERVAL = 64; ///< Positions between consecutive entries of the position index
+
     struct Node {
         Word theWord; ///< The word stored in this node
-        Node* next; ///< Pointer to the next node
-        Node* prev; ///< Pointer to the previous node
+        uint32_t next; ///< Slot of the next node, or NIL (for a free slot: the next free slot)
+        uint32_t prev; ///< Slot of the previous node, or NIL
 
         /**
          * @brief Constructor for Node.
          * @param word The word to store in this node.
-         * @param nxt Pointer to the next node.
-         * @param prv Pointer to the previous node.
+         * @param nxt Slot of the next node.
+         * @param prv Slot of the previous node.
          */
-        Node(const Word& word, Node* nxt = nullptr, Node* prv = nullptr)
-            : theWord(word), next(nxt), prev(prv) {}
+        Node(Word&& word, uint32_t nxt, uint32_t prv)
+            : theWord(std::move(word)), next(nxt), prev(prv) {}
 
         Node() = delete; // Prevent default construction
         Node(const Node& other) = delete; // Prevent copy construction
-        Node(Node&& other) = delete; // Prevent move construction
         Node& operator=(const Node& other) = delete; // Prevent copy assignment
-        Node& operator=(Node&& other) = delete; // Prevent move assignment
-        virtual ~Node() = default; // Default virtual destructor
     };
 
-    Node* head; ///< Pointer to the first node in the list
-    Node* tail; ///< Pointer to the last node in the list
+    Node* nodes; ///< The node pool; slots [0, pool_used) hold constructed nodes
+    uint32_t pool_used; ///< Number of pool slots handed out so far, live or free
+    uint32_t pool_capacity; ///< Number of slots the pool has room for
+    uint32_t free_slot; ///< First slot of the free list, or NIL
+    uint32_t head; ///< Slot of the first node in the list, or NIL
+    uint32_t tail; ///< Slot of the last node in the list, or NIL
     size_t size; ///< Number of nodes in the list
 
+    mutable uint32_t* samples; ///< Position index: samples[k] is the slot of the node at position k * SAMPLE_INTERVAL
+    mutable size_t sample_capacity; ///< Allocated entries of samples
+    mutable bool samples_valid; ///< False when a link changed since samples was built
+
     // Private methods
     /**
      * @brief Releases ownership of all nodes in the list.
      */
     void releaseOwnership();
 
+    /**
+     * @brief Destroys every node and frees the pool.
+     */
+    void releasePool();
+
+    /**
+     * @brief Grows the pool so that it has room for at least the given number of slots.
+     * @param minimum The number of slots needed.
+     */
+    void growPool(size_t minimum);
+
+    /**
+     * @brief Takes a slot from the free list or the pool and constructs a node in it.
+     * @param word The word to store; moved into the node.
+     * @param next Slot of the next node.
+     * @param prev Slot of the previous node.
+     * @return The slot of the new node.
+     */
+    uint32_t allocateNode(Word&& word, uint32_t next, uint32_t prev);
+
+    /**
+     * @brief Frees the word of an unlinked node and puts its slot on the free list.
+     * @param slot The slot to release.
+     */
+    void releaseNode(uint32_t slot);
+
+    /**
+     * @brief Links a node between two neighbours, or at the ends of the list when they are NIL.
+     * @param slot The slot of the node to link; its next and prev must already be set.
+     */
+    void linkNode(uint32_t slot);
+
+    /**
+     * @brief Unlinks a node from its neighbours.
+     * @param slot The slot of the node to unlink.
+     */
+    void unlinkNode(uint32_t slot);
+
     /**
      * @brief Copies all nodes from another list into this list.
      * @param other The WordList to copy from.
@@ -53,16 +112,45 @@ private:
     /**
      * @brief Searches for a node containing the specified word.
      * @param word The word to search for.
-     * @return Pointer to the node containing the word, or nullptr if not found.
+     * @return Slot of the node containing the word, or NIL if not found.
      */
-    Node* search(const Word& word) const;
+    uint32_t search(const Word& word) const;
 
     /**
      * @brief Gets the node at the specified index.
      * @param n The index of the node.
-     * @return Pointer to the node at the specified index, or nullptr if out of range.
+     * @return Slot of the node at the specified index, or NIL if out of range.
+     */
+    uint32_t getWord(int n) const;
+
+    /**
+     * @brief Rebuilds the position index if a mutation made it stale.
+     * Not safe to call concurrently on the same list; WordCat serializes its callers.
      */
-    Node* getWord(int n) const;
+    void refreshSamples() const;
+
+    /**
+     * @brief Returns the slot of the node at the given position, through the position index.
+     * @param position The position, less than size
+     * @return The slot of the node
+     */
+    uint32_t slotAt(size_t position) const;
+
+    /**
+     * @brief Finds the first node whose word is not less than the given word. The list must be sorted.
+     * @param word The word to search for
+     * @param position Receives the position of that node, or size if every word is less
+     * @return The slot of that node, or NIL if every word is less
+     */
+    uint32_t lowerBound(const Word& word, size_t& position) const;
+
+    /**
+     * @brief Copies up to limit words, starting at a node, into a new list.
+     * @param slot The slot of the first node to copy, or NIL
+     * @param limit The maximum number of words
+     * @return The copied words
+     */
+    WordList copyFrom(uint32_t slot, size_t limit) const;
 
 public:
     /**
@@ -76,7 +164,7 @@ public:
     ~WordList();
 
     /**
-     * @brief Copy constructor. Initializes head and tail to nullptr and size to 0, then copies all nodes from 'other' to this list.
+     * @brief Copy constructor. Initializes an empty list, then copies all nodes from 'other' to this list.
      * @param other The WordList to copy from.
      */
     WordList(const WordList& other);
@@ -102,14 +190,14 @@ public:
     WordList& operator=(WordList&& other) noexcept;
 
     /**
-     * @brief Returns the word in the head node.
+     * @brief Returns the word in the head node. The reference is invalidated by the next insertion.
      * @return The word in the head node.
      * @throws std::runtime_error if the list is empty.
      */
     const Word& front() const;
 
     /**
-     * @brief Returns the word in the tail node.
+     * @brief Returns the word in the tail node. The reference is invalidated by the next insertion.
      * @return The word in the tail node.
      * @throws std::runtime_error if the list is empty.
      */
@@ -122,11 +210,11 @@ public:
     void push_front(const Word& word);
 
     /**
-     * @brief Removes the node at the head of this list and returns the removed node.
-     * @return Pointer to the removed head node.
+     * @brief Removes the node at the head of this list and returns its word.
+     * @return The word of the removed head node.
      * @throws std::runtime_error if the list is empty.
      */
-    Node* pop_front();
+    Word pop_front();
 
     /**
      * @brief Inserts a new node at the tail of this list.
@@ -135,11 +223,17 @@ public:
     void push_back(const Word& word);
 
     /**
-     * @brief Removes the node at the tail of this list and returns the removed node.
-     * @return Pointer to the removed tail node.
+     * @brief Inserts a new node at the tail of this list, moving the word into it.
+     * @param word The word to insert.
+     */
+    void push_back(Word&& word);
+
+    /**
+     * @brief Removes the node at the tail of this list and returns its word.
+     * @return The word of the removed tail node.
      * @throws std::runtime_error if the list is empty.
      */
-    Node* pop_back();
+    Word pop_back();
 
     /**
      * @brief Inserts a new node in the correct position to keep the list sorted.
@@ -148,7 +242,14 @@ public:
     void insertSorted(const Word& word);
 
     /**
-     * @brief Removes all nodes from the list.
+     * @brief Moves all words of another list to the end of this list without copying any characters.
+     * When this list is empty it takes over the other's pool in O(1); otherwise each word is moved into a new node.
+     * @param other The list to take the words from. It is left empty.
+     */
+    void append(WordList&& other);
+
+    /**
+     * @brief Removes all nodes from the list and frees the pool.
      */
     void clear();
 
@@ -160,18 +261,76 @@ public:
     bool remove(const Word& word);
 
     /**
-     * @brief Returns a copy of the word in the node at the given index.
+     * @brief Returns a copy of the word in the node at the given index. Costs one jump through the position index.
      * @param index The index of the node.
      * @return A copy of the word in the node.
      * @throws std::runtime_error if the index is out of range.
      */
     Word fetchWord(int index) const;
 
+    /**
+     * @brief Returns the words at positions [offset, offset + limit), in list order.
+     * Costs one jump through the position index plus the words copied.
+     * @param offset The position of the first word
+     * @param limit The maximum number of words
+     * @return The words of the page; empty when offset is past the end
+     */
+    WordList page(size_t offset, size_t limit) const;
+
+    /**
+     * @brief Returns up to limit words, starting at the first one that is not less than a given word.
+     * To resume after a page, ask for one word more than needed and pass the extra word as the next 'from'.
+     * The list must be sorted (see insertSorted).
+     * @param from Where to start; it need not be in the list
+     * @param limit The maximum number of words
+     * @return The words of the page
+     */
+    WordList range(const Word& from, size_t limit) const;
+
+    /**
+     * @brief Counts the words less than a given word. For a word in the list, this is its position.
+     * The list must be sorted (see insertSorted).
+     * @param word The word to rank; it need not be in the list
+     * @return The number of words that sort before it
+     */
+    size_t rank(const Word& word) const;
+
     /**
      * @brief Determines whether this WordList is empty.
      * @return True if the list is empty, false otherwise.
      */
-    inline bool isEmpty() const { return head == nullptr; };
+    inline bool isEmpty() const { return head == NIL; };
+
+    /**
+     * @brief Returns the number of words in the list.
+     * @return The number of nodes in the list.
+     */
+    inline size_t length() const { return size; };
+
+    /**
+     * @brief Calls a function on every word of the list, from head to tail.
+     * @param visit The function to call with each word.
+     */
+    void forEach(const std::function<void(const Word&)>& visit) const;
+
+    /**
+     * @brief Calls a function on every stored word, from head to tail, so that it can share the word's
+     * buffer with an equal word (see Word::shareBuffer). The function must not change the characters.
+     * @param visit The function to call with each word.
+     */
+    void forEachStored(const std::function<void(Word&)>& visit);
+
+    /**
+     * @brief Rebuilds the pool at exactly the current size, dropping free slots and growth slack.
+     * Afterwards the nodes occupy consecutive slots in list order, so traversals walk memory sequentially.
+     */
+    void shrinkToFit();
+
+    /**
+     * @brief Returns the memory owned by the list: the node pool plus the heap buffers of long words.
+     * @return The size in bytes.
+     */
+    size_t memoryBytes() const;
 
     /**
      * @brief Checks if the given word is in the list.
@@ -180,6 +339,26 @@ public:
      */
     bool lookup(const Word& word) const;
 
+    /**
+     * @brief Looks up a batch of words with a single pass over the list.
+     * The probes are visited in sorted order and merged against the sorted list, so the whole batch
+     * costs O(size + count log count) instead of O(size * count). The list must be sorted (see insertSorted).
+     * @param words The words to look up
+     * @param count The number of words
+     * @param found Array of count elements; found[i] is set to whether words[i] is in the list
+     * @param order Optional permutation of [0, count) that visits words in ascending order (see sortedOrder).
+     *              When nullptr, the order is computed here.
+     */
+    void lookupMany(const Word* words, size_t count, bool* found, const size_t* order = nullptr) const;
+
+    /**
+     * @brief Computes the permutation that visits a batch of words in ascending order.
+     * @param words The words to order
+     * @param count The number of words
+     * @return A new[]-allocated array of count indices into words, which the caller must delete[]
+     */
+    static size_t* sortedOrder(const Word* words, size_t count);
+
     /**
      * @brief Returns a list of words starting with the given letter.
      * @param letter The initial letter of the words to return.
@@ -190,7 +369,7 @@ public:
     /**
      * @brief Prints the words in the list to the given output stream, with a maximum of n words per line.
      * @param os The output stream to print to.
-     * @param n The maximum number of words per line.
+     * @param n The maximum number of words per line, or WordFormatter::FIT_TERMINAL to fit the terminal width.
      * @return The total number of words printed.
      */
     int print(std::ostream& os, const int n = 5) const;
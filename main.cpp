@@ -3,6 +3,8 @@
 #include "WordList.h"  // Includes the WordList header file
 #include "WordCat.h"  // Includes the WordCat header file
 #include "WordCatVec.h"  // Includes the WordCatVec header file
+#include <chrono>  // Provides clocks for the benchmarks
+#include <cstdio>  // Provides snprintf for generating words
 
 /**
  * @brief Tests the WordCatVec class by running its main loop.
@@ -51,6 +53,34 @@ void testWordCatVec() {
 // }
 
 
+/**
+ * @brief Measures the memory footprint of a WordList holding 10 million words.
+ * The words are short (like most dictionary words) and are appended in sorted order,
+ * the way loadFromFile builds a category.
+ */
+void benchWordListFootprint() {
+    const size_t word_count = 10000000;  // Number of words to load
+    char buffer[16];  // Holds each generated word
+
+    auto start = std::chrono::steady_clock::now();
+    WordList word_list;  // The list being measured
+    size_t characters = 0;  // Total characters of all words, excluding terminators
+    for (size_t i = 0; i < word_count; ++i) {
+        int length = std::snprintf(buffer, sizeof buffer, "w%08zu", i);  // Sorted, 9-character words
+        characters += static_cast<size_t>(length);
+        word_list.push_back(Word(buffer));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    word_list.shrinkToFit();  // Drop the pool's growth slack, as after any bulk load
+
+    size_t bytes = word_list.memoryBytes();  // Pool plus long-word buffers
+    std::cout << "Loaded " << word_list.length() << " words in " << seconds << " s\n";
+    std::cout << "sizeof(Word) = " << sizeof(Word) << " bytes\n";
+    std::cout << "Memory: " << bytes << " bytes, " << static_cast<double>(bytes) / word_count << " bytes/word\n";
+    std::cout << "Overhead beyond the characters: "
+              << static_cast<double>(bytes - characters) / word_count << " bytes/word\n";
+}
+
 /**
  * @brief The main function of the program. Calls the test function for WordCatVec.
  * @return int Returns 0 to indicate successful execution.
@@ -63,6 +93,7 @@ int main() {
     // testWordCat();  // Calls the test function for WordCat
     // testWordList();  // Calls the test function for WordList
     // test_Word();  // Calls the test function for Word
+    // benchWordListFootprint();  // Measures the memory footprint of a 10M-word WordList
 
     return 0;  // Returns 0 to indicate successful execution
 }